@@ -21,6 +21,7 @@ void BlockMatching::loadAttributes() {
 BlockMatching::BlockMatching(int blockSize, int searhSize, MatchingMetric metric, bool forwardBackwardTracking, int timeLag) {
     createInputPort(0, "Image");
     createOutputPort(0, "Image");
+    setImageBufferPooling(true); // New output image every frame
 
     createOpenCLProgram(Config::getKernelSourcePath() + "/Algorithms/BlockMatching/BlockMatching.cl");
 
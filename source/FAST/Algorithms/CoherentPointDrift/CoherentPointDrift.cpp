@@ -1,5 +1,6 @@
 #include "FAST/Algorithms/CoherentPointDrift/CoherentPointDrift.hpp"
 #include "FAST/SceneGraph.hpp"
+#include "FAST/ThreadPool.hpp"
 #include "CoherentPointDrift.hpp"
 
 #include "FAST/Algorithms/CoherentPointDrift/Rigid.hpp"
@@ -23,6 +24,8 @@ namespace fast {
         mTransformation = Transform::create();
         mRegistrationConverged = false;
         mScale = 1.0;
+        mGaussTransformMethod = GaussTransformMethod::DIRECT;
+        mGaussTransformTolerance = 1e-3;
 
         timeE = 0.0;
         timeEDistances = 0.0;
@@ -112,19 +115,53 @@ namespace fast {
         auto c = (float) (pow(2*(double)EIGEN_PI*mVariance, (double)mNumDimensions/2.0)
                           * (mUniformWeight/(1-mUniformWeight)) * (float)mNumMovingPoints/mNumFixedPoints);
 
-#pragma omp parallel for //collapse(2)
-        for (int col = 0; col < mNumFixedPoints; ++col) {
-            for (int row = 0; row < mNumMovingPoints; ++row) {
-                double norm = (fixedPoints.row(col) - movingPoints.row(row)).squaredNorm();
-                mResponsibilityMatrix(row, col) = exp(norm / (-2.0 * mVariance));
-            }
-        }
-
-#pragma omp parallel for
-        for (int col = 0; col < mNumFixedPoints; ++col) {
-            float denom = mResponsibilityMatrix.col(col).sum() + c;
-            mResponsibilityMatrix.col(col) /= max(denom, Eigen::NumTraits<float>::epsilon() );
+        /* **********************************************************************************
+         * Only the sums of P needed by the maximization step are computed, P is not stored:
+         * Pt1 (colwise sums), P1 (rowwise sums) and PX (P times fixed points).
+         * Column n of P is exp(-|x_n - y_m|^2/(2*sigma^2)) divided by the sum of the column plus c.
+         * *********************************************************************************/
+        if(mGaussTransformMethod == GaussTransformMethod::DIRECT) {
+            mP1 = VectorXf::Zero(mNumMovingPoints);
+            mPX = MatrixXf::Zero(mNumMovingPoints, mNumDimensions);
+            std::mutex mutex;
+            ThreadPool::getInstance()->parallelFor(0, mNumFixedPoints, [&](int begin, int end) {
+                VectorXf column(mNumMovingPoints);
+                VectorXf P1Local = VectorXf::Zero(mNumMovingPoints);
+                MatrixXf PXLocal = MatrixXf::Zero(mNumMovingPoints, mNumDimensions);
+                for (int col = begin; col < end; ++col) {
+                    for (int row = 0; row < mNumMovingPoints; ++row) {
+                        double norm = (fixedPoints.row(col) - movingPoints.row(row)).squaredNorm();
+                        column(row) = exp(norm / (-2.0 * mVariance));
+                    }
+                    float denom = column.sum() + c;
+                    column /= max(denom, Eigen::NumTraits<float>::epsilon() );
+                    mPt1(col) = column.sum();
+                    P1Local += column;
+                    PXLocal.noalias() += column * fixedPoints.row(col);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                mP1 += P1Local;
+                mPX += PXLocal;
+            });
+        } else {
+            // Kernel values are divided by the sum of the column plus c, thus the error must be small relative to c
+            GaussTransform transform(mGaussTransformMethod, mGaussTransformTolerance * min(1.0f, c));
+            const double bandwidth = sqrt(2.0 * mVariance);
+            // Sum of each column
+            VectorXf Kt1 = transform.compute(movingPoints, MatrixXf::Ones(mNumMovingPoints, 1), fixedPoints, bandwidth);
+            Kt1 = Kt1.cwiseMax(0.0f);
+            VectorXf denom = (Kt1.array() + c).cwiseMax(Eigen::NumTraits<float>::epsilon());
+            mPt1 = Kt1.cwiseQuotient(denom);
+            // P1 and PX in one transform, with the column normalization as weights
+            MatrixXf weights(mNumFixedPoints, mNumDimensions + 1);
+            weights.col(0) = denom.cwiseInverse();
+            weights.rightCols(mNumDimensions) = fixedPoints.array().colwise() * weights.col(0).array();
+            MatrixXf result = transform.compute(fixedPoints, weights, movingPoints, bandwidth);
+            mP1 = result.col(0);
+            mPX = result.rightCols(mNumDimensions);
+            reportInfo() << "CPD expectation used " << (transform.getLastMethod() == GaussTransformMethod::IFGT ? "IFGT" : "truncated") << " Gauss transform" << reportEnd();
         }
+        mNp = mPt1.sum();
     }
 
     void CoherentPointDrift::execute() {
@@ -150,8 +187,12 @@ namespace fast {
          * ************************/
         while (mIteration < mMaxIterations && !mRegistrationConverged) {
 //            std::cout << "ITERATION " << (int) mIteration << std::endl;
+            mRuntimeManager->startRegularTimer("expectation");
             expectation(mFixedPoints, mMovingPoints);
+            mRuntimeManager->stopRegularTimer("expectation");
+            mRuntimeManager->startRegularTimer("maximization");
             maximization(mFixedPoints, mMovingPoints);
+            mRuntimeManager->stopRegularTimer("maximization");
             mIteration++;
         }
 
@@ -218,6 +259,18 @@ namespace fast {
         mTolerance = tolerance;
     }
 
+    void CoherentPointDrift::setGaussTransformMethod(GaussTransformMethod method) {
+        mGaussTransformMethod = method;
+        setModified(true);
+    }
+
+    void CoherentPointDrift::setGaussTransformTolerance(double epsilon) {
+        if(epsilon <= 0 || epsilon >= 1)
+            throw Exception("Gauss transform tolerance must be between 0 and 1");
+        mGaussTransformTolerance = epsilon;
+        setModified(true);
+    }
+
     Transform::pointer CoherentPointDrift::getOutputTransformation() {
         return mTransformation;
     }
@@ -3,11 +3,16 @@
 #include "FAST/Data/DataBoundingBox.hpp"
 #include "FAST/ProcessObject.hpp"
 #include "FAST/Data/Mesh.hpp"
+#include "FAST/Algorithms/CoherentPointDrift/GaussTransform.hpp"
 
 namespace fast {
 
 /**
  * @brief Abstract base class for Coherent Point Drift (CPD) registration
+ *
+ * The expectation step computes the sums of the responsibility matrix P which are needed by the maximization step,
+ * without storing P. By default these are computed exactly, which takes O(NM) time. For large point sets, a fast
+ * Gauss transform can be used instead, see setGaussTransformMethod.
  */
 class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
 //    FAST_OBJECT(CoherentPointDrift)
@@ -20,6 +25,20 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         void setMaximumIterations(unsigned char maxIterations);
         void setUniformWeight(float uniformWeight);
         void setTolerance(double tolerance);
+        /**
+         * @brief Set how the expectation step sums the gaussian kernels between all fixed and moving points.
+         *
+         * DIRECT is exact and O(NM). AUTO uses, for each iteration, either the truncated kernel or the
+         * improved fast Gauss transform, whichever is fastest, which makes each iteration close to linear in nr of points.
+         * Default is DIRECT.
+         * @param method
+         */
+        void setGaussTransformMethod(GaussTransformMethod method);
+        /**
+         * @brief Set max error of the approximate Gauss transform methods, relative to the sum of weights. Default is 1e-3.
+         * @param epsilon
+         */
+        void setGaussTransformTolerance(double epsilon);
         Transform::pointer getOutputTransformation();
 
         virtual void initializeVarianceAndMore() = 0;
@@ -33,7 +52,10 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         MatrixXf mMovingPoints;
         MatrixXf mMovingMeanInitial;
         MatrixXf mFixedMeanInitial;
-        MatrixXf mResponsibilityMatrix;         // P
+        VectorXf mPt1;                          // Colwise sum of P, then transpose
+        VectorXf mP1;                           // Rowwise sum of P
+        MatrixXf mPX;                           // P * fixed points
+        float mNp;                              // Sum of all elements in P
         unsigned int mNumFixedPoints;           // N
         unsigned int mNumMovingPoints;          // M
         unsigned int mNumDimensions;            // D
@@ -67,6 +89,8 @@ class FAST_EXPORT  CoherentPointDrift: public ProcessObject {
         std::shared_ptr<Mesh> mFixedMesh;
         std::shared_ptr<Mesh> mMovingMesh;
         unsigned char mMaxIterations;
+        GaussTransformMethod mGaussTransformMethod;
+        double mGaussTransformTolerance;
         CoherentPointDrift::TransformationType mTransformationType;
     };
 
@@ -0,0 +1,344 @@
+#include "GaussTransform.hpp"
+#include <FAST/Algorithms/NearestNeighbourSearch/NearestNeighbourSearch.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <FAST/Exception.hpp>
+#undef min
+#undef max
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace fast {
+
+namespace {
+
+/**
+ * Nr of monomials of D variables with degree less than order
+ */
+int getNrOfTerms(int order, int dimensions) {
+    double terms = 1;
+    for(int i = 1; i <= dimensions; ++i)
+        terms = terms*(order - 1 + i)/i;
+    return (int)std::round(terms);
+}
+
+/**
+ * Compute all monomials of x with degree less than order, in graded order.
+ * Monomials of degree k are made by multiplying each variable with the monomials of degree k-1 which start
+ * with the same or a later variable (Raykar et al. 2005).
+ * If constants is not nullptr, 2^|alpha|/alpha! of each monomial alpha is stored there.
+ */
+void computeMonomials(const double* x, int dimensions, int order, double* monomials, double* constants = nullptr) {
+    int heads[16];
+    std::vector<int> exponents(constants != nullptr ? getNrOfTerms(order, dimensions) : 0);
+    for(int i = 0; i < dimensions; ++i)
+        heads[i] = 0;
+    heads[dimensions] = std::numeric_limits<int>::max();
+    monomials[0] = 1.0;
+    if(constants != nullptr) {
+        constants[0] = 1.0;
+        exponents[0] = 0;
+    }
+    int t = 1;
+    int tail = 1;
+    for(int k = 1; k < order; ++k, tail = t) {
+        for(int i = 0; i < dimensions; ++i) {
+            const int head = heads[i];
+            heads[i] = t;
+            for(int j = head; j < tail; ++j, ++t) {
+                monomials[t] = x[i]*monomials[j];
+                if(constants != nullptr) {
+                    // Exponent of variable i in this monomial
+                    exponents[t] = j < heads[i + 1] ? exponents[j] + 1 : 1;
+                    constants[t] = 2.0*constants[j]/exponents[t];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Upper bound of the error of truncating the Taylor expansion of one source after the given order.
+ * a is the cluster radius and maxDistance the cutoff distance between targets and cluster centers, relative to bandwidth.
+ */
+double getTruncationError(int order, double a, double maxDistance) {
+    // The error (2^p/p!) (a*t)^p exp(-(t-a)^2) is largest at t = (a + sqrt(a^2 + 2p))/2
+    const double t = std::min(maxDistance, (a + std::sqrt(a*a + 2.0*order))/2.0);
+    return std::exp(order*std::log(2.0*a*t) - std::lgamma(order + 1.0) - (t - a)*(t - a));
+}
+
+}
+
+GaussTransform::GaussTransform(GaussTransformMethod method, double epsilon) {
+    if(epsilon <= 0 || epsilon >= 1)
+        throw Exception("Epsilon of GaussTransform must be between 0 and 1");
+    m_method = method;
+    m_lastMethod = method;
+    m_epsilon = epsilon;
+}
+
+GaussTransformMethod GaussTransform::getLastMethod() const {
+    return m_lastMethod;
+}
+
+MatrixXf GaussTransform::compute(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth) {
+    if(sources.rows() != weights.rows())
+        throw Exception("Nr of sources and weights must be equal in GaussTransform");
+    if(sources.cols() != targets.cols())
+        throw Exception("Sources and targets must have same nr of dimensions in GaussTransform");
+    if(sources.cols() > 15)
+        throw Exception("GaussTransform supports at most 15 dimensions");
+    if(bandwidth <= 0)
+        throw Exception("Bandwidth of GaussTransform must be larger than 0");
+    const int N = sources.rows();
+    const int M = targets.rows();
+    const int D = sources.cols();
+    const int W = weights.cols();
+    if(N == 0 || M == 0)
+        return MatrixXf::Zero(M, W);
+
+    m_lastMethod = m_method;
+    if(m_method == GaussTransformMethod::DIRECT)
+        return computeDirect(sources, weights, targets, bandwidth);
+    if(m_method == GaussTransformMethod::TRUNCATED)
+        return computeTruncated(sources, weights, targets, bandwidth);
+
+    // Estimate cost of each method, using a sample of the targets
+    const double cutoff = bandwidth*std::sqrt(std::log(1.0/m_epsilon));
+    const int samples = std::min(M, 32);
+    std::vector<int> sampleTargets(samples);
+    for(int i = 0; i < samples; ++i)
+        sampleTargets[i] = (int)((int64_t)i*M/samples);
+    double truncatedCost;
+    {
+        int64_t neighbours = 0;
+        for(int target : sampleTargets) {
+            for(int i = 0; i < N; ++i)
+                neighbours += (sources.row(i) - targets.row(target)).squaredNorm() <= cutoff*cutoff;
+        }
+        truncatedCost = (double)M*neighbours/samples*(D + W + 8) + N*std::log2(N + 1.0)*D;
+    }
+
+    // Select centers by farthest point clustering (Gonzalez 1985), and evaluate cost for 1, 2, 4 ... clusters.
+    // The cluster radius after K centers is the distance to the point which is selected as the next center.
+    const int maxClusters = std::min(N, 128);
+    std::vector<int> centers = {0};
+    std::vector<float> distances(N);
+    for(int i = 0; i < N; ++i)
+        distances[i] = (sources.row(i) - sources.row(0)).squaredNorm();
+    double bestCost = std::numeric_limits<double>::max();
+    int bestClusters = 0;
+    int bestOrder = 0;
+    const int maxOrder = 30;
+    for(int K = 1; K <= maxClusters; ++K) {
+        if(m_method == GaussTransformMethod::AUTO && (double)N*K*D > truncatedCost)
+            break; // Clustering alone is more expensive than the truncated method
+        const int farthest = std::max_element(distances.begin(), distances.end()) - distances.begin();
+        if(K == maxClusters || (K & (K - 1)) == 0) {
+            // Find nr of Taylor terms needed for the cluster radius
+            const double radius = std::sqrt(distances[farthest]);
+            const double maxDistance = radius + cutoff;
+            int order = 1;
+            while(order <= maxOrder && getTruncationError(order, radius/bandwidth, maxDistance/bandwidth) > m_epsilon)
+                ++order;
+            if(order <= maxOrder) {
+                int64_t nearbyClusters = 0;
+                for(int target : sampleTargets) {
+                    for(int k = 0; k < K; ++k)
+                        nearbyClusters += (sources.row(centers[k]) - targets.row(target)).norm() <= maxDistance;
+                }
+                const int terms = getNrOfTerms(order, D);
+                const double cost = (double)N*K*D + (double)N*terms*(W + 2) + (double)M*nearbyClusters/samples*(terms*(W + 2) + D);
+                if(cost < bestCost) {
+                    bestCost = cost;
+                    bestClusters = K;
+                    bestOrder = order;
+                } else if(bestClusters > 0 && cost > 2.0*bestCost) {
+                    break;
+                }
+            }
+            if(radius == 0.0) // All points are centers
+                break;
+        }
+        if(K < maxClusters) {
+            centers.push_back(farthest);
+            for(int i = 0; i < N; ++i)
+                distances[i] = std::min(distances[i], (sources.row(i) - sources.row(farthest)).squaredNorm());
+        }
+    }
+
+    if(m_method == GaussTransformMethod::IFGT && bestClusters == 0) {
+        // Error bound can't be reached, use max nr of clusters and terms
+        bestClusters = maxClusters;
+        bestOrder = maxOrder;
+    }
+    if(m_method == GaussTransformMethod::IFGT || (bestClusters > 0 && bestCost < truncatedCost)) {
+        m_lastMethod = GaussTransformMethod::IFGT;
+        centers.resize(std::min<int>(bestClusters, centers.size()));
+        return computeIFGT(sources, weights, targets, bandwidth, centers, bestOrder);
+    } else {
+        m_lastMethod = GaussTransformMethod::TRUNCATED;
+        return computeTruncated(sources, weights, targets, bandwidth);
+    }
+}
+
+MatrixXf GaussTransform::computeDirect(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth) const {
+    const int W = weights.cols();
+    const float scale = 1.0/(bandwidth*bandwidth);
+    // Store points as columns, so that the coordinates of each point are contiguous
+    const MatrixXf sourceColumns = sources.transpose();
+    const MatrixXf targetColumns = targets.transpose();
+    const MatrixXf weightColumns = weights.transpose();
+    MatrixXf result(targets.rows(), W);
+    ThreadPool::getInstance()->parallelFor(0, targets.rows(), [&](int begin, int end) {
+        std::vector<double> sum(W);
+        for(int j = begin; j < end; ++j) {
+            std::fill(sum.begin(), sum.end(), 0.0);
+            for(int i = 0; i < sourceColumns.cols(); ++i) {
+                const float kernel = std::exp(-(sourceColumns.col(i) - targetColumns.col(j)).squaredNorm()*scale);
+                for(int w = 0; w < W; ++w)
+                    sum[w] += kernel*weightColumns(w, i);
+            }
+            for(int w = 0; w < W; ++w)
+                result(j, w) = sum[w];
+        }
+    });
+    return result;
+}
+
+MatrixXf GaussTransform::computeTruncated(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth) const {
+    const int W = weights.cols();
+    const float scale = 1.0/(bandwidth*bandwidth);
+    const float cutoff = bandwidth*std::sqrt(std::log(1.0/m_epsilon));
+    const MatrixXf sourceColumns = sources.transpose();
+    const MatrixXf targetColumns = targets.transpose();
+    const MatrixXf weightColumns = weights.transpose();
+    const KDTree tree(sourceColumns);
+    MatrixXf result(targets.rows(), W);
+    ThreadPool::getInstance()->parallelFor(0, targets.rows(), [&](int begin, int end) {
+        std::vector<double> sum(W);
+        std::vector<int> neighbours;
+        for(int j = begin; j < end; ++j) {
+            std::fill(sum.begin(), sum.end(), 0.0);
+            neighbours.clear();
+            tree.findWithinRadius(targetColumns.col(j).data(), cutoff, neighbours);
+            for(int i : neighbours) {
+                const float kernel = std::exp(-(sourceColumns.col(i) - targetColumns.col(j)).squaredNorm()*scale);
+                for(int w = 0; w < W; ++w)
+                    sum[w] += kernel*weightColumns(w, i);
+            }
+            for(int w = 0; w < W; ++w)
+                result(j, w) = sum[w];
+        }
+    });
+    return result;
+}
+
+MatrixXf GaussTransform::computeIFGT(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth,
+                                     const std::vector<int>& centerIndices, int order) const {
+    const int N = sources.rows();
+    const int D = sources.cols();
+    const int W = weights.cols();
+    const int K = centerIndices.size();
+    const int terms = getNrOfTerms(order, D);
+    Eigen::MatrixXd centers(K, D);
+    for(int k = 0; k < K; ++k)
+        centers.row(k) = sources.row(centerIndices[k]).cast<double>();
+
+    // Assign sources to nearest center, and sort them by cluster
+    std::vector<int> clusters(N);
+    std::vector<int> clusterStart(K + 1, 0);
+    double radius = 0.0;
+    for(int i = 0; i < N; ++i) {
+        double bestDistance = std::numeric_limits<double>::max();
+        for(int k = 0; k < K; ++k) {
+            const double distance = (sources.row(i).cast<double>() - centers.row(k)).squaredNorm();
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                clusters[i] = k;
+            }
+        }
+        radius = std::max(radius, bestDistance);
+        ++clusterStart[clusters[i] + 1];
+    }
+    radius = std::sqrt(radius);
+    for(int k = 0; k < K; ++k)
+        clusterStart[k + 1] += clusterStart[k];
+    std::vector<int> sorted(N);
+    {
+        std::vector<int> next(clusterStart.begin(), clusterStart.end() - 1);
+        for(int i = 0; i < N; ++i)
+            sorted[next[clusters[i]]++] = i;
+    }
+
+    // Taylor coefficients of each cluster: C_k,alpha = 2^|alpha|/alpha! sum_i q_i exp(-|dx|^2) dx^alpha, where dx = (x_i - c_k)/h
+    std::vector<double> constants(terms);
+    {
+        std::vector<double> monomials(terms);
+        std::vector<double> zero(D, 0.0);
+        computeMonomials(zero.data(), D, order, monomials.data(), constants.data());
+    }
+    std::vector<double> coefficients((size_t)K*terms*W, 0.0);
+    ThreadPool::getInstance()->parallelFor(0, K, [&](int begin, int end) {
+        std::vector<double> dx(D);
+        std::vector<double> monomials(terms);
+        for(int k = begin; k < end; ++k) {
+            double* coefficient = &coefficients[(size_t)k*terms*W];
+            for(int s = clusterStart[k]; s < clusterStart[k + 1]; ++s) {
+                const int i = sorted[s];
+                double squaredDistance = 0.0;
+                for(int d = 0; d < D; ++d) {
+                    dx[d] = (sources(i, d) - centers(k, d))/bandwidth;
+                    squaredDistance += dx[d]*dx[d];
+                }
+                computeMonomials(dx.data(), D, order, monomials.data());
+                const double kernel = std::exp(-squaredDistance);
+                for(int w = 0; w < W; ++w) {
+                    const double weight = weights(i, w)*kernel;
+                    for(int t = 0; t < terms; ++t)
+                        coefficient[t*W + w] += weight*monomials[t];
+                }
+            }
+            for(int t = 0; t < terms; ++t) {
+                for(int w = 0; w < W; ++w)
+                    coefficient[t*W + w] *= constants[t];
+            }
+        }
+    }, 1);
+
+    // Evaluate expansions of clusters within cutoff distance of each target
+    const double maxDistance = radius + bandwidth*std::sqrt(std::log(1.0/m_epsilon));
+    MatrixXf result(targets.rows(), W);
+    ThreadPool::getInstance()->parallelFor(0, targets.rows(), [&](int begin, int end) {
+        std::vector<double> dy(D);
+        std::vector<double> monomials(terms);
+        std::vector<double> sum(W);
+        for(int j = begin; j < end; ++j) {
+            std::fill(sum.begin(), sum.end(), 0.0);
+            for(int k = 0; k < K; ++k) {
+                double squaredDistance = 0.0;
+                for(int d = 0; d < D; ++d) {
+                    dy[d] = targets(j, d) - centers(k, d);
+                    squaredDistance += dy[d]*dy[d];
+                }
+                if(squaredDistance > maxDistance*maxDistance)
+                    continue;
+                for(int d = 0; d < D; ++d)
+                    dy[d] /= bandwidth;
+                computeMonomials(dy.data(), D, order, monomials.data());
+                const double kernel = std::exp(-squaredDistance/(bandwidth*bandwidth));
+                const double* coefficient = &coefficients[(size_t)k*terms*W];
+                for(int t = 0; t < terms; ++t) {
+                    const double value = kernel*monomials[t];
+                    for(int w = 0; w < W; ++w)
+                        sum[w] += coefficient[t*W + w]*value;
+                }
+            }
+            for(int w = 0; w < W; ++w)
+                result(j, w) = sum[w];
+        }
+    });
+    return result;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+
+namespace fast {
+
+/**
+ * @brief Method used to compute a Gauss transform
+ */
+enum class GaussTransformMethod {
+    DIRECT, // Sum over all pairs of sources and targets, O(NM)
+    TRUNCATED, // Sum over sources within cutoff distance of each target, found with a k-d tree
+    IFGT, // Improved fast Gauss transform: Taylor expansion of sources around cluster centers
+    AUTO, // Select TRUNCATED or IFGT, whichever is estimated to be fastest
+};
+
+/**
+ * @brief Computes sums of gaussian kernels: G(y_j) = sum_i q_i * exp(-||y_j - x_i||^2 / h^2)
+ *
+ * x_i are N source points with weights q_i, y_j are M target points and h is the bandwidth.
+ * Several weight vectors can be given at once, as columns of the weight matrix.
+ *
+ * The approximate methods have an absolute error of at most epsilon times the sum of absolute weights, per target.
+ * TRUNCATED ignores sources further away than h*sqrt(ln(1/epsilon)), which is fast for small bandwidths.
+ * IFGT (Yang et al. 2003, Raykar et al. 2005) clusters the sources and sums truncated Taylor expansions
+ * around each cluster center, which is fast for large bandwidths. The nr of clusters and Taylor terms are
+ * selected from the error bound.
+ */
+class FAST_EXPORT GaussTransform {
+    public:
+        /**
+         * @brief Create Gauss transform
+         * @param method
+         * @param epsilon Max error per unit of source weight for TRUNCATED and IFGT
+         */
+        explicit GaussTransform(GaussTransformMethod method = GaussTransformMethod::AUTO, double epsilon = 1e-3);
+        /**
+         * @brief Compute Gauss transform
+         * @param sources NxD matrix of source points
+         * @param weights NxW matrix of weights
+         * @param targets MxD matrix of target points
+         * @param bandwidth h
+         * @return MxW matrix of sums
+         */
+        MatrixXf compute(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth);
+        /**
+         * @brief Method used in last call to compute. Is TRUNCATED or IFGT if method is AUTO.
+         */
+        GaussTransformMethod getLastMethod() const;
+    private:
+        MatrixXf computeDirect(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth) const;
+        MatrixXf computeTruncated(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth) const;
+        MatrixXf computeIFGT(const MatrixXf& sources, const MatrixXf& weights, const MatrixXf& targets, double bandwidth,
+                             const std::vector<int>& centers, int order) const;
+
+        GaussTransformMethod m_method;
+        GaussTransformMethod m_lastMethod;
+        double m_epsilon;
+};
+
+}
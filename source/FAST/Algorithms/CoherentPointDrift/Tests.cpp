@@ -10,6 +10,8 @@
 #include "CoherentPointDrift.hpp"
 #include "Rigid.hpp"
 #include "Affine.hpp"
+#include "GaussTransform.hpp"
+#include "FAST/SceneGraph.hpp"
 
 #include <random>
 #include <iostream>
@@ -181,4 +183,76 @@ TEST_CASE("cpd", "[fast][coherentpointdrift][visual][cpd]") {
         window->start();
     }
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("Approximate Gauss transforms are within error bound of direct", "[fast][coherentpointdrift][cpd]") {
+    std::mt19937 generator(1);
+    std::normal_distribution<float> distribution(0.0f, 1.0f);
+    const int size = 1000;
+    MatrixXf sources(size, 3);
+    MatrixXf targets(size, 3);
+    MatrixXf weights(size, 2);
+    for(int i = 0; i < size; ++i) {
+        Vector3f point(distribution(generator), distribution(generator), distribution(generator));
+        sources.row(i) = point.normalized();
+        targets.row(i) = sources.row(i) + Vector3f(0.05f, 0.02f, 0.0f).transpose()*distribution(generator);
+        weights(i, 0) = 1.0f;
+        weights(i, 1) = sources(i, 0);
+    }
+    const double epsilon = 1e-3;
+    const double maxError = epsilon*weights.cwiseAbs().colwise().sum().maxCoeff();
+    for(double bandwidth : {2.0, 0.5, 0.05}) {
+        MatrixXf expected = GaussTransform(GaussTransformMethod::DIRECT).compute(sources, weights, targets, bandwidth);
+        for(auto method : {GaussTransformMethod::TRUNCATED, GaussTransformMethod::IFGT, GaussTransformMethod::AUTO}) {
+            GaussTransform transform(method, epsilon);
+            MatrixXf result = transform.compute(sources, weights, targets, bandwidth);
+            CHECK((result - expected).cwiseAbs().maxCoeff() <= maxError);
+        }
+    }
+    // Large bandwidth is fastest with IFGT, small with truncation
+    GaussTransform transform(GaussTransformMethod::AUTO);
+    transform.compute(sources, weights, targets, 2.0);
+    CHECK(transform.getLastMethod() == GaussTransformMethod::IFGT);
+    transform.compute(sources, weights, targets, 0.05);
+    CHECK(transform.getLastMethod() == GaussTransformMethod::TRUNCATED);
+}
+
+TEST_CASE("CPD with fast Gauss transform gives same result as direct", "[fast][coherentpointdrift][cpd]") {
+    // Points evenly spread on an ellipsoid
+    const int size = 2000;
+    std::vector<MeshVertex> vertices;
+    const float goldenAngle = EIGEN_PI*(3.0f - std::sqrt(5.0f));
+    for(int i = 0; i < size; ++i) {
+        const float z = 1.0f - 2.0f*(i + 0.5f)/size;
+        const float radius = std::sqrt(1.0f - z*z);
+        vertices.push_back(MeshVertex(Vector3f(std::cos(goldenAngle*i)*radius*30.0f, std::sin(goldenAngle*i)*radius*20.0f, z*10.0f)));
+    }
+    Affine3f affine = Affine3f::Identity();
+    affine.translate(Vector3f(2.0f, -1.0f, 0.5f));
+    affine.rotate(Eigen::AngleAxisf(0.2f, Vector3f::UnitZ()));
+
+    for(bool rigid : {true, false}) {
+        std::vector<Matrix4f> results;
+        for(auto method : {GaussTransformMethod::DIRECT, GaussTransformMethod::AUTO}) {
+            auto fixed = Mesh::create(vertices);
+            auto moving = Mesh::create(vertices);
+            moving->getSceneGraphNode()->setTransform(affine);
+            std::shared_ptr<CoherentPointDrift> cpd;
+            if(rigid) {
+                cpd = CoherentPointDriftRigid::create();
+            } else {
+                cpd = CoherentPointDriftAffine::create();
+            }
+            cpd->setFixedMesh(fixed);
+            cpd->setMovingMesh(moving);
+            cpd->setMaximumIterations(50);
+            cpd->setUniformWeight(0.1);
+            cpd->setGaussTransformMethod(method);
+            cpd->update();
+            results.push_back(SceneGraph::getEigenTransformFromData(moving).matrix());
+        }
+        // Registered transform should be close to identity
+        CHECK((results[0] - Matrix4f::Identity()).cwiseAbs().maxCoeff() < 0.1f);
+        CHECK((results[1] - results[0]).cwiseAbs().maxCoeff() < 0.01f);
+    }
+}
@@ -33,6 +33,7 @@ void GaussianSmoothing::setStandardDeviation(float stdDev) {
 GaussianSmoothing::GaussianSmoothing(float stdDev, uchar maskSize) {
     createInputPort(0, "Image");
     createOutputPort(0, "Image");
+    setImageBufferPooling(true); // New output image every frame
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GaussianSmoothing/GaussianSmoothing2D.cl", "2D");
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/GaussianSmoothing/GaussianSmoothing3D.cl", "3D");
     createFloatAttribute("stdev", "Standard deviation", "Standard deviation", stdDev);
@@ -2,6 +2,8 @@
 #include <FAST/Data/Image.hpp>
 #include <FAST/Algorithms/ImageResizer/ImageResizer.hpp>
 #include "PatchGenerator.hpp"
+#include <deque>
+#include <condition_variable>
 
 namespace fast {
 
@@ -25,6 +27,8 @@ PatchGenerator::PatchGenerator() {
     createFloatAttribute("patch-overlap", "Patch overlap", "Patch overlap in percent", m_overlapPercent);
     createFloatAttribute("mask-threshold", "Mask threshold", "Threshold, in percent, for how much of the candidate patch must be inside the mask to be accepted", m_maskThreshold);
     createIntegerAttribute("padding-value", "Padding value", "Value to pad patches with when out-of-bounds. Default is negative, meaning it will use (white)255 for color images, and (black)0 for grayscale images", m_paddingValue);
+    createIntegerAttribute("prefetch", "Prefetch", "Nr of image pyramid patches to extract in advance on multiple threads. 0 disables prefetching.", m_prefetchCount);
+    createIntegerAttribute("prefetch-threads", "Prefetch threads", "Nr of threads to use for prefetching. Negative value means nr of cores available.", m_prefetchThreads);
 }
 
 PatchGenerator::PatchGenerator(int width, int height, int depth, int level, float magnification, float percent, float maskThreshold, int paddingValue) : PatchGenerator() {
@@ -51,15 +55,7 @@ void PatchGenerator::loadAttributes() {
     setMaskThreshold(getFloatAttribute("mask-threshold"));
     setPaddingValue(getIntegerAttribute("padding-value"));
     setPatchMagnification(getFloatAttribute("patch-magnification"));
-}
-
-template <typename T>
-std::string to_string_with_precision(const T a_value, const int n = 6)
-{
-    std::ostringstream out;
-    out.precision(n);
-    out << std::fixed << a_value;
-    return std::move(out).str();
+    setPrefetch(getIntegerAttribute("prefetch"), getIntegerAttribute("prefetch-threads"));
 }
 
 void PatchGenerator::generateStream() {
@@ -109,22 +105,110 @@ void PatchGenerator::generateStream() {
             const int patchesX = std::ceil((float) levelWidth / (float) (patchWidthWithoutOverlap*resampleFactor));
             const int patchesY = std::ceil((float) levelHeight / (float) (patchHeightWithoutOverlap*resampleFactor));
 
-            bool useTileCache = true;
-            int tileCacheSize = -1;
             // No need to use tile cache if we are only going to get each tile exactly 1 time
             // This happens when the request patch size is the same as the tile size of the data
-            if((int)round(m_width*resampleFactor) == m_inputImagePyramid->getLevelTileWidth(level) && (int)round(m_height*resampleFactor) == m_inputImagePyramid->getLevelTileHeight(level)) {
-                useTileCache = false;
-            } else {
-                useTileCache = true;
-                int rowsPerPatch = std::ceil((float)m_inputImagePyramid->getLevelTileHeight(level) / m_height*resampleFactor);
-                tileCacheSize = patchesX*rowsPerPatch;
-                reportInfo() << "PatchGenerator is using a tile cache with size limit of " << tileCacheSize << reportEnd();
+            // Otherwise decoded tiles are kept in the process-wide TileCache, which is limited by TileCache::setMaximumSize
+            const bool useTileCache = !((int)round(m_width*resampleFactor) == m_inputImagePyramid->getLevelTileWidth(level) && (int)round(m_height*resampleFactor) == m_inputImagePyramid->getLevelTileHeight(level));
+            int paddingValue = m_paddingValue;
+            if(m_paddingValue < 0) {
+                if(m_inputImagePyramid->getNrOfChannels() > 1) {
+                    paddingValue = 255;
+                } else {
+                    paddingValue = 0;
+                }
             }
-            auto access = m_inputImagePyramid->getAccess(ACCESS_READ, useTileCache, tileCacheSize);
-            for(int patchY = 0; patchY < patchesY; ++patchY) {
-                for(int patchX = 0; patchX < patchesX; ++patchX) {
-                    mRuntimeManager->startRegularTimer("create patch");
+
+            // Extracts the pixels of a patch. Is run by the prefetch threads if enabled.
+            auto extractPatch = [=](ImagePyramidAccess* access, const PatchJob& job) {
+                auto patch = access->getPatchAsImage(level,
+                                                     job.offsetX < 0 ? 0 : job.offsetX, // if there is overlap, we will have negative offset at edges
+                                                     job.offsetY < 0 ? 0 : job.offsetY,
+                                                     job.width + (job.offsetX < 0 ? job.offsetX : 0), // We have to reduce width and height if negative offset
+                                                     job.height + (job.offsetY < 0 ? job.offsetY : 0));
+                // If patch does not have correct size, pad it
+                if(job.offsetX < 0 || job.offsetY < 0 || patch->getWidth() != (int)(m_width*resampleFactor) || patch->getHeight() != (int)(m_height*resampleFactor)) {
+                    // Edge cases, patches may not be the target patch size. Need to pad.
+                    patch = patch->crop(Vector2i(job.offsetX < 0 ? job.offsetX : 0, job.offsetY < 0 ? job.offsetY : 0), Vector2i(m_width*resampleFactor, m_height*resampleFactor), true, paddingValue);
+                }
+                if(resampleFactor > 1.0f) {
+                    patch = ImageResizer::create(m_width, m_height, 1, m_inputImagePyramid->getNrOfChannels() > 1)->connect(patch)->runAndGetOutputData<Image>();
+                }
+                return patch;
+            };
+
+            // Patches are extracted by a pool of prefetch threads, if enabled. Each thread has its own access object.
+            // The patches are emitted in the same order as they were queued, which is the same as when prefetching is disabled.
+            std::deque<std::shared_ptr<PatchJob>> window; // Patches in emission order
+            std::deque<std::shared_ptr<PatchJob>> queue; // Patches which have not been started yet
+            std::mutex mutex;
+            std::condition_variable jobQueued;
+            std::condition_variable jobDone;
+            bool stopThreads = false;
+            const int prefetchCount = m_prefetchCount > 0 ? m_prefetchCount : 1;
+            const int prefetchThreads = m_prefetchCount > 0 ? (m_prefetchThreads > 0 ? m_prefetchThreads : std::max(1, (int)std::thread::hardware_concurrency())) : 0;
+            std::vector<std::thread> threads;
+            for(int i = 0; i < prefetchThreads; ++i) {
+                threads.emplace_back([&]() {
+                    auto access = m_inputImagePyramid->getAccess(ACCESS_READ, useTileCache);
+                    while(true) {
+                        std::shared_ptr<PatchJob> job;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            jobQueued.wait(lock, [&] { return !queue.empty() || stopThreads; });
+                            if(stopThreads)
+                                return;
+                            job = queue.front();
+                            queue.pop_front();
+                        }
+                        try {
+                            job->patch = extractPatch(access.get(), *job);
+                        } catch(...) {
+                            job->error = std::current_exception();
+                        }
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            job->done = true;
+                        }
+                        jobDone.notify_all();
+                    }
+                });
+            }
+            auto stopPrefetchThreads = [&]() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopThreads = true;
+                }
+                jobQueued.notify_all();
+                for(auto& thread : threads)
+                    thread.join();
+                threads.clear();
+            };
+            // Used if prefetch is disabled
+            ImagePyramidAccess::pointer access;
+            if(prefetchThreads == 0)
+                access = m_inputImagePyramid->getAccess(ACCESS_READ, useTileCache);
+
+            // Frame data keys
+            static const FrameDataKey keyOriginalWidth = FrameData::getKey("original-width");
+            static const FrameDataKey keyOriginalHeight = FrameData::getKey("original-height");
+            static const FrameDataKey keyPatchIdX = FrameData::getKey("patchid-x");
+            static const FrameDataKey keyPatchIdY = FrameData::getKey("patchid-y");
+            static const FrameDataKey keyPatchWidth = FrameData::getKey("patch-width");
+            static const FrameDataKey keyPatchHeight = FrameData::getKey("patch-height");
+            static const FrameDataKey keyPatchOverlapX = FrameData::getKey("patch-overlap-x");
+            static const FrameDataKey keyPatchOverlapY = FrameData::getKey("patch-overlap-y");
+            static const FrameDataKey keyPatchSpacingX = FrameData::getKey("patch-spacing-x");
+            static const FrameDataKey keyPatchSpacingY = FrameData::getKey("patch-spacing-y");
+            static const FrameDataKey keyPatchLevel = FrameData::getKey("patch-level");
+            static const FrameDataKey keyProgress = FrameData::getKey("progress");
+            static const FrameDataKey keyStreaming = FrameData::getKey("streaming");
+
+            // Finds the next patch to extract, skipping patches outside the mask before any pixels are read.
+            int candidate = 0;
+            auto nextPatchJob = [&]() -> std::shared_ptr<PatchJob> {
+                for(; candidate < patchesX*patchesY; ++candidate) {
+                    const int patchX = candidate % patchesX;
+                    const int patchY = candidate / patchesX;
                     int patchWidth = m_width*resampleFactor;
                     if(patchWidth + (patchX*patchWidthWithoutOverlap - overlapInPixelsX)*resampleFactor >= levelWidth) {
                         patchWidth = levelWidth - (patchX * patchWidthWithoutOverlap - overlapInPixelsX)*resampleFactor;
@@ -139,7 +223,6 @@ void PatchGenerator::generateStream() {
                     if(m_inputMask) {
                         // If a mask exist, check if this patch should be included or not
                         // At least half of the patch should be clasified as foreground
-                        auto access = m_inputMask->getImageAccess(ACCESS_READ);
                         // Calculate physical position and size
                         float x = patchOffsetX * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().x();
                         float y = patchOffsetY * m_inputImagePyramid->getLevelScale(level) * m_inputImagePyramid->getSpacing().y();
@@ -162,53 +245,72 @@ void PatchGenerator::generateStream() {
                             continue;
                         }
                     }
-                    reportInfo() << "Generating patch " << patchX << " " << patchY << reportEnd();
                     if(patchWidth < overlapInPixelsX*2 || patchHeight < overlapInPixelsY*2)
                         continue;
-                    mRuntimeManager->startRegularTimer("getPatchAsImage");
-                    auto patch = access->getPatchAsImage(level,
-                                                         patchOffsetX < 0 ? 0 : patchOffsetX, // if there is overlap, we will have negative offset at edges
-                                                         patchOffsetY < 0 ? 0 : patchOffsetY,
-                                                         patchWidth + (patchOffsetX < 0 ? patchOffsetX : 0), // We have to reduce width and height if negative offset
-                                                         patchHeight + (patchOffsetY < 0 ? patchOffsetY : 0));
-                    mRuntimeManager->stopRegularTimer("getPatchAsImage");
-                    //access->getAllRuntimes()->printAll();
-
-                    // If patch does not have correct size, pad it
-                    int paddingValue = m_paddingValue;
-                    if(m_paddingValue < 0) {
-                        if(m_inputImagePyramid->getNrOfChannels() > 1) {
-                            paddingValue = 255;
-                        } else {
-                            paddingValue = 0;
-                        }
-                    }
-                    if(patchOffsetX < 0 || patchOffsetY < 0 || patch->getWidth() != (int)(m_width*resampleFactor) || patch->getHeight() != (int)(m_height*resampleFactor)) {
-                        // Edge cases, patches may not be the target patch size. Need to pad.
-                        patch = patch->crop(Vector2i(patchOffsetX < 0 ? patchOffsetX : 0, patchOffsetY < 0 ? patchOffsetY : 0), Vector2i(m_width*resampleFactor, m_height*resampleFactor), true, paddingValue);
+                    auto job = std::make_shared<PatchJob>();
+                    job->patchX = patchX;
+                    job->patchY = patchY;
+                    job->offsetX = patchOffsetX;
+                    job->offsetY = patchOffsetY;
+                    job->width = patchWidth;
+                    job->height = patchHeight;
+                    ++candidate;
+                    return job;
+                }
+                return nullptr;
+            };
+
+            try {
+                while(!m_stop) {
+                    // Fill the prefetch window
+                    while((int)window.size() < prefetchCount) {
+                        auto job = nextPatchJob();
+                        if(!job)
+                            break;
+                        std::lock_guard<std::mutex> lock(mutex);
+                        window.push_back(job);
+                        if(prefetchThreads > 0)
+                            queue.push_back(job);
                     }
-                    if(resampleFactor > 1.0f) {
-                        patch = ImageResizer::create(m_width, m_height, 1, m_inputImagePyramid->getNrOfChannels() > 1)->connect(patch)->runAndGetOutputData<Image>();
+                    if(window.empty())
+                        break;
+                    jobQueued.notify_all();
+
+                    auto job = window.front();
+                    window.pop_front();
+                    mRuntimeManager->startRegularTimer("create patch");
+                    reportInfo() << "Generating patch " << job->patchX << " " << job->patchY << reportEnd();
+                    if(prefetchThreads == 0) {
+                        mRuntimeManager->startRegularTimer("getPatchAsImage");
+                        job->patch = extractPatch(access.get(), *job);
+                        mRuntimeManager->stopRegularTimer("getPatchAsImage");
+                    } else {
+                        mRuntimeManager->startRegularTimer("wait for prefetch");
+                        std::unique_lock<std::mutex> lock(mutex);
+                        jobDone.wait(lock, [&] { return job->done; });
+                        mRuntimeManager->stopRegularTimer("wait for prefetch");
+                        if(job->error)
+                            std::rethrow_exception(job->error);
                     }
+                    auto patch = job->patch;
 
                     // Store some frame data useful for patch stitching
-                    patch->setFrameData("original-width", std::to_string(round(levelWidth/resampleFactor)));
-                    patch->setFrameData("original-height", std::to_string(round(levelHeight/resampleFactor)));
-                    patch->setFrameData("patchid-x", std::to_string(patchX));
-                    patch->setFrameData("patchid-y", std::to_string(patchY));
+                    patch->setFrameData(keyOriginalWidth, (int)round(levelWidth/resampleFactor));
+                    patch->setFrameData(keyOriginalHeight, (int)round(levelHeight/resampleFactor));
+                    patch->setFrameData(keyPatchIdX, job->patchX);
+                    patch->setFrameData(keyPatchIdY, job->patchY);
                     // Target width/height of patches
-                    patch->setFrameData("patch-width", std::to_string(m_width));
-                    patch->setFrameData("patch-height", std::to_string(m_height));
-                    patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                    patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                    // Image patch spacing of a WSI can be very small, and std::to_string can round the numbers,
-                    // and there is no way to set the precision, so we use a custom function instead.
-                    patch->setFrameData("patch-spacing-x", to_string_with_precision(patch->getSpacing().x(), 32));
-                    patch->setFrameData("patch-spacing-y", to_string_with_precision(patch->getSpacing().y(), 32));
-                    patch->setFrameData("patch-level", std::to_string(level));
-                    m_progress = (float)(patchX+patchY*patchesX)/(patchesX*patchesY);
-                    patch->setFrameData("progress", std::to_string(m_progress));
-                    patch->setFrameData("streaming", "yes"); // Since we are not propagating frame data, we have to set this
+                    patch->setFrameData(keyPatchWidth, m_width);
+                    patch->setFrameData(keyPatchHeight, m_height);
+                    patch->setFrameData(keyPatchOverlapX, overlapInPixelsX);
+                    patch->setFrameData(keyPatchOverlapY, overlapInPixelsY);
+                    // Image patch spacing of a WSI can be very small, thus store it as double
+                    patch->setFrameData(keyPatchSpacingX, (double)patch->getSpacing().x());
+                    patch->setFrameData(keyPatchSpacingY, (double)patch->getSpacing().y());
+                    patch->setFrameData(keyPatchLevel, level);
+                    m_progress = (float)(job->patchX+job->patchY*patchesX)/(patchesX*patchesY);
+                    patch->setFrameData(keyProgress, m_progress);
+                    patch->setFrameData(keyStreaming, "yes"); // Since we are not propagating frame data, we have to set this
 
                     mRuntimeManager->stopRegularTimer("create patch");
                     try {
@@ -221,14 +323,15 @@ void PatchGenerator::generateStream() {
                         break;
                     }
                     previousPatch = patch;
-                    if(m_stop)
-                        break;
-                }
-                if(m_stop) {
-                    //m_streamIsStarted = false;
-                    m_firstFrameIsInserted = false;
-                    break;
                 }
+            } catch(...) {
+                stopPrefetchThreads();
+                throw;
+            }
+            stopPrefetchThreads();
+            if(m_stop) {
+                //m_streamIsStarted = false;
+                m_firstFrameIsInserted = false;
             }
         } else if(m_inputVolume) { // Could be 3D or 2D
             const int width = m_inputVolume->getWidth();
@@ -275,28 +378,28 @@ void PatchGenerator::generateStream() {
                             }
                         }
                         auto patch = m_inputVolume->crop(Vector3i(x, y, z), Vector3i(m_width, m_height, m_depth), true, paddingValue);
-                        patch->setFrameData("original-width", std::to_string(width));
-                        patch->setFrameData("original-height", std::to_string(height));
-                        patch->setFrameData("original-depth", std::to_string(depth));
+                        patch->setFrameData("original-width", width);
+                        patch->setFrameData("original-height", height);
+                        patch->setFrameData("original-depth", depth);
                         patch->setFrameData("original-transform", transformString);
-                        patch->setFrameData("patch-offset-x", std::to_string(x));
-                        patch->setFrameData("patch-offset-y", std::to_string(y));
-                        patch->setFrameData("patch-offset-z", std::to_string(z));
-                        patch->setFrameData("patch-width", std::to_string(m_width));
-                        patch->setFrameData("patch-height", std::to_string(m_height));
-                        patch->setFrameData("patch-depth", std::to_string(m_depth));
-                        patch->setFrameData("patchid-x", std::to_string(patchX));
-                        patch->setFrameData("patchid-y", std::to_string(patchY));
-                        patch->setFrameData("patchid-z", std::to_string(patchZ));
-                        patch->setFrameData("patch-overlap-x", std::to_string(overlapInPixelsX));
-                        patch->setFrameData("patch-overlap-y", std::to_string(overlapInPixelsY));
-                        patch->setFrameData("patch-overlap-z", std::to_string(overlapInPixelsZ));
+                        patch->setFrameData("patch-offset-x", x);
+                        patch->setFrameData("patch-offset-y", y);
+                        patch->setFrameData("patch-offset-z", z);
+                        patch->setFrameData("patch-width", m_width);
+                        patch->setFrameData("patch-height", m_height);
+                        patch->setFrameData("patch-depth", m_depth);
+                        patch->setFrameData("patchid-x", patchX);
+                        patch->setFrameData("patchid-y", patchY);
+                        patch->setFrameData("patchid-z", patchZ);
+                        patch->setFrameData("patch-overlap-x", overlapInPixelsX);
+                        patch->setFrameData("patch-overlap-y", overlapInPixelsY);
+                        patch->setFrameData("patch-overlap-z", overlapInPixelsZ);
                         Vector3f spacing = m_inputVolume->getSpacing();
-                        patch->setFrameData("patch-spacing-x", std::to_string(spacing.x()));
-                        patch->setFrameData("patch-spacing-y", std::to_string(spacing.y()));
-                        patch->setFrameData("patch-spacing-z", std::to_string(spacing.z()));
+                        patch->setFrameData("patch-spacing-x", spacing.x());
+                        patch->setFrameData("patch-spacing-y", spacing.y());
+                        patch->setFrameData("patch-spacing-z", spacing.z());
                         m_progress = ((float)(patchX+patchY*patchesX+patchZ*patchesX*patchesY)/(patchesX*patchesY*patchesZ));
-                        patch->setFrameData("progress", std::to_string(m_progress));
+                        patch->setFrameData("progress", m_progress);
                         patch->setFrameData("streaming", "yes"); // Since we are not propagating frame data, we have to set this
                         try {
                             if(previousPatch) {
@@ -391,6 +494,14 @@ void PatchGenerator::setPatchMagnification(float magnification) {
     setModified(true);
 }
 
+void PatchGenerator::setPrefetch(int patches, int threads) {
+    if(patches < 0)
+        throw Exception("Nr of patches to prefetch must be >= 0");
+    m_prefetchCount = patches;
+    m_prefetchThreads = threads;
+    setModified(true);
+}
+
 float PatchGenerator::getProgress() {
     return m_progress;
 }
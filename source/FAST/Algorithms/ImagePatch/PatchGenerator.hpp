@@ -62,6 +62,18 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         void setMaskThreshold(float percent);
         void setPaddingValue(int paddingValue);
         void loadAttributes() override;
+        /**
+         * @brief Extract image pyramid patches in advance on multiple threads
+         *
+         * When enabled, the next patches are extracted (read, decoded, padded and resized) by a pool of threads while
+         * the current patch is processed downstream. Patches outside the mask are skipped before any pixels are read.
+         * Patches are still emitted in the same deterministic order as when prefetching is disabled.
+         * Only used for ImagePyramid input.
+         *
+         * @param patches Nr of patches to extract in advance. 0 (default) disables prefetching.
+         * @param threads Nr of threads to use. If <= 0, it will use the nr of cores available.
+         */
+        void setPrefetch(int patches, int threads = -1);
         /**
          * @brief Get progress of this patch generator in percent.
          * @return progress in percent 0.0-1.0
@@ -74,6 +86,8 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         int m_paddingValue = -1;
         float m_magnification = -1;
         float m_progress = 0.0f;
+        int m_prefetchCount = 0;
+        int m_prefetchThreads = -1;
 
         std::shared_ptr<ImagePyramid> m_inputImagePyramid;
         std::shared_ptr<Image> m_inputVolume;
@@ -84,5 +98,13 @@ class FAST_EXPORT PatchGenerator : public Streamer {
         void generateStream() override;
     private:
         PatchGenerator();
+        struct PatchJob {
+            int patchX, patchY;
+            int offsetX, offsetY;
+            int width, height;
+            std::shared_ptr<Image> patch;
+            std::exception_ptr error;
+            bool done = false;
+        };
 };
 }
\ No newline at end of file
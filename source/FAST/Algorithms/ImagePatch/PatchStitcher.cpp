@@ -4,6 +4,7 @@
 #include <FAST/Algorithms/NeuralNetwork/NeuralNetwork.hpp>
 #include <FAST/Algorithms/ImageResizer/ImageResizer.hpp>
 #include "PatchStitcher.hpp"
+#include <cstring>
 
 namespace fast {
 
@@ -48,6 +49,17 @@ void PatchStitcher::execute() {
     }
     mRuntimeManager->stopRegularTimer("stitch patch");
 
+    if(m_outputImagePyramid && m_pyramidUpdateInterval >= 0) {
+        // Update coarser levels with all patches stitched since last update
+        const auto now = std::chrono::steady_clock::now();
+        if(patch->isLastFrame() || (m_pyramidUpdateInterval > 0 && now - m_lastPyramidUpdate >= std::chrono::milliseconds(m_pyramidUpdateInterval))) {
+            mRuntimeManager->startRegularTimer("update pyramid levels");
+            m_outputImagePyramid->getAccess(ACCESS_READ_WRITE)->updatePyramidLevels();
+            mRuntimeManager->stopRegularTimer("update pyramid levels");
+            m_lastPyramidUpdate = now;
+        }
+    }
+
     if(m_outputImage) {
         addOutputData(0, m_outputImage);
     } else if(m_outputTensor) {
@@ -60,14 +72,14 @@ void PatchStitcher::execute() {
 }
 
 void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
 
-    const int patchWidth = std::stoi(patch->getFrameData("patch-width"))- 2*std::stoi(patch->getFrameData("patch-overlap-x"));;
-    const int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));;
+    const int patchWidth = patch->getFrameData<int>("patch-width")- 2*patch->getFrameData<int>("patch-overlap-x");;
+    const int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");;
 
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
     auto shape = patch->getShape();
     if(shape.getDimensions() != 1) {
@@ -78,39 +90,41 @@ void PatchStitcher::processTensor(std::shared_ptr<Tensor> patch) {
     if(!m_outputTensor) {
         // Create output tensor
         TensorShape fullShape({(int)std::ceil((float)fullHeight / patchHeight), (int)std::ceil((float)fullWidth / patchWidth), channels});
-        auto initializedData = std::make_unique<float[]>(fullShape.getTotalSize());
-        m_outputTensor = Tensor::create(std::move(initializedData), fullShape);
+        // Use same data type as patches, so that e.g. half precision network output stays half precision
+        m_outputTensor = Tensor::create(fullShape, patch->getDataType());
+        {
+            auto outputAccess = m_outputTensor->getAccess(ACCESS_READ_WRITE);
+            std::memset(outputAccess->get(), 0, m_outputTensor->getBufferSize());
+        }
         // TODO Use Y-X or X-Y ordering on spacing here? Changes will influence other objects
         m_outputTensor->setSpacing(Vector3f(patchHeight*patchSpacingY, patchWidth*patchSpacingX, 1.0f));
     }
     reportInfo() << "Stitching " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y") << reportEnd();
     reportInfo() << "Stitching data with spacing " << patch->getFrameData("patch-spacing-x") << " " << patch->getFrameData("patch-spacing-y") << reportEnd();
 
-    const int startX = std::stoi(patch->getFrameData("patchid-x"));
-    const int startY = std::stoi(patch->getFrameData("patchid-y"));
+    const int startX = patch->getFrameData<int>("patchid-x");
+    const int startY = patch->getFrameData<int>("patchid-y");
 
-    auto inputAccess = patch->getAccess(ACCESS_READ);
-    auto tensorData = inputAccess->getData<1>();
+    auto inputAccess = patch->convertToType(m_outputTensor->getDataType())->getAccess(ACCESS_READ);
     auto outputAccess = m_outputTensor->getAccess(ACCESS_READ_WRITE);
-    auto outputTensorData = outputAccess->getData<3>();
-
-    for(int i = 0; i < channels; ++i) {
-        outputTensorData(startY, startX, i) = tensorData(i);
-    }
+    const auto outputShape = m_outputTensor->getShape();
+    const std::size_t bytes = getSizeOfDataType(m_outputTensor->getDataType(), channels);
+    auto outputData = (uchar*)outputAccess->get();
+    std::memcpy(&outputData[((std::size_t)startY*outputShape[1] + startX)*bytes], inputAccess->get(), bytes);
 }
 
 void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
-    const int fullWidth = std::stoi(patch->getFrameData("original-width"));
-    const int fullHeight = std::stoi(patch->getFrameData("original-height"));
-    const float patchSpacingX = std::stof(patch->getFrameData("patch-spacing-x"));
-    const float patchSpacingY = std::stof(patch->getFrameData("patch-spacing-y"));
+    const int fullWidth = patch->getFrameData<int>("original-width");
+    const int fullHeight = patch->getFrameData<int>("original-height");
+    const float patchSpacingX = patch->getFrameData<float>("patch-spacing-x");
+    const float patchSpacingY = patch->getFrameData<float>("patch-spacing-y");
 
     int fullDepth = 1;
     float patchSpacingZ = 1.0f;
     bool is3D = true;
     try {
-        fullDepth = std::stoi(patch->getFrameData("original-depth"));
-        patchSpacingZ = std::stof(patch->getFrameData("patch-spacing-z"));
+        fullDepth = patch->getFrameData<int>("original-depth");
+        patchSpacingZ = patch->getFrameData<float>("patch-spacing-z");
         if(fullDepth == 1)
             is3D = false;
     } catch(Exception &e) {
@@ -128,8 +142,8 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
 				m_outputImage = Image::create(fullWidth, fullHeight, patch->getDataType(), patch->getNrOfChannels());
             } else {
                 // Large image, create image pyramid instead
-                int patchWidth = std::stoi(patch->getFrameData("patch-width")) - 2*std::stoi(patch->getFrameData("patch-overlap-x"));
-                int patchHeight = std::stoi(patch->getFrameData("patch-height")) - 2*std::stoi(patch->getFrameData("patch-overlap-y"));
+                int patchWidth = patch->getFrameData<int>("patch-width") - 2*patch->getFrameData<int>("patch-overlap-x");
+                int patchHeight = patch->getFrameData<int>("patch-height") - 2*patch->getFrameData<int>("patch-overlap-y");
                 m_outputImagePyramid = ImagePyramid::create(fullWidth, fullHeight, patch->getNrOfChannels(), patchWidth, patchHeight);
                 reportInfo() << "Patch stitcher creating image PYRAMID with size " << fullWidth << " " << fullHeight << ", patch size: " <<
                     patchWidth << " " << patchHeight << " Levels: " << m_outputImagePyramid->getNrOfLevels() << reportEnd();
@@ -166,16 +180,16 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
 		reportInfo() << "Stitching 2D data " << patch->getFrameData("patchid-x") << " " << patch->getFrameData("patchid-y")
 			<< reportEnd();
 
-        const int patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-        const int patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
+        const int patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+        const int patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
         // Calculate offset. If this calculation is incorrect. Update in ImagePyramidPatchExporter as well.
         // Position of where to insert the (cropped) patch
-        const int patchWidth = std::stoi(patch->getFrameData("patch-width"));
-        const int patchHeight = std::stoi(patch->getFrameData("patch-height"));
+        const int patchWidth = patch->getFrameData<int>("patch-width");
+        const int patchHeight = patch->getFrameData<int>("patch-height");
         const int patchWidthWithoutOverlap = patchWidth - patchOverlapX*2;
         const int patchHeightWithoutOverlap = patchHeight - patchOverlapY*2;
-        const int startX = std::stoi(patch->getFrameData("patchid-x")) * patchWidthWithoutOverlap;
-        const int startY = std::stoi(patch->getFrameData("patchid-y")) * patchHeightWithoutOverlap;
+        const int startX = patch->getFrameData<int>("patchid-x") * patchWidthWithoutOverlap;
+        const int startY = patch->getFrameData<int>("patchid-y") * patchHeightWithoutOverlap;
         if(m_outputImage) {
             // 2D image
             cl::Program program = getOpenCLProgram(device, "2D");
@@ -219,15 +233,15 @@ void PatchStitcher::processImage(std::shared_ptr<Image> patch) {
                 int diffY = patch->getHeight() - m_outputImagePyramid->getLevelTileHeight(0);
                 patch = patch->crop(Vector2i(diffX/2, diffY/2), Vector2i(patch->getWidth()-diffX, patch->getHeight()-diffY));
             }
-            outputAccess->setPatch(0, startX, startY, patch);
+            outputAccess->setPatch(0, startX, startY, patch, m_pyramidUpdateInterval < 0);
             mRuntimeManager->stopRegularTimer("copy patch");
         }
     } else {
         // 3D
         // TODO overlap not implemented for 3D
-        const int startX = std::stoi(patch->getFrameData("patch-offset-x"));
-        const int startY = std::stoi(patch->getFrameData("patch-offset-y"));
-        const int startZ = std::stoi(patch->getFrameData("patch-offset-z"));
+        const int startX = patch->getFrameData<int>("patch-offset-x");
+        const int startY = patch->getFrameData<int>("patch-offset-y");
+        const int startZ = patch->getFrameData<int>("patch-offset-z");
         const int endX = startX + patch->getWidth();
         const int endY = startY + patch->getHeight();
         reportInfo() << "Stitching " << startZ << reportEnd();
@@ -321,5 +335,14 @@ bool PatchStitcher::getForceImagePyramidOutput() const {
     return m_forceImagePyramidOutput;
 }
 
+void PatchStitcher::setPyramidUpdateInterval(int milliseconds) {
+    m_pyramidUpdateInterval = milliseconds;
+    setModified(true);
+}
+
+int PatchStitcher::getPyramidUpdateInterval() const {
+    return m_pyramidUpdateInterval;
+}
+
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <FAST/ProcessObject.hpp>
+#include <chrono>
 
 namespace fast {
 
@@ -55,6 +56,18 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
          * @return
          */
         bool getForceImagePyramidOutput() const;
+        /**
+         * @brief Set how often the coarser levels of an output image pyramid are updated while stitching
+         *
+         * Patches are only written to the full resolution level while stitching. The coarser levels are updated
+         * for the regions which have changed at most this often, so that the pyramid can be viewed while it is created,
+         * and all remaining levels are updated when the last patch arrives.
+         *
+         * @param milliseconds Minimum time between updates. 0 only updates the levels when the last patch arrives.
+         *      A negative value updates all levels for every patch.
+         */
+        void setPyramidUpdateInterval(int milliseconds);
+        int getPyramidUpdateInterval() const;
     protected:
         void execute() override;
 
@@ -67,6 +80,8 @@ class FAST_EXPORT PatchStitcher : public ProcessObject {
     private:
         bool m_patchesAreCropped = false;
         bool m_forceImagePyramidOutput = false;
+        int m_pyramidUpdateInterval = 1000;
+        std::chrono::steady_clock::time_point m_lastPyramidUpdate;
 
 };
 
@@ -39,6 +39,37 @@ TEST_CASE("Patch generator for WSI", "[fast][wsi][PatchGenerator]") {
     REQUIRE(nrOfPatches == counter);
 }
 
+TEST_CASE("Patch generator for WSI with prefetching", "[fast][wsi][PatchGenerator]") {
+    auto importer = WholeSlideImageImporter::create(Config::getTestDataPath() + "/WSI/CMU-1.svs");
+    auto wsi = importer->runAndGetOutputData<ImagePyramid>();
+    auto mask = TissueSegmentation::create()->connect(wsi)->runAndGetOutputData<Image>();
+
+    const int level = 2;
+    const int width = 512;
+    const int height = 256;
+    // Prefetching should give the same patches in the same order
+    std::vector<std::pair<std::string, float>> patches[2];
+    for(int i = 0; i < 2; ++i) {
+        auto generator = PatchGenerator::create(width, height, 1, level)
+                ->connect(wsi)
+                ->connect(1, mask);
+        if(i == 1)
+            generator->setPrefetch(16, 4);
+        auto stream = DataStream(generator);
+        while(!stream.isDone()) {
+            auto image = stream.getNextFrame<Image>();
+            REQUIRE(image->getWidth() == width);
+            REQUIRE(image->getHeight() == height);
+            patches[i].push_back({image->getFrameData("patchid-x") + "_" + image->getFrameData("patchid-y"), image->calculateAverageIntensity()});
+        }
+    }
+    REQUIRE(patches[0].size() == patches[1].size());
+    for(int i = 0; i < patches[0].size(); ++i) {
+        CHECK(patches[0][i].first == patches[1][i].first);
+        CHECK(patches[0][i].second == Approx(patches[1][i].second));
+    }
+}
+
 TEST_CASE("Patch generator on 2D image", "[fast][PatchGenerator]") {
     auto importer = ImageFileImporter::create(Config::getTestDataPath() + "/US/US-2D.jpg");
     auto image = importer->runAndGetOutputData<Image>();
@@ -69,44 +69,29 @@ inline Vector3f RGB2YIQ(Vector3f rgb) {
 }
 
 /**
- * Create a new matrix which is matrix A rearranged.
- * This matrix has the same size as B
+ * Get points used to find closest points: Position, and if colors are used, weighted color in YIQ space
  */
-inline MatrixXf rearrangeMatrixToClosestPoints(const MatrixXf& A, const MatrixXf& B, const MatrixXf& Acolors, const MatrixXf& Bcolors, float colorWeight) {
-    MatrixXf result = MatrixXf::Constant(B.rows(), B.cols(), 0);
-
-    Vector3f colorWeights(100.0, 1000.0, 1000.0);
-    // For each point in B, find the closest point in A
-#pragma omp parallel for
-    for(int b = 0; b < B.cols(); ++b) {
-        Vector3f pointInB = B.col(b);
-        Vector3f Bcolor = RGB2YIQ(Bcolors.col(b));
-        float minDistance = std::numeric_limits<float>::max();
-        uint closestPoint = 0;
-        for(int a = 0; a < A.cols(); ++a) {
-            Vector3f pointInA = A.col(a);
-            Vector3f Acolor = RGB2YIQ(Acolors.col(a));
-            VectorXf distanceVector = VectorXf::Zero(6);
-            distanceVector.head(3) = pointInA - pointInB;
-            distanceVector(3) = (Acolor.x() - Bcolor.x())*colorWeights.x();
-            distanceVector(4) = (Acolor.y() - Bcolor.y())*colorWeights.y();
-            distanceVector(5) = (Acolor.z() - Bcolor.z())*colorWeights.z();
-            //std::cout << distanceVector.tail(3) << std::endl;
-            float distance = distanceVector.norm();
-            //float distance = (pointInA-pointInB).norm();
-            //std::cout << colorDistance(Acolor, Bcolor) << std::endl;
-            //if(colorDistance(Acolor, Bcolor) < 100) {
-                if(distance < minDistance) {
-                    minDistance = distance;
-                    closestPoint = a;
-                }
-            //}
-        }
-        result.col(b) = A.col(closestPoint);
-    }
-
+inline MatrixXf getSearchPoints(const MatrixXf& points, const MatrixXf& colors, bool useColors) {
+    if(!useColors)
+        return points;
+    const Vector3f colorWeights(100.0, 1000.0, 1000.0);
+    MatrixXf result(6, points.cols());
+    result.topRows<3>() = points;
+    for(int i = 0; i < points.cols(); ++i)
+        result.col(i).tail<3>() = RGB2YIQ(colors.col(i)).cwiseProduct(colorWeights);
     return result;
+}
 
+/**
+ * Create a new matrix which is matrix A rearranged.
+ * Column i is the point in A closest to column i of B.
+ */
+inline MatrixXf rearrangeMatrixToClosestPoints(const MatrixXf& A, const NearestNeighbourSearch& searchA, const MatrixXf& B) {
+    std::vector<int> closestPoints = searchA.findNearest(B);
+    MatrixXf result(A.rows(), B.cols());
+    for(int b = 0; b < B.cols(); ++b)
+        result.col(b) = A.col(closestPoints[b]);
+    return result;
 }
 
 /*
@@ -243,14 +228,36 @@ void IterativeClosestPoint::execute() {
     }
     fixedPoints = fixedPointTransform*fixedPoints.colwise().homogeneous();
 
-    float colorWeight = 1.0f;
+    // If all fixed points have the same color, color doesn't affect which fixed point is closest,
+    // and closest points can be found using position only.
+    const bool useColors = fixedColors.cols() > 1 &&
+            !(fixedColors.colwise() - fixedColors.col(0)).isZero();
+
+    // Build index of fixed points once, or reuse index from last execute if fixed points are unchanged
+    mRuntimeManager->startRegularTimer("build_index");
+    const bool reuseIndex = mDistanceThreshold <= 0 && m_fixedSearch &&
+            m_fixedSearchMesh.lock() == fixedMesh &&
+            m_fixedSearchTimestamp == fixedMesh->getTimestamp() &&
+            m_fixedSearchTransform == fixedPointTransform.matrix() &&
+            m_fixedSearchPoints.cols() == fixedPoints.cols();
+    if(reuseIndex) {
+        reportInfo() << "Reusing nearest neighbour index of fixed points in ICP" << reportEnd();
+    } else {
+        m_fixedSearch = NearestNeighbourSearch::create(getSearchPoints(fixedPoints, fixedColors, useColors), m_nearestNeighbourSearchMethod);
+        m_fixedSearchPoints = fixedPoints;
+        m_fixedSearchMesh = fixedMesh;
+        m_fixedSearchTimestamp = fixedMesh->getTimestamp();
+        m_fixedSearchTransform = fixedPointTransform.matrix();
+    }
+    mRuntimeManager->stopRegularTimer("build_index");
+    MatrixXf movingSearchPoints = getSearchPoints(movingPoints, movingColors, useColors);
 
     // Want to choose the smallest one as moving
     bool invertTransform = false;
 	MatrixXf movedPoints = currentTransformation*(movingPoints.colwise().homogeneous());
     // Match closest points using current transformation
-    MatrixXf rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-            fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+    movingSearchPoints.topRows<3>() = movedPoints;
+    MatrixXf rearrangedFixedPoints = rearrangeMatrixToClosestPoints(fixedPoints, *m_fixedSearch, movingSearchPoints);
     do {
         previousError = error;        
 
@@ -301,8 +308,8 @@ void IterativeClosestPoint::execute() {
         // Calculate RMS error
         // Should we rearrange the points here?
         mRuntimeManager->startRegularTimer("find_closest");
-        rearrangedFixedPoints = rearrangeMatrixToClosestPoints(
-                fixedPoints, movedPoints, fixedColors, movingColors, colorWeight);
+        movingSearchPoints.topRows<3>() = movedPoints;
+        rearrangedFixedPoints = rearrangeMatrixToClosestPoints(fixedPoints, *m_fixedSearch, movingSearchPoints);
         mRuntimeManager->stopRegularTimer("find_closest");
 		MatrixXf distance = rearrangedFixedPoints - movedPoints;
         error = 0;
@@ -344,4 +351,14 @@ void IterativeClosestPoint::setMinimumErrorChange(float errorChange) {
     mMinErrorChange = errorChange;
 }
 
+void IterativeClosestPoint::setNearestNeighbourSearchMethod(NearestNeighbourSearchMethod method) {
+    m_nearestNeighbourSearchMethod = method;
+    m_fixedSearch.reset();
+    mIsModified = true;
+}
+
+NearestNeighbourSearchMethod IterativeClosestPoint::getNearestNeighbourSearchMethod() const {
+    return m_nearestNeighbourSearchMethod;
+}
+
 }
@@ -2,6 +2,7 @@
 
 #include "FAST/ProcessObject.hpp"
 #include "FAST/Data/Mesh.hpp"
+#include "FAST/Algorithms/NearestNeighbourSearch/NearestNeighbourSearch.hpp"
 
 namespace fast {
 
@@ -44,6 +45,15 @@ class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
         void setMaximumNrOfIterations(uint iterations);
         void setRandomPointSampling(uint nrOfPointsToSample);
         void setDistanceThreshold(float distance);
+        /**
+         * @brief Set spatial index used to find closest points. Default is k-d tree.
+         *
+         * The index of the fixed points is built once per execute, and reused in later executes
+         * if the fixed mesh and its transform are unchanged and no distance threshold is set.
+         * @param method
+         */
+        void setNearestNeighbourSearchMethod(NearestNeighbourSearchMethod method);
+        NearestNeighbourSearchMethod getNearestNeighbourSearchMethod() const;
     private:
         void execute();
 
@@ -54,6 +64,13 @@ class FAST_EXPORT  IterativeClosestPoint : public ProcessObject {
         float mError;
         Transform::pointer mTransformation;
         IterativeClosestPoint::TransformationType mTransformationType;
+        NearestNeighbourSearchMethod m_nearestNeighbourSearchMethod = NearestNeighbourSearchMethod::KD_TREE;
+        // Index of fixed points, kept between executes
+        NearestNeighbourSearch::pointer m_fixedSearch;
+        MatrixXf m_fixedSearchPoints;
+        std::weak_ptr<Mesh> m_fixedSearchMesh;
+        uint64_t m_fixedSearchTimestamp;
+        Matrix4f m_fixedSearchTransform;
 };
 
 } // end namespace fast
@@ -1,6 +1,7 @@
 #include "FAST/Testing.hpp"
 #include "FAST/Algorithms/IterativeClosestPoint/IterativeClosestPoint.hpp"
 #include "FAST/Importers/VTKMeshFileImporter.hpp"
+#include <iostream>
 
 namespace fast {
 
@@ -161,5 +162,45 @@ TEST_CASE("ICP on two point sets which are already transformed by scene graph",
 }
 
 
+TEST_CASE("ICP nearest neighbour search benchmark", "[fast][IterativeClosestPoint][icp][benchmark]") {
+    const int iterations = 10;
+    for(int size : {1000, 4000, 16000}) {
+        // Points evenly spread on a sphere
+        std::vector<MeshVertex> vertices;
+        const float goldenAngle = M_PI*(3.0f - std::sqrt(5.0f));
+        for(int i = 0; i < size; ++i) {
+            const float z = 1.0f - 2.0f*(i + 0.5f)/size;
+            const float radius = std::sqrt(1.0f - z*z);
+            vertices.push_back(MeshVertex(Vector3f(std::cos(goldenAngle*i)*radius, std::sin(goldenAngle*i)*radius, z*0.5f)*50.0f));
+        }
+        auto fixed = Mesh::create(vertices);
+        auto moving = Mesh::create(vertices);
+        Affine3f transform = Affine3f::Identity();
+        transform.translate(Vector3f(1.0f, 0.5f, 0.0f));
+        transform.rotate(Eigen::AngleAxisf(0.05f, Vector3f::UnitZ()));
+        moving->getSceneGraphNode()->setTransform(transform);
+
+        Matrix4f bruteForceResult;
+        for(auto method : {NearestNeighbourSearchMethod::BRUTE_FORCE, NearestNeighbourSearchMethod::KD_TREE, NearestNeighbourSearchMethod::VOXEL_GRID}) {
+            // Negative min error change to always run all iterations
+            auto icp = IterativeClosestPoint::create(IterativeClosestPoint::RIGID, iterations, -1.0f)
+                    ->connectFixed(fixed)
+                    ->connectMoving(moving);
+            icp->setNearestNeighbourSearchMethod(method);
+            icp->enableRuntimeMeasurements();
+            icp->run();
+            const std::string name = method == NearestNeighbourSearchMethod::BRUTE_FORCE ? "brute force" :
+                    (method == NearestNeighbourSearchMethod::KD_TREE ? "k-d tree" : "voxel grid");
+            std::cout << size << " points " << name << ": build index " << icp->getRuntime("build_index")->getAverage()
+                << " ms, find closest " << icp->getRuntime("find_closest")->getAverage() << " ms per iteration" << std::endl;
+            const Matrix4f result = icp->getOutputTransformation()->get().matrix();
+            if(method == NearestNeighbourSearchMethod::BRUTE_FORCE) {
+                bruteForceResult = result;
+            } else {
+                CHECK(result.isApprox(bruteForceResult, 1e-4f));
+            }
+        }
+    }
+}
 
 } // end namespace fast
@@ -15,13 +15,28 @@ __kernel void updateLevelSetFunction(
         __private float threshold,
         __private float epsilon,
         __private float alpha,
-        PHI_WRITE_TYPE speedStorage,
-        __private float deltaT
+        __global int* reduction,
+        __private float deltaT,
+        __private float bandWidth
 ) {
     int x = get_global_id(0);
     int y = get_global_id(1);
     int z = get_global_id(2);
     const int4 pos = {x,y,z,0};
+    const float phiValue = read_imagef(phi_read,sampler,pos).x;
+
+    // Only update the narrow band around the zero level set, and the voxels next to it so that the band can move.
+    // Phi is clamped to +-bandWidth, thus all other voxels are far from the zero level set.
+    if(fabs(phiValue) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x+1,y,z,0)).x) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x-1,y,z,0)).x) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x,y+1,z,0)).x) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x,y-1,z,0)).x) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x,y,z+1,0)).x) >= bandWidth &&
+            fabs(read_imagef(phi_read,sampler,(int4)(x,y,z-1,0)).x) >= bandWidth) {
+        WRITE_RESULT(phi_write, pos, phiValue);
+        return;
+    }
 
     // Calculate all first order derivatives
     float3 D = {
@@ -111,22 +126,30 @@ __kernel void updateLevelSetFunction(
     if(length(gradient) > 1.0f)
         gradient = normalize(gradient);
 
-    // Stability CFL
-    // max(fabs(speed*gradient.length()))
-    WRITE_RESULT(speedStorage, pos, fabs(speed*length(gradient)));
-
     // Update the level set function phi
-    WRITE_RESULT(phi_write, pos, read_imagef(phi_read,sampler,pos).x + deltaT*speed*length(gradient));
+    const float change = speed*length(gradient);
+    const float newValue = clamp(phiValue + deltaT*change, -bandWidth, bandWidth);
+    WRITE_RESULT(phi_write, pos, newValue);
+
+    // Stability CFL: max(fabs(speed*gradient.length())) of the updated voxels.
+    // Non-negative floats have the same order as their bits interpreted as integers.
+    atomic_max(&reduction[0], as_int(fabs(change)));
+    // Count voxels which changed side of the zero level set, used to detect convergence
+    if((newValue <= 0.0f) != (phiValue <= 0.0f))
+        atomic_inc(&reduction[1]);
 }
 
 __kernel void initializeLevelSetFunction(
         PHI_WRITE_TYPE phi,
-        __private int seedX,
-        __private int seedY,
-        __private int seedZ,
-        __private float radius
+        __global const float4* seeds, // x, y, z, radius
+        __private int seedCount,
+        __private float bandWidth
 ) {
     const int4 pos = {get_global_id(0), get_global_id(1), get_global_id(2), 0};
 
-    WRITE_RESULT(phi, pos, distance((float3)(seedX,seedY,seedZ), convert_float3(pos.xyz)) - radius);
+    // Union of all seed spheres
+    float value = bandWidth;
+    for(int i = 0; i < seedCount; ++i)
+        value = min(value, distance(seeds[i].xyz, convert_float3(pos.xyz)) - seeds[i].w);
+    WRITE_RESULT(phi, pos, max(value, -bandWidth));
 }
\ No newline at end of file
@@ -1,9 +1,295 @@
 #include "LevelSetSegmentation.hpp"
 #include "FAST/Data/Image.hpp"
 #include "FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp"
+#include "FAST/ThreadPool.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <queue>
 
 namespace fast {
 
+namespace {
+
+// Voxels outside the narrow band have a level set function value of +/- the band width
+const float bandWidth = 4.0f;
+// The band is rebuilt if the zero level set reaches a voxel this far from where it was when the band was built,
+// or after a fixed nr of iterations to keep the level set function close to a distance function.
+const float landMineDistance = 2.5f;
+const int reinitializationInterval = 20;
+
+/**
+ * Level set function where only voxels within a narrow band of the zero level set are stored in the band list.
+ * Negative values are inside the segmentation.
+ */
+class NarrowBand {
+    public:
+        explicit NarrowBand(Vector3i size);
+        void addSeed(Vector3i position, float radius);
+        /**
+         * Set the level set function in the band to the distance to the zero level set, using fast marching.
+         * The zero level set is estimated by linear interpolation between voxels of different sign.
+         */
+        void reinitialize();
+        /**
+         * Speed multiplied with the upwind gradient magnitude of a voxel in the band, same as the OpenCL kernel.
+         */
+        float getUpdate(int64_t index, float intensity, float mean, float variance, float curvatureWeight) const;
+
+        std::vector<float> phi;
+        std::vector<int64_t> band;
+        std::vector<uchar> landMines; // Per band voxel
+    private:
+        float get(int x, int y, int z) const;
+        float solveEikonal(int64_t index) const;
+        void updateNeighbours(int64_t index, std::priority_queue<std::pair<float, int64_t>, std::vector<std::pair<float, int64_t>>, std::greater<std::pair<float, int64_t>>>& trials);
+
+        Vector3i m_size;
+        std::vector<uchar> m_known; // Fast marching state, only set while reinitializing
+};
+
+NarrowBand::NarrowBand(Vector3i size) : m_size(size) {
+    phi.resize((int64_t)size.x()*size.y()*size.z(), bandWidth);
+    m_known.resize(phi.size(), 0);
+}
+
+void NarrowBand::addSeed(Vector3i position, float radius) {
+    const Vector3i start = (position.array() - (int)std::ceil(radius + bandWidth)).max(0);
+    const Vector3i end = (position.array() + (int)std::ceil(radius + bandWidth)).min(m_size.array() - 1);
+    for(int z = start.z(); z <= end.z(); ++z) {
+        for(int y = start.y(); y <= end.y(); ++y) {
+            for(int x = start.x(); x <= end.x(); ++x) {
+                const int64_t index = x + ((int64_t)y + (int64_t)z*m_size.y())*m_size.x();
+                const float distance = (Vector3f(x, y, z) - position.cast<float>()).norm() - radius;
+                // Union of all seeds
+                if(distance < phi[index]) {
+                    if(std::abs(phi[index]) >= bandWidth && distance > -bandWidth)
+                        band.push_back(index);
+                    phi[index] = std::max(distance, -bandWidth);
+                }
+            }
+        }
+    }
+}
+
+float NarrowBand::get(int x, int y, int z) const {
+    // Clamp to edge, as the OpenCL sampler
+    x = std::min(std::max(x, 0), m_size.x() - 1);
+    y = std::min(std::max(y, 0), m_size.y() - 1);
+    z = std::min(std::max(z, 0), m_size.z() - 1);
+    return phi[x + ((int64_t)y + (int64_t)z*m_size.y())*m_size.x()];
+}
+
+float NarrowBand::getUpdate(int64_t index, float intensity, float mean, float variance, float curvatureWeight) const {
+    const int x = index % m_size.x();
+    const int y = (index / m_size.x()) % m_size.y();
+    const int z = index / ((int64_t)m_size.x()*m_size.y());
+    const float value = phi[index];
+
+    // Calculate all first order derivatives
+    const Vector3f D(
+            0.5f*(get(x+1,y,z) - get(x-1,y,z)),
+            0.5f*(get(x,y+1,z) - get(x,y-1,z)),
+            0.5f*(get(x,y,z+1) - get(x,y,z-1))
+    );
+    const Vector3f Dminus(value - get(x-1,y,z), value - get(x,y-1,z), value - get(x,y,z-1));
+    const Vector3f Dplus(get(x+1,y,z) - value, get(x,y+1,z) - value, get(x,y,z+1) - value);
+
+    // Calculate all second order derivatives
+    const Vector3f DxMinus(
+            0.0f,
+            0.5f*(get(x+1,y-1,z) - get(x-1,y-1,z)),
+            0.5f*(get(x+1,y,z-1) - get(x-1,y,z-1))
+    );
+    const Vector3f DxPlus(
+            0.0f,
+            0.5f*(get(x+1,y+1,z) - get(x-1,y+1,z)),
+            0.5f*(get(x+1,y,z+1) - get(x-1,y,z+1))
+    );
+    const Vector3f DyMinus(
+            0.5f*(get(x-1,y+1,z) - get(x-1,y-1,z)),
+            0.0f,
+            0.5f*(get(x,y+1,z-1) - get(x,y-1,z-1))
+    );
+    const Vector3f DyPlus(
+            0.5f*(get(x+1,y+1,z) - get(x+1,y-1,z)),
+            0.0f,
+            0.5f*(get(x,y+1,z+1) - get(x,y-1,z+1))
+    );
+    const Vector3f DzMinus(
+            0.5f*(get(x-1,y,z+1) - get(x-1,y,z-1)),
+            0.5f*(get(x,y-1,z+1) - get(x,y-1,z-1)),
+            0.0f
+    );
+    const Vector3f DzPlus(
+            0.5f*(get(x+1,y,z+1) - get(x+1,y,z-1)),
+            0.5f*(get(x,y+1,z+1) - get(x,y+1,z-1)),
+            0.0f
+    );
+
+    // Calculate curvature
+    auto square = [](float v) { return v*v; };
+    const float epsilon = std::numeric_limits<float>::epsilon();
+    const Vector3f nMinus(
+            Dminus.x() / std::sqrt(epsilon + square(Dminus.x()) + square(0.5f*(DyMinus.x() + D.y())) + square(0.5f*(DzMinus.x() + D.z()))),
+            Dminus.y() / std::sqrt(epsilon + square(Dminus.y()) + square(0.5f*(DxMinus.y() + D.x())) + square(0.5f*(DzMinus.y() + D.z()))),
+            Dminus.z() / std::sqrt(epsilon + square(Dminus.z()) + square(0.5f*(DxMinus.z() + D.x())) + square(0.5f*(DyMinus.z() + D.y())))
+    );
+    const Vector3f nPlus(
+            Dplus.x() / std::sqrt(epsilon + square(Dplus.x()) + square(0.5f*(DyPlus.x() + D.y())) + square(0.5f*(DzPlus.x() + D.z()))),
+            Dplus.y() / std::sqrt(epsilon + square(Dplus.y()) + square(0.5f*(DxPlus.y() + D.x())) + square(0.5f*(DzPlus.y() + D.z()))),
+            Dplus.z() / std::sqrt(epsilon + square(Dplus.z()) + square(0.5f*(DxPlus.z() + D.x())) + square(0.5f*(DyPlus.z() + D.y())))
+    );
+    const float curvature = (nPlus - nMinus).sum()*0.5f;
+
+    // Calculate speed term
+    const float speed = -(1.0f - curvatureWeight)*std::max(-variance, variance - std::abs(mean - intensity))/variance + curvatureWeight*curvature;
+
+    // Determine upwind gradient based on speed direction
+    float gradientLength;
+    if(speed < 0) {
+        gradientLength = Vector3f(
+                std::sqrt(square(std::min(Dplus.x(), 0.0f)) + square(std::min(-Dminus.x(), 0.0f))),
+                std::sqrt(square(std::min(Dplus.y(), 0.0f)) + square(std::min(-Dminus.y(), 0.0f))),
+                std::sqrt(square(std::min(Dplus.z(), 0.0f)) + square(std::min(-Dminus.z(), 0.0f)))
+        ).norm();
+    } else {
+        gradientLength = Vector3f(
+                std::sqrt(square(std::max(Dplus.x(), 0.0f)) + square(std::max(-Dminus.x(), 0.0f))),
+                std::sqrt(square(std::max(Dplus.y(), 0.0f)) + square(std::max(-Dminus.y(), 0.0f))),
+                std::sqrt(square(std::max(Dplus.z(), 0.0f)) + square(std::max(-Dminus.z(), 0.0f)))
+        ).norm();
+    }
+
+    return speed*std::min(gradientLength, 1.0f);
+}
+
+float NarrowBand::solveEikonal(int64_t index) const {
+    const int64_t strides[3] = {1, m_size.x(), (int64_t)m_size.x()*m_size.y()};
+    const int position[3] = {
+            (int)(index % m_size.x()),
+            (int)((index / m_size.x()) % m_size.y()),
+            (int)(index / strides[2])
+    };
+    // Smallest known distance along each axis
+    float a[3];
+    for(int axis = 0; axis < 3; ++axis) {
+        a[axis] = std::numeric_limits<float>::max();
+        if(position[axis] > 0 && m_known[index - strides[axis]])
+            a[axis] = std::abs(phi[index - strides[axis]]);
+        if(position[axis] < m_size[axis] - 1 && m_known[index + strides[axis]])
+            a[axis] = std::min(a[axis], std::abs(phi[index + strides[axis]]));
+    }
+    std::sort(a, a + 3);
+
+    // First order solution of |grad distance| = 1, using as many axes as give a distance larger than their neighbours
+    float distance = a[0] + 1.0f;
+    if(distance > a[1]) {
+        distance = 0.5f*(a[0] + a[1] + std::sqrt(2.0f - (a[0] - a[1])*(a[0] - a[1])));
+        if(distance > a[2]) {
+            const float sum = a[0] + a[1] + a[2];
+            const float squaredSum = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+            distance = (sum + std::sqrt(std::max(sum*sum - 3.0f*(squaredSum - 1.0f), 0.0f))) / 3.0f;
+        }
+    }
+    return distance;
+}
+
+void NarrowBand::updateNeighbours(int64_t index, std::priority_queue<std::pair<float, int64_t>, std::vector<std::pair<float, int64_t>>, std::greater<std::pair<float, int64_t>>>& trials) {
+    const int64_t strides[3] = {1, m_size.x(), (int64_t)m_size.x()*m_size.y()};
+    const int position[3] = {
+            (int)(index % m_size.x()),
+            (int)((index / m_size.x()) % m_size.y()),
+            (int)(index / strides[2])
+    };
+    for(int axis = 0; axis < 3; ++axis) {
+        for(int direction : {-1, 1}) {
+            if(position[axis] + direction < 0 || position[axis] + direction >= m_size[axis])
+                continue;
+            const int64_t neighbour = index + direction*strides[axis];
+            if(m_known[neighbour])
+                continue;
+            const float distance = solveEikonal(neighbour);
+            if(distance < std::abs(phi[neighbour])) {
+                phi[neighbour] = phi[neighbour] < 0 ? -distance : distance;
+                trials.push(std::make_pair(distance, neighbour));
+            }
+        }
+    }
+}
+
+void NarrowBand::reinitialize() {
+    const int64_t strides[3] = {1, m_size.x(), (int64_t)m_size.x()*m_size.y()};
+
+    // Distance of voxels next to the zero level set
+    std::vector<std::pair<int64_t, float>> zeroCrossings;
+    std::mutex mutex;
+    ThreadPool::getInstance()->parallelFor(0, band.size(), [&](int begin, int end) {
+        std::vector<std::pair<int64_t, float>> found;
+        for(int i = begin; i < end; ++i) {
+            const int64_t index = band[i];
+            const float value = phi[index];
+            const int position[3] = {
+                    (int)(index % m_size.x()),
+                    (int)((index / m_size.x()) % m_size.y()),
+                    (int)(index / strides[2])
+            };
+            float inverseSquaredSum = 0.0f;
+            for(int axis = 0; axis < 3; ++axis) {
+                float distance = std::numeric_limits<float>::max();
+                for(int direction : {-1, 1}) {
+                    if(position[axis] + direction < 0 || position[axis] + direction >= m_size[axis])
+                        continue;
+                    const float neighbour = phi[index + direction*strides[axis]];
+                    if((neighbour < 0) != (value < 0))
+                        distance = std::min(distance, value / (value - neighbour));
+                }
+                if(distance < std::numeric_limits<float>::max())
+                    inverseSquaredSum += 1.0f / std::max(distance*distance, 1e-6f);
+            }
+            if(inverseSquaredSum > 0.0f)
+                found.push_back(std::make_pair(index, 1.0f / std::sqrt(inverseSquaredSum)));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        zeroCrossings.insert(zeroCrossings.end(), found.begin(), found.end());
+    });
+
+    // Reset old band, keeping the sign
+    for(int64_t index : band)
+        phi[index] = phi[index] < 0 ? -bandWidth : bandWidth;
+    band.clear();
+    for(const auto& crossing : zeroCrossings) {
+        phi[crossing.first] = phi[crossing.first] < 0 ? -crossing.second : crossing.second;
+        m_known[crossing.first] = 1;
+        band.push_back(crossing.first);
+    }
+
+    // Fast marching out to the band width. Only trial voxels closer than the band width are added to the queue.
+    std::priority_queue<std::pair<float, int64_t>, std::vector<std::pair<float, int64_t>>, std::greater<std::pair<float, int64_t>>> trials;
+    for(const auto& crossing : zeroCrossings)
+        updateNeighbours(crossing.first, trials);
+    while(!trials.empty()) {
+        const auto trial = trials.top();
+        trials.pop();
+        // Skip voxels which have been added to the queue again with a smaller distance
+        if(m_known[trial.second] || std::abs(phi[trial.second]) != trial.first)
+            continue;
+        m_known[trial.second] = 1;
+        band.push_back(trial.second);
+        updateNeighbours(trial.second, trials);
+    }
+
+    // Sort band for memory locality
+    std::sort(band.begin(), band.end());
+    landMines.resize(band.size());
+    for(int i = 0; i < band.size(); ++i) {
+        m_known[band[i]] = 0;
+        landMines[i] = std::abs(phi[band[i]]) > landMineDistance;
+    }
+}
+
+}
+
 LevelSetSegmentation::LevelSetSegmentation() {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
@@ -13,6 +299,7 @@ LevelSetSegmentation::LevelSetSegmentation() {
     mIntensityMeanSet = false;
     mIntensityVarianceSet = false;
     mIterations = 1000;
+    mConvergenceIterations = 20;
 }
 
 LevelSetSegmentation::LevelSetSegmentation(std::vector<Vector3i> seedPoints, float seedRadius, float curvatureWeight,
@@ -48,11 +335,87 @@ void LevelSetSegmentation::setMaxIterations(uint iterations) {
     mIterations = iterations;
 }
 
+void LevelSetSegmentation::setConvergenceIterations(int iterations) {
+    if(iterations <= 0)
+        throw Exception("Convergence iterations must be > 0");
+    mConvergenceIterations = iterations;
+    mIsModified = true;
+}
+
 void LevelSetSegmentation::addSeedPoint(Vector3i position, float size) {
     mSeeds.push_back(std::make_pair(position, size));
     mIsModified = true;
 }
 
+template <class T>
+Image::pointer LevelSetSegmentation::executeNarrowBand(const T* input, Vector3i size) {
+    NarrowBand levelSet(size);
+    for(auto seed : mSeeds) {
+        reportInfo() << "Using seed: " << seed.first.transpose() << reportEnd();
+        levelSet.addSeed(seed.first, seed.second);
+    }
+    levelSet.reinitialize();
+
+    auto pool = ThreadPool::getInstance();
+    std::mutex mutex;
+    std::vector<float> updates;
+    int iterationsWithoutChange = 0;
+    int iteration = 0;
+    while(iteration < mIterations && !levelSet.band.empty() && iterationsWithoutChange < mConvergenceIterations) {
+        updates.resize(levelSet.band.size());
+        float maxUpdate = 0.0f;
+        pool->parallelFor(0, levelSet.band.size(), [&](int begin, int end) {
+            float chunkMax = 0.0f;
+            for(int i = begin; i < end; ++i) {
+                const int64_t index = levelSet.band[i];
+                updates[i] = levelSet.getUpdate(index, input[index], mIntensityMean, mIntensityVariance, mCurvatureWeight);
+                chunkMax = std::max(chunkMax, std::abs(updates[i]));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            maxUpdate = std::max(maxUpdate, chunkMax);
+        }, 1024);
+        if(maxUpdate == 0.0f)
+            break;
+
+        // Stability CFL
+        const float deltaT = 0.5f/maxUpdate;
+        std::atomic<int64_t> signChanges(0);
+        std::atomic<bool> landMineHit(false);
+        pool->parallelFor(0, levelSet.band.size(), [&](int begin, int end) {
+            int64_t chunkSignChanges = 0;
+            for(int i = begin; i < end; ++i) {
+                const int64_t index = levelSet.band[i];
+                const float previous = levelSet.phi[index];
+                const float value = std::min(std::max(previous + deltaT*updates[i], -bandWidth), bandWidth);
+                levelSet.phi[index] = value;
+                if((value < 0) != (previous < 0)) {
+                    ++chunkSignChanges;
+                    if(levelSet.landMines[i])
+                        landMineHit = true;
+                }
+            }
+            signChanges += chunkSignChanges;
+        }, 1024);
+
+        reportInfo() << "Iteration: " << iteration << " delta t: " << deltaT << " band size: " << levelSet.band.size()
+            << " sign changes: " << signChanges << reportEnd();
+        iterationsWithoutChange = signChanges == 0 ? iterationsWithoutChange + 1 : 0;
+        iteration++;
+        if(landMineHit || iteration % reinitializationInterval == 0)
+            levelSet.reinitialize();
+    }
+    reportInfo() << "Narrow band level set finished after " << iteration << " iterations" << reportEnd();
+
+    // Create segmentation from level set function
+    std::vector<uchar> segmentation(levelSet.phi.size());
+    const int64_t sliceSize = (int64_t)size.x()*size.y();
+    pool->parallelFor(0, size.z(), [&](int begin, int end) {
+        for(int64_t i = begin*sliceSize; i < end*sliceSize; ++i)
+            segmentation[i] = levelSet.phi[i] <= 0 ? 1 : 0;
+    });
+    return Image::create(size.x(), size.y(), size.z(), TYPE_UINT8, 1, segmentation.data());
+}
+
 void LevelSetSegmentation::execute() {
     if(!mIntensityMeanSet || !mIntensityVarianceSet)
         throw Exception("Intensity mean or variance not given to LevelSetSegmentation");
@@ -62,6 +425,28 @@ void LevelSetSegmentation::execute() {
     if(input->getDimensions() != 3)
         throw Exception("Level set segmentation only supports 3D atm");
 
+    if(mSeeds.size() == 0)
+        throw Exception("The LevelSetSegmentation algorithm must be given a seed point");
+
+    // The narrow band only updates voxels close to the zero level set, which is faster than updating the entire
+    // level set function with OpenCL on CPU devices.
+    bool useNarrowBand = getMainDevice()->isHost();
+    if(!useNarrowBand) {
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+        useNarrowBand = device->getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
+    }
+    if(useNarrowBand) {
+        auto access = input->getImageAccess(ACCESS_READ);
+        const void* inputData = access->get();
+        Image::pointer output;
+        switch(input->getDataType()) {
+            fastSwitchTypeMacro(output = executeNarrowBand<FAST_TYPE>((const FAST_TYPE*)inputData, input->getSize().cast<int>()))
+        }
+        output->setSpacing(input->getSpacing());
+        SceneGraph::setParentNode(output, input);
+        addOutputData(0, output);
+        return;
+    }
 
     OpenCLDevice::pointer device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
     cl::CommandQueue queue = device->getCommandQueue();
@@ -69,17 +454,16 @@ void LevelSetSegmentation::execute() {
 
     auto phi = Image::create(input->getSize(), TYPE_FLOAT, 1);
 
-
-    if(mSeeds.size() == 0)
-        throw Exception("The LevelSetSegmentation algorithm must be given a seed point");
-
     Vector3ui size = input->getSize();
+    // All seeds are created in one kernel as the union of the spheres, same as the narrow band on the host.
+    // Phi can't be read in the kernel, since it is a write only image when 3D image writes are supported.
+    std::vector<float> seeds;
     for(auto seed : mSeeds) {
-        Vector3i seedPos = seed.first;
-        reportInfo() << "Using seed: " << seedPos.transpose() << reportEnd();
-        float seedRadius = seed.second;
-
-        // Create seed
+        reportInfo() << "Using seed: " << seed.first.transpose() << reportEnd();
+        seeds.insert(seeds.end(), {(float)seed.first.x(), (float)seed.first.y(), (float)seed.first.z(), seed.second});
+    }
+    cl::Buffer seedBuffer(device->getContext(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, seeds.size()*sizeof(float), seeds.data());
+    {
         cl::Kernel createSeedKernel(program, "initializeLevelSetFunction");
 
         if(device->isWritingTo3DTexturesSupported()) {
@@ -90,10 +474,9 @@ void LevelSetSegmentation::execute() {
             auto phiAccess = phi->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
             createSeedKernel.setArg(0, *phiAccess->get());
         }
-        createSeedKernel.setArg(1, seedPos.x());
-        createSeedKernel.setArg(2, seedPos.y());
-        createSeedKernel.setArg(3, seedPos.z());
-        createSeedKernel.setArg(4, seedRadius);
+        createSeedKernel.setArg(1, seedBuffer);
+        createSeedKernel.setArg(2, (int)mSeeds.size());
+        createSeedKernel.setArg(3, bandWidth);
         queue.enqueueNDRangeKernel(
                 createSeedKernel,
                 cl::NullRange,
@@ -109,9 +492,32 @@ void LevelSetSegmentation::execute() {
     Vector3f spacing = input->getSpacing();
     const float minimumSpacing = std::min(std::min(spacing.x(), spacing.y()), spacing.z());
 
+    // The kernel only updates the narrow band, and reduces the max speed (as the bits of a float) and the nr of
+    // voxels which changed sign in this buffer. Thus only two values are read back each iteration.
+    cl::Buffer reductionBuffer(device->getContext(), CL_MEM_READ_WRITE, 2*sizeof(int));
+    const int reductionReset[2] = {0, 0};
+    kernel.setArg(6, reductionBuffer);
+    kernel.setArg(8, bandWidth);
+    int iteration = 0;
+    int iterationsWithoutChange = 0;
+    // Returns false when the level set has converged
+    auto reduce = [&](float& deltaT) {
+        int reduction[2];
+        queue.enqueueReadBuffer(reductionBuffer, CL_TRUE, 0, sizeof(reduction), reduction);
+        float maxSpeed;
+        std::memcpy(&maxSpeed, &reduction[0], sizeof(float));
+        reportInfo() << "Iteration: " << iteration << " delta t: " << deltaT << " sign changes: " << reduction[1] << reportEnd();
+        ++iteration;
+        iterationsWithoutChange = reduction[1] == 0 ? iterationsWithoutChange + 1 : 0;
+        if(maxSpeed <= 0.0f) // Nothing is moving
+            return false;
+        // Calculate deltaT for next round
+        deltaT = 0.5f/maxSpeed;
+        return iterationsWithoutChange < mConvergenceIterations;
+    };
+
     if(!device->isWritingTo3DTexturesSupported()) {
         auto phi2 = Image::create(input->getSize(), TYPE_FLOAT, 1);
-        auto speed = Image::create(input->getSize(), TYPE_FLOAT, 1);
 
         auto access = input->getOpenCLImageAccess(ACCESS_READ, device);
         kernel.setArg(0, *access->get3DImage());
@@ -120,10 +526,11 @@ void LevelSetSegmentation::execute() {
         kernel.setArg(5, mCurvatureWeight);
 
         float deltaT = 0.0001;
-        for(int i = 0; i < mIterations; i++) {
+        bool converged = false;
+        while(iteration < mIterations && !converged) {
             kernel.setArg(7, deltaT);
-            reportInfo() << "Iteration: " << i << " delta t: " << deltaT << reportEnd();
-            if(i % 2 == 0) {
+            queue.enqueueWriteBuffer(reductionBuffer, CL_FALSE, 0, sizeof(reductionReset), reductionReset);
+            if(iteration % 2 == 0) {
                 auto access1 = phi->getOpenCLImageAccess(ACCESS_READ, device);
                 auto access2 = phi2->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
                 kernel.setArg(1, *access1->get3DImage());
@@ -134,22 +541,15 @@ void LevelSetSegmentation::execute() {
                 kernel.setArg(1, *access2->get3DImage());
                 kernel.setArg(2, *access1->get());
             }
-            {
-                auto speedAccess = speed->getOpenCLBufferAccess(ACCESS_READ_WRITE,device);
-                kernel.setArg(6, *speedAccess->get());
-                queue.enqueueNDRangeKernel(
-                        kernel,
-                        cl::NullRange,
-                        cl::NDRange(size.x(), size.y(), size.z()),
-                        cl::NullRange
-                        );
-                queue.finish();
-            }
-
-            // Calculate max speed and deltaT for next round
-            deltaT = 0.5f/speed->calculateMaximumIntensity();
+            queue.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NullRange,
+                    cl::NDRange(size.x(), size.y(), size.z()),
+                    cl::NullRange
+                    );
+            converged = !reduce(deltaT);
         }
-        if(mIterations % 2 != 0) {
+        if(iteration % 2 != 0) {
             // Phi_2 was written to in the last iteration, copy this to the result
             //auto access1 = phi->getOpenCLImageAccess(ACCESS_READ, device);
             //auto access2 = phi2->getOpenCLImageAccess(ACCESS_READ, device);
@@ -168,8 +568,6 @@ void LevelSetSegmentation::execute() {
                 input->getDepth()
         );
 
-        auto speed = Image::create(input->getSize(), TYPE_FLOAT, 1);
-
         auto access = input->getOpenCLImageAccess(ACCESS_READ, device);
         kernel.setArg(0, *access->get3DImage());
         kernel.setArg(3, mIntensityMean);
@@ -177,32 +575,26 @@ void LevelSetSegmentation::execute() {
         kernel.setArg(5, mCurvatureWeight);
 
         float deltaT = 0.0001;
-        for(int i = 0; i < mIterations; i++) {
+        bool converged = false;
+        while(iteration < mIterations && !converged) {
             kernel.setArg(7, deltaT);
-            reportInfo() << "Iteration: " << i << " delta t: " << deltaT << reportEnd();
-            if(i % 2 == 0) {
+            queue.enqueueWriteBuffer(reductionBuffer, CL_FALSE, 0, sizeof(reductionReset), reductionReset);
+            if(iteration % 2 == 0) {
                 kernel.setArg(1, phi_1);
                 kernel.setArg(2, phi_2);
             } else {
                 kernel.setArg(1, phi_2);
                 kernel.setArg(2, phi_1);
             }
-            {
-                OpenCLImageAccess::pointer speedAccess = speed->getOpenCLImageAccess(ACCESS_READ_WRITE, device);
-                kernel.setArg(6, *speedAccess->get3DImage());
-                queue.enqueueNDRangeKernel(
-                        kernel,
-                        cl::NullRange,
-                        cl::NDRange(size.x(), size.y(), size.z()),
-                        cl::NullRange
-                );
-                queue.finish();
-            }
-
-            // Calculate max speed and deltaT for next round
-            deltaT = 0.5/speed->calculateMaximumIntensity();
+            queue.enqueueNDRangeKernel(
+                    kernel,
+                    cl::NullRange,
+                    cl::NDRange(size.x(), size.y(), size.z()),
+                    cl::NullRange
+            );
+            converged = !reduce(deltaT);
         }
-        if(mIterations % 2 != 0) {
+        if(iteration % 2 != 0) {
             // Phi_2 was written to in the last iteration, copy this to the result
             queue.enqueueCopyImage(phi_2,phi_1,origin,origin,region);
         }
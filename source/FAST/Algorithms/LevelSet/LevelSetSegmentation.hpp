@@ -1,15 +1,22 @@
 #pragma once
 
 #include "FAST/ProcessObject.hpp"
+#include "FAST/Data/Image.hpp"
 
 namespace fast {
 
 /**
  * @brief Level set image segmentation
  *
- * GPU-based level set segmentation using spherical seed points.
+ * Level set segmentation using spherical seed points.
  * Only supports 3D images atm.
  *
+ * On GPUs the level set function is clamped to a narrow band, and only voxels in and next to the band are updated
+ * with OpenCL every iteration.
+ * On the host and on CPU devices, only a narrow band around the zero level set is updated, using the ThreadPool.
+ * The band is rebuilt by fast marching when the zero level set gets close to its edge.
+ * On all devices this stops before the max nr of iterations when the zero level set has converged.
+ *
  * Inputs:
  * - 0: Image 3D
  *
@@ -40,9 +47,17 @@ class FAST_EXPORT  LevelSetSegmentation : public ProcessObject {
         void setIntensityMean(float intensity);
         void setIntensityVariance(float variation);
         void setMaxIterations(uint iterations);
+        /**
+         * @brief Set convergence criterion of the level set
+         * @param iterations Stop when no voxel has changed side of the zero level set for this nr of iterations.
+         *      Default is 20.
+         */
+        void setConvergenceIterations(int iterations);
     private:
         LevelSetSegmentation();
         void execute();
+        template <class T>
+        Image::pointer executeNarrowBand(const T* input, Vector3i size);
 
         std::vector<std::pair<Vector3i, float> > mSeeds;
 
@@ -50,6 +65,7 @@ class FAST_EXPORT  LevelSetSegmentation : public ProcessObject {
         bool mIntensityMeanSet;
         bool mIntensityVarianceSet;
         int mIterations;
+        int mConvergenceIterations;
 
 };
 
@@ -8,6 +8,7 @@
 #include "FAST/Visualization/ImageRenderer/ImageRenderer.hpp"
 #include "FAST/Visualization/SimpleWindow.hpp"
 #include "FAST/Visualization/DualViewWindow.hpp"
+#include <random>
 
 using namespace fast;
 
@@ -38,4 +39,58 @@ TEST_CASE("Level set segmentation", "[fast][levelset][visual]") {
     window->getTopLeftView()->set3DMode();
     window->start();
 }
-*/
\ No newline at end of file
+*/
+
+/**
+ * Segment a noisy sphere phantom and return the Dice score
+ */
+static float segmentSphere(std::vector<Vector3i> seeds, ExecutionDevice::pointer device) {
+    const int size = 64;
+    const float radius = 16.0f;
+    const Vector3f center(32, 32, 32);
+    std::mt19937 generator(1);
+    std::normal_distribution<float> noise(0.0f, 10.0f);
+    std::vector<uchar> data(size*size*size);
+    std::vector<uchar> expected(data.size());
+    for(int z = 0; z < size; ++z) {
+        for(int y = 0; y < size; ++y) {
+            for(int x = 0; x < size; ++x) {
+                const int index = x + (y + z*size)*size;
+                expected[index] = (Vector3f(x, y, z) - center).norm() < radius ? 1 : 0;
+                data[index] = (uchar)std::min(std::max((expected[index] == 1 ? 150.0f : 20.0f) + noise(generator), 0.0f), 255.0f);
+            }
+        }
+    }
+    auto image = Image::create(size, size, size, TYPE_UINT8, 1, data.data());
+
+    auto segmentation = LevelSetSegmentation::create(seeds, 3.0f, 0.5f, 1000);
+    segmentation->setIntensityMean(150);
+    segmentation->setIntensityVariance(50);
+    segmentation->connect(image);
+    segmentation->setMainDevice(device);
+    auto result = segmentation->runAndGetOutputData<Image>();
+
+    auto access = result->getImageAccess(ACCESS_READ);
+    const uchar* resultData = (const uchar*)access->get();
+    int intersection = 0;
+    int resultCount = 0;
+    int expectedCount = 0;
+    for(int i = 0; i < data.size(); ++i) {
+        intersection += resultData[i] == 1 && expected[i] == 1;
+        resultCount += resultData[i] == 1;
+        expectedCount += expected[i];
+    }
+    return 2.0f*intersection/(resultCount + expectedCount);
+}
+
+TEST_CASE("Narrow band level set segmentation of sphere on host", "[fast][levelset]") {
+    // Second seed is outside the sphere, and disappears
+    CHECK(segmentSphere({Vector3i(32, 32, 32), Vector3i(2, 2, 2)}, Host::getInstance()) > 0.95f);
+}
+
+TEST_CASE("Level set segmentation of sphere with OpenCL", "[fast][levelset]") {
+    CHECK(segmentSphere({Vector3i(32, 32, 32)}, DeviceManager::getInstance()->getDefaultDevice()) > 0.95f);
+    // Seeds are combined as a union, the second seed is outside the sphere and disappears
+    CHECK(segmentSphere({Vector3i(32, 32, 32), Vector3i(2, 2, 2)}, DeviceManager::getInstance()->getDefaultDevice()) > 0.95f);
+    CHECK(segmentSphere({Vector3i(2, 2, 2), Vector3i(32, 32, 32)}, DeviceManager::getInstance()->getDefaultDevice()) > 0.95f);
+}
@@ -0,0 +1,305 @@
+#include "NearestNeighbourSearch.hpp"
+#include <FAST/ThreadPool.hpp>
+#include <FAST/Exception.hpp>
+#undef min
+#undef max
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace fast {
+
+NearestNeighbourSearch::pointer NearestNeighbourSearch::create(const MatrixXf& points, NearestNeighbourSearchMethod method) {
+    switch(method) {
+        case NearestNeighbourSearchMethod::BRUTE_FORCE:
+            return std::make_shared<BruteForceNearestNeighbourSearch>(points);
+        case NearestNeighbourSearchMethod::KD_TREE:
+            return std::make_shared<KDTree>(points);
+        case NearestNeighbourSearchMethod::VOXEL_GRID:
+            return std::make_shared<VoxelGrid>(points);
+        default:
+            throw Exception("Unknown nearest neighbour search method");
+    }
+}
+
+NearestNeighbourSearch::NearestNeighbourSearch(const MatrixXf& points) {
+    if(points.rows() == 0)
+        throw Exception("Points given to nearest neighbour search must have at least 1 dimension");
+    m_points = points;
+}
+
+int NearestNeighbourSearch::getNrOfPoints() const {
+    return m_points.cols();
+}
+
+int NearestNeighbourSearch::getNrOfDimensions() const {
+    return m_points.rows();
+}
+
+float NearestNeighbourSearch::squaredDistance(const float* a, const float* b) const {
+    float distance = 0.0f;
+    for(int i = 0; i < m_points.rows(); ++i) {
+        const float difference = a[i] - b[i];
+        distance += difference*difference;
+    }
+    return distance;
+}
+
+std::vector<int> NearestNeighbourSearch::findNearest(const MatrixXf& queries, std::vector<float>* squaredDistances) const {
+    if(queries.rows() != m_points.rows())
+        throw Exception("Query points must have " + std::to_string(m_points.rows()) + " dimensions in nearest neighbour search");
+    std::vector<int> result(queries.cols());
+    if(squaredDistances != nullptr)
+        squaredDistances->resize(queries.cols());
+    ThreadPool::getInstance()->parallelFor(0, queries.cols(), [&](int begin, int end) {
+        for(int i = begin; i < end; ++i) {
+            float distance;
+            result[i] = findNearest(queries.col(i).data(), &distance);
+            if(squaredDistances != nullptr)
+                (*squaredDistances)[i] = distance;
+        }
+    }, 64);
+    return result;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+BruteForceNearestNeighbourSearch::BruteForceNearestNeighbourSearch(const MatrixXf& points) : NearestNeighbourSearch(points) {
+}
+
+int BruteForceNearestNeighbourSearch::findNearest(const float* point, float* squaredDistance) const {
+    float bestDistance = std::numeric_limits<float>::max();
+    int best = -1;
+    for(int i = 0; i < m_points.cols(); ++i) {
+        const float distance = NearestNeighbourSearch::squaredDistance(point, m_points.col(i).data());
+        if(distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    if(squaredDistance != nullptr)
+        *squaredDistance = bestDistance;
+    return best;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+KDTree::KDTree(const MatrixXf& points, int leafSize) : NearestNeighbourSearch(points) {
+    if(leafSize < 1)
+        throw Exception("Leaf size of KDTree must be at least 1");
+    m_leafSize = leafSize;
+    std::vector<int> indices(points.cols());
+    for(int i = 0; i < points.cols(); ++i)
+        indices[i] = i;
+    if(!indices.empty()) {
+        m_nodes.reserve(2*(points.cols()/leafSize + 1));
+        build(indices, 0, indices.size(), points);
+    }
+    // Store points in the order of the leaves, so that each leaf is contiguous in memory
+    for(int i = 0; i < indices.size(); ++i)
+        m_points.col(i) = points.col(indices[i]);
+    m_indices = std::move(indices);
+}
+
+int KDTree::build(std::vector<int>& indices, int begin, int end, const MatrixXf& points) {
+    const int nodeIndex = m_nodes.size();
+    m_nodes.push_back(Node{-1, 0.0f, begin, end, -1, -1});
+    if(end - begin <= m_leafSize)
+        return nodeIndex;
+
+    // Split dimension with largest extent
+    int dimension = 0;
+    float largestExtent = 0.0f;
+    for(int d = 0; d < points.rows(); ++d) {
+        float minimum = points(d, indices[begin]);
+        float maximum = minimum;
+        for(int i = begin + 1; i < end; ++i) {
+            minimum = std::min(minimum, points(d, indices[i]));
+            maximum = std::max(maximum, points(d, indices[i]));
+        }
+        if(maximum - minimum > largestExtent) {
+            largestExtent = maximum - minimum;
+            dimension = d;
+        }
+    }
+    if(largestExtent <= 0.0f) // All points are equal
+        return nodeIndex;
+
+    const int middle = begin + (end - begin)/2;
+    std::nth_element(indices.begin() + begin, indices.begin() + middle, indices.begin() + end, [&](int a, int b) {
+        return points(dimension, a) < points(dimension, b);
+    });
+    const float splitValue = points(dimension, indices[middle]);
+    const int left = build(indices, begin, middle, points);
+    const int right = build(indices, middle, end, points);
+    // Don't keep a reference to the node, as m_nodes may have been reallocated by the recursive calls
+    m_nodes[nodeIndex].splitDimension = dimension;
+    m_nodes[nodeIndex].splitValue = splitValue;
+    m_nodes[nodeIndex].left = left;
+    m_nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void KDTree::search(int nodeIndex, const float* point, float& bestDistance, int& best) const {
+    const Node& node = m_nodes[nodeIndex];
+    if(node.splitDimension < 0) {
+        for(int i = node.begin; i < node.end; ++i) {
+            const float distance = squaredDistance(point, m_points.col(i).data());
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return;
+    }
+    // Points at the split value may be on both sides, thus visit the far side as long as it can contain a point at the same distance
+    const float difference = point[node.splitDimension] - node.splitValue;
+    const int nearChild = difference < 0.0f ? node.left : node.right;
+    const int farChild = difference < 0.0f ? node.right : node.left;
+    search(nearChild, point, bestDistance, best);
+    if(difference*difference <= bestDistance)
+        search(farChild, point, bestDistance, best);
+}
+
+int KDTree::findNearest(const float* point, float* squaredDistance) const {
+    float bestDistance = std::numeric_limits<float>::max();
+    int best = -1;
+    if(!m_nodes.empty())
+        search(0, point, bestDistance, best);
+    if(squaredDistance != nullptr)
+        *squaredDistance = bestDistance;
+    return best < 0 ? -1 : m_indices[best];
+}
+
+void KDTree::searchRadius(int nodeIndex, const float* point, float squaredRadius, std::vector<int>& result) const {
+    const Node& node = m_nodes[nodeIndex];
+    if(node.splitDimension < 0) {
+        for(int i = node.begin; i < node.end; ++i) {
+            if(squaredDistance(point, m_points.col(i).data()) <= squaredRadius)
+                result.push_back(m_indices[i]);
+        }
+        return;
+    }
+    const float difference = point[node.splitDimension] - node.splitValue;
+    if(difference <= 0.0f || difference*difference <= squaredRadius)
+        searchRadius(node.left, point, squaredRadius, result);
+    if(difference >= 0.0f || difference*difference <= squaredRadius)
+        searchRadius(node.right, point, squaredRadius, result);
+}
+
+void KDTree::findWithinRadius(const float* point, float radius, std::vector<int>& result) const {
+    if(!m_nodes.empty())
+        searchRadius(0, point, radius*radius, result);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+VoxelGrid::VoxelGrid(const MatrixXf& points, float cellSize) : NearestNeighbourSearch(points) {
+    if(points.rows() < 3)
+        throw Exception("VoxelGrid requires points with at least 3 dimensions");
+    const int nrOfPoints = points.cols();
+    Vector3f minimum = Vector3f::Zero();
+    Vector3f maximum = Vector3f::Zero();
+    if(nrOfPoints > 0) {
+        minimum = points.topRows<3>().rowwise().minCoeff();
+        maximum = points.topRows<3>().rowwise().maxCoeff();
+    }
+    const Vector3f extent = maximum - minimum;
+    auto getNrOfCells = [&extent](float size) {
+        double cells = 1;
+        for(int i = 0; i < 3; ++i)
+            cells *= std::floor(extent[i]/size) + 1;
+        return cells;
+    };
+    if(cellSize <= 0.0f) {
+        // Halve cell size until there would be more cells than points
+        cellSize = extent.maxCoeff() > 0.0f ? extent.maxCoeff() : 1.0f;
+        while(extent.maxCoeff() > 0.0f && getNrOfCells(cellSize*0.5f) <= nrOfPoints)
+            cellSize *= 0.5f;
+    } else if(getNrOfCells(cellSize) > std::max(8.0*nrOfPoints, 1e6)) {
+        throw Exception("Cell size " + std::to_string(cellSize) + " of VoxelGrid gives too many cells");
+    }
+    m_cellSize = cellSize;
+    for(int i = 0; i < 3; ++i) {
+        m_origin[i] = minimum[i];
+        m_size[i] = (int)std::floor(extent[i]/cellSize) + 1;
+    }
+
+    // Sort points by cell, using counting sort
+    std::vector<int> cells(nrOfPoints);
+    m_cellStart.assign((size_t)m_size[0]*m_size[1]*m_size[2] + 1, 0);
+    for(int i = 0; i < nrOfPoints; ++i) {
+        int cell[3];
+        for(int j = 0; j < 3; ++j)
+            cell[j] = std::min((int)((points(j, i) - m_origin[j])/cellSize), m_size[j] - 1);
+        cells[i] = cell[0] + (cell[1] + cell[2]*m_size[1])*m_size[0];
+        ++m_cellStart[cells[i] + 1];
+    }
+    for(int i = 1; i < m_cellStart.size(); ++i)
+        m_cellStart[i] += m_cellStart[i - 1];
+    std::vector<int> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_indices.resize(nrOfPoints);
+    for(int i = 0; i < nrOfPoints; ++i) {
+        const int position = next[cells[i]]++;
+        m_indices[position] = i;
+        m_points.col(position) = points.col(i);
+    }
+}
+
+float VoxelGrid::getCellSize() const {
+    return m_cellSize;
+}
+
+int VoxelGrid::findNearest(const float* point, float* squaredDistance) const {
+    float bestDistance = std::numeric_limits<float>::max();
+    int best = -1;
+    // Cell of query, clamped to the grid
+    int center[3];
+    for(int i = 0; i < 3; ++i)
+        center[i] = std::max(0, std::min((int)std::floor((point[i] - m_origin[i])/m_cellSize), m_size[i] - 1));
+    int maxRadius = 0;
+    for(int i = 0; i < 3; ++i)
+        maxRadius = std::max(maxRadius, std::max(center[i], m_size[i] - 1 - center[i]));
+
+    for(int radius = 0; radius <= maxRadius; ++radius) {
+        if(radius > 0) {
+            // Lower bound of distance to any cell in this shell or further out: Distance from query
+            // to the closest face of the box of cells already searched, along any axis.
+            float bound = std::numeric_limits<float>::max();
+            for(int i = 0; i < 3; ++i) {
+                const float lower = point[i] - (m_origin[i] + (center[i] - radius + 1)*m_cellSize);
+                const float upper = (m_origin[i] + (center[i] + radius)*m_cellSize) - point[i];
+                bound = std::min(bound, std::max(0.0f, std::min(lower, upper)));
+            }
+            if(bound*bound > bestDistance)
+                break;
+        }
+        const int zBegin = std::max(center[2] - radius, 0), zEnd = std::min(center[2] + radius, m_size[2] - 1);
+        const int yBegin = std::max(center[1] - radius, 0), yEnd = std::min(center[1] + radius, m_size[1] - 1);
+        for(int z = zBegin; z <= zEnd; ++z) {
+            const bool zOnShell = std::abs(z - center[2]) == radius;
+            for(int y = yBegin; y <= yEnd; ++y) {
+                const bool yOnShell = std::abs(y - center[1]) == radius;
+                // Inside the shell, only the first and last x are part of it
+                const int xStep = zOnShell || yOnShell || radius == 0 ? 1 : 2*radius;
+                for(int x = center[0] - radius; x <= center[0] + radius; x += xStep) {
+                    if(x < 0 || x >= m_size[0])
+                        continue;
+                    const int cell = x + (y + z*m_size[1])*m_size[0];
+                    for(int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+                        const float distance = NearestNeighbourSearch::squaredDistance(point, m_points.col(i).data());
+                        if(distance < bestDistance) {
+                            bestDistance = distance;
+                            best = i;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if(squaredDistance != nullptr)
+        *squaredDistance = bestDistance;
+    return best < 0 ? -1 : m_indices[best];
+}
+
+}
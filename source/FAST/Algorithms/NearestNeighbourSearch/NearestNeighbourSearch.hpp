@@ -0,0 +1,135 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+
+namespace fast {
+
+/**
+ * @brief Spatial index type used by NearestNeighbourSearch::create
+ */
+enum class NearestNeighbourSearchMethod {
+    BRUTE_FORCE, // Compare query with all points, O(N) per query
+    KD_TREE, // k-d tree, O(log N) per query on average
+    VOXEL_GRID, // Uniform grid of the first 3 dimensions, fast for evenly spread 3D points such as surface meshes
+};
+
+/**
+ * @brief Index of a fixed set of points for finding the nearest point of query points
+ *
+ * Points are the columns of a DxN matrix, where D is the nr of dimensions, e.g. 3 for positions.
+ * The index is built once in the constructor and can then be queried from several threads at the same time.
+ * Distances are euclidean, and returned squared.
+ *
+ * @code
+ * auto search = NearestNeighbourSearch::create(fixedPoints); // k-d tree
+ * std::vector<int> closest = search->findNearest(movingPoints);
+ * @endcode
+ */
+class FAST_EXPORT NearestNeighbourSearch {
+    public:
+        typedef std::shared_ptr<NearestNeighbourSearch> pointer;
+        /**
+         * @brief Build an index of points
+         * @param points DxN matrix of points
+         * @param method
+         * @return index
+         */
+        static NearestNeighbourSearch::pointer create(const MatrixXf& points, NearestNeighbourSearchMethod method = NearestNeighbourSearchMethod::KD_TREE);
+        int getNrOfPoints() const;
+        int getNrOfDimensions() const;
+        /**
+         * @brief Find nearest point of a single query point
+         * @param point Pointer to D floats
+         * @param squaredDistance If not nullptr, squared distance to the nearest point is stored here
+         * @return column index of nearest point, or -1 if index is empty
+         */
+        virtual int findNearest(const float* point, float* squaredDistance = nullptr) const = 0;
+        /**
+         * @brief Find nearest point of each column in queries, in parallel using the ThreadPool
+         * @param queries DxM matrix of query points
+         * @param squaredDistances If not nullptr, filled with squared distance to the nearest point of each query
+         * @return column index of nearest point for each query
+         */
+        std::vector<int> findNearest(const MatrixXf& queries, std::vector<float>* squaredDistances = nullptr) const;
+        virtual ~NearestNeighbourSearch() = default;
+    protected:
+        explicit NearestNeighbourSearch(const MatrixXf& points);
+        float squaredDistance(const float* a, const float* b) const;
+
+        MatrixXf m_points;
+};
+
+/**
+ * @brief Nearest neighbour search comparing the query with every point. Used as reference.
+ */
+class FAST_EXPORT BruteForceNearestNeighbourSearch : public NearestNeighbourSearch {
+    public:
+        explicit BruteForceNearestNeighbourSearch(const MatrixXf& points);
+        int findNearest(const float* point, float* squaredDistance = nullptr) const override;
+        using NearestNeighbourSearch::findNearest;
+};
+
+/**
+ * @brief k-d tree for nearest neighbour search
+ *
+ * Each node splits its points at the median of the dimension with largest extent.
+ * Leaves store up to leafSize points contiguously in memory.
+ */
+class FAST_EXPORT KDTree : public NearestNeighbourSearch {
+    public:
+        explicit KDTree(const MatrixXf& points, int leafSize = 16);
+        int findNearest(const float* point, float* squaredDistance = nullptr) const override;
+        using NearestNeighbourSearch::findNearest;
+        /**
+         * @brief Find all points within a radius of a point
+         * @param point Pointer to D floats
+         * @param radius
+         * @param result Column index of each point within radius is appended to this vector
+         */
+        void findWithinRadius(const float* point, float radius, std::vector<int>& result) const;
+    private:
+        struct Node {
+            int splitDimension; // -1 for leaf
+            float splitValue;
+            int begin; // Range of points in m_points for leaf nodes
+            int end;
+            int left; // Index of child nodes
+            int right;
+        };
+        int build(std::vector<int>& indices, int begin, int end, const MatrixXf& points);
+        void search(int node, const float* point, float& bestDistance, int& best) const;
+        void searchRadius(int node, const float* point, float squaredRadius, std::vector<int>& result) const;
+
+        int m_leafSize;
+        std::vector<Node> m_nodes;
+        std::vector<int> m_indices; // Original column index of each point in m_points
+};
+
+/**
+ * @brief Uniform voxel grid for nearest neighbour search
+ *
+ * Points are put into cubic cells using their first 3 dimensions. Queries search cells in
+ * shells of increasing distance around the cell of the query, and stop when no cell further out can contain a nearer point.
+ * Remaining dimensions, if any, are only used when comparing points.
+ */
+class FAST_EXPORT VoxelGrid : public NearestNeighbourSearch {
+    public:
+        /**
+         * @brief Build voxel grid
+         * @param points DxN matrix, D >= 3
+         * @param cellSize Size of each cell. If <= 0, it is selected to get at most as many cells as points.
+         */
+        explicit VoxelGrid(const MatrixXf& points, float cellSize = -1);
+        int findNearest(const float* point, float* squaredDistance = nullptr) const override;
+        using NearestNeighbourSearch::findNearest;
+        float getCellSize() const;
+    private:
+        int m_size[3];
+        float m_origin[3];
+        float m_cellSize;
+        std::vector<int> m_cellStart; // Points of cell i are m_cellStart[i] to m_cellStart[i+1] in m_points
+        std::vector<int> m_indices; // Original column index of each point in m_points
+};
+
+}
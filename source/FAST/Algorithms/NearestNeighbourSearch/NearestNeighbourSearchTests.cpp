@@ -0,0 +1,59 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Algorithms/NearestNeighbourSearch/NearestNeighbourSearch.hpp"
+#include <random>
+
+using namespace fast;
+
+TEST_CASE("Nearest neighbour search methods give same result as brute force", "[fast][NearestNeighbourSearch]") {
+    std::mt19937 generator(1);
+    std::normal_distribution<float> distribution(0.0f, 1.0f);
+    for(int dimensions : {3, 6}) {
+        for(int size : {1, 2, 15, 1000}) {
+            // Points on a sphere, with some duplicates
+            MatrixXf points(dimensions, size);
+            for(int i = 0; i < size; ++i) {
+                for(int d = 0; d < dimensions; ++d)
+                    points(d, i) = distribution(generator);
+                points.col(i).head(3) = points.col(i).head(3).normalized()*10.0f;
+            }
+            if(size > 10)
+                points.col(3) = points.col(4);
+            MatrixXf queries(dimensions, 500);
+            for(int i = 0; i < queries.cols(); ++i) {
+                for(int d = 0; d < dimensions; ++d)
+                    queries(d, i) = distribution(generator)*8.0f;
+            }
+
+            BruteForceNearestNeighbourSearch bruteForce(points);
+            std::vector<float> expectedDistances;
+            bruteForce.findNearest(queries, &expectedDistances);
+            for(auto method : {NearestNeighbourSearchMethod::KD_TREE, NearestNeighbourSearchMethod::VOXEL_GRID}) {
+                auto search = NearestNeighbourSearch::create(points, method);
+                CHECK(search->getNrOfPoints() == size);
+                CHECK(search->getNrOfDimensions() == dimensions);
+                std::vector<float> distances;
+                std::vector<int> result = search->findNearest(queries, &distances);
+                int errors = 0;
+                for(int i = 0; i < queries.cols(); ++i) {
+                    // Several points may be at the same distance, thus compare distances instead of indices
+                    const float distance = (points.col(result[i]) - queries.col(i)).squaredNorm();
+                    if(std::fabs(distance - expectedDistances[i]) > 1e-4f*(1.0f + expectedDistances[i]) ||
+                        std::fabs(distances[i] - expectedDistances[i]) > 1e-4f*(1.0f + expectedDistances[i]))
+                        ++errors;
+                }
+                CHECK(errors == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Nearest neighbour search with no points or wrong dimensions", "[fast][NearestNeighbourSearch]") {
+    MatrixXf points(3, 0);
+    Vector3f query(1, 2, 3);
+    CHECK(KDTree(points).findNearest(query.data()) == -1);
+    CHECK(VoxelGrid(points).findNearest(query.data()) == -1);
+
+    points = MatrixXf::Zero(3, 10);
+    CHECK_THROWS(KDTree(points).findNearest(MatrixXf::Zero(2, 5)));
+    CHECK_THROWS(VoxelGrid(MatrixXf::Zero(2, 5)));
+}
@@ -43,7 +43,7 @@ void ImageClassificationNetwork::execute() {
     auto tensor = std::dynamic_pointer_cast<Tensor>(m_processedOutputData[0]);
     if(!tensor)
         throw Exception("ImageClassificationNetwork batch support not implemented");
-    auto access = tensor->getAccess(ACCESS_READ);
+    auto access = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
 
     auto data = access->getData<1>();
     if(mLabels.size() != data.dimension(0)) {
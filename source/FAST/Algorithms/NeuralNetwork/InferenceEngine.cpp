@@ -78,6 +78,22 @@ std::vector<InferenceDeviceInfo> InferenceEngine::getDeviceList() {
     throw Exception("getDeviceList is not supported for the inference engine " + getName());
 }
 
+InferenceDeviceType InferenceEngine::getDeviceType() const {
+    return m_deviceType;
+}
+
+int InferenceEngine::getDeviceIndex() const {
+    return m_deviceIndex;
+}
+
+void InferenceEngine::setNrOfThreads(int threads) {
+    m_nrOfThreads = threads;
+}
+
+int InferenceEngine::getNrOfThreads() const {
+    return m_nrOfThreads;
+}
+
 void InferenceEngine::setMaxBatchSize(int size) {
     m_maxBatchSize = size;
 }
@@ -149,6 +149,8 @@ class FAST_EXPORT InferenceEngine : public Object {
          * @param type
          */
         virtual void setDevice(int index = -1, InferenceDeviceType type = InferenceDeviceType::ANY);
+        virtual InferenceDeviceType getDeviceType() const;
+        virtual int getDeviceIndex() const;
         /**
          * Get a list of devices available for this inference engine.
          *
@@ -158,6 +160,14 @@ class FAST_EXPORT InferenceEngine : public Object {
 
         virtual int getMaxBatchSize();
         virtual void setMaxBatchSize(int size);
+        /**
+         * @brief Set max nr of threads the engine may use to run the network on the CPU (intra-op threads).
+         * Must be called before load(). Not supported by all engines.
+         *
+         * @param threads Nr of threads. If <= 0, the engine decides.
+         */
+        virtual void setNrOfThreads(int threads);
+        virtual int getNrOfThreads() const;
         /**
          * Load a custom operator (op), plugin. Must be called before load()
          *
@@ -193,6 +203,7 @@ class FAST_EXPORT InferenceEngine : public Object {
         int m_deviceIndex = -1;
         InferenceDeviceType m_deviceType = InferenceDeviceType::ANY;
         int m_maxBatchSize = 1;
+        int m_nrOfThreads = -1;
 
         std::vector<uint8_t> m_model;
         std::vector<uint8_t> m_weights;
@@ -20,17 +20,57 @@ std::string print_shape(const std::vector<int64_t>& v) {
   return ss.str();
 }
 
+static ONNXTensorElementDataType getONNXType(DataType type) {
+    switch(type) {
+        case TYPE_FLOAT:
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+        case TYPE_FLOAT16:
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+        case TYPE_UINT8:
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+        case TYPE_INT8:
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+        case TYPE_INT32:
+            return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32;
+        default:
+            throw Exception("Unsupported tensor data type for ONNXRuntime: " + getCTypeAsString(type));
+    }
+}
+
+static DataType getFASTType(ONNXTensorElementDataType type) {
+    switch(type) {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+            return TYPE_FLOAT;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+            return TYPE_FLOAT16;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+            return TYPE_UINT8;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+            return TYPE_INT8;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+            return TYPE_INT32;
+        default:
+            throw Exception("Unsupported ONNXRuntime tensor element type " + std::to_string((int)type));
+    }
+}
 
 void ONNXRuntimeEngine::run() {
 	//auto start = std::chrono::high_resolution_clock::now();
     std::vector<const char*> inputNames;
     std::vector<Ort::Value> inputTensors;
+    std::vector<Tensor::pointer> convertedTensors; // Must be kept alive until the session has run
 	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
     for (const auto& inputNode : mInputNodes) {
         auto tensor = inputNode.second.data;
+        // Convert to the element type of the model, e.g. for FP16 and INT8 models
+        auto elementType = m_inputElementTypes.find(inputNode.first);
+        if(elementType != m_inputElementTypes.end() && (ONNXTensorElementDataType)elementType->second != getONNXType(tensor->getDataType())) {
+            tensor = tensor->convertToType(getFASTType((ONNXTensorElementDataType)elementType->second));
+            convertedTensors.push_back(tensor);
+        }
         auto access = tensor->getAccess(ACCESS_READ);
 		inputNames.push_back(strdup(inputNode.first.c_str()));
-        float* tensorData = access->getRawData();
+        void* tensorData = access->get();
         reportInfo() << "ONNXRuntime: Creating memory info.." << reportEnd();
         Ort::MemoryInfo info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeCPU); // Must be TypeCPU to work on CPU
         auto shape = tensor->getShape();
@@ -38,7 +78,7 @@ void ONNXRuntimeEngine::run() {
         std::vector<int64_t> dims;
         for (int x : shape.getAll())
             dims.push_back(x);
-        inputTensors.emplace_back(Ort::Value::CreateTensor<float>(info, tensorData, shape.getTotalSize(), dims.data(), shape.getDimensions()));
+        inputTensors.emplace_back(Ort::Value::CreateTensor(info, tensorData, tensor->getBufferSize(), dims.data(), shape.getDimensions(), getONNXType(tensor->getDataType())));
     }
     std::vector<const char*> outputNames;
 	// Important to use reference here, as we are using c_str() which does not copy string, and will be deleted if std::string is deleted.
@@ -53,23 +93,32 @@ void ONNXRuntimeEngine::run() {
     //std::chrono::duration<float, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
     //std::cout << "Run: " << duration.count() << std::endl;
 
-    // Copy output data to FAST
+    // Give output data to FAST without copying. The Ort::Value is kept alive until the FAST tensor data is deleted.
     int counter = 0;
     for(auto& outputNode : mOutputNodes) {
-        const float* data = output[counter].GetTensorData<float>();
-        // Get shape of output tensor
+        // Get shape and type of output tensor
+        auto info = output[counter].GetTensorTypeAndShapeInfo();
         auto shape = TensorShape();
-        for(int x : output[counter].GetTensorTypeAndShapeInfo().GetShape()) {
+        for(int x : info.GetShape()) {
             shape.addDimension(x);
         }
-        const auto name = outputNode.first;
+        const DataType type = getFASTType(info.GetElementType());
+        auto holder = new Ort::Value(std::move(output[counter]));
+        unique_pixel_ptr data(holder->GetTensorMutableData<void>(), [holder](void*) { delete holder; });
         outputNode.second.shape = shape;
-        auto outputTensor = Tensor::create(data, shape);
+        auto outputTensor = Tensor::create(std::move(data), shape, type);
         outputNode.second.data = outputTensor;
         ++counter;
     }
 }
 
+static Ort::SessionOptions createSessionOptions(int threads) {
+    Ort::SessionOptions session_options;
+    if(threads > 0)
+        session_options.SetIntraOpNumThreads(threads);
+    return session_options;
+}
+
 void ONNXRuntimeEngine::load() {
     const auto filename = getFilename();
     std::wstring wideStr(filename.begin(), filename.end());
@@ -78,7 +127,7 @@ void ONNXRuntimeEngine::load() {
     //auto start = std::chrono::high_resolution_clock::now();
 	m_env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntime");
     if(m_deviceType == InferenceDeviceType::CPU) {
-		Ort::SessionOptions session_options;
+		Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
 #ifdef WIN32
 		m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
 #else
@@ -87,7 +136,7 @@ void ONNXRuntimeEngine::load() {
     } else {
 #ifdef WIN32
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
             SetDllDirectory(Config::getLibraryPath().c_str()); // Make sure delay-load dlls are found (directml.dll) etc.
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_DML(session_options, 0));
             session_options.DisableMemPattern();
@@ -96,25 +145,25 @@ void ONNXRuntimeEngine::load() {
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load DirectML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what()  << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
             m_session = std::make_unique<Ort::Session>(*m_env.get(), wideStr.c_str(), session_options);
         }
 #elif defined(__APPLE__) || defined(__MACOSX)
         // APPLE
         try {
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
             uint32_t coreml_flags = 0;
             Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_CoreML(session_options, coreml_flags));
             m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
         }
         catch (Ort::Exception& e) {
             reportWarning() << "Exception occured while trying to load CoreML for ONNXRuntime with message: (" << e.GetOrtErrorCode() << ") " << e.what() << ". Falling back to CPU." << reportEnd();
-            Ort::SessionOptions session_options;
+            Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
             m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
         }
 #else
         // LINUX (only CPU available)
-        Ort::SessionOptions session_options;
+        Ort::SessionOptions session_options = createSessionOptions(m_nrOfThreads);
         m_session = std::make_unique<Ort::Session>(*m_env.get(), filename.c_str(), session_options);
 #endif
     }
@@ -141,6 +190,7 @@ void ONNXRuntimeEngine::load() {
    for(auto node : sortedInputNodes) {
 		auto i = node.second;
         std::string name = m_session->GetInputNameAllocated(i, allocator).get();
+		m_inputElementTypes[name] = m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType();
 		reportInfo() << "Found input node: " << name << " : " << print_shape(m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()) << reportEnd();
 		auto shape = TensorShape();
 		for(int x : m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape()) {
@@ -46,6 +46,8 @@ public:
 private:
 	std::unique_ptr<Ort::Session> m_session;
 	std::unique_ptr<Ort::Env> m_env;
+	// ONNXTensorElementDataType of each input node of the model
+	std::map<std::string, int> m_inputElementTypes;
 };
 
 DEFINE_INFERENCE_ENGINE(ONNXRuntimeEngine, INFERENCEENGINEONNXRUNTIME_EXPORT)
@@ -9,6 +9,33 @@ public:
     ov::InferRequest request;
 };
 
+static ov::element::Type getOpenVINOType(DataType type) {
+    switch(type) {
+        case TYPE_FLOAT:
+            return ov::element::f32;
+        case TYPE_FLOAT16:
+            return ov::element::f16;
+        case TYPE_UINT8:
+            return ov::element::u8;
+        case TYPE_INT8:
+            return ov::element::i8;
+        default:
+            throw Exception("Unsupported tensor data type for OpenVINO: " + getCTypeAsString(type));
+    }
+}
+
+static DataType getFASTType(ov::element::Type type) {
+    if(type == ov::element::f16) {
+        return TYPE_FLOAT16;
+    } else if(type == ov::element::u8) {
+        return TYPE_UINT8;
+    } else if(type == ov::element::i8) {
+        return TYPE_INT8;
+    } else if(type == ov::element::f32) {
+        return TYPE_FLOAT;
+    }
+    throw Exception("Unsupported OpenVINO tensor element type " + type.get_type_name());
+}
 
 void OpenVINOEngine::run() {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -17,14 +44,16 @@ void OpenVINOEngine::run() {
     reportInfo() << "OpenVINO processing input nodes." << reportEnd();
     for(auto inputNode : mInputNodes) {
         const auto index = m_inputIndices[inputNode.first];
-        auto tensor = inputNode.second.data;
+        // Convert input to the element type the model expects
+        const auto type = getFASTType(m_infer->request.get_input_tensor(index).get_element_type());
+        auto tensor = inputNode.second.data->convertToType(type);
         auto access = tensor->getAccess(ACCESS_READ);
-        float* tensorData = access->getRawData();
+        void* tensorData = access->get();
         ov::Shape shape;
         for(int x : tensor->getShape().getAll()) {
             shape.push_back(x);
         }
-        m_infer->request.set_input_tensor(index, ov::Tensor(ov::element::f32, shape, tensorData));
+        m_infer->request.set_input_tensor(index, ov::Tensor(getOpenVINOType(type), shape, tensorData));
     }
     reportInfo() << "OpenVINO input data added." << reportEnd();
 
@@ -36,16 +65,18 @@ void OpenVINOEngine::run() {
     reportInfo() << "OpenVINO processing output nodes." << reportEnd();
     for(auto& outputNode : mOutputNodes) {
         const auto index = m_outputIndices[outputNode.first];
-        ov::Tensor ovTensor = m_infer->request.get_output_tensor(index);
-        const float* data = ovTensor.data<float>();
-        // Get shape of output tensor
+        // Give output tensor to FAST without copying, and let the request allocate a new output tensor for the next run
+        auto holder = new ov::Tensor(m_infer->request.get_output_tensor(index));
+        // Get shape and type of output tensor
         auto shape = TensorShape();
-        for(int x : ovTensor.get_shape()) {
+        for(int x : holder->get_shape()) {
             shape.addDimension(x);
         }
-        const auto name = outputNode.first;
+        const DataType type = getFASTType(holder->get_element_type());
+        m_infer->request.set_output_tensor(index, ov::Tensor(holder->get_element_type(), holder->get_shape()));
+        unique_pixel_ptr data(holder->data(), [holder](void*) { delete holder; });
         outputNode.second.shape = shape;
-        auto outputTensor = Tensor::create(data, shape);
+        auto outputTensor = Tensor::create(std::move(data), shape, type);
         outputNode.second.data = outputTensor;
     }
     reportInfo() << "OpenVINO processing output nodes done." << reportEnd();
@@ -199,7 +230,10 @@ void OpenVINOEngine::load() {
                 {InferenceDeviceType::CPU, "AUTO:CPU"},
                 {InferenceDeviceType::VPU, "AUTO:MYRIAD"},
                 };
-        ov::CompiledModel compiled_model = m_core->compile_model(model, deviceMap[m_deviceType]);
+        ov::AnyMap properties;
+        if(m_nrOfThreads > 0)
+            properties.emplace(ov::inference_num_threads(m_nrOfThreads));
+        ov::CompiledModel compiled_model = m_core->compile_model(model, deviceMap[m_deviceType], properties);
         reportInfo() << "OpenVINO successfully compiled model" << reportEnd();
         ov::Any execution_devices = compiled_model.get_property(ov::execution_devices);
         reportInfo() << "OpenVINO is running network on " << execution_devices->to_string() << reportEnd();
@@ -70,7 +70,7 @@ TensorFlowTensor::~TensorFlowTensor() {
     delete m_tensorflowTensor;
 }
 
-float* TensorFlowTensor::getHostDataPointer() {
+void* TensorFlowTensor::getHostDataPointer() {
     return m_tensorflowTensor->tensor.flat<float>().data();
 }
 
@@ -113,7 +113,8 @@ void TensorFlowEngine::run() {
 
         // Give tensor data to tensorflow
         // TODO is the data here actually moved?
-        TensorAccess::pointer access = inputNode.second.data->getAccess(ACCESS_READ);
+        auto inputTensor = inputNode.second.data->convertToType(TYPE_FLOAT);
+        TensorAccess::pointer access = inputTensor->getAccess(ACCESS_READ);
         switch(shape.getDimensions()) {
             case 2:
                 input_tensor.tensor<float, 2>() = std::move(access->getData<2>());
@@ -186,6 +187,8 @@ void TensorFlowEngine::load() {
     } else if (m_deviceIndex >= 0) {
         config.mutable_gpu_options()->set_visible_device_list(std::to_string(m_deviceIndex)); // Use specific GPU
     }
+    if(m_nrOfThreads > 0)
+        config.set_intra_op_parallelism_threads(m_nrOfThreads);
 
 	tensorflow::GraphDef tensorflow_graph;
 
@@ -62,7 +62,7 @@ class TensorFlowTensor : public Tensor {
         ~TensorFlowTensor();
     private:
         TensorFlowTensorWrapper* m_tensorflowTensor;
-        float* getHostDataPointer() override;
+        void* getHostDataPointer() override;
         bool hasAnyData() override;
 };
 
@@ -69,6 +69,17 @@ inline unsigned int elementSize(nvinfer1::DataType t) {
     return 0;
 }
 
+inline DataType getFASTType(nvinfer1::DataType t) {
+    switch(t) {
+        case nvinfer1::DataType::kHALF: return TYPE_FLOAT16;
+        case nvinfer1::DataType::kINT8: return TYPE_INT8;
+        case nvinfer1::DataType::kINT32: return TYPE_INT32;
+        case nvinfer1::DataType::kFLOAT: return TYPE_FLOAT;
+        default:
+            throw Exception("Unsupported TensorRT tensor data type " + std::to_string((int)t));
+    }
+}
+
 void* safeCudaMalloc(size_t memSize) {
     void* deviceMem;
     CUDA_CHECK(cudaMalloc(&deviceMem, memSize));
@@ -146,11 +157,12 @@ void TensorRTEngine::run() {
 
     // Allocate data for each input and copy data to it
     for(const auto& inputNode : mInputNodes) {
-        auto tensor = inputNode.second.data;
-        auto access = tensor->getAccess(ACCESS_READ);
-        float* tensorData = access->getRawData();
         const int index = m_inputIndexes.at(inputNode.first);
         auto dtype = m_engine->getBindingDataType(index);
+        // Convert input to the data type of the engine binding
+        auto tensor = inputNode.second.data->convertToType(getFASTType(dtype));
+        auto access = tensor->getAccess(ACCESS_READ);
+        void* tensorData = access->get();
         auto shape = tensor->getShape();
         shape[0] = batchSize;
         if(shape != getTensorShape(m_context->getBindingDimensions(index))) // If shapes differ, e.g. batch size has changed, we need to reshape
@@ -182,7 +194,8 @@ void TensorRTEngine::run() {
         shape[0] = batchSize;
         auto dtype = m_engine->getBindingDataType(index);
         reportInfo() << "Processing output node " << name << reportEnd();
-        auto outputData = make_uninitialized_unique<float[]>(shape.getTotalSize()); // TODO possible type mismatch issue here..
+        const DataType type = getFASTType(dtype);
+        auto outputData = allocatePixelArray(shape.getTotalSize(), type);
         CUDA_CHECK(cudaMemcpy(outputData.get(), m_cudaBuffers[index],
                               shape.getTotalSize() * elementSize(dtype),
                               cudaMemcpyDeviceToHost));
@@ -193,7 +206,7 @@ void TensorRTEngine::run() {
         if(shape.getDimensions() == 0)
             throw Exception("Missing shape for output node");
 
-        auto outputTensor = Tensor::create(std::move(outputData), shape);
+        auto outputTensor = Tensor::create(std::move(outputData), shape, type);
         outputNode.second.data = outputTensor;
         reportInfo() << "Finished moving data to FAST tensor, TensorRT" << reportEnd();
         reportInfo() << "Finished transfer of output data TensorRT" << reportEnd();
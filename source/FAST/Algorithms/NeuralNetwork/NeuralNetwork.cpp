@@ -3,6 +3,8 @@
 #include "FAST/Data/Tensor.hpp"
 #include "FAST/Algorithms/ImageResizer/ImageResizer.hpp"
 #include "InferenceEngineManager.hpp"
+#include <chrono>
+#include <thread>
 
 
 namespace fast {
@@ -63,6 +65,8 @@ void NeuralNetwork::loadAttributes() {
     setScaleFactor(getFloatAttribute("scale-factor"));
     setSignedInputNormalization(getBooleanAttribute("signed-input-normalization"));
     setPreserveAspectRatio(getBooleanAttribute("preserve-aspect"));
+    setDynamicBatching(getIntegerAttribute("dynamic-batch-size"), getIntegerAttribute("dynamic-batch-latency"));
+    setInferenceInstances(getIntegerAttribute("inference-instances"), getIntegerAttribute("threads-per-instance"));
 
     // Load network here so that input and output nodes are readily defined after loadAttributes()
 	load(getStringAttribute("model"));
@@ -134,6 +138,10 @@ NeuralNetwork::NeuralNetwork() {
 	createStringAttribute("output-nodes", "Output node names, and shapes", "Example: input_node_1:256,256,1  input_node2:1", "");
 	createBooleanAttribute("signed-input-normalization", "Signed input normalization", "Normalize input to -1 and 1 instead of 0 to 1.", false);
     createBooleanAttribute("preserve-aspect", "Preserve aspect ratio of input images", "", mPreserveAspectRatio);
+    createIntegerAttribute("dynamic-batch-size", "Dynamic batch size", "Max nr of streamed frames to collect and process as one batch. 1 disables dynamic batching.", m_dynamicBatchSize);
+    createIntegerAttribute("dynamic-batch-latency", "Dynamic batch latency", "Max time in milliseconds to wait for frames to fill a dynamic batch.", m_dynamicBatchLatency);
+    createIntegerAttribute("inference-instances", "Inference instances", "Nr of inference engine instances to run in parallel.", m_inferenceInstances);
+    createIntegerAttribute("threads-per-instance", "Threads per instance", "Max nr of threads each inference engine instance can use. -1 divides the cores evenly among the instances.", m_threadsPerInstance);
     createStringAttribute("dimension-ordering", "Dimension ordering", "Dimension ordering (channel-last or channel-first), will override auto detecting if set.", "");
 
 	m_engine = InferenceEngineManager::loadBestAvailableEngine();
@@ -155,7 +163,12 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
             continue;
         }
 
-        std::shared_ptr<DataObject> data = getInputData<DataObject>(inputNode.second.id);
+        std::shared_ptr<DataObject> data;
+        if(m_collectedInputData.count(inputNode.second.id) > 0) {
+            data = m_collectedInputData[inputNode.second.id];
+        } else {
+            data = getInputData<DataObject>(inputNode.second.id);
+        }
         mRuntimeManager->startRegularTimer("input_processing");
 
         bool containsSequence = false;
@@ -289,13 +302,14 @@ std::unordered_map<std::string, Tensor::pointer> NeuralNetwork::processInputData
                 auto shape = inputTensors.front()->getShape();
                 m_batchSize = shape[0];
                 shape.insertDimension(0, inputTensors.size());
-                auto tensor = Tensor::create(shape);
+                const DataType type = inputTensors.front()->getDataType();
+                auto tensor = Tensor::create(shape, type);
                 auto access = tensor->getAccess(ACCESS_READ_WRITE);
-                float* data = access->getRawData();
+                auto data = (uchar*)access->get();
                 for(int i = 0; i < inputTensors.size(); ++i) {
-                    auto accessRead = inputTensors[i]->getAccess(ACCESS_READ);
-                    const int totalSize = accessRead->getShape().getTotalSize();
-                    std::memcpy(&data[i*totalSize], accessRead->getRawData(), totalSize*sizeof(float));
+                    auto accessRead = inputTensors[i]->convertToType(type)->getAccess(ACCESS_READ);
+                    const std::size_t bytes = getSizeOfDataType(type, accessRead->getShape().getTotalSize());
+                    std::memcpy(&data[i*bytes], accessRead->get(), bytes);
                 }
             }
         } else {
@@ -327,6 +341,7 @@ Tensor::pointer NeuralNetwork::standardizeOutputTensorData(Tensor::pointer tenso
     // Transform tensor to channel last if necessary
     if(m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst) {
         // Convert to channel last
+        tensor = tensor->convertToType(TYPE_FLOAT);
         const int nrOfClasses = tensor->getShape()[0];
         const int size = tensor->getShape().getTotalSize()/nrOfClasses;
         auto newTensorData = make_uninitialized_unique<float[]>(size*nrOfClasses);
@@ -351,19 +366,17 @@ Tensor::pointer NeuralNetwork::standardizeOutputTensorData(Tensor::pointer tenso
     // Transfer frame data and spacing information from input to output data
     for(auto& inputNode : m_engine->getInputNodes()) {
         if(mInputImages.count(inputNode.first) > 0) {
-            for(auto &&frameData : mInputImages[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->mergeFrameData(mInputImages[inputNode.first][sample]->getTypedFrameData());
             for(auto &&lastFrame : mInputImages[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             // TODO will cause issue if multiple input images:
             tensor->setSpacing(mNewInputSpacing);
-            tensor->setFrameData("network-input-size-x", std::to_string(m_newInputSize.x()));
-            tensor->setFrameData("network-input-size-y", std::to_string(m_newInputSize.y()));
-            tensor->setFrameData("network-input-size-z", std::to_string(m_newInputSize.z()));
+            tensor->setFrameData("network-input-size-x", m_newInputSize.x());
+            tensor->setFrameData("network-input-size-y", m_newInputSize.y());
+            tensor->setFrameData("network-input-size-z", m_newInputSize.z());
             SceneGraph::setParentNode(tensor, mInputImages[inputNode.first][sample]);
         } else {
-            for(auto &&frameData : mInputTensors[inputNode.first][sample]->getFrameData())
-                tensor->setFrameData(frameData.first, frameData.second);
+            tensor->mergeFrameData(mInputTensors[inputNode.first][sample]->getTypedFrameData());
             for(auto &&lastFrame : mInputTensors[inputNode.first][sample]->getLastFrame())
                 tensor->setLastFrame(lastFrame);
             SceneGraph::setParentNode(tensor, mInputTensors[inputNode.first][sample]);
@@ -410,7 +423,8 @@ void NeuralNetwork::processOutputTensors() {
             // Create a batch of tensors
             std::vector<Tensor::pointer> tensorList;
             auto tensorAccess = tensor->getAccess(ACCESS_READ);
-            const float* rawTensorData = tensorAccess->getRawData();
+            const auto rawTensorData = (const uchar*)tensorAccess->get();
+            const DataType type = tensor->getDataType();
             // Calculate sample size
             auto shape = tensor->getShape();
             int size = 1;
@@ -421,9 +435,10 @@ void NeuralNetwork::processOutputTensors() {
             }
 
             for(int i = 0; i < m_batchSize; ++i) {
-                auto newData = make_uninitialized_unique<float[]>(size);
-                std::memcpy(newData.get(), &(rawTensorData[i*size]), size*sizeof(float));
-                auto newTensor = Tensor::create(std::move(newData), newShape);
+                const std::size_t bytes = getSizeOfDataType(type, size);
+                auto newData = allocatePixelArray(size, type);
+                std::memcpy(newData.get(), &(rawTensorData[i*bytes]), bytes);
+                auto newTensor = Tensor::create(std::move(newData), newShape, type);
                 newTensor = standardizeOutputTensorData(newTensor, i);
                 tensorList.push_back(newTensor);
             }
@@ -444,12 +459,312 @@ void NeuralNetwork::processOutputTensors() {
 }
 
 void NeuralNetwork::execute() {
-    // Load, prepare input and run network
-    runNeuralNetwork();
+    if(m_inferenceInstances > 1) {
+        if(mTemporalWindow > 0 || !m_temporalStateNodes.empty()) {
+            reportWarning() << "Multiple inference instances can't be used with temporal neural networks, using a single instance." << reportEnd();
+            m_inferenceInstances = 1;
+        } else {
+            executeWithInstances();
+            return;
+        }
+    }
+
+    if(m_dynamicBatchOutputs.empty()) {
+        const bool dynamicBatch = collectDynamicBatch();
+
+        // Load, prepare input and run network
+        runNeuralNetwork();
+        m_collectedInputData.clear();
+
+        if(!dynamicBatch) {
+            // Add output data to output ports
+            for(const auto &node : m_processedOutputData) {
+                addOutputData(node.first, node.second);
+            }
+            return;
+        }
+
+        // Split output into one set of output data per input frame
+        for(const auto &node : m_processedOutputData) {
+            auto batch = std::dynamic_pointer_cast<Batch>(node.second);
+            std::vector<DataObject::pointer> outputs;
+            if(batch) {
+                for(auto&& tensor : batch->get().getTensors())
+                    outputs.push_back(tensor);
+            } else {
+                outputs.push_back(node.second);
+            }
+            m_dynamicBatchOutputs.resize(std::max(m_dynamicBatchOutputs.size(), outputs.size()));
+            for(int i = 0; i < outputs.size(); ++i)
+                m_dynamicBatchOutputs[i][node.first] = outputs[i];
+        }
+    }
+
+    // Output data of one frame each execute. Frame data and last frame of each input frame have already been added
+    // in standardizeOutputTensorData, thus don't propagate as that would add frame data of the last frame to all.
+    for(const auto &node : m_dynamicBatchOutputs.front())
+        addOutputData(node.first, node.second, false, false);
+    m_dynamicBatchOutputs.pop_front();
+    // Make sure this process object is executed again even if there is no new input data
+    if(!m_dynamicBatchOutputs.empty())
+        mIsModified = true;
+}
+
+bool NeuralNetwork::collectDynamicBatch() {
+    if(m_dynamicBatchSize <= 1)
+        return false;
+
+    if(!m_engine->isLoaded())
+        m_engine->load();
+    auto inputNodes = m_engine->getInputNodes();
+    const auto shape = inputNodes.empty() ? TensorShape() : inputNodes.begin()->second.shape;
+    if(inputNodes.size() != 1 || mTemporalWindow > 0 || !m_temporalStateNodes.empty() ||
+        shape.getDimensions() < 4 || shape[0] > 0 || shape.getUnknownDimensions(true) > 0) {
+        reportWarning() << "Dynamic batching in NeuralNetwork requires a single image input node with a dynamic batch "
+                           "dimension and a fixed image size. Dynamic batching is disabled." << reportEnd();
+        m_dynamicBatchSize = 1;
+        return false;
+    }
+
+    const uint portID = inputNodes.begin()->second.id;
+    // Wait for first frame
+    auto data = getInputData<DataObject>(portID);
+    m_collectedInputData[portID] = data;
+    auto image = std::dynamic_pointer_cast<Image>(data);
+    if(!image) // Batch, Sequence or Tensor, process as normal
+        return false;
+    if(image->isLastFrame())
+        return true;
+
+    mRuntimeManager->startRegularTimer("dynamic_batching");
+    std::vector<Image::pointer> images = {image};
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_dynamicBatchLatency);
+    while(images.size() < m_dynamicBatchSize) {
+        // Frames which are already available are collected even if the deadline has passed
+        const auto timeout = std::max(std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()), std::chrono::microseconds(0));
+        auto nextData = tryGetInputData(portID, timeout);
+        if(!nextData)
+            break;
+        auto nextImage = std::dynamic_pointer_cast<Image>(nextData);
+        if(!nextImage)
+            throw BadCastException(nextData->getNameOfClass(), Image::getStaticNameOfClass());
+        images.push_back(nextImage);
+        if(nextImage->isLastFrame())
+            break;
+    }
+    mRuntimeManager->stopRegularTimer("dynamic_batching");
+    reportInfo() << "Dynamic batching collected " << images.size() << " frames" << reportEnd();
+
+    if(images.size() > 1)
+        m_collectedInputData[portID] = Batch::create(images);
+    return true;
+}
+
+DataObject::pointer NeuralNetwork::tryGetInputData(uint portID, std::chrono::microseconds timeout) {
+    auto data = mInputConnections.at(portID)->tryGetNextFrame(timeout);
+    if(!data)
+        return nullptr;
+    // Do the same bookkeeping as getInputData, except frame data which is kept per frame
+    mLastProcessed[portID] = std::make_pair(data, data->getTimestamp());
+    for(auto&& lastFrame : data->getLastFrame())
+        m_lastFrame.insert(lastFrame);
+    return data;
+}
+
+void NeuralNetwork::executeWithInstances() {
+    if(m_workers.empty())
+        startInferenceWorkers();
+
+    // Submit jobs until there is enough work in flight to keep all instances busy
+    const int maxJobs = 2*m_inferenceInstances;
+    while(m_jobWindow.size() < maxJobs && !mInputConnections.empty()) {
+        auto job = std::make_shared<InferenceJob>();
+        auto firstPort = mInputConnections.begin();
+        if(m_jobWindow.empty()) {
+            // Nothing in flight, wait for input
+            job->input[firstPort->first] = getInputData<DataObject>(firstPort->first);
+        } else {
+            // Only submit more jobs if input is available without waiting
+            auto data = tryGetInputData(firstPort->first);
+            if(!data)
+                break;
+            job->input[firstPort->first] = data;
+        }
+        for(auto port = std::next(firstPort); port != mInputConnections.end(); ++port)
+            job->input[port->first] = getInputData<DataObject>(port->first);
+        m_jobWindow.push_back(job);
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_jobQueue.push_back(job);
+        }
+        m_jobAvailable.notify_one();
+    }
+
+    // Emit output of oldest job, to keep the input order
+    auto job = m_jobWindow.front();
+    m_jobWindow.pop_front();
+    {
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        m_jobDone.wait(lock, [&job] { return job->done; });
+    }
+    if(job->error)
+        std::rethrow_exception(job->error);
+    // Frame data has already been added to the output by the instance
+    for(auto&& output : job->output)
+        addOutputData(output.first, output.second, false, false);
+
+    // Make sure this process object is executed again even if there is no new input data
+    if(!m_jobWindow.empty())
+        mIsModified = true;
+}
+
+void NeuralNetwork::startInferenceWorkers() {
+    if(m_engine->getFilename().empty())
+        throw Exception("Multiple inference instances in NeuralNetwork requires that the model is loaded from a file");
+    int threads = m_threadsPerInstance;
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency() / m_inferenceInstances);
+
+    reportInfo() << "Creating " << m_inferenceInstances << " inference instances with " << threads << " threads each" << reportEnd();
+    for(int i = 0; i < m_inferenceInstances; ++i) {
+        auto engine = InferenceEngineManager::loadEngine(m_engine->getName());
+        engine->setDevice(m_engine->getDeviceIndex(), m_engine->getDeviceType());
+        engine->setMaxBatchSize(m_engine->getMaxBatchSize());
+        engine->setNrOfThreads(threads);
+
+        auto instance = NeuralNetwork::New();
+        instance->setInferenceEngine(engine);
+        for(auto&& node : m_engine->getInputNodes())
+            instance->setInputNode(node.second);
+        for(auto&& node : m_engine->getOutputNodes())
+            instance->setOutputNode(node.second);
+        instance->load(m_engine->getFilename());
+        engine->setImageOrdering(m_engine->getPreferredImageOrdering());
+        instance->mScaleFactor = mScaleFactor;
+        instance->mMean = mMean;
+        instance->mStd = mStd;
+        instance->mMinIntensity = mMinIntensity;
+        instance->mMaxIntensity = mMaxIntensity;
+        instance->mMinAndMaxIntensitySet = mMinAndMaxIntensitySet;
+        instance->mSignedInputNormalization = mSignedInputNormalization;
+        instance->mHorizontalImageFlipping = mHorizontalImageFlipping;
+        instance->mPreserveAspectRatio = mPreserveAspectRatio;
+        instance->mInputSizes = mInputSizes;
+        m_instances.push_back(instance);
+    }
+    m_stopWorkers = false;
+    for(int i = 0; i < m_inferenceInstances; ++i)
+        m_workers.push_back(std::thread(&NeuralNetwork::inferenceWorker, this, i));
+}
+
+void NeuralNetwork::stopInferenceWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_stopWorkers = true;
+    }
+    m_jobAvailable.notify_all();
+    for(auto&& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_instances.clear();
+    m_jobQueue.clear();
+    m_jobWindow.clear();
+}
+
+void NeuralNetwork::inferenceWorker(int index) {
+    auto instance = m_instances[index];
+    while(true) {
+        std::shared_ptr<InferenceJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobAvailable.wait(lock, [this] { return m_stopWorkers || !m_jobQueue.empty(); });
+            if(m_stopWorkers)
+                return;
+            job = m_jobQueue.front();
+            m_jobQueue.pop_front();
+        }
+        try {
+            for(auto&& input : job->input)
+                instance->setInputData(input.first, input.second);
+            instance->run();
+            for(auto&& node : instance->getOutputNodes())
+                job->output[node.second.id] = instance->getOutputData(node.second.id);
+        } catch(...) {
+            job->error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            job->done = true;
+        }
+        m_jobDone.notify_all();
+    }
+}
+
+void NeuralNetwork::setInferenceInstances(int instances, int threadsPerInstance) {
+    // Subclasses post-process the output of a single frame in their own execute
+    if(instances > 1 && getNameOfClass() != NeuralNetwork::getStaticNameOfClass())
+        throw Exception("Multiple inference instances are not supported by " + getNameOfClass() + ", only by NeuralNetwork");
+    if(!m_workers.empty())
+        stopInferenceWorkers();
+    m_inferenceInstances = std::max(1, instances);
+    m_threadsPerInstance = threadsPerInstance;
+    setModified(true);
+}
+
+int NeuralNetwork::getInferenceInstances() const {
+    return m_inferenceInstances;
+}
+
+void NeuralNetwork::setDynamicBatching(int maxBatchSize, int maxLatency) {
+    if(maxLatency < 0)
+        throw Exception("Max latency for dynamic batching must be >= 0");
+    // Subclasses post-process the output of a single frame in their own execute
+    if(maxBatchSize > 1 && getNameOfClass() != NeuralNetwork::getStaticNameOfClass())
+        throw Exception("Dynamic batching is not supported by " + getNameOfClass() + ", only by NeuralNetwork");
+    m_dynamicBatchSize = std::max(1, maxBatchSize);
+    m_dynamicBatchLatency = maxLatency;
+    if(!m_engine->isLoaded() && m_engine->getMaxBatchSize() < m_dynamicBatchSize)
+        m_engine->setMaxBatchSize(m_dynamicBatchSize);
+}
+
+int NeuralNetwork::getDynamicBatchSize() const {
+    return m_dynamicBatchSize;
+}
 
-    // Add output data to output ports
-    for(const auto &node : m_processedOutputData) {
-        addOutputData(node.first, node.second);
+int NeuralNetwork::getDynamicBatchLatency() const {
+    return m_dynamicBatchLatency;
+}
+
+/**
+ * Normalize image data on the host and write it to the output tensor data, same as the normalize kernels in
+ * NeuralNetwork.cl. Normalization is done as output = clamp(input)*scale + bias.
+ * The loops are kept simple, without branches, so that the compiler can vectorize them.
+ */
+template <class T>
+static void normalizeInputOnHost(const T* input, float* output, int64_t size, int channels, float scale, float bias,
+                                 bool clip, float minIntensity, float maxIntensity, bool channelFirst) {
+    if(!channelFirst) {
+        // Channel last has the same layout as the image, thus process all values in one loop
+        const int64_t total = size*channels;
+        if(clip) {
+            for(int64_t i = 0; i < total; ++i)
+                output[i] = std::min(std::max((float)input[i], minIntensity), maxIntensity)*scale + bias;
+        } else {
+            for(int64_t i = 0; i < total; ++i)
+                output[i] = (float)input[i]*scale + bias;
+        }
+    } else {
+        for(int c = 0; c < channels; ++c) {
+            float* channelOutput = &output[c*size];
+            const T* channelInput = &input[c];
+            if(clip) {
+                for(int64_t i = 0; i < size; ++i)
+                    channelOutput[i] = std::min(std::max((float)channelInput[i*channels], minIntensity), maxIntensity)*scale + bias;
+            } else {
+                for(int64_t i = 0; i < size; ++i)
+                    channelOutput[i] = (float)channelInput[i*channels]*scale + bias;
+            }
+        }
     }
 }
 
@@ -499,6 +814,14 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
     }
     cl::Kernel kernel(program, kernelName.c_str());
     const std::size_t size = width*height*depth*channels; // nr of elements per image
+    // Normalization as a single multiply-add for the host path: ((x - mean)/std)*scale, then optionally *2 - 1
+    float hostScale = mScaleFactor/mStd;
+    float hostBias = -mMean*mScaleFactor/mStd;
+    if(mSignedInputNormalization) {
+        hostScale *= 2.0f;
+        hostBias = hostBias*2.0f - 1.0f;
+    }
+    const bool channelFirst = m_engine->getPreferredImageOrdering() == ImageOrdering::ChannelFirst;
     for(int i = 0; i < images.size(); ++i) {
         auto image = images[i];
         if(image->getWidth() != width ||
@@ -511,6 +834,21 @@ Tensor::pointer NeuralNetwork::convertImagesToTensor(std::vector<Image::pointer>
         if(image->getNrOfChannels() != channels)
             throw Exception("Input image sent to executeNetwork has incorrect nr of channels: " +
                     std::to_string(image->getNrOfChannels())+ ". Expected: " + std::to_string(channels) + ".");
+        // If image data is already on the host, normalize it directly into the tensor data on the host
+        // instead of transferring it to the GPU and back. Normalized integer types and flipping are only supported by the kernels.
+        const DataType type = image->getDataType();
+        if(image->isHostDataUpToDate() && !mHorizontalImageFlipping && type != TYPE_SNORM_INT16 && type != TYPE_UNORM_INT16) {
+            mRuntimeManager->startRegularTimer("host_input_normalization");
+            auto access = image->getImageAccess(ACCESS_READ);
+            float* output = values.get() + i*size;
+            switch(type) {
+                fastSwitchTypeMacro(normalizeInputOnHost<FAST_TYPE>((const FAST_TYPE*)access->get(), output,
+                        (int64_t)width*height*depth, channels, hostScale, hostBias, mMinAndMaxIntensitySet,
+                        mMinIntensity, mMaxIntensity, channelFirst))
+            }
+            mRuntimeManager->stopRegularTimer("host_input_normalization");
+            continue;
+        }
         OpenCLImageAccess::pointer access = image->getOpenCLImageAccess(ACCESS_READ, device);
         cl::Buffer buffer(
                 device->getContext(),
@@ -593,6 +931,8 @@ void NeuralNetwork::setSignedInputNormalization(bool signedInputNormalization) {
 }
 
 NeuralNetwork::~NeuralNetwork() {
+    if(!m_workers.empty())
+        stopInferenceWorkers();
 }
 
 void NeuralNetwork::setInputNode(NeuralNetworkNode node) {
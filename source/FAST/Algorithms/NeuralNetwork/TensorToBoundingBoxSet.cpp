@@ -68,7 +68,7 @@ void TensorToBoundingBoxSet::execute() {
         if(!tensor)
             throw Exception("Output data " + std::to_string(node.first) + " was not a tensor");
         const auto shape = tensor->getShape();
-        auto access = tensor->getAccess(ACCESS_READ);
+        auto access = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
         const int dims = shape.getDimensions();
         if(dims != 3)
             throw Exception("Expected nr of output dimensions to be 3");
@@ -15,7 +15,7 @@ TensorToImage::TensorToImage(std::vector<int> channels) {
 void TensorToImage::execute() {
     auto tensor = getInputData<Tensor>();
     const auto shape = tensor->getShape();
-    auto access = tensor->getAccess(ACCESS_READ);
+    auto access = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
     const int dims = shape.getDimensions();
     const int channelsInTensor = shape[dims-1];
     const int outputWidth = shape[dims-2];
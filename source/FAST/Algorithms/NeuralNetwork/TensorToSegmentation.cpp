@@ -37,7 +37,7 @@ void TensorToSegmentation::execute() {
     int outputHeight = shape[dims-3];
     int outputWidth = shape[dims-2];
     int outputDepth = 1;
-    auto access = tensor->getAccess(ACCESS_READ);
+    auto access = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
     float* tensorData = access->getRawData();
     if(dims == 4) {
         outputDepth = shape[dims - 4];
@@ -15,6 +15,8 @@
 #include <FAST/Streamers/ImageFileStreamer.hpp>
 #include <FAST/Visualization/HeatmapRenderer/HeatmapRenderer.hpp>
 #include <FAST/Visualization/Widgets/PlaybackWidget/PlaybackWidget.hpp>
+#include <FAST/Algorithms/ImagePatch/PatchGenerator.hpp>
+#include <chrono>
 
 using namespace fast;
 
@@ -435,6 +437,151 @@ TEST_CASE("NN: temporal input temporal output, streaming mode", "[fast][neuralne
     }
 }
 
+TEST_CASE("NN: host and OpenCL input normalization give same result", "[fast][neuralnetwork]") {
+    for(auto&& engine : InferenceEngineManager::getEngineList()) {
+        auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+        auto hostImage = importer->runAndGetOutputData<Image>();
+        // Copy image to GPU, so that the host data is not up to date
+        auto device = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+        auto image = hostImage->copy(device);
+        REQUIRE(hostImage->isHostDataUpToDate());
+        REQUIRE_FALSE(image->isHostDataUpToDate());
+
+        std::vector<Tensor::pointer> results;
+        for(auto&& input : {hostImage, image}) {
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            if(engine == "TensorFlow") {
+                // TensorFlow needs to know about the two nodes
+                network->setOutputNode(0, "dense_1/BiasAdd", NodeType::TENSOR);
+                network->setOutputNode(1, "dense_2/BiasAdd", NodeType::TENSOR);
+            }
+            network->load(join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/single_input_multi_output." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            network->setScaleFactor(1.0f/255.0f);
+            network->setMeanAndStandardDeviation(10.0f, 2.0f);
+            network->setMinAndMaxIntensity(20.0f, 200.0f);
+            network->setSignedInputNormalization(true);
+            network->setInputData(input);
+            results.push_back(network->runAndGetOutputData<Tensor>());
+        }
+        auto access1 = results[0]->getAccess(ACCESS_READ);
+        auto access2 = results[1]->getAccess(ACCESS_READ);
+        REQUIRE(results[0]->getShape()[0] == results[1]->getShape()[0]);
+        for(int i = 0; i < results[0]->getShape()[0]; ++i)
+            CHECK(access1->getRawData()[i] == Approx(access2->getRawData()[i]).margin(1e-4));
+    }
+}
+
+TEST_CASE("NN: dynamic batching of streamed images", "[fast][neuralnetwork][batch]") {
+    for(auto&& engine : InferenceEngineManager::getEngineList()) {
+#ifdef WIN32
+#elif defined(__APPLE__) || defined(__MACOSX)
+#else
+        if(engine == "ONNXRuntime") {
+            // This test hangs on linux for ONNXRuntime for some reason
+            continue;
+        }
+#endif
+        const int nrOfFrames = 10;
+        // Run without and with dynamic batching, and compare the results
+        std::vector<Tensor::pointer> results[2];
+        for(int dynamicBatching : {0, 1}) {
+            auto streamer = ImageFileStreamer::create(Config::getTestDataPath() + "US/JugularVein/US-2D_#.mhd", false, false);
+            streamer->setMaximumNumberOfFrames(nrOfFrames);
+
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            if(dynamicBatching == 1)
+                network->setDynamicBatching(4, 100);
+            if(engine == "TensorFlow") {
+                // TensorFlow needs to know about the two nodes
+                network->setOutputNode(0, "dense_1/BiasAdd", NodeType::TENSOR);
+                network->setOutputNode(1, "dense_2/BiasAdd", NodeType::TENSOR);
+            }
+            network->load(join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/single_input_multi_output." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            network->setInputConnection(streamer->getOutputPort());
+            auto port = network->getOutputPort(0);
+            for(int i = 0; i < nrOfFrames; ++i) {
+                network->update();
+                auto data = port->getNextFrame<Tensor>();
+                REQUIRE(data->getShape().getDimensions() == 1);
+                CHECK(data->getShape()[0] == 6);
+                CHECK(data->isLastFrame() == (i == nrOfFrames - 1));
+                results[dynamicBatching].push_back(data);
+            }
+        }
+
+        for(int i = 0; i < nrOfFrames; ++i) {
+            auto access1 = results[0][i]->getAccess(ACCESS_READ);
+            auto access2 = results[1][i]->getAccess(ACCESS_READ);
+            for(int j = 0; j < 6; ++j)
+                CHECK(access1->getRawData()[j] == Approx(access2->getRawData()[j]).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("NN: dynamic batching is rejected by subclasses of NeuralNetwork", "[fast][neuralnetwork][batch]") {
+    auto network = SegmentationNetwork::New();
+    CHECK_THROWS(network->setDynamicBatching(4));
+    CHECK_NOTHROW(network->setDynamicBatching(1));
+}
+
+TEST_CASE("NN: inference instances are rejected by subclasses of NeuralNetwork", "[fast][neuralnetwork]") {
+    auto network = SegmentationNetwork::New();
+    CHECK_THROWS(network->setInferenceInstances(4));
+    CHECK_NOTHROW(network->setInferenceInstances(1));
+}
+
+TEST_CASE("NN: inference instances benchmark", "[fast][neuralnetwork][benchmark]") {
+    for(auto&& engine : InferenceEngineManager::getEngineList()) {
+        if(engine == "TensorRT") // GPU only
+            continue;
+        std::vector<float> firstResults;
+        for(int instances : {1, 2, 4, 8}) {
+            auto importer = ImageFileImporter::create(Config::getTestDataPath() + "US/JugularVein/US-2D_0.mhd");
+            auto generator = PatchGenerator::create(32, 32);
+            generator->connect(importer);
+
+            auto network = NeuralNetwork::New();
+            network->setInferenceEngine(engine);
+            network->getInferenceEngine()->setDeviceType(InferenceDeviceType::CPU);
+            if(engine == "TensorFlow") {
+                // TensorFlow needs to know about the two nodes
+                network->setOutputNode(0, "dense_1/BiasAdd", NodeType::TENSOR);
+                network->setOutputNode(1, "dense_2/BiasAdd", NodeType::TENSOR);
+            }
+            network->load(join(Config::getTestDataPath(),
+                               "NeuralNetworkModels/single_input_multi_output." +
+                               getModelFileExtension(network->getInferenceEngine()->getPreferredModelFormat())));
+            network->setInferenceInstances(instances);
+            network->connect(generator);
+            auto port = network->getOutputPort(0);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            int patches = 0;
+            Tensor::pointer data;
+            do {
+                network->update();
+                data = port->getNextFrame<Tensor>();
+                if(instances == 1) {
+                    firstResults.push_back(data->getAccess(ACCESS_READ)->getRawData()[0]);
+                } else {
+                    // Results should be the same, and in the same order, as with a single instance
+                    REQUIRE(patches < firstResults.size());
+                    CHECK(data->getAccess(ACCESS_READ)->getRawData()[0] == Approx(firstResults[patches]).margin(1e-4));
+                }
+                ++patches;
+            } while(!data->isLastFrame());
+            std::chrono::duration<float> duration = std::chrono::high_resolution_clock::now() - start;
+            std::cout << engine << " with " << instances << " inference instances: " << patches / duration.count() << " patches/sec" << std::endl;
+        }
+    }
+}
+
 /*
 TEST_CASE("Dynamic input shapes", "[fast][dynamicshapes]") {
     auto network = NeuralNetwork::create("/home/smistad/workspace/adapt-ai-tuning/models/unet-adapt-rspace-full-res-ssim-1.5-dynamic.onnx",
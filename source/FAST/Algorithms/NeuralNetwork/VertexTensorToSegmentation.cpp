@@ -28,7 +28,7 @@ void VertexTensorToSegmentation::execute() {
     int width = tensor->getFrameData<int>("network-input-size-x");
     int height = tensor->getFrameData<int>("network-input-size-y");
 
-    auto access = tensor->getAccess(ACCESS_READ);
+    auto access = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
     auto shape = access->getShape();
     auto tensorData = access->getData<2>();
 
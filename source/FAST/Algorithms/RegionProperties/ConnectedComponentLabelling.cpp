@@ -0,0 +1,577 @@
+#include "ConnectedComponentLabelling.hpp"
+#include <FAST/Data/ImagePyramid.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <numeric>
+#include <array>
+
+namespace fast {
+
+namespace {
+
+// Properties summed over the pixels of a provisional label
+struct Accumulator {
+    uchar label = 0;
+    int64_t count = 0;
+    double sum[3] = {0, 0, 0};
+    int min[3] = {0, 0, 0};
+    int max[3] = {0, 0, 0};
+    int first[3] = {0, 0, 0};
+    double perimeter = 0;
+
+    // Add pixels x0 to x1-1 of a row
+    void addRun(int x0, int x1, int y, int z) {
+        const int n = x1 - x0;
+        if(count == 0) {
+            min[0] = max[0] = first[0] = x0;
+            min[1] = max[1] = first[1] = y;
+            min[2] = max[2] = first[2] = z;
+        }
+        sum[0] += 0.5*(double)(x0 + x1 - 1)*n;
+        sum[1] += (double)y*n;
+        sum[2] += (double)z*n;
+        min[0] = std::min(min[0], x0);
+        max[0] = std::max(max[0], x1 - 1);
+        min[1] = std::min(min[1], y);
+        max[1] = std::max(max[1], y);
+        min[2] = std::min(min[2], z);
+        max[2] = std::max(max[2], z);
+        count += n;
+    }
+
+    void merge(const Accumulator& other) {
+        if(isBefore(other.first, first))
+            std::copy(other.first, other.first + 3, first);
+        for(int i = 0; i < 3; ++i) {
+            sum[i] += other.sum[i];
+            min[i] = std::min(min[i], other.min[i]);
+            max[i] = std::max(max[i], other.max[i]);
+        }
+        count += other.count;
+        perimeter += other.perimeter;
+    }
+
+    static bool isBefore(const int a[3], const int b[3]) {
+        return std::make_tuple(a[2], a[1], a[0]) < std::make_tuple(b[2], b[1], b[0]);
+    }
+};
+
+// Labels of a box of the image, indexed with image coordinates
+struct LabelView {
+    const uchar* data;
+    Vector3i offset;
+    Vector3i size;
+
+    uchar get(int x, int y, int z) const {
+        return data[(x - offset.x()) + ((int64_t)(y - offset.y()) + (int64_t)(z - offset.z())*size.y())*size.x()];
+    }
+};
+
+// A box of the image which is labelled by one thread
+struct Block {
+    Vector3i offset;
+    Vector3i size;
+    std::vector<int> ids; // Provisional label of each pixel, -1 for background
+    std::vector<Accumulator> components; // Properties of each provisional label
+    int globalOffset = 0; // Index of the first provisional label of this block in the list of all labels
+
+    int64_t getIndex(int x, int y, int z) const {
+        return (x - offset.x()) + ((int64_t)(y - offset.y()) + (int64_t)(z - offset.z())*size.y())*size.x();
+    }
+
+    bool contains(int x, int y, int z) const {
+        return x >= offset.x() && y >= offset.y() && z >= offset.z() &&
+            x < offset.x() + size.x() && y < offset.y() + size.y() && z < offset.z() + size.z();
+    }
+};
+
+// Label and global provisional label of a pixel. Id is -1 for background and pixels outside the image.
+struct Pixel {
+    uchar label;
+    int id;
+};
+
+int findRoot(std::vector<int>& parent, int i) {
+    while(parent[i] != i) {
+        parent[i] = parent[parent[i]]; // Path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+// The smallest label is always the root, thus a root is before the other labels of its component
+int unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if(a < b) {
+        parent[b] = a;
+        return a;
+    } else {
+        parent[a] = b;
+        return b;
+    }
+}
+
+bool isInside(int x, int y, int z, const Vector3i& size) {
+    return x >= 0 && y >= 0 && z >= 0 && x < size.x() && y < size.y() && z < size.z();
+}
+
+/*
+ * Contour length of the marching squares case of a 2x2 window of pixels, divided by the nr of pixels in the case.
+ * The pixels are bits 0 to 3 of the index, ordered top left, top right, bottom left and bottom right.
+ */
+std::array<double, 16> getWindowLengths(const Vector3f& spacing) {
+    const double halfDiagonal = 0.5*std::sqrt(spacing.x()*spacing.x() + spacing.y()*spacing.y());
+    std::array<double, 16> lengths;
+    for(int mask = 0; mask < 16; ++mask) {
+        const int count = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        double length = 0.0;
+        if(count == 1 || count == 3) {
+            length = halfDiagonal; // Cuts a corner
+        } else if(mask == 0b0011 || mask == 0b1100) { // Same row
+            length = spacing.x();
+        } else if(mask == 0b0101 || mask == 0b1010) { // Same column
+            length = spacing.y();
+        } else if(mask == 0b1001 || mask == 0b0110) { // Diagonal, two corners
+            length = 2.0*halfDiagonal;
+        }
+        lengths[mask] = count > 0 ? length / count : 0.0;
+    }
+    return lengths;
+}
+
+/*
+ * Adds the length of the marching squares contour within a 2x2 window of pixels to the components of the pixels.
+ * Label 0 is background or outside the image.
+ * The contour only depends on which pixels have the same label. When two diagonal pixels with the same label
+ * belong to different components, each gets half of the length, which equals what they get as single pixels.
+ * The perimeter is thus independent of which block handles the window.
+ */
+void addWindowPerimeter(const uchar labels[4], Accumulator* components[4], const std::array<double, 16>& lengths) {
+    for(int i = 0; i < 4; ++i) {
+        if(labels[i] == 0)
+            continue;
+        const int mask = (labels[0] == labels[i]) | (labels[1] == labels[i]) << 1 | (labels[2] == labels[i]) << 2 | (labels[3] == labels[i]) << 3;
+        components[i]->perimeter += lengths[mask];
+    }
+}
+
+/*
+ * Label a block with a raster scan. Each pixel gets the provisional label of its earlier neighbours in the block,
+ * and these are merged if they differ. Also adds the perimeter which can be computed from pixels in the block.
+ * Afterwards the provisional labels of each component are merged, so that the block has one label per component.
+ */
+void labelBlock(Block& block, const LabelView& view, const std::vector<Vector3i>& neighbours, const Vector3i& imageSize, const Vector3f& spacing) {
+    const Vector3i begin = block.offset;
+    const Vector3i end = block.offset + block.size;
+    block.ids.assign((size_t)block.size.x()*block.size.y()*block.size.z(), -1);
+    std::vector<Accumulator>& components = block.components;
+    components.clear();
+    std::vector<int> parent;
+
+    // Neighbours with linear offsets in the view and the block
+    // coveredByLeft means that the neighbour was already checked by the pixel to the left, thus it can be skipped
+    // when that pixel has the same label.
+    struct Neighbour {
+        Vector3i offset;
+        int64_t viewOffset;
+        int64_t blockOffset;
+        bool coveredByLeft;
+    };
+    const int64_t viewStrideZ = (int64_t)view.size.x()*view.size.y();
+    const int64_t blockStrideZ = (int64_t)block.size.x()*block.size.y();
+    std::vector<Neighbour> allNeighbours;
+    for(const Vector3i& offset : neighbours) {
+        const bool coveredByLeft = offset == Vector3i(-1, 0, 0) ||
+                std::find(neighbours.begin(), neighbours.end(), offset + Vector3i(1, 0, 0)) != neighbours.end();
+        allNeighbours.push_back({offset, offset.x() + offset.y()*view.size.x() + offset.z()*viewStrideZ,
+                                 offset.x() + offset.y()*block.size.x() + offset.z()*blockStrideZ, coveredByLeft});
+    }
+    std::vector<Neighbour> rowNeighbours;
+    for(int z = begin.z(); z < end.z(); ++z) {
+        for(int y = begin.y(); y < end.y(); ++y) {
+            // Neighbours on previous rows and slices of the block
+            rowNeighbours.clear();
+            for(const Neighbour& neighbour : allNeighbours) {
+                if((neighbour.offset.y() < 0 && y == begin.y()) || (neighbour.offset.z() < 0 && z == begin.z()))
+                    continue;
+                rowNeighbours.push_back(neighbour);
+            }
+            const uchar* row = &view.data[(begin.x() - view.offset.x()) + (y - view.offset.y())*(int64_t)view.size.x() + (z - view.offset.z())*viewStrideZ];
+            int* rowIds = &block.ids[block.getIndex(begin.x(), y, z)];
+            // Pixels of a run of equal labels are added to the component of the first pixel at the end of the run
+            int runStart = 0;
+            int runId = -1;
+            for(int x = 0; x < block.size.x(); ++x) {
+                const uchar label = row[x];
+                const bool continuesRun = x > 0 && label == row[x - 1];
+                if(!continuesRun && runId >= 0) {
+                    components[runId].addRun(begin.x() + runStart, begin.x() + x, y, z);
+                    runId = -1;
+                }
+                if(label == 0)
+                    continue;
+                int id = continuesRun ? runId : -1;
+                for(const Neighbour& neighbour : rowNeighbours) {
+                    if(continuesRun && neighbour.coveredByLeft)
+                        continue;
+                    if((neighbour.offset.x() < 0 && x == 0) || (neighbour.offset.x() > 0 && x == block.size.x() - 1))
+                        continue;
+                    if(row[x + neighbour.viewOffset] != label)
+                        continue;
+                    const int neighbourId = rowIds[x + neighbour.blockOffset];
+                    id = id < 0 ? findRoot(parent, neighbourId) : unite(parent, id, neighbourId);
+                }
+                if(id < 0) {
+                    id = components.size();
+                    parent.push_back(id);
+                    components.emplace_back();
+                    components.back().label = label;
+                }
+                if(!continuesRun) {
+                    runStart = x;
+                    runId = id;
+                }
+                rowIds[x] = id;
+            }
+            if(runId >= 0)
+                components[runId].addRun(begin.x() + runStart, end.x(), y, z);
+        }
+    }
+
+    if(imageSize.z() == 1) {
+        // The window with bottom right pixel (x, y) belongs to the block containing that pixel,
+        // or the nearest pixel in the image. Windows crossing the top or left border of the block are added in stitchBlock.
+        // Pixels of the remaining windows are either in the block or outside the image.
+        const auto windowLengths = getWindowLengths(spacing);
+        const int startX = begin.x() == 0 ? 0 : begin.x() + 1;
+        const int startY = begin.y() == 0 ? 0 : begin.y() + 1;
+        const int endX = end.x() == imageSize.x() ? end.x() + 1 : end.x();
+        const int endY = end.y() == imageSize.y() ? end.y() + 1 : end.y();
+        for(int y = startY; y < endY; ++y) {
+            const bool hasTop = y > 0;
+            const bool hasBottom = y < imageSize.y();
+            const uchar* top = hasTop ? &view.data[(begin.x() - view.offset.x()) + (y - 1 - view.offset.y())*(int64_t)view.size.x()] : nullptr;
+            const uchar* bottom = hasBottom ? &view.data[(begin.x() - view.offset.x()) + (y - view.offset.y())*(int64_t)view.size.x()] : nullptr;
+            const int* topIds = hasTop ? &block.ids[block.getIndex(begin.x(), y - 1, 0)] : nullptr;
+            const int* bottomIds = hasBottom ? &block.ids[block.getIndex(begin.x(), y, 0)] : nullptr;
+            for(int x = startX - begin.x(); x < endX - begin.x(); ++x) {
+                const bool hasLeft = begin.x() + x > 0;
+                const bool hasRight = begin.x() + x < imageSize.x();
+                const uchar labels[4] = {
+                        hasTop && hasLeft ? top[x - 1] : (uchar)0,
+                        hasTop && hasRight ? top[x] : (uchar)0,
+                        hasBottom && hasLeft ? bottom[x - 1] : (uchar)0,
+                        hasBottom && hasRight ? bottom[x] : (uchar)0,
+                };
+                if(labels[0] == labels[1] && labels[0] == labels[2] && labels[0] == labels[3])
+                    continue; // Inside a region or the background
+                Accumulator* targets[4] = {
+                        labels[0] != 0 ? &components[topIds[x - 1]] : nullptr,
+                        labels[1] != 0 ? &components[topIds[x]] : nullptr,
+                        labels[2] != 0 ? &components[bottomIds[x - 1]] : nullptr,
+                        labels[3] != 0 ? &components[bottomIds[x]] : nullptr,
+                };
+                addWindowPerimeter(labels, targets, windowLengths);
+            }
+        }
+    } else {
+        // Area of faces towards other labels or the image border
+        const Vector3i faces[6] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+        const double faceArea[3] = {spacing.y()*spacing.z(), spacing.x()*spacing.z(), spacing.x()*spacing.y()};
+        for(int z = begin.z(); z < end.z(); ++z) {
+            for(int y = begin.y(); y < end.y(); ++y) {
+                for(int x = begin.x(); x < end.x(); ++x) {
+                    const int id = block.ids[block.getIndex(x, y, z)];
+                    if(id < 0)
+                        continue;
+                    const uchar label = components[id].label;
+                    for(int i = 0; i < 6; ++i) {
+                        const int nx = x + faces[i].x();
+                        const int ny = y + faces[i].y();
+                        const int nz = z + faces[i].z();
+                        if(!isInside(nx, ny, nz, imageSize) || view.get(nx, ny, nz) != label)
+                            components[id].perimeter += faceArea[i / 2];
+                    }
+                }
+            }
+        }
+    }
+
+    // Merge provisional labels of each component. Roots are before the other labels of their component.
+    std::vector<int> newIds(components.size());
+    std::vector<Accumulator> merged;
+    for(int i = 0; i < (int)components.size(); ++i) {
+        const int root = findRoot(parent, i);
+        if(root == i) {
+            newIds[i] = merged.size();
+            merged.push_back(components[i]);
+        } else {
+            newIds[i] = newIds[root];
+            merged[newIds[root]].merge(components[i]);
+        }
+    }
+    for(int& id : block.ids) {
+        if(id >= 0)
+            id = newIds[id];
+    }
+    components = std::move(merged);
+}
+
+/*
+ * Merge the components of a block with connected components of neighbour blocks, and add the perimeter
+ * of windows crossing the top or left border of the block.
+ * Only earlier neighbours in raster order are checked, thus these pixels are on the first slice, row or column of the block,
+ * or on the last column for neighbours in the block to the right on the previous row.
+ * lookup(x, y, z) returns the Pixel of any pixel in the image which is in a labelled block.
+ */
+template <class Lookup>
+void stitchBlock(const Block& block, const Lookup& lookup, const std::vector<Vector3i>& neighbours, const Vector3i& imageSize, const Vector3f& spacing,
+                 std::vector<int>& parent, std::vector<Accumulator>& components) {
+    const Vector3i begin = block.offset;
+    const Vector3i end = block.offset + block.size;
+    for(int z = begin.z(); z < end.z(); ++z) {
+        for(int y = begin.y(); y < end.y(); ++y) {
+            const bool allColumns = z == begin.z() || y == begin.y();
+            for(int x = begin.x(); x < end.x(); x = (allColumns || x == end.x() - 1) ? x + 1 : end.x() - 1) {
+                const int id = block.ids[block.getIndex(x, y, z)];
+                if(id < 0)
+                    continue;
+                const uchar label = block.components[id].label;
+                for(const Vector3i& offset : neighbours) {
+                    const int nx = x + offset.x();
+                    const int ny = y + offset.y();
+                    const int nz = z + offset.z();
+                    if(block.contains(nx, ny, nz))
+                        continue;
+                    const Pixel neighbour = lookup(nx, ny, nz);
+                    if(neighbour.id >= 0 && neighbour.label == label)
+                        unite(parent, block.globalOffset + id, neighbour.id);
+                }
+            }
+        }
+    }
+
+    if(imageSize.z() == 1) {
+        const auto windowLengths = getWindowLengths(spacing);
+        const int endX = end.x() == imageSize.x() ? end.x() + 1 : end.x();
+        const int endY = end.y() == imageSize.y() ? end.y() + 1 : end.y();
+        for(int y = begin.y(); y < endY; ++y) {
+            const bool allColumns = y == begin.y() && begin.y() > 0;
+            if(!allColumns && begin.x() == 0)
+                continue;
+            const int lastX = allColumns ? endX : begin.x() + 1;
+            for(int x = begin.x(); x < lastX; ++x) {
+                const int windowX[4] = {x - 1, x, x - 1, x};
+                const int windowY[4] = {y - 1, y - 1, y, y};
+                uchar labels[4];
+                Accumulator* targets[4];
+                for(int i = 0; i < 4; ++i) {
+                    const Pixel pixel = lookup(windowX[i], windowY[i], 0);
+                    labels[i] = pixel.label;
+                    targets[i] = pixel.id >= 0 ? &components[pixel.id] : nullptr;
+                }
+                addWindowPerimeter(labels, targets, windowLengths);
+            }
+        }
+    }
+}
+
+/*
+ * Merge the provisional labels of each component, and create the components ordered by first pixel.
+ * If componentIndices is not nullptr, it is filled with the index of the component of each provisional label.
+ */
+std::vector<ConnectedComponent> createComponents(std::vector<Accumulator>& accumulators, std::vector<int>& parent, std::vector<int>* componentIndices) {
+    std::vector<int> roots;
+    for(int i = 0; i < (int)accumulators.size(); ++i) {
+        const int root = findRoot(parent, i);
+        if(root == i) {
+            roots.push_back(i);
+        } else {
+            accumulators[root].merge(accumulators[i]);
+        }
+    }
+    std::sort(roots.begin(), roots.end(), [&accumulators](int a, int b) {
+        return Accumulator::isBefore(accumulators[a].first, accumulators[b].first);
+    });
+
+    std::vector<ConnectedComponent> components;
+    components.reserve(roots.size());
+    for(int root : roots) {
+        const Accumulator& accumulator = accumulators[root];
+        ConnectedComponent component;
+        component.label = accumulator.label;
+        component.pixelCount = accumulator.count;
+        component.centroid = Vector3f(
+                accumulator.sum[0] / accumulator.count,
+                accumulator.sum[1] / accumulator.count,
+                accumulator.sum[2] / accumulator.count
+        );
+        component.minPixelPosition = Vector3i(accumulator.min[0], accumulator.min[1], accumulator.min[2]);
+        component.maxPixelPosition = Vector3i(accumulator.max[0], accumulator.max[1], accumulator.max[2]);
+        component.firstPixelPosition = Vector3i(accumulator.first[0], accumulator.first[1], accumulator.first[2]);
+        component.perimeter = accumulator.perimeter;
+        components.push_back(component);
+    }
+
+    if(componentIndices != nullptr) {
+        std::vector<int> rootIndex(accumulators.size());
+        for(int i = 0; i < (int)roots.size(); ++i)
+            rootIndex[roots[i]] = i;
+        componentIndices->resize(accumulators.size());
+        for(int i = 0; i < (int)accumulators.size(); ++i)
+            (*componentIndices)[i] = rootIndex[findRoot(parent, i)];
+    }
+    return components;
+}
+
+void appendComponents(Block& block, std::vector<Accumulator>& accumulators, std::vector<int>& parent) {
+    block.globalOffset = accumulators.size();
+    accumulators.insert(accumulators.end(), block.components.begin(), block.components.end());
+    parent.resize(accumulators.size());
+    std::iota(parent.begin() + block.globalOffset, parent.end(), block.globalOffset);
+}
+
+}
+
+ConnectedComponentLabelling::ConnectedComponentLabelling(bool fullConnectivity) {
+    m_fullConnectivity = fullConnectivity;
+}
+
+std::vector<Vector3i> ConnectedComponentLabelling::getBackwardNeighbours(bool is3D) const {
+    // Neighbours before a pixel in raster order, which are already visited in a raster scan
+    std::vector<Vector3i> neighbours;
+    for(int z = is3D ? -1 : 0; z <= 0; ++z) {
+        for(int y = -1; y <= 1; ++y) {
+            for(int x = -1; x <= 1; ++x) {
+                const bool backward = z < 0 || (z == 0 && (y < 0 || (y == 0 && x < 0)));
+                if(!backward || (!m_fullConnectivity && std::abs(x) + std::abs(y) + std::abs(z) > 1))
+                    continue;
+                neighbours.push_back(Vector3i(x, y, z));
+            }
+        }
+    }
+    return neighbours;
+}
+
+std::vector<ConnectedComponent> ConnectedComponentLabelling::run(const uchar* labels, Vector3i size, Vector3f spacing, std::vector<int>* componentImage) {
+    if(size.minCoeff() <= 0)
+        throw Exception("Image size must be positive in ConnectedComponentLabelling");
+    const bool is3D = size.z() > 1;
+    const auto neighbours = getBackwardNeighbours(is3D);
+    const LabelView view{labels, Vector3i::Zero(), size};
+
+    // Split image in blocks of rows in 2D and slices in 3D
+    const int axis = is3D ? 2 : 1;
+    const int extent = size[axis];
+    auto pool = ThreadPool::getInstance();
+    const int blockCount = std::max(1, std::min(extent, pool->getNrOfThreads()*4));
+    std::vector<Block> blocks(blockCount);
+    std::vector<int> blockOfPosition(extent);
+    for(int i = 0; i < blockCount; ++i) {
+        const int first = (int)((int64_t)extent*i/blockCount);
+        const int last = (int)((int64_t)extent*(i + 1)/blockCount);
+        blocks[i].offset = Vector3i::Zero();
+        blocks[i].offset[axis] = first;
+        blocks[i].size = size;
+        blocks[i].size[axis] = last - first;
+        std::fill(blockOfPosition.begin() + first, blockOfPosition.begin() + last, i);
+    }
+    pool->parallelFor(0, blockCount, [&](int begin, int end) {
+        for(int i = begin; i < end; ++i)
+            labelBlock(blocks[i], view, neighbours, size, spacing);
+    }, 1);
+
+    std::vector<Accumulator> accumulators;
+    std::vector<int> parent;
+    for(auto& block : blocks)
+        appendComponents(block, accumulators, parent);
+    auto lookup = [&](int x, int y, int z) -> Pixel {
+        if(!isInside(x, y, z, size))
+            return {0, -1};
+        const Block& block = blocks[blockOfPosition[axis == 1 ? y : z]];
+        const int id = block.ids[block.getIndex(x, y, z)];
+        if(id < 0)
+            return {0, -1};
+        return {block.components[id].label, block.globalOffset + id};
+    };
+    for(auto& block : blocks)
+        stitchBlock(block, lookup, neighbours, size, spacing, parent, accumulators);
+
+    if(componentImage == nullptr)
+        return createComponents(accumulators, parent, nullptr);
+
+    std::vector<int> componentIndices;
+    auto components = createComponents(accumulators, parent, &componentIndices);
+    componentImage->resize((size_t)size.x()*size.y()*size.z());
+    pool->parallelFor(0, blockCount, [&](int begin, int end) {
+        for(int i = begin; i < end; ++i) {
+            // Blocks are contiguous in memory
+            const Block& block = blocks[i];
+            int* output = componentImage->data() + (int64_t)block.offset[axis]*(axis == 1 ? size.x() : (int64_t)size.x()*size.y());
+            for(size_t j = 0; j < block.ids.size(); ++j)
+                output[j] = block.ids[j] < 0 ? -1 : componentIndices[block.globalOffset + block.ids[j]];
+        }
+    }, 1);
+    return components;
+}
+
+std::vector<ConnectedComponent> ConnectedComponentLabelling::run(std::shared_ptr<ImagePyramid> segmentation, int level) {
+    if(segmentation->getNrOfChannels() != 1 || segmentation->getDataType() != TYPE_UINT8)
+        throw Exception("ConnectedComponentLabelling requires a single channel uint8 image pyramid");
+    if(level < 0 || level >= segmentation->getNrOfLevels())
+        throw Exception("Level " + std::to_string(level) + " does not exist in image pyramid given to ConnectedComponentLabelling");
+    const Vector3i size(segmentation->getLevelWidth(level), segmentation->getLevelHeight(level), 1);
+    const int tileWidth = segmentation->getLevelTileWidth(level);
+    const int tileHeight = segmentation->getLevelTileHeight(level);
+    const int tilesX = (size.x() + tileWidth - 1) / tileWidth;
+    const int tilesY = (size.y() + tileHeight - 1) / tileHeight;
+    const Vector3f spacing = segmentation->getSpacing()*segmentation->getLevelScale(level);
+    const auto neighbours = getBackwardNeighbours(false);
+    auto pool = ThreadPool::getInstance();
+
+    std::vector<Accumulator> accumulators;
+    std::vector<int> parent;
+    // Pixels of the last row of the previous row of tiles
+    std::vector<uchar> previousLabels(size.x(), 0);
+    std::vector<int> previousIds(size.x(), -1);
+    std::vector<Block> tiles(tilesX);
+    for(int tileY = 0; tileY < tilesY; ++tileY) {
+        const int offsetY = tileY*tileHeight;
+        const int height = std::min(tileHeight, size.y() - offsetY);
+        pool->parallelFor(0, tilesX, [&](int begin, int end) {
+            auto access = segmentation->getAccess(ACCESS_READ);
+            for(int tileX = begin; tileX < end; ++tileX) {
+                Block& tile = tiles[tileX];
+                tile.offset = Vector3i(tileX*tileWidth, offsetY, 0);
+                tile.size = Vector3i(std::min(tileWidth, size.x() - tile.offset.x()), height, 1);
+                auto data = access->getPatchData<uchar>(level, tile.offset.x(), tile.offset.y(), tile.size.x(), tile.size.y());
+                labelBlock(tile, LabelView{data.get(), tile.offset, tile.size}, neighbours, size, spacing);
+            }
+        }, 1);
+
+        for(auto& tile : tiles)
+            appendComponents(tile, accumulators, parent);
+        auto lookup = [&](int x, int y, int z) -> Pixel {
+            if(!isInside(x, y, z, size))
+                return {0, -1};
+            if(y < offsetY)
+                return {previousLabels[x], previousIds[x]};
+            const Block& tile = tiles[x / tileWidth];
+            const int id = tile.ids[tile.getIndex(x, y, z)];
+            if(id < 0)
+                return {0, -1};
+            return {tile.components[id].label, tile.globalOffset + id};
+        };
+        for(auto& tile : tiles)
+            stitchBlock(tile, lookup, neighbours, size, spacing, parent, accumulators);
+
+        for(int x = 0; x < size.x(); ++x) {
+            const Pixel pixel = lookup(x, offsetY + height - 1, 0);
+            previousLabels[x] = pixel.label;
+            previousIds[x] = pixel.id;
+        }
+    }
+    return createComponents(accumulators, parent, nullptr);
+}
+
+}
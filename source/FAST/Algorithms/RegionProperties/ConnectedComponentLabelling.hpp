@@ -0,0 +1,73 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+
+namespace fast {
+
+class ImagePyramid;
+
+/**
+ * @brief Properties of a connected component found by ConnectedComponentLabelling
+ */
+struct FAST_EXPORT ConnectedComponent {
+    uchar label;
+    int64_t pixelCount;
+    Vector3f centroid; // In pixel coordinates
+    Vector3i minPixelPosition;
+    Vector3i maxPixelPosition;
+    Vector3i firstPixelPosition; // First pixel of the component in raster order
+    float perimeter; // Contour length in 2D and surface area in 3D, in physical units
+};
+
+/**
+ * @brief Block parallel connected component labelling of segmentations using union-find
+ *
+ * Neighbour pixels with the same non-zero label belong to the same component.
+ * The image is split into blocks which are labelled in parallel using the ThreadPool.
+ * Each block is labelled in a single raster scan, where union-find merges provisional labels which turn out to be connected.
+ * Pixel count, centroid, bounding box and perimeter are accumulated per provisional label in the same scan.
+ * Components crossing block borders are then merged, which only requires the pixels on the borders.
+ *
+ * In 2D, the perimeter is the length of the marching squares contour through the pixel centers.
+ * In 3D, it is the area of the voxel faces between the component and other labels or the image border.
+ *
+ * A level of an ImagePyramid is labelled one row of tiles at a time, thus the entire level is never loaded into memory.
+ *
+ * @code
+ * ConnectedComponentLabelling labelling;
+ * auto components = labelling.run(segmentationPyramid, 0);
+ * @endcode
+ */
+class FAST_EXPORT ConnectedComponentLabelling {
+    public:
+        /**
+         * @brief Create connected component labelling
+         * @param fullConnectivity If true, pixels are connected to all 8 neighbours in 2D and 26 in 3D.
+         *      If false, only to the 4 (2D) or 6 (3D) neighbours sharing an edge or face.
+         */
+        explicit ConnectedComponentLabelling(bool fullConnectivity = true);
+        /**
+         * @brief Label a 2D or 3D segmentation
+         * @param labels width*height*depth labels in raster order, 0 is background
+         * @param size Width, height and depth. Depth is 1 for 2D.
+         * @param spacing Pixel spacing, used for the perimeter
+         * @param componentImage If not nullptr, it is filled with the index of the component of each pixel, or -1 for background
+         * @return components, ordered by first pixel in raster order
+         */
+        std::vector<ConnectedComponent> run(const uchar* labels, Vector3i size, Vector3f spacing, std::vector<int>* componentImage = nullptr);
+        /**
+         * @brief Label a level of a single channel uint8 ImagePyramid, one row of tiles at a time.
+         * Pixel positions are in pixels of the given level.
+         * @param segmentation
+         * @param level
+         * @return components, ordered by first pixel in raster order
+         */
+        std::vector<ConnectedComponent> run(std::shared_ptr<ImagePyramid> segmentation, int level);
+    private:
+        std::vector<Vector3i> getBackwardNeighbours(bool is3D) const;
+
+        bool m_fullConnectivity;
+};
+
+}
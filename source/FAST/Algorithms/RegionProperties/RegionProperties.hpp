@@ -25,8 +25,15 @@ FAST_SIMPLE_DATA_OBJECT(RegionList, std::vector<Region>)
 /**
  * @brief Calculate properties, such as area, contour and centroid, for every segmentation region
  *
+ * Regions are 8-connected pixels with the same label, found with ConnectedComponentLabelling in parallel.
+ * The perimeter length is the length of the marching squares contour through the pixel centers.
+ *
+ * For an ImagePyramid segmentation, one level is processed one row of tiles at a time, thus the entire level
+ * is never in memory. Only pixel count, area, centroid, bounding box and perimeter length are computed in this case,
+ * not pixels or contours.
+ *
  * Inputs:
- * - 0: Image segmentation
+ * - 0: Image or ImagePyramid segmentation
  *
  * Outputs:
  * - 0: RegionList, a simple data object which is a vector of Region
@@ -39,12 +46,16 @@ class FAST_EXPORT RegionProperties : public ProcessObject {
         /**
          * @brief Create instance
          * @param extractContours Whether to extract contours of each region or not
+         * @param level Which level to use if input is an ImagePyramid
          * @return instance
          */
-        FAST_CONSTRUCTOR(RegionProperties, bool, extractContours, = true);
+        FAST_CONSTRUCTOR(RegionProperties, bool, extractContours, = true, int, level, = 0);
+        void setLevel(int level);
+        int getLevel() const;
     protected:
         void execute() override;
         bool m_extractContours;
+        int m_level;
 };
 
-}
\ No newline at end of file
+}
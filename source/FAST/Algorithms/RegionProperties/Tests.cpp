@@ -1,7 +1,12 @@
 #include "RegionProperties.hpp"
+#include "ConnectedComponentLabelling.hpp"
 #include <FAST/Testing.hpp>
 #include <FAST/Importers/ImageFileImporter.hpp>
 #include <FAST/Algorithms/BinaryThresholding/BinaryThresholding.hpp>
+#include <FAST/Data/Image.hpp>
+#include <FAST/Data/ImagePyramid.hpp>
+#include <queue>
+#include <random>
 
 using namespace fast;
 
@@ -24,4 +29,193 @@ TEST_CASE("Region properties", "[regionproperties][fast]") {
         //std::cout << "Area: " << region.area << std::endl;
         //std::cout << "Label: " << (int)region.label << std::endl;
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Region properties of synthetic segmentation", "[regionproperties][fast]") {
+    const int width = 64;
+    const int height = 48;
+    std::vector<uchar> data(width*height, 0);
+    for(int y = 5; y < 15; ++y) {
+        for(int x = 10; x < 20; ++x) {
+            data[x + y*width] = 1;
+        }
+    }
+    // Diagonal pixels are connected
+    data[30 + 30*width] = 1;
+    data[31 + 31*width] = 1;
+    data[40 + 30*width] = 2;
+    auto image = Image::create(width, height, TYPE_UINT8, 1, data.data());
+    image->setSpacing(Vector3f(0.5f, 0.25f, 1.0f));
+
+    auto regions = RegionProperties::create()->connect(image)->runAndGetOutputData<RegionList>()->get();
+    REQUIRE(regions.size() == 3);
+    // Corner of marching squares contour
+    const float halfDiagonal = 0.5f*std::sqrt(0.5f*0.5f + 0.25f*0.25f);
+
+    // Regions are ordered by their first pixel
+    auto square = regions[0];
+    CHECK(square.label == 1);
+    CHECK(square.pixelCount == 100);
+    CHECK(square.area == Approx(100*0.5*0.25));
+    CHECK(square.centroid.x() == Approx(14.5*0.5));
+    CHECK(square.centroid.y() == Approx(9.5*0.25));
+    CHECK(square.minPixelPosition == Vector2i(10, 5));
+    CHECK(square.maxPixelPosition == Vector2i(19, 14));
+    CHECK(square.perimiterLength == Approx(9*0.5*2 + 9*0.25*2 + 4*halfDiagonal));
+    CHECK(square.pixels.size() == 100);
+    CHECK(square.contourPixels.size() == 36);
+    CHECK(square.contourMesh);
+
+    auto diagonal = regions[1];
+    CHECK(diagonal.label == 1);
+    CHECK(diagonal.pixelCount == 2);
+    CHECK(diagonal.minPixelPosition == Vector2i(30, 30));
+    CHECK(diagonal.maxPixelPosition == Vector2i(31, 31));
+    CHECK(diagonal.perimiterLength == Approx(8*halfDiagonal));
+
+    auto single = regions[2];
+    CHECK(single.label == 2);
+    CHECK(single.pixelCount == 1);
+    CHECK(single.centroid.x() == Approx(40*0.5));
+    CHECK(single.perimiterLength == Approx(4*halfDiagonal));
+}
+
+// Flood fill reference for ConnectedComponentLabelling
+static std::vector<int> floodFill(const std::vector<uchar>& data, Vector3i size, bool fullConnectivity, std::vector<int64_t>& pixelCounts) {
+    std::vector<int> components(data.size(), -1);
+    auto getIndex = [&size](Vector3i p) {
+        return p.x() + ((int64_t)p.y() + (int64_t)p.z()*size.y())*size.x();
+    };
+    for(int z = 0; z < size.z(); ++z) {
+        for(int y = 0; y < size.y(); ++y) {
+            for(int x = 0; x < size.x(); ++x) {
+                const uchar label = data[getIndex(Vector3i(x, y, z))];
+                if(label == 0 || components[getIndex(Vector3i(x, y, z))] >= 0)
+                    continue;
+                const int component = pixelCounts.size();
+                pixelCounts.push_back(0);
+                std::queue<Vector3i> queue;
+                queue.push(Vector3i(x, y, z));
+                components[getIndex(Vector3i(x, y, z))] = component;
+                while(!queue.empty()) {
+                    const Vector3i current = queue.front();
+                    queue.pop();
+                    ++pixelCounts[component];
+                    for(int c = -1; c <= 1; ++c) {
+                        for(int b = -1; b <= 1; ++b) {
+                            for(int a = -1; a <= 1; ++a) {
+                                const int distance = std::abs(a) + std::abs(b) + std::abs(c);
+                                if(distance == 0 || (!fullConnectivity && distance > 1) || (size.z() == 1 && c != 0))
+                                    continue;
+                                const Vector3i next = current + Vector3i(a, b, c);
+                                if((next.array() < 0).any() || (next.array() >= size.array()).any())
+                                    continue;
+                                if(data[getIndex(next)] == label && components[getIndex(next)] < 0) {
+                                    components[getIndex(next)] = component;
+                                    queue.push(next);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return components;
+}
+
+TEST_CASE("Connected component labelling gives same components as flood fill", "[regionproperties][ConnectedComponentLabelling][fast]") {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for(Vector3i size : {Vector3i(1, 1, 1), Vector3i(97, 61, 1), Vector3i(300, 5, 1), Vector3i(23, 19, 17)}) {
+        for(float density : {0.3f, 0.6f}) {
+            std::vector<uchar> data(size.prod());
+            for(auto& value : data)
+                value = distribution(generator) < density ? (distribution(generator) < 0.5f ? 1 : 2) : 0;
+            for(bool fullConnectivity : {true, false}) {
+                std::vector<int64_t> pixelCounts;
+                auto expected = floodFill(data, size, fullConnectivity, pixelCounts);
+                std::vector<int> componentImage;
+                auto components = ConnectedComponentLabelling(fullConnectivity).run(data.data(), size, Vector3f::Ones(), &componentImage);
+                REQUIRE(components.size() == pixelCounts.size());
+                CHECK(componentImage == expected);
+                for(int i = 0; i < components.size(); ++i)
+                    CHECK(components[i].pixelCount == pixelCounts[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Connected component labelling of 3D cube", "[regionproperties][ConnectedComponentLabelling][fast]") {
+    const Vector3i size(16, 16, 16);
+    std::vector<uchar> data(size.prod(), 0);
+    for(int z = 2; z < 5; ++z) {
+        for(int y = 3; y < 7; ++y) {
+            for(int x = 4; x < 9; ++x) {
+                data[x + (y + z*size.y())*size.x()] = 3;
+            }
+        }
+    }
+    auto components = ConnectedComponentLabelling().run(data.data(), size, Vector3f(1.0f, 2.0f, 3.0f));
+    REQUIRE(components.size() == 1);
+    CHECK(components[0].label == 3);
+    CHECK(components[0].pixelCount == 3*4*5);
+    CHECK(components[0].centroid.isApprox(Vector3f(6, 4.5, 3)));
+    CHECK(components[0].minPixelPosition == Vector3i(4, 3, 2));
+    CHECK(components[0].maxPixelPosition == Vector3i(8, 6, 4));
+    // Surface area
+    CHECK(components[0].perimeter == Approx(2*(4*2*3*3) + 2*(5*1*3*3) + 2*(5*1*4*2)));
+}
+
+TEST_CASE("Region properties of image pyramid is same as of image", "[regionproperties][ImagePyramid][fast]") {
+    const int tileSize = 256;
+    const int tilesX = 4;
+    const int tilesY = 3;
+    const int width = tileSize*tilesX;
+    const int height = tileSize*tilesY;
+    // Discs of random size and label, many crossing tile borders
+    std::mt19937 generator(2);
+    std::vector<uchar> data(width*height, 0);
+    for(int i = 0; i < 200; ++i) {
+        const int centerX = generator() % width;
+        const int centerY = generator() % height;
+        const int radius = 2 + generator() % 40;
+        const uchar label = 1 + generator() % 2;
+        for(int y = std::max(0, centerY - radius); y < std::min(height, centerY + radius); ++y) {
+            for(int x = std::max(0, centerX - radius); x < std::min(width, centerX + radius); ++x) {
+                if((x - centerX)*(x - centerX) + (y - centerY)*(y - centerY) < radius*radius)
+                    data[x + y*width] = label;
+            }
+        }
+    }
+    auto image = Image::create(width, height, TYPE_UINT8, 1, data.data());
+    auto imagePyramid = ImagePyramid::create(width, height, 1, tileSize, tileSize);
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        std::vector<uchar> tile(tileSize*tileSize);
+        for(int tileY = 0; tileY < tilesY; ++tileY) {
+            for(int tileX = 0; tileX < tilesX; ++tileX) {
+                for(int y = 0; y < tileSize; ++y) {
+                    for(int x = 0; x < tileSize; ++x) {
+                        tile[x + y*tileSize] = data[tileX*tileSize + x + (tileY*tileSize + y)*width];
+                    }
+                }
+                auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 1, tile.data());
+                access->setPatch(0, tileX*tileSize, tileY*tileSize, patch, false);
+            }
+        }
+    }
+
+    auto expected = RegionProperties::create(false)->connect(image)->runAndGetOutputData<RegionList>()->get();
+    auto regions = RegionProperties::create(false, 0)->connect(imagePyramid)->runAndGetOutputData<RegionList>()->get();
+    REQUIRE(regions.size() == expected.size());
+    for(int i = 0; i < regions.size(); ++i) {
+        CHECK(regions[i].label == expected[i].label);
+        CHECK(regions[i].pixelCount == expected[i].pixelCount);
+        CHECK(regions[i].centroid.isApprox(expected[i].centroid));
+        CHECK(regions[i].minPixelPosition == expected[i].minPixelPosition);
+        CHECK(regions[i].maxPixelPosition == expected[i].maxPixelPosition);
+        CHECK(regions[i].perimiterLength == Approx(expected[i].perimiterLength));
+        CHECK(regions[i].pixels.empty());
+    }
+}
@@ -1,7 +1,9 @@
 #include "FAST/Algorithms/SeededRegionGrowing/SeededRegionGrowing.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/SceneGraph.hpp"
-#include <stack>
+#include "FAST/ThreadPool.hpp"
+#include <atomic>
+#include <mutex>
 #include "FAST/Data/Image.hpp"
 
 namespace fast {
@@ -79,73 +81,100 @@ SeededRegionGrowing::SeededRegionGrowing(float intensityMinimum, float intensity
     void SeededRegionGrowing::executeOnHost(T* input, Image::pointer output) {
         ImageAccess::pointer outputAccess = output->getImageAccess(ACCESS_READ_WRITE);
         uchar* outputData = (uchar*)outputAccess->get();
-        std::stack<Vector3i> queue;
-
-        // Add seeds to queue
+        const int width = output->getWidth();
+        const int height = output->getHeight();
+        const int depth = output->getDepth();
+        const int64_t size = (int64_t)width*height*depth;
+
+        // Voxels which have been checked against the intensity range, one bit per voxel.
+        // The thread which sets the bit of a voxel is the only one checking it.
+        std::vector<std::atomic<uint64_t>> visited((size + 63) / 64);
+        for(auto& word : visited)
+            word.store(0, std::memory_order_relaxed);
+        auto visit = [&visited](int64_t index) {
+            const uint64_t bit = (uint64_t)1 << (index & 63);
+            std::atomic<uint64_t>& word = visited[index >> 6];
+            if(word.load(std::memory_order_relaxed) & bit)
+                return false;
+            return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+        };
+        auto accept = [&](int64_t index) {
+            const T value = input[index];
+            return value >= mMinimumIntensity && value <= mMaximumIntensity;
+        };
+
+        // Add seeds to frontier
+        std::vector<int64_t> frontier;
         for(int i = 0; i < mSeedPoints.size(); i++) {
             Vector3i pos = mSeedPoints[i];
 
             // Check if seed point is in bounds
             if(pos.x() < 0 || pos.y() < 0 || pos.z() < 0 ||
-               pos.x() >= output->getWidth() || pos.y() >= output->getHeight() || pos.z() >= output->getDepth())
+               pos.x() >= width || pos.y() >= height || pos.z() >= depth)
                 throw Exception("One of the seed points given to SeededRegionGrowing was out of bounds.");
 
-            queue.push(pos.cast<int>());
+            const int64_t index = pos.x() + ((int64_t)pos.y() + (int64_t)pos.z()*height)*width;
+            if(visit(index) && accept(index)) {
+                outputData[index] = 1;
+                frontier.push_back(index);
+            }
         }
 
         std::vector<Vector3i> neighborhood;
-        if(output->getDimensions() == 3) {
-            for(int a = -1; a < 2; a++) {
-                for(int b = -1; b < 2; b++) {
-                    for(int c = -1; c < 2; c++) {
-                        if(m_pixelConnectivity != PixelConnectivity::All) {
-                            if(abs(a) + abs(b) + abs(c) != 1) // connectivity
-                                continue;
-                        }
-                        neighborhood.push_back(Vector3i(a, b, c));
-                    }
+        for(int c = (depth > 1 ? -1 : 0); c < (depth > 1 ? 2 : 1); c++) {
+            for(int b = -1; b < 2; b++) {
+                for(int a = -1; a < 2; a++) {
+                    const int distance = abs(a) + abs(b) + abs(c);
+                    if(distance == 0 || (m_pixelConnectivity != PixelConnectivity::All && distance != 1)) // connectivity
+                        continue;
+                    neighborhood.push_back(Vector3i(a, b, c));
                 }
             }
-        } else {
-            for(int a = -1; a < 2; a++) {
-                for(int b = -1; b < 2; b++) {
-                    if(m_pixelConnectivity != PixelConnectivity::All) {
-                        if(abs(a) + abs(b) != 1) // connectivity
+        }
+        std::vector<int64_t> linearOffsets;
+        for(auto offset : neighborhood)
+            linearOffsets.push_back(offset.x() + ((int64_t)offset.y() + (int64_t)offset.z()*height)*width);
+
+        // Grow one wavefront at a time. Each wavefront is the voxels added to the segmentation in the previous one,
+        // and is processed in parallel.
+        auto pool = ThreadPool::getInstance();
+        std::mutex mutex;
+        std::vector<int64_t> nextFrontier;
+        int wavefronts = 0;
+        while(!frontier.empty()) {
+            nextFrontier.clear();
+            pool->parallelFor(0, frontier.size(), [&](int begin, int end) {
+                std::vector<int64_t> added;
+                for(int i = begin; i < end; ++i) {
+                    const int64_t index = frontier[i];
+                    const int x = index % width;
+                    const int y = (index / width) % height;
+                    const int z = index / ((int64_t)width*height);
+                    // No bounds check needed for neighbors of voxels not on the border
+                    const bool inside = x > 0 && y > 0 && x < width - 1 && y < height - 1 &&
+                            (depth == 1 || (z > 0 && z < depth - 1));
+                    for(int j = 0; j < neighborhood.size(); ++j) {
+                        if(!inside) {
+                            const Vector3i neighbor = Vector3i(x, y, z) + neighborhood[j];
+                            if(neighbor.x() < 0 || neighbor.y() < 0 || neighbor.z() < 0 ||
+                               neighbor.x() >= width || neighbor.y() >= height || neighbor.z() >= depth)
+                                continue;
+                        }
+                        const int64_t neighbor = index + linearOffsets[j];
+                        if(!visit(neighbor) || !accept(neighbor))
                             continue;
+                        // add it to segmentation
+                        outputData[neighbor] = 1;
+                        added.push_back(neighbor);
                     }
-                    neighborhood.push_back(Vector3i(a, b, 0));
                 }
-            }
-        }
-
-        // Process queue
-        while(!queue.empty()) {
-            Vector3i pos = queue.top();
-            queue.pop();
-
-            // Add neighbors to queue
-            for(auto offset : neighborhood) {
-                Vector3i neighbor = pos.cast<int>() + offset;
-                // Check for out of bounds
-                if(neighbor.x() < 0 || neighbor.y() < 0 || neighbor.z() < 0 ||
-                   neighbor.x() >= output->getWidth() || neighbor.y() >= output->getHeight() || neighbor.z() >= output->getDepth())
-                    continue;
-
-                // Check that voxel is not already segmented
-                if(outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] == 1)
-                    continue;
-
-                // Check condition
-                T value = input[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()];
-                if(value >= mMinimumIntensity && value <= mMaximumIntensity) {
-                    // add it to segmentation
-                    outputData[neighbor.x()+neighbor.y()*output->getWidth()+neighbor.z()*output->getWidth()*output->getHeight()] = 1;
-
-                    // Add to queue
-                    queue.push(neighbor);
-                }
-            }
+                std::lock_guard<std::mutex> lock(mutex);
+                nextFrontier.insert(nextFrontier.end(), added.begin(), added.end());
+            }, 1024);
+            std::swap(frontier, nextFrontier);
+            ++wavefronts;
         }
+        reportInfo() << "Seeded region growing finished after " << wavefronts << " wavefronts" << reportEnd();
     }
 
     void SeededRegionGrowing::execute() {
@@ -159,7 +188,14 @@ SeededRegionGrowing::SeededRegionGrowing(float intensityMinimum, float intensity
         auto output = Image::createSegmentationFromImage(input);
         output->fill(0);
 
-        if(getMainDevice()->isHost()) {
+        // The frontier based growing on the host only processes voxels next to the segmentation, and is faster than
+        // the OpenCL kernel on CPU devices, which processes the entire image until nothing more is added.
+        bool useHost = getMainDevice()->isHost();
+        if(!useHost) {
+            auto device = std::dynamic_pointer_cast<OpenCLDevice>(getMainDevice());
+            useHost = device->getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU;
+        }
+        if(useHost) {
             auto inputAccess = input->getImageAccess(ACCESS_READ);
             void* inputData = inputAccess->get();
             switch(input->getDataType()) {
@@ -212,21 +248,25 @@ SeededRegionGrowing::SeededRegionGrowing(float intensityMinimum, float intensity
             mKernel.setArg(5, m_pixelConnectivity == PixelConnectivity::All ? 26 : 6);
         }
 
+        // The stop flag is only read back after a batch of iterations, since the blocking read stalls the queue.
+        // Growing has stopped if no iteration in the batch added anything. Iterations after that do nothing.
+        const int iterationsPerRead = 8;
         char stopGrowingInit = 1;
         char stopGrowingResult;
         int iterations = 0;
         bool stopGrowing = false;
         do {
-            iterations++;
-            queue.enqueueWriteBuffer(stopGrowingBuffer, CL_TRUE, 0, sizeof(char), &stopGrowingInit);
-
-            queue.enqueueNDRangeKernel(
-                    mKernel,
-                    cl::NullRange,
-                    globalSize,
-                    cl::NullRange
-            );
-            //queue.finish();
+            queue.enqueueWriteBuffer(stopGrowingBuffer, CL_FALSE, 0, sizeof(char), &stopGrowingInit);
+
+            for(int i = 0; i < iterationsPerRead; i++) {
+                iterations++;
+                queue.enqueueNDRangeKernel(
+                        mKernel,
+                        cl::NullRange,
+                        globalSize,
+                        cl::NullRange
+                );
+            }
 
             queue.enqueueReadBuffer(stopGrowingBuffer, CL_TRUE, 0, sizeof(char), &stopGrowingResult);
             if(stopGrowingResult == 1)
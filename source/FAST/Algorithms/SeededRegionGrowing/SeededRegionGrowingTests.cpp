@@ -3,6 +3,8 @@
 #include "FAST/Importers/ImageFileImporter.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Data/Image.hpp"
+#include <queue>
+#include <random>
 
 namespace fast {
 
@@ -90,4 +92,77 @@ TEST_CASE("3D Seeded region growing on Host", "[fast][SeededRegionGrowing]") {
     CHECK(4106484 == sum);
 }
 
+// Breadth first reference: a seed or neighbor of the segmentation is added if its intensity is within the range
+static std::vector<uchar> growRegion(const std::vector<uchar>& data, Vector3i size, float minimum, float maximum,
+                                     const std::vector<Vector3i>& seeds, bool fullConnectivity) {
+    std::vector<uchar> result(data.size(), 0);
+    std::vector<bool> visited(data.size(), false);
+    auto getIndex = [&size](Vector3i p) {
+        return p.x() + ((int64_t)p.y() + (int64_t)p.z()*size.y())*size.x();
+    };
+    std::queue<Vector3i> queue;
+    for(auto seed : seeds)
+        queue.push(seed);
+    while(!queue.empty()) {
+        const Vector3i current = queue.front();
+        queue.pop();
+        const int64_t index = getIndex(current);
+        if(visited[index])
+            continue;
+        visited[index] = true;
+        if(data[index] < minimum || data[index] > maximum)
+            continue;
+        result[index] = 1;
+        for(int c = -1; c <= 1; ++c) {
+            for(int b = -1; b <= 1; ++b) {
+                for(int a = -1; a <= 1; ++a) {
+                    const int distance = std::abs(a) + std::abs(b) + std::abs(c);
+                    if(distance == 0 || (!fullConnectivity && distance > 1) || (size.z() == 1 && c != 0))
+                        continue;
+                    const Vector3i next = current + Vector3i(a, b, c);
+                    if((next.array() < 0).any() || (next.array() >= size.array()).any())
+                        continue;
+                    queue.push(next);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+TEST_CASE("Seeded region growing of synthetic image is same on host and OpenCL devices", "[fast][SeededRegionGrowing]") {
+    std::mt19937 generator(3);
+    std::vector<ExecutionDevice::pointer> devices = {Host::getInstance()};
+    for(auto device : DeviceManager::getInstance()->getAllDevices())
+        devices.push_back(device);
+    for(Vector3i size : {Vector3i(173, 91, 1), Vector3i(41, 37, 29)}) {
+        std::vector<uchar> data(size.prod());
+        for(auto& value : data)
+            value = generator() % 256;
+        // Last seed is outside the intensity range, and is not grown from
+        std::vector<Vector3i> seeds = {{0, 0, 0}, size/2, size - Vector3i::Ones()};
+        data[0] = 200;
+        data[seeds[1].x() + (seeds[1].y() + seeds[1].z()*size.y())*size.x()] = 100;
+        data[data.size() - 1] = 10;
+        for(auto connectivity : {PixelConnectivity::All, PixelConnectivity::Closests}) {
+            // Percolating for full connectivity, mostly small regions for closest
+            const float minimum = connectivity == PixelConnectivity::All ? 100 : 64;
+            auto expected = growRegion(data, size, minimum, 255, seeds, connectivity == PixelConnectivity::All);
+            for(auto device : devices) {
+                INFO("Device " << (device->isHost() ? "Host" : std::dynamic_pointer_cast<OpenCLDevice>(device)->getName()));
+                auto image = size.z() == 1 ?
+                        Image::create(size.x(), size.y(), TYPE_UINT8, 1, data.data()) :
+                        Image::create(size.x(), size.y(), size.z(), TYPE_UINT8, 1, data.data());
+                auto algorithm = SeededRegionGrowing::create(minimum, 255, seeds, connectivity);
+                algorithm->connect(image);
+                algorithm->setMainDevice(device);
+                auto result = algorithm->runAndGetOutputData<Image>();
+                auto access = result->getImageAccess(ACCESS_READ);
+                const uchar* resultData = (const uchar*)access->get();
+                CHECK(std::vector<uchar>(resultData, resultData + data.size()) == expected);
+            }
+        }
+    }
+}
+
 } // end namespace fast
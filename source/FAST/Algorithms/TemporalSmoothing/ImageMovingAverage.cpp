@@ -6,6 +6,7 @@ namespace fast {
 ImageMovingAverage::ImageMovingAverage(int frameCount, bool keepDataType) {
     createInputPort<Image>(0);
     createOutputPort<Image>(0);
+    setImageBufferPooling(true); // New output image every frame
 
     createOpenCLProgram(Config::getKernelSourcePath() + "Algorithms/TemporalSmoothing/ImageMovingAverage.cl");
 
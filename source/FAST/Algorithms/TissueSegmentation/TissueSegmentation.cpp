@@ -73,7 +73,7 @@ bool TissueSegmentation::getFilterZeros() const {
 void TissueSegmentation::runColorThresholding(SpatialDataObject::pointer image) {
     Image::pointer input;
     if(auto wsi = std::dynamic_pointer_cast<ImagePyramid>(image)) {
-        auto access = wsi->getAccess(ACCESS_READ);
+        auto access = wsi->getAccess(ACCESS_READ, true);
         input = access->getLevelAsImage(wsi->getNrOfLevels()-1);
     } else if(auto patch = std::dynamic_pointer_cast<Image>(image)) {
         input = patch;
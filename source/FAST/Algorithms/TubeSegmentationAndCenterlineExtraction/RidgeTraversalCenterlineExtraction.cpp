@@ -1,6 +1,7 @@
 #include "RidgeTraversalCenterlineExtraction.hpp"
 #include "FAST/Data/Image.hpp"
 #include "FAST/Data/Mesh.hpp"
+#include "FAST/ThreadPool.hpp"
 #include <queue>
 #include <vector>
 #include <list>
@@ -268,35 +269,41 @@ void extractCenterlines(
     Reporter::info() << "Getting valid start points for centerline extraction.." << Reporter::end();
     float* TDFarray = (float*)TDFaccess->get();
     // Collect all valid start points
-    #pragma omp parallel for
-    for(int z = 2; z < size.z()-2; z++) {
-        for(int y = 2; y < size.y()-2; y++) {
-            for(int x = 2; x < size.x()-2; x++) {
-                if(TDFarray[x + y*size.x() + z*size.x()*size.y()] < Thigh)
-                //if(TDFaccess->getScalar(Vector3i(x,y,z)) < Thigh) // This is reaaaaallllly slow
-                    continue;
-
-                Vector3i pos(x,y,z);
-                bool valid = true;
-                for(int i = 0; i < 26; ++i) {
-                    Vector3i nPos = pos + neighborhood[i];
-                    if(squaredMagnitude(vectorFieldAccess, nPos) < squaredMagnitude(vectorFieldAccess, pos)) {
-                        valid = false;
-                        break;
+    // Start points are collected per slice, and added to the queue in the same order as a serial loop
+    std::vector<std::vector<point>> startPoints(size.z());
+    ThreadPool::getInstance()->parallelFor(2, size.z()-2, [&](int begin, int end) {
+        for(int z = begin; z < end; z++) {
+            for(int y = 2; y < size.y()-2; y++) {
+                for(int x = 2; x < size.x()-2; x++) {
+                    if(TDFarray[x + y*size.x() + z*size.x()*size.y()] < Thigh)
+                    //if(TDFaccess->getScalar(Vector3i(x,y,z)) < Thigh) // This is reaaaaallllly slow
+                        continue;
+
+                    Vector3i pos(x,y,z);
+                    bool valid = true;
+                    for(int i = 0; i < 26; ++i) {
+                        Vector3i nPos = pos + neighborhood[i];
+                        if(squaredMagnitude(vectorFieldAccess, nPos) < squaredMagnitude(vectorFieldAccess, pos)) {
+                            valid = false;
+                            break;
+                        }
                     }
-                }
 
-                if(valid) {
-                    point p;
-                    p.value = TDFaccess->getScalar(Vector3i(x,y,z));
-                    p.x = x;
-                    p.y = y;
-                    p.z = z;
-                    #pragma omp critical
-                    queue.push(p);
+                    if(valid) {
+                        point p;
+                        p.value = TDFaccess->getScalar(Vector3i(x,y,z));
+                        p.x = x;
+                        p.y = y;
+                        p.z = z;
+                        startPoints[z].push_back(p);
+                    }
                 }
             }
         }
+    });
+    for(auto&& slice : startPoints) {
+        for(auto&& p : slice)
+            queue.push(p);
     }
 
     Reporter::info() << "Processing " << queue.size() << " valid start points" << Reporter::end();
@@ -526,11 +533,12 @@ void extractCenterlines(
                         secondConnectionStack.pop();
                     }
 
-                    #pragma omp parallel for
-                    for(int i = 0; i < totalSize;i++) {
-                        if(centerlines[i] == secondConnection)
-                            centerlines[i] = prevConnection;
-                    }
+                    ThreadPool::getInstance()->parallelFor(0, totalSize, [&](int begin, int end) {
+                        for(int i = begin; i < end; i++) {
+                            if(centerlines[i] == secondConnection)
+                                centerlines[i] = prevConnection;
+                        }
+                    });
                     centerlineDistances[prevConnection] += centerlineDistances[secondConnection];
                     centerlineDistances.erase(secondConnection);
                 }
@@ -621,25 +629,26 @@ void RidgeTraversalCenterlineExtraction::execute() {
     if(radius2)
         radius2Access = radius2->getImageAccess(ACCESS_READ);
     // Mark largest tree with 1, and rest with 0
-    #pragma omp parallel for
-    for(int i = 0; i < totalSize;i++) {
-        bool valid = false;
-        std::list<int>::iterator it2;
-        for(it2 = trees.begin(); it2 != trees.end(); it2++) {
-            if(centerlines[i] == *it2) {
-                // Store radius in centerline volume
-                if(useFirstRadius[i]) {
-                    returnCenterlines[i] = round(radiusAccess->getScalar(i));
-                } else {
-                    returnCenterlines[i] = 1;//round(radius2Access->getScalar(i));
+    ThreadPool::getInstance()->parallelFor(0, totalSize, [&](int begin, int end) {
+        for(int i = begin; i < end; i++) {
+            bool valid = false;
+            std::list<int>::iterator it2;
+            for(it2 = trees.begin(); it2 != trees.end(); it2++) {
+                if(centerlines[i] == *it2) {
+                    // Store radius in centerline volume
+                    if(useFirstRadius[i]) {
+                        returnCenterlines[i] = round(radiusAccess->getScalar(i));
+                    } else {
+                        returnCenterlines[i] = 1;//round(radius2Access->getScalar(i));
+                    }
+                    valid = true;
+                    break;
                 }
-                valid = true;
-                break;
             }
+            if(!valid)
+                returnCenterlines[i] = 0;
         }
-        if(!valid)
-            returnCenterlines[i] = 0;
-    }
+    });
 
     delete[] centerlines;
 
@@ -6,6 +6,7 @@ namespace fast {
 ScanConverter::ScanConverter(int width, int height, float gain, float dynamicRange, float startDepth, float endDepth, float startAngle, float endAngle, float leftPos, float rightPos) {
     createInputPort(0, "Beamspace image");
     createOutputPort(0, "Scan converted image");
+    setImageBufferPooling(true); // New output image every frame
 
     m_width = width;
     m_height = height;
@@ -33,8 +34,8 @@ void ScanConverter::execute() {
     float startRadius = m_startDepth;
     float stopRadius = m_endDepth;
     if(m_endDepth - m_startDepth <= 0) {
-        startRadius = std::stof(input->getFrameData("startRadius"));
-        stopRadius = std::stof(input->getFrameData("stopRadius"));
+        startRadius = input->getFrameData<float>("startRadius");
+        stopRadius = input->getFrameData<float>("stopRadius");
     }
     float startTheta;
     float stopTheta;
@@ -48,8 +49,8 @@ void ScanConverter::execute() {
         startTheta = m_leftPos;
         stopTheta = m_rightPos;
     } else {
-        startTheta = std::stof(input->getFrameData("startTheta"));
-        stopTheta = std::stof(input->getFrameData("stopTheta"));
+        startTheta = input->getFrameData<float>("startTheta");
+        stopTheta = input->getFrameData<float>("stopTheta");
         isPolar = input->getFrameData("isPolar") == "true";
     }
 
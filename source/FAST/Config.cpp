@@ -2,6 +2,7 @@
 #include "Exception.hpp"
 #include "Utility.hpp"
 #include <fstream>
+#include <map>
 #ifndef WIN32
 #include <unistd.h>
 #include <sys/types.h>
@@ -50,6 +51,8 @@ namespace fast {
 			std::string mQtPluginsPath;
 			bool m_visualization = true;
 			bool m_terminateHandlerDisabled = false;
+			std::map<std::string, int> m_threadPoolSizes;
+			std::map<std::string, std::vector<int>> m_threadPoolAffinities;
 		}
 
 		static void copyPipelineFilesRecursivly(std::string pipelineSourcePath, std::string pipelineDestinationPath) {
@@ -228,6 +231,19 @@ namespace fast {
 					value = replace(value, "@ROOT@", getPath() + "/../");
 					mLibraryPath = value;
 				}
+				else if (key == "ThreadPoolSize" || key.substr(0, 15) == "ThreadPoolSize.") {
+					// Pool name after the dot, e.g. ThreadPoolSize.default = 4
+					const std::string pool = key.size() > 15 ? key.substr(15) : "default";
+					m_threadPoolSizes[pool] = std::stoi(value);
+				}
+				else if (key == "ThreadPoolAffinity" || key.substr(0, 19) == "ThreadPoolAffinity.") {
+					// Comma separated list of cores, e.g. ThreadPoolAffinity.default = 0,1,2,3
+					const std::string pool = key.size() > 19 ? key.substr(19) : "default";
+					std::vector<int> cores;
+					for(auto&& core : split(value, ","))
+						cores.push_back(std::stoi(core));
+					m_threadPoolAffinities[pool] = cores;
+				}
 				else {
 					throw Exception("Error parsing configuration file. Unrecognized key: " + key);
 				}
@@ -354,6 +370,30 @@ namespace fast {
 		    return m_terminateHandlerDisabled;
 		}
 
+		void Config::setThreadPoolSize(int threads, std::string pool) {
+			loadConfiguration();
+			m_threadPoolSizes[pool] = threads;
+		}
+
+		int Config::getThreadPoolSize(std::string pool) {
+			loadConfiguration();
+			if(m_threadPoolSizes.count(pool) == 0)
+				return -1;
+			return m_threadPoolSizes[pool];
+		}
+
+		void Config::setThreadPoolAffinity(std::vector<int> cores, std::string pool) {
+			loadConfiguration();
+			m_threadPoolAffinities[pool] = cores;
+		}
+
+		std::vector<int> Config::getThreadPoolAffinity(std::string pool) {
+			loadConfiguration();
+			if(m_threadPoolAffinities.count(pool) == 0)
+				return {};
+			return m_threadPoolAffinities[pool];
+		}
+
     void downloadTestDataIfNotExists(std::string destination, bool force) {
 #ifdef FAST_MODULE_VISUALIZATION
 			if(destination.empty())
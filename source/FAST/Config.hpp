@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <FASTExport.hpp>
 #include <FAST/DataChannels/DataChannel.hpp>
 
@@ -28,6 +29,20 @@ public:
     static void setVisualization(bool visualization);
     static void setTerminateHandlerDisabled(bool disabled);
     static bool getTerminateHandlerDisabled();
+    /**
+     * @brief Set nr of threads of a thread pool. Must be set before the pool is used for the first time.
+     * @param threads Nr of threads. If <= 0, the nr of cores available is used.
+     * @param pool Name of thread pool
+     */
+    static void setThreadPoolSize(int threads, std::string pool = "default");
+    static int getThreadPoolSize(std::string pool = "default");
+    /**
+     * @brief Set CPU cores the threads of a thread pool are pinned to. Must be set before the pool is used for the first time.
+     * @param cores List of core indices. If empty, threads are not pinned.
+     * @param pool Name of thread pool
+     */
+    static void setThreadPoolAffinity(std::vector<int> cores, std::string pool = "default");
+    static std::vector<int> getThreadPoolAffinity(std::string pool = "default");
 protected:
     static void loadConfiguration();
     static std::string getPath();
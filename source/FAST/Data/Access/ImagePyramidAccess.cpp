@@ -9,6 +9,12 @@
 #include <FAST/Algorithms/ImageResizer/ImageResizer.hpp>
 #include <FAST/Algorithms/Compression/JPEGXLCompression.hpp>
 #include <FAST/Algorithms/Compression/JPEGCompression.hpp>
+#include <FAST/Data/Access/TIFFTileWriter.hpp>
+#include <FAST/Data/Access/TileCache.hpp>
+#include <FAST/Data/Access/TIFFHandlePool.hpp>
+#include <FAST/Data/Access/ImagePyramidDownsampling.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <FAST/Tracer.hpp>
 #include <openslide/openslide.h>
 #include <tiffio.h>
 
@@ -24,7 +30,9 @@ ImagePyramidAccess::ImagePyramidAccess(
         std::mutex& readMutex,
         ImageCompression compressionFormat,
         bool useCache,
-        int cacheLimit
+        uint64_t cacheID,
+        std::shared_ptr<TIFFTileWriter> tileWriter,
+        std::shared_ptr<TIFFHandlePool> tiffHandlePool
         ) : m_initializedPatchList(initializedPatchList), m_readMutex(readMutex) {
 	if(levels.size() == 0)
 		throw Exception("Image pyramid has no levels");
@@ -35,7 +43,9 @@ ImagePyramidAccess::ImagePyramidAccess(
     m_tiffHandle = tiffHandle;
     m_compressionFormat = compressionFormat;
     m_useTileCache = useCache;
-    m_tileCacheSizeLimit = cacheLimit;
+    m_tileCacheID = cacheID;
+    m_tileWriter = tileWriter;
+    m_tiffHandlePool = tiffHandlePool;
 }
 
 void ImagePyramidAccess::release() {
@@ -63,20 +73,7 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchDataChar(int level, int x,
             std::memset(data.get(), channels > 1 ? 255 : 0, width*height*channels);
             return data;
         }
-        std::lock_guard<std::mutex> lock(m_readMutex);
-        if(m_image->isOMETIFF()) {
-            if(TIFFCurrentDirOffset(m_tiffHandle) != m_levels[level].offset) {
-                if(level == 0) {
-                    TIFFSetDirectory(m_tiffHandle, level);
-                    TIFFSetSubDirectory(m_tiffHandle, 0);
-                } else {
-                    TIFFSetSubDirectory(m_tiffHandle, m_levels[level].offset);
-                }
-            }
-        } else {
-            if(TIFFCurrentDirectory(m_tiffHandle) != level)
-                TIFFSetDirectory(m_tiffHandle, level);
-        }
+        // Locking and selection of TIFF directory is done per tile in readTileFromTIFF
         if(width == tileWidth && height == tileHeight && x % tileWidth == 0 && y % tileHeight == 0) {
             // From TIFFReadTile documentation: Return the data for the tile containing the specified coordinates.
             int bytesRead = readTileFromTIFF((void *) data.get(), x, y, level);
@@ -220,6 +217,8 @@ std::unique_ptr<uchar[]> ImagePyramidAccess::getPatchDataChar(int level, int x,
         }
     } else if(m_fileHandle != nullptr) {
         int scale = (float)m_image->getFullWidth()/levelWidth;
+        Tracer::Scope traceScope("Read region", "ImagePyramid", Tracer::isEnabled() ? Tracer::Arguments{
+            {"level", std::to_string(level)}, {"x", std::to_string(x)}, {"y", std::to_string(y)}} : Tracer::Arguments());
         openslide_read_region(m_fileHandle, (uint32_t*)data.get(), x * scale, y * scale, level, width, height);
     }
 
@@ -385,33 +384,71 @@ uint32_t ImagePyramidAccess::writeTileToTIFF(int level, int x, int y, uchar *dat
     TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0, 0);
     TIFFCheckpointDirectory(m_tiffHandle);
     uint32_t tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
+    if(m_tileWriter != nullptr)
+        m_tileWriter->discard(level, tile_id);
+    removeTileFromCache(level, tile_id);
     return tile_id;
 }
 
+uint32_t ImagePyramidAccess::computeTileID(int level, int x, int y) {
+    // Same as TIFFComputeTile for 2D tiled images with contiguous planar config, but without having to set the directory
+    return (y / m_image->getLevelTileHeight(level))*m_image->getLevelTilesX(level) + x / m_image->getLevelTileWidth(level);
+}
+
 uint32_t ImagePyramidAccess::writeTileToTIFFJPEGXL(int level, int x, int y, uchar *data) {
+    const int tileWidth = m_image->getLevelTileWidth(level);
+    const int tileHeight = m_image->getLevelTileHeight(level);
+    if(m_tileWriter != nullptr) {
+        // Compress and write tile asynchronously
+        const uint32_t tile_id = computeTileID(level, x, y);
+        const std::size_t bytes = (std::size_t)tileWidth*tileHeight*getSizeOfDataType(m_image->getDataType(), m_image->getNrOfChannels());
+        auto copy = make_uninitialized_unique<uchar[]>(bytes);
+        std::memcpy(copy.get(), data, bytes);
+        m_tileWriter->write(level, tile_id, tileWidth, tileHeight, bytes, std::move(copy));
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        removeTileFromCache(level, tile_id);
+        return tile_id;
+    }
+    // Compress before locking, so that multiple threads can compress in parallel
+    JPEGXLCompression jxl;
+    std::vector<uchar> compressed;
+    jxl.compress(data, tileWidth, tileHeight, &compressed, m_image->getCompressionQuality());
     std::lock_guard<std::mutex> lock(m_readMutex);
     TIFFSetDirectory(m_tiffHandle, level);
     uint32_t tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    JPEGXLCompression jxl;
-    std::vector<uchar> compressed;
-    jxl.compress(data, m_image->getLevelTileWidth(level), m_image->getLevelTileHeight(level), &compressed, m_image->getCompressionQuality());
     TIFFSetWriteOffset(m_tiffHandle, 0); // Set write offset to 0, so that we dont appen data
     TIFFWriteRawTile(m_tiffHandle, tile_id, (void *) compressed.data(), compressed.size()); // This appends data..
     TIFFCheckpointDirectory(m_tiffHandle);
+    removeTileFromCache(level, tile_id);
     return tile_id;
 }
 
 
 uint32_t ImagePyramidAccess::writeTileToTIFFJPEG(int level, int x, int y, uchar *data) {
+    const int tileWidth = m_image->getLevelTileWidth(level);
+    const int tileHeight = m_image->getLevelTileHeight(level);
+    if(m_tileWriter != nullptr) {
+        // Compress and write tile asynchronously
+        const uint32_t tile_id = computeTileID(level, x, y);
+        const std::size_t bytes = (std::size_t)tileWidth*tileHeight*getSizeOfDataType(m_image->getDataType(), m_image->getNrOfChannels());
+        auto copy = make_uninitialized_unique<uchar[]>(bytes);
+        std::memcpy(copy.get(), data, bytes);
+        m_tileWriter->write(level, tile_id, tileWidth, tileHeight, bytes, std::move(copy));
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        removeTileFromCache(level, tile_id);
+        return tile_id;
+    }
+    // Compress before locking, so that multiple threads can compress in parallel
+    JPEGCompression jpeg;
+    std::vector<uchar> compressed;
+    jpeg.compress(data, tileWidth, tileHeight, &compressed, m_image->getCompressionQuality());
     std::lock_guard<std::mutex> lock(m_readMutex);
     TIFFSetDirectory(m_tiffHandle, level);
     uint32_t tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    JPEGCompression jpeg;
-    std::vector<uchar> compressed;
-    jpeg.compress(data, m_image->getLevelTileWidth(level), m_image->getLevelTileHeight(level), &compressed, m_image->getCompressionQuality());
     TIFFSetWriteOffset(m_tiffHandle, 0); // Set write offset to 0, so that we dont appen data
     TIFFWriteRawTile(m_tiffHandle, tile_id, (void *) compressed.data(), compressed.size()); // This appends data..
     TIFFCheckpointDirectory(m_tiffHandle);
+    removeTileFromCache(level, tile_id);
     return tile_id;
 }
 
@@ -425,17 +462,34 @@ uint32_t ImagePyramidAccess::writeTileToTIFFNeuralNetwork(int level, int x, int
     auto compressionModel = m_image->getCompressionModel();
     compressionModel->connect(image);
     auto tensor = compressionModel->runAndGetOutputData<Tensor>();
+    // Tiles are stored as float, as expected by readTileFromTIFF
+    tensor = tensor->convertToType(TYPE_FLOAT);
     auto access = tensor->getAccess(ACCESS_READ);
     float* data = access->getRawData();
-    uint32_t size = tensor->getShape().getTotalSize()*4;
+    uint32_t size = tensor->getBufferSize();
     TIFFSetWriteOffset(m_tiffHandle, 0); // Set write offset to 0, so that we dont appen data
     TIFFWriteRawTile(m_tiffHandle, tile_id, (void *) data, size); // This appends data..
     //TIFFWriteTile(m_tiffHandle, (void *) data, x, y, 0,0); // This does not append, but tries to compress data
 
     TIFFCheckpointDirectory(m_tiffHandle);
+    if(m_tileWriter != nullptr)
+        m_tileWriter->discard(level, tile_id);
+    removeTileFromCache(level, tile_id);
     return tile_id;
 }
 
+/**
+ * Downsample a tile by a factor of 2 into one quadrant of an output tile.
+ * Each 2x2 block is reduced with the given method, see ImagePyramid::getDownsampling(). By default this is
+ * PyramidDownsampling::AVERAGE for color tiles and PyramidDownsampling::MAJORITY for single channel tiles (e.g. segmentations).
+ */
+static void downsampleTile(const uchar* input, int inputTileWidth, uchar* output, int tileWidth, int tileHeight, int quadrantX, int quadrantY, int channels, PyramidDownsampling method) {
+    const int outputOffsetX = quadrantX*tileWidth/2;
+    const int outputOffsetY = quadrantY*tileHeight/2;
+    downsample2x2(input, inputTileWidth, output + (std::size_t)channels*(outputOffsetX + outputOffsetY*tileWidth), tileWidth,
+                  tileWidth/2, tileHeight/2, channels, method);
+}
+
 void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch, bool propagate) {
     if(m_tiffHandle == nullptr)
         throw Exception("setPatch only available for TIFF backend ImagePyramids");
@@ -474,8 +528,12 @@ void ImagePyramidAccess::setPatch(int level, int x, int y, Image::pointer patch,
     m_image->setDirtyPatch(level, patchIdX, patchIdY);
 
     // Propagate upwards
-    if(propagate)
+    if(propagate) {
         propagatePatch(patch, level, x, y);
+    } else if(level + 1 < m_image->getNrOfLevels()) {
+        // Regenerate the tile above later, see updatePyramidLevels
+        m_image->setOutdatedTile(level + 1, (x/2) / m_image->getLevelTileWidth(level + 1), (y/2) / m_image->getLevelTileHeight(level + 1));
+    }
 }
 
 void ImagePyramidAccess::propagatePatch(Image::pointer patch, int level, int x, int y) {
@@ -486,7 +544,6 @@ void ImagePyramidAccess::propagatePatch(Image::pointer patch, int level, int x,
     const auto channels = m_image->getNrOfChannels();
     while(level < m_image->getNrOfLevels()-1) {
         const auto previousTileWidth = m_image->getLevelTileWidth(level);
-        const auto previousTileHeight = m_image->getLevelTileHeight(level);
         ++level;
         x /= 2;
         y /= 2;
@@ -501,52 +558,7 @@ void ImagePyramidAccess::propagatePatch(Image::pointer patch, int level, int x,
         auto newData = getPatchData<uchar>(level, x, y, tileWidth, tileHeight);
 
         // Downsample tile from previous level and add it to existing tile
-        if(m_image->getNrOfChannels() >= 3) {
-            const int channels = m_image->getNrOfChannels();
-            // Use average if RGB(A) image
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    for(int c = 0; c < channels; ++c) {
-                        newData[c + channels*(dx + offsetX * tileWidth / 2 + (dy + offsetY * tileHeight / 2) * tileWidth)] =
-                                (uchar)round((float)(
-                                        previousData[c + channels*(dx * 2 + dy * 2 * previousTileWidth)] +
-                                        previousData[c + channels*(dx * 2 + 1 + dy * 2 * previousTileWidth)] +
-                                        previousData[c + channels*(dx * 2 + 1 + (dy * 2 + 1) * previousTileWidth)] +
-                                        previousData[c + channels*(dx * 2 + (dy * 2 + 1) * previousTileWidth)]
-                                        ) / 4);
-                    }
-                }
-            }
-        } else {
-            // Use majority vote if single channel image.
-            for(int dy = 0; dy < tileHeight/2; ++dy) {
-                for(int dx = 0; dx < tileWidth/2; ++dx) {
-                    /*
-                    // This is more correct, but 100 times slower than just doing max.
-                    std::vector<uchar> list = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    std::sort(list.begin(), list.end());
-                    if(list[0] == list[1]) { // If there is more than of element 0, it should be placed as element 1
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[0];
-                    } else { // If not, it means that there is more than 1 of element 1, OR all 4 values are different and its no matter which is picked.
-                        newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = list[2];
-                    }*/
-
-                    // Just do max? 0.006 milliseconds
-                    uchar list[4] = {
-                            previousData[dx*2 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + dy*2*previousTileWidth],
-                            previousData[dx*2 + 1 + (dy*2+1)*previousTileWidth],
-                            previousData[dx*2 + (dy*2+1)*previousTileWidth]
-                    };
-                    newData[dx + offsetX*tileWidth/2 + (dy+offsetY*tileHeight/2)*tileWidth] = std::max(std::max(std::max(list[0], list[1]), list[2]), list[3]);
-                }
-            }
-        }
+        downsampleTile(previousData.get(), previousTileWidth, newData.get(), tileWidth, tileHeight, offsetX, offsetY, channels, m_image->getDownsampling());
         auto tile_id = writeTileToTIFF(level, x, y, newData.get(), tileWidth, tileHeight, channels);
         previousData = std::move(newData);
 
@@ -561,33 +573,97 @@ void ImagePyramidAccess::propagatePatch(Image::pointer patch, int level, int x,
     }
 }
 
+void ImagePyramidAccess::updatePyramidLevels() {
+    if(m_tiffHandle == nullptr)
+        throw Exception("updatePyramidLevels only available for TIFF backend ImagePyramids");
+    if(!m_write)
+        throw Exception("updatePyramidLevels requires an ImagePyramidAccess with write access");
+    const int channels = m_image->getNrOfChannels();
+    const int bytesPerPixel = getSizeOfDataType(m_image->getDataType(), channels);
+    const uchar background = channels > 1 ? 255 : 0;
+    const auto downsampling = m_image->getDownsampling();
+    // One level at a time, since each level is generated from the level below
+    for(int level = 1; level < m_image->getNrOfLevels(); ++level) {
+        const auto tiles = m_image->takeOutdatedTiles(level);
+        if(tiles.empty())
+            continue;
+        reportInfo() << "Updating " << tiles.size() << " tiles of pyramid level " << level << reportEnd();
+        const int tileWidth = m_image->getLevelTileWidth(level);
+        const int tileHeight = m_image->getLevelTileHeight(level);
+        const int childTileWidth = m_image->getLevelTileWidth(level - 1);
+        const int childTileHeight = m_image->getLevelTileHeight(level - 1);
+        if(childTileWidth != tileWidth || childTileHeight != tileHeight)
+            throw Exception("updatePyramidLevels requires all levels to have the same tile size");
+        const int childTilesX = m_image->getLevelTilesX(level - 1);
+        const int childTilesY = m_image->getLevelTilesY(level - 1);
+        auto updateTiles = [&](int begin, int end) {
+            const std::size_t tileBytes = (std::size_t)tileWidth*tileHeight*bytesPerPixel;
+            auto childData = make_uninitialized_unique<uchar[]>(tileBytes);
+            for(int i = begin; i < end; ++i) {
+                const int tileX = tiles[i].first;
+                const int tileY = tiles[i].second;
+                auto data = make_uninitialized_unique<uchar[]>(tileBytes);
+                std::memset(data.get(), background, tileBytes);
+                // Each tile is the downsampled 2x2 child tiles of the level below
+                for(int quadrantY = 0; quadrantY < 2; ++quadrantY) {
+                    for(int quadrantX = 0; quadrantX < 2; ++quadrantX) {
+                        const int childTileX = tileX*2 + quadrantX;
+                        const int childTileY = tileY*2 + quadrantY;
+                        if(childTileX >= childTilesX || childTileY >= childTilesY)
+                            continue;
+                        const int childX = childTileX*childTileWidth;
+                        const int childY = childTileY*childTileHeight;
+                        if(!isPatchInitialized(level - 1, childX, childY))
+                            continue;
+                        readTileFromTIFF(childData.get(), childX, childY, level - 1);
+                        downsampleTile(childData.get(), childTileWidth, data.get(), tileWidth, tileHeight, quadrantX, quadrantY, channels, downsampling);
+                    }
+                }
+                const uint32_t tileID = writeTileToTIFF(level, tileX*tileWidth, tileY*tileHeight, data.get(), tileWidth, tileHeight, channels);
+                {
+                    std::lock_guard<std::mutex> lock(m_readMutex);
+                    m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tileID));
+                }
+                m_image->setDirtyPatch(level, tileX, tileY);
+                if(level + 1 < m_image->getNrOfLevels())
+                    m_image->setOutdatedTile(level + 1, tileX/2, tileY/2);
+            }
+        };
+        if(m_compressionFormat == ImageCompression::NEURAL_NETWORK) {
+            // Compression model can't be run by several threads at the same time
+            updateTiles(0, (int)tiles.size());
+        } else {
+            ThreadPool::getInstance()->parallelFor(0, (int)tiles.size(), updateTiles);
+        }
+    }
+}
+
 bool ImagePyramidAccess::isPatchInitialized(int level, int x, int y) {
     if(m_image->isPyramidFullyInitialized())
         return true;
     std::lock_guard<std::mutex> lock(m_readMutex);
-    TIFFSetDirectory(m_tiffHandle, level);
-    auto tile = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
+    auto tile = computeTileID(level, x, y);
     return m_initializedPatchList.count(std::to_string(level) + "-" + std::to_string(tile)) > 0;
 }
 
-void ImagePyramidAccess::addTileToQueue(const std::string& id) {
-    if(m_tileCacheCounter.count(id) == 0) {
-        m_tileCacheCounter[id] = 1;
-    } else {
-        m_tileCacheCounter[id] += 1;
-    }
-    m_tileCacheQueue.push_back(id);
-
-    if(m_tileCacheSizeLimit > 0) { // Tile cache is limited
-        while(m_tileCache.size() >= m_tileCacheSizeLimit) {
-            auto item = m_tileCacheQueue.front();
-            m_tileCacheQueue.pop_front();
-            m_tileCacheCounter[item] -= 1;
-            if(m_tileCacheCounter[item] <= 0) {
-                m_tileCache.erase(item);
-                m_tileCacheCounter.erase(item);
+void ImagePyramidAccess::removeTileFromCache(int level, uint32_t tileID) {
+    // Must be called with m_readMutex locked, so that a concurrent read can't put the old tile back into the cache
+    TileCache::getInstance()->remove(m_tileCacheID, level, tileID);
+}
+
+void ImagePyramidAccess::setTIFFDirectory(TIFF* tiff, int level) {
+    if(m_image->isOMETIFF()) {
+        if(TIFFCurrentDirOffset(tiff) != m_levels[level].offset) {
+            if(level == 0) {
+                TIFFSetDirectory(tiff, level);
+                TIFFSetSubDirectory(tiff, 0);
+            } else {
+                TIFFSetSubDirectory(tiff, m_levels[level].offset);
             }
         }
+    } else {
+        if(TIFFCurrentDirectory(tiff) != level)
+            TIFFSetDirectory(tiff, level);
     }
 }
 
@@ -596,18 +672,34 @@ int ImagePyramidAccess::readTileFromTIFF(void *data, int x, int y, int level) {
     const auto tileHeight = m_image->getLevelTileHeight(level);
     const auto channels = m_image->getNrOfChannels();
     const int bytesPerPixel = getSizeOfDataType(m_image->getDataType(), channels);
-    TIFFSetDirectory(m_tiffHandle, level);
-    const uint32_t tile_id = TIFFComputeTile(m_tiffHandle, x, y, 0, 0);
-    auto id = std::to_string(level) + "_" + std::to_string(tile_id);
-    if(m_useTileCache) {
-        if(m_tileCache.count(id) > 0) {
-            // Cache hit
-            std::memcpy(data, m_tileCache.at(id).get(), tileWidth*tileHeight*bytesPerPixel);
-            addTileToQueue(id);
+    const std::size_t tileBytes = (std::size_t)tileWidth*tileHeight*bytesPerPixel;
+    const uint32_t tile_id = computeTileID(level, x, y);
+    auto tileCache = TileCache::getInstance();
+    if(m_useTileCache && tileCache->get(m_tileCacheID, level, tile_id, data, tileBytes))
+        return 0;
+    Tracer::Scope traceScope("Read tile", "ImagePyramid", Tracer::isEnabled() ? Tracer::Arguments{
+        {"level", std::to_string(level)}, {"x", std::to_string(x)}, {"y", std::to_string(y)}} : Tracer::Arguments());
+
+    // Get a TIFF handle. Read-only pyramids have a pool of handles which can be used by several threads at the same time,
+    // otherwise the single TIFF handle of the pyramid is used, which has to be locked.
+    TIFFHandlePool::Handle pooledHandle;
+    std::unique_lock<std::mutex> lock(m_readMutex, std::defer_lock);
+    TIFF* tiff;
+    if(m_tiffHandlePool != nullptr) {
+        pooledHandle = m_tiffHandlePool->acquire();
+        tiff = pooledHandle.get();
+    } else {
+        lock.lock();
+        tiff = m_tiffHandle;
+        if(m_tileWriter != nullptr && m_tileWriter->readPendingTile(level, tile_id, data)) {
+            // Tile has not been compressed and written to disk yet
             return 0;
         }
     }
-    if(TIFFGetStrileByteCount(m_tiffHandle, tile_id) == 0) { // Blank patch
+    // The tile may be overwritten after the lock is released, thus only add it to the cache if it has not been invalidated since now
+    const int64_t cacheGeneration = tileCache->getGeneration(m_tileCacheID, level, tile_id);
+    setTIFFDirectory(tiff, level);
+    if(TIFFGetStrileByteCount(tiff, tile_id) == 0) { // Blank patch
         if(channels == 1) {
             std::memset(data, 0, tileWidth*tileHeight*channels);
         } else {
@@ -615,7 +707,7 @@ int ImagePyramidAccess::readTileFromTIFF(void *data, int x, int y, int level) {
         }
         return 0;
     }
-    // Assumes level (directory is already set)
+    int bytesRead = 0;
     if(m_compressionFormat == ImageCompression::NEURAL_NETWORK) {
         auto decompressionModel = m_image->getDecompressionModel();
         // TODO The logic here must be improved
@@ -624,7 +716,7 @@ int ImagePyramidAccess::readTileFromTIFF(void *data, int x, int y, int level) {
         shape[0] = 1;
         int64_t size = shape.getTotalSize()*4;
         float* buffer = new float[shape.getTotalSize()];
-        int bytesRead = TIFFReadRawTile(m_tiffHandle, tile_id, buffer, size);
+        bytesRead = TIFFReadRawTile(tiff, tile_id, buffer, size);
         auto tensor = Tensor::create(buffer, shape);
         decompressionModel->connect(tensor);
         // TODO TensorToImage not really needed..
@@ -636,38 +728,37 @@ int ImagePyramidAccess::readTileFromTIFF(void *data, int x, int y, int level) {
         auto access = image->getImageAccess(ACCESS_READ);
         std::memcpy(data, access->get(), image->getNrOfVoxels()*image->getNrOfChannels());
         return bytesRead;
-    } else {
-        int bytesRead = 0;
+    } else if(m_compressionFormat == ImageCompression::JPEG || m_compressionFormat == ImageCompression::JPEGXL) {
+        auto buffer = make_uninitialized_unique<char[]>(tileWidth*tileHeight*channels);
+        mRuntimeManager->startRegularTimer("TIFFReadRawTile");
+        bytesRead = TIFFReadRawTile(tiff, tile_id, buffer.get(), tileWidth*tileHeight*channels);
+        mRuntimeManager->stopRegularTimer("TIFFReadRawTile");
+        // Release TIFF handle before decoding, so that other threads can read while this thread decodes
+        pooledHandle.reset();
+        if(lock.owns_lock())
+            lock.unlock();
+
+        int width, height;
         if(m_compressionFormat == ImageCompression::JPEG /*&& m_image->isOMETIFF()*/) {
             // Use libjpeg for decompression, as ome-tiff files doesn't seem to like tiff's internal jpeg
-            auto buffer = make_uninitialized_unique<char[]>(tileWidth*tileHeight*channels);
-            mRuntimeManager->startRegularTimer("TIFFReadRawTile");
-            bytesRead = TIFFReadRawTile(m_tiffHandle, tile_id, buffer.get(), tileWidth*tileHeight*channels);
-            mRuntimeManager->stopRegularTimer("TIFFReadRawTile");
-
             mRuntimeManager->startRegularTimer("JPEG decompression");
             JPEGCompression jpeg(m_JPEGTablesCount, m_JPEGTablesData);
-            int width, height;
             jpeg.decompress((uchar*)buffer.get(), bytesRead, &width, &height, (uchar*)data);
             mRuntimeManager->stopRegularTimer("JPEG decompression");
-        } else if(m_compressionFormat == ImageCompression::JPEGXL) {
-            auto buffer = make_uninitialized_unique<char[]>(tileWidth*tileHeight*channels);
-            bytesRead = TIFFReadRawTile(m_tiffHandle, tile_id, buffer.get(), tileWidth*tileHeight*channels);
-
+        } else {
             JPEGXLCompression jxl;
-            int width, height;
             jxl.decompress((uchar*)buffer.get(), bytesRead, &width, &height, (uchar*)data);
-        } else {
-            bytesRead = TIFFReadTile(m_tiffHandle, data, x, y, 0, 0);
-        }
-        if(m_useTileCache) {
-            auto data2 = make_uninitialized_unique<char[]>(tileWidth*tileHeight*bytesPerPixel);
-            std::memcpy(data2.get(), data, tileWidth*tileHeight*bytesPerPixel);
-            m_tileCache.insert({id, std::move(data2)});
-            addTileToQueue(id);
         }
-        return bytesRead;
+    } else {
+        // Other compression types are decoded by libtiff, which needs the handle
+        bytesRead = TIFFReadTile(tiff, data, x, y, 0, 0);
+        pooledHandle.reset();
+        if(lock.owns_lock())
+            lock.unlock();
     }
+    if(m_useTileCache)
+        tileCache->put(m_tileCacheID, level, tile_id, data, tileBytes, cacheGeneration);
+    return bytesRead;
 }
 
 void ImagePyramidAccess::setBlankPatch(int level, int x, int y) {
@@ -682,6 +773,9 @@ void ImagePyramidAccess::setBlankPatch(int level, int x, int y) {
     char data = 0;
     TIFFWriteRawTile(m_tiffHandle, tile_id, &data, 0);
     TIFFCheckpointDirectory(m_tiffHandle);
+    if(m_tileWriter != nullptr)
+        m_tileWriter->discard(level, tile_id);
+    removeTileFromCache(level, tile_id);
     m_initializedPatchList.insert(std::to_string(level) + "-" + std::to_string(tile_id));
 
     // TODO Propagate or not?
@@ -13,6 +13,8 @@ namespace fast {
 class Image;
 class ImagePyramid;
 class NeuralNetwork;
+class TIFFTileWriter;
+class TIFFHandlePool;
 
 /**
  * @brief Image compression types for ImagePyramids
@@ -58,16 +60,25 @@ class FAST_EXPORT ImagePyramidAccess : public Object {
 #endif
 public:
 	typedef std::unique_ptr<ImagePyramidAccess> pointer;
-	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<std::string>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat, bool useCache = false, int cacheLimit = -1);
+	ImagePyramidAccess(std::vector<ImagePyramidLevel> levels, openslide_t* fileHandle, TIFF* tiffHandle, std::shared_ptr<ImagePyramid> imagePyramid, bool writeAccess, std::unordered_set<std::string>& initializedPatchList, std::mutex& readMutex, ImageCompression compressionFormat, bool useCache = false, uint64_t cacheID = 0, std::shared_ptr<TIFFTileWriter> tileWriter = nullptr, std::shared_ptr<TIFFHandlePool> tiffHandlePool = nullptr);
 	/**
 	 * @brief Write a patch to the pyramid
 	 * @param level
 	 * @param x
 	 * @param y
 	 * @param patch
-	 * @param propagate
+	 * @param propagate Whether to update all coarser levels immediately. If false, the tile above is marked
+	 *      as outdated instead, and all coarser levels can be updated at once with updatePyramidLevels.
 	 */
 	void setPatch(int level, int x, int y, std::shared_ptr<Image> patch, bool propagate = true);
+	/**
+	 * @brief Regenerate all outdated tiles of coarser levels, from patches written with propagate = false.
+	 *
+	 * Levels are updated one at a time, with the tiles of each level downsampled, compressed and written in parallel.
+	 * Each tile is only written once, no matter how many patches below it were written.
+	 * Can be called several times while writing patches, to update only the regions which have changed since last time.
+	 */
+	void updatePyramidLevels();
 	/**
 	 * @brief Write patch/tile as empty. It will render as white/black
 	 * @param level
@@ -129,6 +140,11 @@ private:
     std::unordered_set<std::string>& m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
     std::mutex& m_readMutex;
     ImageCompression m_compressionFormat;
+    // Optional asynchronous tile compression and writing. Shared, so that the writer outlives accesses created before it is replaced
+    std::shared_ptr<TIFFTileWriter> m_tileWriter;
+    std::shared_ptr<TIFFHandlePool> m_tiffHandlePool; // Optional pool of TIFF handles for parallel reading of read-only pyramids
+    void setTIFFDirectory(TIFF* tiff, int level);
+    uint32_t computeTileID(int level, int x, int y);
     uint32_t writeTileToTIFF(int level, int x, int y, std::shared_ptr<Image> image);
     uint32_t writeTileToTIFF(int level, int x, int y, uchar* data, int width, int height, int channels);
     uint32_t writeTileToTIFF(int level, int x, int y, uchar* data);
@@ -141,12 +157,9 @@ private:
     uint32_t m_JPEGTablesCount = 0;
     void* m_JPEGTablesData = nullptr;
 
-    // Optional tile cache
-    void addTileToQueue(const std::string& id);
-    std::unordered_map<std::string, std::shared_ptr<char[]>> m_tileCache; // Should ideally be a unique_ptr here, but MSVC can't handle that
-    std::deque<std::string> m_tileCacheQueue;
-    std::unordered_map<std::string, int> m_tileCacheCounter;
-    uint64_t m_tileCacheSizeLimit;
+    // Optional process-wide tile cache, see TileCache
+    void removeTileFromCache(int level, uint32_t tileID);
+    uint64_t m_tileCacheID;
     bool m_useTileCache;
 };
 
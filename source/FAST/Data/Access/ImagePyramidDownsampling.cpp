@@ -0,0 +1,340 @@
+#include "ImagePyramidDownsampling.hpp"
+#include <FAST/Exception.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is part of x86-64, AVX2 is selected at runtime
+#define FAST_DOWNSAMPLING_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FAST_TARGET_AVX2
+#else
+#define FAST_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace fast {
+
+/**
+ * Most frequent of 4 values, lowest value on ties
+ */
+static inline uint8_t majority(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    const uint8_t values[4] = {a, b, c, d};
+    const int counts[4] = {
+            (a == b) + (a == c) + (a == d),
+            (b == a) + (b == c) + (b == d),
+            (c == a) + (c == b) + (c == d),
+            (d == a) + (d == b) + (d == c),
+    };
+    uint8_t best = a;
+    int bestCount = counts[0];
+    for(int i = 1; i < 4; ++i) {
+        if(counts[i] > bestCount || (counts[i] == bestCount && values[i] < best)) {
+            best = values[i];
+            bestCount = counts[i];
+        }
+    }
+    return best;
+}
+
+/**
+ * Downsample output pixels [start, width) of a row. row0 and row1 are the two input rows.
+ */
+static void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* output, int start, int width, int channels, PyramidDownsampling method) {
+    for(int x = start; x < width; ++x) {
+        for(int c = 0; c < channels; ++c) {
+            const int left = 2*x*channels + c;
+            const int right = left + channels;
+            const uint8_t a = row0[left], b = row0[right], d = row1[left], e = row1[right];
+            uint8_t result;
+            switch(method) {
+                case PyramidDownsampling::AVERAGE:
+                    // Same as rounding (a+b+d+e)/4 to nearest
+                    result = (uint8_t)((a + b + d + e + 2) >> 2);
+                    break;
+                case PyramidDownsampling::MAX:
+                    result = std::max(std::max(a, b), std::max(d, e));
+                    break;
+                case PyramidDownsampling::MAJORITY:
+                default:
+                    result = majority(a, b, d, e);
+                    break;
+            }
+            output[x*channels + c] = result;
+        }
+    }
+}
+
+#ifdef FAST_DOWNSAMPLING_X86
+// ------------------------------------------ SSE2 ------------------------------------------
+
+/**
+ * Split 32 bytes of a single channel row into 16 even and 16 odd pixels
+ */
+static inline void deinterleaveSSE2(const uint8_t* row, __m128i& even, __m128i& odd) {
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+    const __m128i first = _mm_loadu_si128((const __m128i*)row);
+    const __m128i second = _mm_loadu_si128((const __m128i*)(row + 16));
+    even = _mm_packus_epi16(_mm_and_si128(first, lowByte), _mm_and_si128(second, lowByte));
+    odd = _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8));
+}
+
+/**
+ * Rounded average of 4 vectors of 16 bytes
+ */
+static inline __m128i average4SSE2(__m128i a, __m128i b, __m128i c, __m128i d) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                                _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+    __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                                 _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+    low = _mm_srli_epi16(_mm_add_epi16(low, two), 2);
+    high = _mm_srli_epi16(_mm_add_epi16(high, two), 2);
+    return _mm_packus_epi16(low, high);
+}
+
+/**
+ * Majority vote of 4 vectors of 16 bytes, same rule as majority()
+ */
+static inline __m128i majority4SSE2(__m128i a, __m128i b, __m128i c, __m128i d) {
+    const __m128i ab = _mm_cmpeq_epi8(a, b);
+    const __m128i ac = _mm_cmpeq_epi8(a, c);
+    const __m128i ad = _mm_cmpeq_epi8(a, d);
+    const __m128i bc = _mm_cmpeq_epi8(b, c);
+    const __m128i bd = _mm_cmpeq_epi8(b, d);
+    const __m128i cd = _mm_cmpeq_epi8(c, d);
+    // Equal masks are -1, thus subtracting them counts matches
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i counts[4] = {
+            _mm_sub_epi8(_mm_sub_epi8(_mm_sub_epi8(zero, ab), ac), ad),
+            _mm_sub_epi8(_mm_sub_epi8(_mm_sub_epi8(zero, ab), bc), bd),
+            _mm_sub_epi8(_mm_sub_epi8(_mm_sub_epi8(zero, ac), bc), cd),
+            _mm_sub_epi8(_mm_sub_epi8(_mm_sub_epi8(zero, ad), bd), cd),
+    };
+    const __m128i values[4] = {a, b, c, d};
+    __m128i best = a;
+    __m128i bestCount = counts[0];
+    for(int i = 1; i < 4; ++i) {
+        const __m128i more = _mm_cmpgt_epi8(counts[i], bestCount);
+        const __m128i same = _mm_cmpeq_epi8(counts[i], bestCount);
+        // values[i] < best if max(values[i], best) != values[i]
+        const __m128i notLower = _mm_cmpeq_epi8(_mm_max_epu8(values[i], best), values[i]);
+        const __m128i take = _mm_or_si128(more, _mm_andnot_si128(notLower, same));
+        best = _mm_or_si128(_mm_and_si128(take, values[i]), _mm_andnot_si128(take, best));
+        bestCount = _mm_or_si128(_mm_and_si128(take, counts[i]), _mm_andnot_si128(take, bestCount));
+    }
+    return best;
+}
+
+/**
+ * Downsample as much as possible of a row with SSE2, starting at output pixel start
+ * @return index of first output pixel not processed
+ */
+static int downsampleRowSSE2(const uint8_t* row0, const uint8_t* row1, uint8_t* output, int start, int width, int channels, PyramidDownsampling method, std::vector<uint16_t>& sums) {
+    int x = start;
+    if(channels == 1) {
+        for(; x + 16 <= width; x += 16) {
+            __m128i a, b, c, d;
+            deinterleaveSSE2(row0 + 2*x, a, b);
+            deinterleaveSSE2(row1 + 2*x, c, d);
+            __m128i result;
+            switch(method) {
+                case PyramidDownsampling::AVERAGE:
+                    result = average4SSE2(a, b, c, d);
+                    break;
+                case PyramidDownsampling::MAX:
+                    result = _mm_max_epu8(_mm_max_epu8(a, b), _mm_max_epu8(c, d));
+                    break;
+                case PyramidDownsampling::MAJORITY:
+                default:
+                    result = majority4SSE2(a, b, c, d);
+                    break;
+            }
+            _mm_storeu_si128((__m128i*)(output + x), result);
+        }
+    } else if(method == PyramidDownsampling::AVERAGE && channels == 4) {
+        // Each pixel is 32 bits; split 8 pixels into 4 even and 4 odd pixels
+        for(; x + 4 <= width; x += 4) {
+            __m128i split[4];
+            const uint8_t* rows[2] = {row0 + 8*x, row1 + 8*x};
+            for(int i = 0; i < 2; ++i) {
+                const __m128 first = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)rows[i]));
+                const __m128 second = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(rows[i] + 16)));
+                split[2*i] = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+                split[2*i + 1] = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+            _mm_storeu_si128((__m128i*)(output + 4*x), average4SSE2(split[0], split[1], split[2], split[3]));
+        }
+    } else if(method == PyramidDownsampling::AVERAGE) {
+        // Other channel counts (e.g. RGB): Sum the two rows with SSE2, then add horizontal neighbours
+        const int size = (width - x)*2*channels;
+        const uint8_t* top = row0 + 2*x*channels;
+        const uint8_t* bottom = row1 + 2*x*channels;
+        sums.resize(size);
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for(; i + 16 <= size; i += 16) {
+            const __m128i first = _mm_loadu_si128((const __m128i*)(top + i));
+            const __m128i second = _mm_loadu_si128((const __m128i*)(bottom + i));
+            _mm_storeu_si128((__m128i*)(sums.data() + i), _mm_add_epi16(_mm_unpacklo_epi8(first, zero), _mm_unpacklo_epi8(second, zero)));
+            _mm_storeu_si128((__m128i*)(sums.data() + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(first, zero), _mm_unpackhi_epi8(second, zero)));
+        }
+        for(; i < size; ++i)
+            sums[i] = top[i] + bottom[i];
+        uint8_t* out = output + x*channels;
+        const uint16_t* left = sums.data();
+        for(; x < width; ++x) {
+            for(int c = 0; c < channels; ++c)
+                out[c] = (uint8_t)((left[c] + left[c + channels] + 2) >> 2);
+            out += channels;
+            left += 2*channels;
+        }
+    }
+    return x;
+}
+
+// ------------------------------------------ AVX2 ------------------------------------------
+
+/**
+ * Split 64 bytes of a single channel row into 32 even and 32 odd pixels
+ */
+FAST_TARGET_AVX2 static inline void deinterleaveAVX2(const uint8_t* row, __m256i& even, __m256i& odd) {
+    const __m256i lowByte = _mm256_set1_epi16(0x00FF);
+    const __m256i first = _mm256_loadu_si256((const __m256i*)row);
+    const __m256i second = _mm256_loadu_si256((const __m256i*)(row + 32));
+    // Pack works within each 128 bit lane, permute to restore pixel order
+    even = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(first, lowByte), _mm256_and_si256(second, lowByte)), _MM_SHUFFLE(3, 1, 2, 0));
+    odd = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(first, 8), _mm256_srli_epi16(second, 8)), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+FAST_TARGET_AVX2 static inline __m256i average4AVX2(__m256i a, __m256i b, __m256i c, __m256i d) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    __m256i low = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)),
+                                   _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero)));
+    __m256i high = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)),
+                                    _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero)));
+    low = _mm256_srli_epi16(_mm256_add_epi16(low, two), 2);
+    high = _mm256_srli_epi16(_mm256_add_epi16(high, two), 2);
+    // Unpack and pack are both within lanes, thus the pixel order is kept
+    return _mm256_packus_epi16(low, high);
+}
+
+FAST_TARGET_AVX2 static inline __m256i majority4AVX2(__m256i a, __m256i b, __m256i c, __m256i d) {
+    const __m256i ab = _mm256_cmpeq_epi8(a, b);
+    const __m256i ac = _mm256_cmpeq_epi8(a, c);
+    const __m256i ad = _mm256_cmpeq_epi8(a, d);
+    const __m256i bc = _mm256_cmpeq_epi8(b, c);
+    const __m256i bd = _mm256_cmpeq_epi8(b, d);
+    const __m256i cd = _mm256_cmpeq_epi8(c, d);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i counts[4] = {
+            _mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, ab), ac), ad),
+            _mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, ab), bc), bd),
+            _mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, ac), bc), cd),
+            _mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, ad), bd), cd),
+    };
+    const __m256i values[4] = {a, b, c, d};
+    __m256i best = a;
+    __m256i bestCount = counts[0];
+    for(int i = 1; i < 4; ++i) {
+        const __m256i more = _mm256_cmpgt_epi8(counts[i], bestCount);
+        const __m256i same = _mm256_cmpeq_epi8(counts[i], bestCount);
+        const __m256i notLower = _mm256_cmpeq_epi8(_mm256_max_epu8(values[i], best), values[i]);
+        const __m256i take = _mm256_or_si256(more, _mm256_andnot_si256(notLower, same));
+        best = _mm256_blendv_epi8(best, values[i], take);
+        bestCount = _mm256_blendv_epi8(bestCount, counts[i], take);
+    }
+    return best;
+}
+
+/**
+ * Downsample as much as possible of a single channel row with AVX2, starting at output pixel start.
+ * The rest is done with SSE2 and scalar code.
+ * @return index of first output pixel not processed
+ */
+FAST_TARGET_AVX2 static int downsampleRowAVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* output, int start, int width, int channels, PyramidDownsampling method) {
+    int x = start;
+    if(channels != 1)
+        return x;
+    for(; x + 32 <= width; x += 32) {
+        __m256i a, b, c, d;
+        deinterleaveAVX2(row0 + 2*x, a, b);
+        deinterleaveAVX2(row1 + 2*x, c, d);
+        __m256i result;
+        switch(method) {
+            case PyramidDownsampling::AVERAGE:
+                result = average4AVX2(a, b, c, d);
+                break;
+            case PyramidDownsampling::MAX:
+                result = _mm256_max_epu8(_mm256_max_epu8(a, b), _mm256_max_epu8(c, d));
+                break;
+            case PyramidDownsampling::MAJORITY:
+            default:
+                result = majority4AVX2(a, b, c, d);
+                break;
+        }
+        _mm256_storeu_si256((__m256i*)(output + x), result);
+    }
+    return x;
+}
+
+static bool cpuSupportsAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // OS must save the AVX registers
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if(!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+DownsamplingInstructionSet getDownsamplingInstructionSet() {
+#ifdef FAST_DOWNSAMPLING_X86
+    static const DownsamplingInstructionSet instructionSet = cpuSupportsAVX2() ? DownsamplingInstructionSet::AVX2 : DownsamplingInstructionSet::SSE2;
+    return instructionSet;
+#else
+    return DownsamplingInstructionSet::SCALAR;
+#endif
+}
+
+void downsample2x2(const uint8_t* input, int inputStride, uint8_t* output, int outputStride, int width, int height, int channels, PyramidDownsampling method) {
+    downsample2x2(input, inputStride, output, outputStride, width, height, channels, method, getDownsamplingInstructionSet());
+}
+
+void downsample2x2(const uint8_t* input, int inputStride, uint8_t* output, int outputStride, int width, int height, int channels, PyramidDownsampling method, DownsamplingInstructionSet instructionSet) {
+    if(channels < 1)
+        throw Exception("Nr of channels must be > 0 in downsample2x2");
+    if(instructionSet > getDownsamplingInstructionSet())
+        throw Exception("Instruction set " + std::to_string((int)instructionSet) + " is not supported by this CPU");
+
+    std::vector<uint16_t> sums;
+    for(int y = 0; y < height; ++y) {
+        const uint8_t* row0 = input + (std::size_t)2*y*inputStride*channels;
+        const uint8_t* row1 = row0 + (std::size_t)inputStride*channels;
+        uint8_t* outputRow = output + (std::size_t)y*outputStride*channels;
+        int x = 0;
+#ifdef FAST_DOWNSAMPLING_X86
+        if(instructionSet == DownsamplingInstructionSet::AVX2)
+            x = downsampleRowAVX2(row0, row1, outputRow, x, width, channels, method);
+        if(instructionSet >= DownsamplingInstructionSet::SSE2)
+            x = downsampleRowSSE2(row0, row1, outputRow, x, width, channels, method, sums);
+#endif
+        downsampleRowScalar(row0, row1, outputRow, x, width, channels, method);
+    }
+}
+
+}
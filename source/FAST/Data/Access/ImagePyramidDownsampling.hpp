@@ -0,0 +1,63 @@
+#pragma once
+
+#include <FASTExport.hpp>
+#include <cstdint>
+
+namespace fast {
+
+/**
+ * @brief How 2x2 pixels are reduced to 1 pixel when creating the levels of an image pyramid
+ * @ingroup wsi
+ */
+enum class PyramidDownsampling {
+    AVERAGE, // Average of the 4 pixels, rounded to nearest. Default for color images.
+    MAX, // Max of the 4 pixels
+    MAJORITY, // Most frequent value of the 4 pixels, lowest value on ties. Default for single channel (label) images.
+};
+
+/**
+ * @brief CPU instruction set used for 2x2 downsampling
+ * @ingroup wsi
+ */
+enum class DownsamplingInstructionSet {
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+/**
+ * @brief Get the best instruction set for 2x2 downsampling supported by this CPU
+ * @ingroup wsi
+ */
+FAST_EXPORT DownsamplingInstructionSet getDownsamplingInstructionSet();
+
+#ifndef SWIG
+/**
+ * @brief Downsample an uint8 image by a factor of 2 in each direction
+ *
+ * Output pixel (x, y) is the reduction of input pixels (2x, 2y), (2x+1, 2y), (2x, 2y+1) and (2x+1, 2y+1).
+ * Channels are reduced independently.
+ * The best instruction set supported by the CPU is selected at runtime, and all instruction sets give identical results.
+ *
+ * @param input Pointer to first input pixel
+ * @param inputStride Row length of input in pixels
+ * @param output Pointer to first output pixel
+ * @param outputStride Row length of output in pixels
+ * @param width Width of output in pixels
+ * @param height Height of output in pixels
+ * @param channels Nr of interleaved channels
+ * @param method Reduction to use
+ * @ingroup wsi
+ */
+FAST_EXPORT void downsample2x2(const uint8_t* input, int inputStride, uint8_t* output, int outputStride, int width, int height, int channels, PyramidDownsampling method);
+/**
+ * @brief Downsample an uint8 image by a factor of 2 in each direction using a specific instruction set
+ *
+ * Mainly for testing and benchmarking. Throws an exception if the instruction set is not supported by this CPU.
+ * @sa downsample2x2
+ * @ingroup wsi
+ */
+FAST_EXPORT void downsample2x2(const uint8_t* input, int inputStride, uint8_t* output, int outputStride, int width, int height, int channels, PyramidDownsampling method, DownsamplingInstructionSet instructionSet);
+#endif
+
+}
@@ -0,0 +1,59 @@
+#include "TIFFHandlePool.hpp"
+#include <tiffio.h>
+#include <thread>
+
+namespace fast {
+
+TIFFHandlePool::TIFFHandlePool(std::string filename, int maxHandles) {
+    if(filename.empty())
+        throw Exception("Filename was empty in TIFFHandlePool");
+    m_filename = filename;
+    if(maxHandles <= 0)
+        maxHandles = std::max(1, (int)std::thread::hardware_concurrency());
+    m_maxHandles = maxHandles;
+}
+
+TIFFHandlePool::Handle TIFFHandlePool::acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_handleAvailable.wait(lock, [this] { return !m_available.empty() || m_openHandles < m_maxHandles; });
+    TIFF* handle;
+    if(!m_available.empty()) {
+        handle = m_available.back();
+        m_available.pop_back();
+    } else {
+        // Open a new handle. m = Disable memory mapping, as it doesn't work well with many handles to large files.
+        handle = TIFFOpen(m_filename.c_str(), "rm");
+        if(handle == nullptr)
+            throw Exception("TIFFHandlePool failed to open file " + m_filename);
+        ++m_openHandles;
+        reportInfo() << "Opened TIFF handle " << m_openHandles << " of " << m_maxHandles << " for " << m_filename << reportEnd();
+    }
+    return Handle(handle, [this](TIFF* handle) { release(handle); });
+}
+
+void TIFFHandlePool::release(TIFF* handle) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_available.push_back(handle);
+    }
+    m_handleAvailable.notify_all();
+}
+
+int TIFFHandlePool::getMaxHandles() const {
+    return m_maxHandles;
+}
+
+int TIFFHandlePool::getNrOfOpenHandles() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_openHandles;
+}
+
+TIFFHandlePool::~TIFFHandlePool() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Wait for all handles to be returned
+    m_handleAvailable.wait(lock, [this] { return (int)m_available.size() == m_openHandles; });
+    for(auto handle : m_available)
+        TIFFClose(handle);
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <condition_variable>
+#include <functional>
+
+// Forward declare
+typedef struct tiff TIFF;
+
+namespace fast {
+
+/**
+ * @brief Pool of read-only TIFF handles to the same file
+ *
+ * A TIFF handle keeps the current directory as state, thus a single handle can't be used by several threads
+ * at the same time. This pool opens additional handles to the same file on demand, so that multiple threads can
+ * read and decode tiles in parallel, each with its own handle.
+ * Handles are returned to the pool when the Handle object returned by acquire goes out of scope.
+ *
+ * Should only be used for TIFF files which are not written to while the pool exists.
+ *
+ * This object is owned by the ImagePyramid and used by ImagePyramidAccess.
+ *
+ * @ingroup wsi
+ */
+class FAST_EXPORT TIFFHandlePool : public Object {
+    public:
+        typedef std::unique_ptr<TIFF, std::function<void(TIFF*)>> Handle;
+        /**
+         * @brief Create pool
+         * @param filename TIFF file to open
+         * @param maxHandles Max nr of handles to open. If <= 0, it will use the nr of cores available.
+         */
+        TIFFHandlePool(std::string filename, int maxHandles = -1);
+        /**
+         * @brief Get a handle from the pool. If no handles are available, a new handle is opened.
+         * If the maximum nr of handles are in use, this will block until one is returned.
+         * @return handle, which is returned to the pool when it is destroyed.
+         */
+        Handle acquire();
+        int getMaxHandles() const;
+        int getNrOfOpenHandles();
+        ~TIFFHandlePool() override;
+    private:
+        void release(TIFF* handle);
+
+        std::string m_filename;
+        int m_maxHandles;
+        int m_openHandles = 0;
+        std::vector<TIFF*> m_available;
+        std::mutex m_mutex;
+        std::condition_variable m_handleAvailable;
+};
+
+}
@@ -0,0 +1,163 @@
+#include "TIFFTileWriter.hpp"
+#include <FAST/Algorithms/Compression/JPEGCompression.hpp>
+#include <FAST/Algorithms/Compression/JPEGXLCompression.hpp>
+#include <tiffio.h>
+#include <cstring>
+
+namespace fast {
+
+TIFFTileWriter::TIFFTileWriter(TIFF* tiffHandle, std::mutex& tiffMutex, ImageCompression compression, int quality, int threads, int maxQueueSize) : m_tiffMutex(tiffMutex) {
+    if(compression != ImageCompression::JPEG && compression != ImageCompression::JPEGXL)
+        throw Exception("TIFFTileWriter only supports JPEG and JPEGXL compression");
+    m_tiffHandle = tiffHandle;
+    m_compression = compression;
+    m_quality = quality;
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    if(maxQueueSize <= 0)
+        maxQueueSize = threads*4;
+    m_maxQueueSize = maxQueueSize;
+    for(int i = 0; i < threads; ++i)
+        m_threads.emplace_back(&TIFFTileWriter::workerLoop, this);
+    reportInfo() << "Created TIFF tile writer with " << threads << " compression threads" << reportEnd();
+}
+
+uint64_t TIFFTileWriter::getKey(int level, uint32_t tileID) {
+    return ((uint64_t)level << 32) | tileID;
+}
+
+int TIFFTileWriter::getThreads() const {
+    return m_threads.size();
+}
+
+void TIFFTileWriter::rethrowError() {
+    // Should be called with m_mutex locked
+    if(m_error) {
+        auto error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void TIFFTileWriter::write(int level, uint32_t tileID, int width, int height, std::size_t bytes, std::unique_ptr<uchar[]> data) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    rethrowError();
+    m_queueNotFull.wait(lock, [this] { return (int)m_queue.size() < m_maxQueueSize || m_stop; });
+    if(m_stop)
+        throw Exception("Trying to write tile to a TIFFTileWriter which has been stopped");
+    PendingTile tile;
+    tile.level = level;
+    tile.tileID = tileID;
+    tile.width = width;
+    tile.height = height;
+    tile.bytes = bytes;
+    tile.version = ++m_versionCounter;
+    tile.data = std::move(data);
+    // Register as the newest version of this tile. Older versions still in the queue will be skipped when written.
+    m_pending[getKey(level, tileID)] = tile;
+    m_queue.push_back(std::move(tile));
+    m_queueNotEmpty.notify_one();
+}
+
+bool TIFFTileWriter::readPendingTile(int level, uint32_t tileID, void* data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pending.find(getKey(level, tileID));
+    if(it == m_pending.end())
+        return false;
+    std::memcpy(data, it->second.data.get(), it->second.bytes);
+    return true;
+}
+
+void TIFFTileWriter::discard(int level, uint32_t tileID) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.erase(getKey(level, tileID));
+}
+
+void TIFFTileWriter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this] { return (m_queue.empty() && m_inProgress == 0) || m_stop; });
+    rethrowError();
+}
+
+void TIFFTileWriter::workerLoop() {
+    while(true) {
+        PendingTile tile;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueNotEmpty.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+            if(m_queue.empty()) // Stopped and nothing left to do
+                return;
+            tile = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_inProgress;
+            m_queueNotFull.notify_one();
+            auto it = m_pending.find(getKey(tile.level, tile.tileID));
+            if(it == m_pending.end() || it->second.version != tile.version) {
+                // A newer version of this tile has been queued, or the tile has been overwritten. Skip it.
+                --m_inProgress;
+                if(m_queue.empty() && m_inProgress == 0)
+                    m_finished.notify_all();
+                continue;
+            }
+        }
+
+        // Compress without holding any lock
+        std::vector<uchar> compressed;
+        std::exception_ptr error;
+        try {
+            if(m_compression == ImageCompression::JPEG) {
+                JPEGCompression jpeg;
+                jpeg.compress(tile.data.get(), tile.width, tile.height, &compressed, m_quality);
+            } else {
+                JPEGXLCompression jxl;
+                jxl.compress(tile.data.get(), tile.width, tile.height, &compressed, m_quality);
+            }
+        } catch(std::exception &e) {
+            const std::string message = "Error compressing tile " + std::to_string(tile.tileID) + " at level " + std::to_string(tile.level) + ": " + e.what();
+            reportError() << message << reportEnd();
+            error = std::make_exception_ptr(Exception(message));
+        }
+
+        {
+            // Only the TIFF write is serialized
+            std::lock_guard<std::mutex> tiffLock(m_tiffMutex);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_pending.find(getKey(tile.level, tile.tileID));
+            if(it != m_pending.end() && it->second.version == tile.version) {
+                if(error) {
+                    // The tile is lost. Report it on the next flush or write, and stop serving the pending data.
+                    if(!m_error)
+                        m_error = error;
+                } else {
+                    TIFFSetDirectory(m_tiffHandle, tile.level);
+                    TIFFSetWriteOffset(m_tiffHandle, 0); // Set write offset to 0, so that we dont appen data
+                    TIFFWriteRawTile(m_tiffHandle, tile.tileID, (void *) compressed.data(), compressed.size()); // This appends data..
+                    TIFFCheckpointDirectory(m_tiffHandle);
+                }
+                m_pending.erase(it);
+            }
+            --m_inProgress;
+            if(m_queue.empty() && m_inProgress == 0)
+                m_finished.notify_all();
+        }
+    }
+}
+
+TIFFTileWriter::~TIFFTileWriter() {
+    try {
+        flush();
+    } catch(std::exception &e) {
+        reportError() << "Tiles were lost when closing TIFF tile writer: " << e.what() << reportEnd();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_queueNotEmpty.notify_all();
+    m_queueNotFull.notify_all();
+    m_finished.notify_all();
+    for(auto& thread : m_threads)
+        thread.join();
+}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/Access/ImagePyramidAccess.hpp>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
+// Forward declare
+typedef struct tiff TIFF;
+
+namespace fast {
+
+/**
+ * @brief Compresses and writes tiles of a TIFF image pyramid on a pool of worker threads
+ *
+ * Tiles are JPEG/JPEG XL compressed by the worker threads without holding the TIFF mutex.
+ * Only the raw tile write and the directory checkpoint is serialized using the TIFF mutex.
+ * Tiles which are queued or being compressed are kept in memory until written,
+ * and can be read with readPendingTile in the mean time.
+ *
+ * This object is shared by the ImagePyramid and its ImagePyramidAccess objects.
+ *
+ * @ingroup wsi
+ */
+class FAST_EXPORT TIFFTileWriter : public Object {
+    public:
+        /**
+         * @brief Create tile writer
+         * @param tiffHandle TIFF file to write to
+         * @param tiffMutex Mutex which protects the TIFF handle
+         * @param compression JPEG or JPEGXL
+         * @param quality Compression quality
+         * @param threads Nr of compression threads. If <= 0, it will use the nr of cores available.
+         * @param maxQueueSize Max nr of tiles to keep in queue before write blocks. If <= 0, it is set to 4 x threads.
+         */
+        TIFFTileWriter(TIFF* tiffHandle, std::mutex& tiffMutex, ImageCompression compression, int quality, int threads = -1, int maxQueueSize = -1);
+        /**
+         * @brief Queue tile for compression and writing.
+         * Blocks if the queue is full.
+         * If an earlier tile failed to be compressed, this throws the error of that tile instead.
+         * @param level
+         * @param tileID
+         * @param width Tile width
+         * @param height Tile height
+         * @param bytes Size of data in bytes
+         * @param data Uncompressed tile data. Ownership is taken by the writer.
+         */
+        void write(int level, uint32_t tileID, int width, int height, std::size_t bytes, std::unique_ptr<uchar[]> data);
+        /**
+         * @brief Read a tile which has not been written to the TIFF yet.
+         * The TIFF mutex should be locked by the caller, otherwise the tile can be written before this returns false.
+         * @param level
+         * @param tileID
+         * @param data Destination buffer
+         * @return true if tile was pending and copied to data, false otherwise
+         */
+        bool readPendingTile(int level, uint32_t tileID, void* data);
+        /**
+         * @brief Discard any pending write of a tile. Used when the tile is overwritten directly in the TIFF.
+         * The TIFF mutex should be locked by the caller.
+         * @param level
+         * @param tileID
+         */
+        void discard(int level, uint32_t tileID);
+        /**
+         * @brief Block until all queued tiles have been written to the TIFF.
+         * If any tile failed to be compressed since the last flush, the error of the first one is thrown.
+         * Such tiles are not written, and are not available from readPendingTile.
+         */
+        void flush();
+        int getThreads() const;
+        ~TIFFTileWriter() override;
+    private:
+        struct PendingTile {
+            int level;
+            uint32_t tileID;
+            int width;
+            int height;
+            std::size_t bytes;
+            uint64_t version;
+            std::shared_ptr<uchar[]> data;
+        };
+        void workerLoop();
+        void rethrowError();
+        static uint64_t getKey(int level, uint32_t tileID);
+
+        TIFF* m_tiffHandle;
+        std::mutex& m_tiffMutex;
+        ImageCompression m_compression;
+        int m_quality;
+        int m_maxQueueSize;
+
+        std::vector<std::thread> m_threads;
+        std::deque<PendingTile> m_queue;
+        // Latest version of each tile which has not been written to disk yet
+        std::unordered_map<uint64_t, PendingTile> m_pending;
+        uint64_t m_versionCounter = 0;
+        int m_inProgress = 0;
+        bool m_stop = false;
+        // First compression error which has not been reported to the user yet
+        std::exception_ptr m_error;
+        std::mutex m_mutex;
+        std::condition_variable m_queueNotEmpty;
+        std::condition_variable m_queueNotFull;
+        std::condition_variable m_finished;
+};
+
+}
@@ -3,9 +3,10 @@
 
 namespace fast {
 
-TensorAccess::TensorAccess(float *data, TensorShape shape, std::shared_ptr<Tensor> tensor) {
+TensorAccess::TensorAccess(void *data, TensorShape shape, DataType type, std::shared_ptr<Tensor> tensor) {
     m_data = data;
     m_shape = shape;
+    m_type = type;
     m_tensor = tensor;
 }
 
@@ -22,7 +23,17 @@ void TensorAccess::release() {
 }
 
 float* TensorAccess::getRawData() {
+    if(m_type != TYPE_FLOAT)
+        throw Exception("TensorAccess::getRawData() is only supported for float tensors, use get() instead.");
+    return (float*)m_data;
+}
+
+void* TensorAccess::get() {
     return m_data;
 }
 
+DataType TensorAccess::getDataType() const {
+    return m_type;
+}
+
 }
\ No newline at end of file
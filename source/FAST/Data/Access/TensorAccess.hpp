@@ -3,6 +3,7 @@
 #include <eigen3/unsupported/Eigen/CXX11/Tensor>
 #include <FAST/Object.hpp>
 #include <FAST/Data/TensorShape.hpp>
+#include <FAST/Data/DataTypes.hpp>
 
 namespace fast {
 
@@ -19,9 +20,19 @@ class Tensor;
 class FAST_EXPORT TensorAccess {
     public:
         typedef std::unique_ptr<TensorAccess> pointer;
-        TensorAccess(float* data, TensorShape shape, std::shared_ptr<Tensor> tensor);
+        TensorAccess(void* data, TensorShape shape, DataType type, std::shared_ptr<Tensor> tensor);
+        /**
+         * Get pointer to float tensor data. Throws an exception if the tensor is not of type TYPE_FLOAT.
+         * @return
+         */
         float * getRawData();
+        /**
+         * Get pointer to tensor data of any type. TYPE_FLOAT16 data is stored as uint16_t.
+         * @return
+         */
+        void* get();
         TensorShape getShape() const;
+        DataType getDataType() const;
         ~TensorAccess();
         void release();
         template <int NumDimensions>
@@ -29,7 +40,8 @@ class FAST_EXPORT TensorAccess {
     private:
         std::shared_ptr<Tensor> m_tensor;
         TensorShape m_shape;
-        float* m_data;
+        DataType m_type;
+        void* m_data;
 };
 
 
@@ -37,6 +49,8 @@ template <int NumDimensions>
 TensorData<NumDimensions> TensorAccess::getData() const {
     if(NumDimensions != m_shape.getDimensions())
         throw Exception("Dimension mismatch for Eigen tensor in TensorAccess::getData<#Dimension>().");
+    if(m_type != TYPE_FLOAT)
+        throw Exception("TensorAccess::getData<#Dimension>() is only supported for float tensors.");
 
     // Construct eigen shape
     Eigen::array<int, NumDimensions> sizes;
@@ -44,7 +58,7 @@ TensorData<NumDimensions> TensorAccess::getData() const {
         sizes[i] = m_shape[i];
 
     // Create and return mapped eigen tensor
-    return TensorData<NumDimensions>(m_data, sizes);
+    return TensorData<NumDimensions>((float*)m_data, sizes);
 }
 
 
@@ -0,0 +1,149 @@
+#include "TileCache.hpp"
+#include <cstring>
+
+namespace fast {
+
+std::shared_ptr<TileCache> TileCache::getInstance() {
+    static std::shared_ptr<TileCache> instance(new TileCache());
+    return instance;
+}
+
+uint64_t TileCache::createCacheID() {
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+TileCache::TileCache() {
+    m_maximumSize = 512ull*1024ull*1024ull;
+    m_hits = mRuntimeManager->getCounter("tile cache hits");
+    m_misses = mRuntimeManager->getCounter("tile cache misses");
+    m_evictions = mRuntimeManager->getCounter("tile cache evictions");
+    m_bytes = mRuntimeManager->getCounter("tile cache bytes");
+}
+
+TileCache::Key TileCache::createKey(uint64_t cacheID, int level, uint32_t tileID) {
+    return {cacheID, ((uint64_t)level << 32) | tileID};
+}
+
+TileCache::Shard& TileCache::getShard(const Key& key) {
+    return m_shards[KeyHash()(key) % m_nrOfShards];
+}
+
+bool TileCache::get(uint64_t cacheID, int level, uint32_t tileID, void* data, std::size_t bytes) {
+    const Key key = createKey(cacheID, level, tileID);
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if(it == shard.index.end() || it->second->bytes != bytes) {
+        ++(*m_misses);
+        return false;
+    }
+    // Move to front of LRU list
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    std::memcpy(data, it->second->data.get(), bytes);
+    ++(*m_hits);
+    return true;
+}
+
+void TileCache::put(uint64_t cacheID, int level, uint32_t tileID, const void* data, std::size_t bytes, int64_t generation) {
+    const uint64_t maxShardBytes = m_maximumSize / m_nrOfShards;
+    if(bytes > maxShardBytes)
+        return;
+    const Key key = createKey(cacheID, level, tileID);
+    // Copy before locking
+    auto copy = std::make_unique<uint8_t[]>(bytes);
+    std::memcpy(copy.get(), data, bytes);
+
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if(generation >= 0 && generation != shard.generation)
+        return;
+    auto it = shard.index.find(key);
+    if(it != shard.index.end()) {
+        shard.bytes -= it->second->bytes;
+        *m_bytes -= it->second->bytes;
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.entries.push_front({key, std::move(copy), bytes});
+    shard.index[key] = shard.entries.begin();
+    shard.bytes += bytes;
+    *m_bytes += bytes;
+    evict(shard, maxShardBytes);
+}
+
+void TileCache::evict(Shard& shard, uint64_t maxBytes) {
+    // Shard mutex must be locked by caller
+    while(shard.bytes > maxBytes && !shard.entries.empty()) {
+        Entry& entry = shard.entries.back();
+        shard.bytes -= entry.bytes;
+        *m_bytes -= entry.bytes;
+        shard.index.erase(entry.key);
+        shard.entries.pop_back();
+        ++(*m_evictions);
+    }
+}
+
+int64_t TileCache::getGeneration(uint64_t cacheID, int level, uint32_t tileID) {
+    Shard& shard = getShard(createKey(cacheID, level, tileID));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.generation;
+}
+
+void TileCache::remove(uint64_t cacheID, int level, uint32_t tileID) {
+    const Key key = createKey(cacheID, level, tileID);
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.generation;
+    auto it = shard.index.find(key);
+    if(it == shard.index.end())
+        return;
+    shard.bytes -= it->second->bytes;
+    *m_bytes -= it->second->bytes;
+    shard.entries.erase(it->second);
+    shard.index.erase(it);
+}
+
+void TileCache::remove(uint64_t cacheID) {
+    for(auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for(auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if(it->key.cacheID == cacheID) {
+                shard.bytes -= it->bytes;
+                *m_bytes -= it->bytes;
+                shard.index.erase(it->key);
+                it = shard.entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void TileCache::clear() {
+    for(auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        *m_bytes -= shard.bytes;
+        shard.bytes = 0;
+        shard.index.clear();
+        shard.entries.clear();
+    }
+}
+
+void TileCache::setMaximumSize(uint64_t bytes) {
+    m_maximumSize = bytes;
+    for(auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        evict(shard, bytes / m_nrOfShards);
+    }
+}
+
+uint64_t TileCache::getMaximumSize() const {
+    return m_maximumSize;
+}
+
+uint64_t TileCache::getSize() const {
+    return (uint64_t)m_bytes->load();
+}
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <mutex>
+#include <list>
+#include <atomic>
+#include <array>
+
+namespace fast {
+
+/**
+ * @brief Process-wide cache of decoded image pyramid tiles
+ *
+ * All ImagePyramidAccess objects which have the tile cache enabled share this cache, thus
+ * tiles decoded by for instance PatchGenerator, TissueSegmentation and ImagePyramidRenderer are only decoded once
+ * as long as they fit in the cache.
+ * The cache is limited by a total byte budget and uses least recently used (LRU) eviction.
+ * To allow multiple threads to use the cache concurrently, the cache is split into shards,
+ * each with its own lock and a part of the byte budget.
+ *
+ * Hit, miss and eviction counters are available through getRuntimeManager()->getCounterValue() with the names
+ * "tile cache hits", "tile cache misses", "tile cache evictions" and "tile cache bytes".
+ *
+ * @ingroup wsi
+ */
+class FAST_EXPORT TileCache : public Object {
+    public:
+        typedef std::shared_ptr<TileCache> pointer;
+        static std::shared_ptr<TileCache> getInstance();
+        /**
+         * @brief Create a unique ID for a data object which is going to use the cache
+         * @return id
+         */
+        static uint64_t createCacheID();
+        /**
+         * @brief Copy a tile from the cache to data
+         * @param cacheID ID of the data object, see createCacheID
+         * @param level
+         * @param tileID
+         * @param data Destination buffer
+         * @param bytes Size of destination buffer
+         * @return true if tile was in cache
+         */
+        bool get(uint64_t cacheID, int level, uint32_t tileID, void* data, std::size_t bytes);
+        /**
+         * @brief Copy a tile into the cache. Least recently used tiles are evicted if needed.
+         * @param cacheID ID of the data object, see createCacheID
+         * @param level
+         * @param tileID
+         * @param data
+         * @param bytes
+         * @param generation If >= 0, the tile is only added if no tiles have been removed from the cache
+         *      since getGeneration returned this value. This avoids adding an old version of a tile which was overwritten
+         *      while it was being decoded.
+         */
+        void put(uint64_t cacheID, int level, uint32_t tileID, const void* data, std::size_t bytes, int64_t generation = -1);
+        /**
+         * @brief Get the current generation of the part of the cache where this tile belongs.
+         * The generation is incremented every time a tile is removed using remove.
+         * @param cacheID
+         * @param level
+         * @param tileID
+         * @return generation
+         */
+        int64_t getGeneration(uint64_t cacheID, int level, uint32_t tileID);
+        /**
+         * @brief Remove a single tile from the cache. Used when a tile is overwritten.
+         * @param cacheID
+         * @param level
+         * @param tileID
+         */
+        void remove(uint64_t cacheID, int level, uint32_t tileID);
+        /**
+         * @brief Remove all tiles of a given data object from the cache
+         * @param cacheID
+         */
+        void remove(uint64_t cacheID);
+        /**
+         * @brief Remove all tiles from the cache
+         */
+        void clear();
+        /**
+         * @brief Set maximum size of the cache in bytes. Default is 512 MB.
+         * @param bytes
+         */
+        void setMaximumSize(uint64_t bytes);
+        uint64_t getMaximumSize() const;
+        /**
+         * @brief Get current size of all tiles in the cache in bytes
+         * @return bytes
+         */
+        uint64_t getSize() const;
+    private:
+        TileCache();
+        struct Key {
+            uint64_t cacheID;
+            uint64_t tile; // level and tile ID
+            bool operator==(const Key& other) const {
+                return cacheID == other.cacheID && tile == other.tile;
+            }
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const {
+                // Combine the two words, similar to boost::hash_combine
+                uint64_t h = key.cacheID * 0x9E3779B97F4A7C15ull ^ (key.tile + 0x9E3779B97F4A7C15ull + (key.cacheID << 6) + (key.cacheID >> 2));
+                h ^= h >> 31;
+                return (std::size_t)h;
+            }
+        };
+        struct Entry {
+            Key key;
+            std::unique_ptr<uint8_t[]> data;
+            std::size_t bytes;
+        };
+        struct Shard {
+            std::mutex mutex;
+            // Most recently used entries are in the front
+            std::list<Entry> entries;
+            std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+            uint64_t bytes = 0;
+            int64_t generation = 0;
+        };
+        static constexpr int m_nrOfShards = 16;
+        static Key createKey(uint64_t cacheID, int level, uint32_t tileID);
+        Shard& getShard(const Key& key);
+        void evict(Shard& shard, uint64_t maxBytes);
+
+        std::array<Shard, m_nrOfShards> m_shards;
+        std::atomic<uint64_t> m_maximumSize;
+        std::shared_ptr<std::atomic<int64_t>> m_hits;
+        std::shared_ptr<std::atomic<int64_t>> m_misses;
+        std::shared_ptr<std::atomic<int64_t>> m_evictions;
+        std::shared_ptr<std::atomic<int64_t>> m_bytes;
+};
+
+}
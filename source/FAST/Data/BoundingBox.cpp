@@ -381,8 +381,8 @@ void BoundingBoxSetAccumulator::execute() {
     auto inputAccess = input->getAccess(ACCESS_READ);
 
 
-	const float offsetX = std::stoi(input->getFrameData("patchid-x")) * std::stoi(input->getFrameData("patch-width")) * std::stof(input->getFrameData("patch-spacing-x"));
-	const float offsetY = std::stoi(input->getFrameData("patchid-y")) * std::stoi(input->getFrameData("patch-height")) * std::stof(input->getFrameData("patch-spacing-y"));
+	const float offsetX = input->getFrameData<int>("patchid-x") * input->getFrameData<int>("patch-width") * input->getFrameData<float>("patch-spacing-x");
+	const float offsetY = input->getFrameData<int>("patchid-y") * input->getFrameData<int>("patch-height") * input->getFrameData<float>("patch-spacing-y");
 
 	auto coords = inputAccess->getCoordinates();
     for(int i = 0; i < coords.size(); i += 3) {
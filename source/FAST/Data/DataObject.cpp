@@ -94,18 +94,15 @@ std::set<std::string> DataObject::getLastFrame() {
 }
 
 void DataObject::setFrameData(std::string name, std::string value) {
-    m_frameData[name] = value;
+    m_frameData.set(FrameData::getKey(name), value);
 }
 
 std::string DataObject::getFrameData(std::string name) {
-    if(m_frameData.count(name) == 0)
-        throw Exception("Frame data " + name + " does not exist.");
-
-    return m_frameData[name];
+    return m_frameData.get<std::string>(FrameData::getKey(name));
 }
 
 std::map<std::string, std::string> DataObject::getFrameData() {
-    return m_frameData;
+    return m_frameData.toStringMap();
 }
 
 void DataObject::removeLastFrame(std::string streamer) {
@@ -117,21 +114,29 @@ void DataObject::clearLastFrame() {
 }
 
 bool DataObject::hasFrameData(std::string name) const {
-    return m_frameData.count(name) > 0;
+    return m_frameData.has(FrameData::getKey(name));
+}
+
+bool DataObject::hasFrameData(FrameDataKey key) const {
+    return m_frameData.has(key);
 }
 
 void DataObject::setFrameData(std::map<std::string, std::string> frameData) {
-    m_frameData = frameData;
+    m_frameData.clear();
+    for(auto&& item : frameData)
+        m_frameData.set(FrameData::getKey(item.first), item.second);
 }
 
+void DataObject::setFrameData(const FrameData& frameData) {
+    m_frameData = frameData;
+}
 
-template <>
-int DataObject::getFrameData(std::string name) {
-    return std::stoi(getFrameData(name));
+void DataObject::mergeFrameData(const FrameData& frameData) {
+    m_frameData.merge(frameData);
 }
-template <>
-float DataObject::getFrameData(std::string name) {
-    return std::stof(getFrameData(name));
+
+const FrameData& DataObject::getTypedFrameData() const {
+    return m_frameData;
 }
 
 } // end namespace fast
@@ -2,6 +2,7 @@
 
 #include "FAST/Object.hpp"
 #include "FAST/ExecutionDevice.hpp"
+#include "FAST/Data/FrameData.hpp"
 #include <map>
 #include <set>
 #include <condition_variable>
@@ -48,10 +49,40 @@ class FAST_EXPORT  DataObject : public Object {
         void setFrameData(std::string name, std::string value);
         void setFrameData(std::map<std::string, std::string> frameData);
         std::string getFrameData(std::string name);
-        template <class T>
-        T getFrameData(std::string name);
         bool hasFrameData(std::string name) const;
+        /**
+         * @brief Get all frame data as strings.
+         * This is slow, use getTypedFrameData instead when possible.
+         * @return map of name and value
+         */
         std::map<std::string, std::string> getFrameData();
+#ifndef SWIG
+        /**
+         * @brief Get frame data value as a given type, e.g. int, float or std::string
+         */
+        template <class T>
+        T getFrameData(std::string name) const;
+        template <class T>
+        T getFrameData(FrameDataKey key) const;
+        /**
+         * @brief Set a typed frame data value without converting it to a string
+         * @tparam T Arithmetic type
+         */
+        template <class T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+        void setFrameData(std::string name, T value);
+        template <class T>
+        void setFrameData(FrameDataKey key, T value);
+        bool hasFrameData(FrameDataKey key) const;
+        /**
+         * @brief Replace all frame data of this object
+         */
+        void setFrameData(const FrameData& frameData);
+        /**
+         * @brief Set all frame data in frameData on this object, keeping any other existing frame data.
+         */
+        void mergeFrameData(const FrameData& frameData);
+        const FrameData& getTypedFrameData() const;
+#endif
         void accessFinished();
     protected:
         virtual void free(ExecutionDevice::pointer device) = 0;
@@ -79,16 +110,33 @@ class FAST_EXPORT  DataObject : public Object {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::set<std::string> m_lastFrame;
 
 
 };
 
-template <>
-int DataObject::getFrameData(std::string name);
-template <>
-float DataObject::getFrameData(std::string name);
+#ifndef SWIG
+template <class T>
+T DataObject::getFrameData(std::string name) const {
+    return m_frameData.get<T>(FrameData::getKey(name));
+}
+
+template <class T>
+T DataObject::getFrameData(FrameDataKey key) const {
+    return m_frameData.get<T>(key);
+}
+
+template <class T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type>
+void DataObject::setFrameData(std::string name, T value) {
+    m_frameData.set(FrameData::getKey(name), value);
+}
+
+template <class T>
+void DataObject::setFrameData(FrameDataKey key, T value) {
+    m_frameData.set(key, value);
+}
+#endif
 
 }
@@ -1,4 +1,5 @@
 #include "DataTypes.hpp"
+#include <cstring>
 
 namespace fast {
 
@@ -13,6 +14,7 @@ std::string getCTypeAsString(DataType type) {
             {TYPE_UNORM_INT16, "ushort"},
             {TYPE_INT32, "int"},
             {TYPE_UINT32, "uint"},
+            {TYPE_FLOAT16, "half"},
     };
 
     return defines.at(type);
@@ -50,6 +52,9 @@ cl::ImageFormat getOpenCLImageFormat(OpenCLDevice::pointer device, cl_mem_object
     case TYPE_UINT32:
         channelType = CL_UNSIGNED_INT32;
         break;
+    case TYPE_FLOAT16:
+        channelType = CL_HALF_FLOAT;
+        break;
     }
 
     switch(channels) {
@@ -104,6 +109,7 @@ size_t getSizeOfDataType(DataType type, unsigned int nrOfComponents) {
         break;
     case TYPE_SNORM_INT16:
     case TYPE_UNORM_INT16:
+    case TYPE_FLOAT16:
         bytes = 2;
         break;
     }
@@ -136,6 +142,7 @@ float getDefaultIntensityLevel(DataType type) {
         level = 0;
         break;
     case TYPE_UNORM_INT16:
+    case TYPE_FLOAT16:
         level = 0.5;
         break;
     case TYPE_SNORM_INT16:
@@ -170,6 +177,7 @@ float getDefaultIntensityWindow(DataType type) {
         window = 255;
         break;
     case TYPE_UNORM_INT16:
+    case TYPE_FLOAT16:
         window = 1;
         break;
     case TYPE_SNORM_INT16:
@@ -192,6 +200,7 @@ void deleteArray(void * data, DataType type) {
             break;
         case TYPE_UINT16:
         case TYPE_UNORM_INT16:
+        case TYPE_FLOAT16:
             delete[] (ushort*)data;
             break;
         case TYPE_INT16:
@@ -205,4 +214,73 @@ void deleteArray(void * data, DataType type) {
     }
 }
 
+unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type) {
+    unique_pixel_ptr ptr;
+    switch(type) {
+        fastSwitchTypeMacro(ptr = make_unique_pixel<FAST_TYPE>(new FAST_TYPE[size]))
+        case TYPE_FLOAT16:
+            ptr = make_unique_pixel<uint16_t>(new uint16_t[size]);
+            break;
+    }
+
+    return ptr;
+}
+
+float float16ToFloat(uint16_t value) {
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t result;
+    if(exponent == 0) {
+        if(mantissa == 0) {
+            result = sign; // Zero
+        } else {
+            // Subnormal, normalize it
+            int e = -1;
+            do {
+                ++e;
+                mantissa <<= 1;
+            } while((mantissa & 0x400) == 0);
+            result = sign | ((uint32_t)(127 - 15 - e) << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if(exponent == 0x1F) {
+        result = sign | 0x7F800000 | (mantissa << 13); // Inf or NaN
+    } else {
+        result = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float output;
+    std::memcpy(&output, &result, sizeof(float));
+    return output;
+}
+
+uint16_t floatToFloat16(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    const int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if(((bits >> 23) & 0xFF) == 0xFF) // Inf or NaN
+        return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+    if(exponent >= 0x1F) // Too large, becomes inf
+        return sign | 0x7C00;
+    if(exponent <= 0) {
+        if(exponent < -10) // Too small, becomes zero
+            return sign;
+        // Subnormal
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t result = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (result & 1)))
+            ++result;
+        return sign | (uint16_t)result;
+    }
+    uint32_t result = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFF;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+        ++result; // May overflow into exponent, which gives the correct result
+    return sign | (uint16_t)result;
+}
+
 } // end namespace fast
@@ -9,6 +9,8 @@
 #include "FAST/ExecutionDevice.hpp"
 #include <iostream>
 #include <Eigen/Dense>
+#include <functional>
+#include <memory>
 
 // These have to be outside of fast namespace or it will not compile with Qt on Windows. Why?
 typedef unsigned char uchar;
@@ -45,7 +47,8 @@ enum DataType {
     TYPE_UNORM_INT16, // Unsigned normalized 16 bit integer. A 16 bit int interpreted as a float between 0 and 1.
     TYPE_SNORM_INT16, // Signed normalized 16 bit integer. A 16 bit int interpreted as a float between -1 and 1.
     TYPE_UINT32,
-    TYPE_INT32
+    TYPE_INT32,
+    TYPE_FLOAT16, // 16 bit half precision float. Stored as a 16 bit unsigned int on the host, see float16ToFloat.
 };
 
 enum PlaneType {PLANE_X, PLANE_Y, PLANE_Z};
@@ -75,6 +78,33 @@ FAST_EXPORT float getDefaultIntensityWindow(DataType type);
 
 FAST_EXPORT void deleteArray(void * data, DataType type);
 
+/**
+ * Convert a 16 bit half precision float (IEEE 754 binary16) to a 32 bit float
+ */
+FAST_EXPORT float float16ToFloat(uint16_t value);
+/**
+ * Convert a 32 bit float to a 16 bit half precision float (IEEE 754 binary16), rounding to nearest even
+ */
+FAST_EXPORT uint16_t floatToFloat16(float value);
+
+#ifndef SWIG
+using pixel_deleter_t = std::function<void(void *)>;
+using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
+template<typename T>
+auto pixel_deleter(void const * data) -> void
+{
+    T const * p = static_cast<T const*>(data);
+    //std::cout << "[" << (uint64_t)p <<  "] is being deleted." << std::endl;
+    delete[] p;
+}
+
+template<typename T>
+auto make_unique_pixel(T * ptr) -> unique_pixel_ptr {
+    return unique_pixel_ptr(ptr, &pixel_deleter<T>);
+}
+FAST_EXPORT unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
+#endif
+
 enum class PixelConnectivity {
     Closests, // in 2D: 4-connectivity, in 3D: 6-connectivity
     All, // in 2D: 8-connectivity, in 3D 26-connectivity
@@ -0,0 +1,215 @@
+#include "FrameData.hpp"
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+
+namespace fast {
+
+// Process-wide table of interned keys
+static std::shared_mutex& getKeyMutex() {
+    static std::shared_mutex mutex;
+    return mutex;
+}
+static std::unordered_map<std::string, FrameDataKey>& getKeyMap() {
+    static std::unordered_map<std::string, FrameDataKey> keys;
+    return keys;
+}
+static std::vector<std::string>& getKeyNames() {
+    static std::vector<std::string> names;
+    return names;
+}
+
+FrameDataKey FrameData::getKey(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(getKeyMutex());
+        auto it = getKeyMap().find(name);
+        if(it != getKeyMap().end())
+            return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(getKeyMutex());
+    auto it = getKeyMap().find(name);
+    if(it != getKeyMap().end()) // Another thread may have added it
+        return it->second;
+    const FrameDataKey key = getKeyNames().size();
+    getKeyNames().push_back(name);
+    getKeyMap()[name] = key;
+    return key;
+}
+
+std::string FrameData::getKeyName(FrameDataKey key) {
+    std::shared_lock<std::shared_mutex> lock(getKeyMutex());
+    if(key >= getKeyNames().size())
+        throw Exception("Unknown frame data key " + std::to_string(key));
+    return getKeyNames()[key];
+}
+
+FrameData::FrameData(const FrameData& other) {
+    *this = other;
+}
+
+FrameData& FrameData::operator=(const FrameData& other) {
+    if(this == &other)
+        return *this;
+    // Only copy entries in use
+    for(int i = 0; i < std::min(other.m_size, m_inlineSize); ++i)
+        m_inline[i] = other.m_inline[i];
+    m_overflow = other.m_overflow;
+    m_size = other.m_size;
+    return *this;
+}
+
+FrameData::Entry& FrameData::at(int index) {
+    return index < m_inlineSize ? m_inline[index] : m_overflow[index - m_inlineSize];
+}
+
+const FrameData::Entry& FrameData::at(int index) const {
+    return index < m_inlineSize ? m_inline[index] : m_overflow[index - m_inlineSize];
+}
+
+FrameData::Entry* FrameData::find(FrameDataKey key) {
+    for(int i = 0; i < m_size; ++i) {
+        if(at(i).key == key)
+            return &at(i);
+    }
+    return nullptr;
+}
+
+const FrameData::Entry* FrameData::find(FrameDataKey key) const {
+    for(int i = 0; i < m_size; ++i) {
+        if(at(i).key == key)
+            return &at(i);
+    }
+    return nullptr;
+}
+
+FrameData::Entry& FrameData::findOrAdd(FrameDataKey key) {
+    Entry* entry = find(key);
+    if(entry != nullptr)
+        return *entry;
+    if(m_size >= m_inlineSize)
+        m_overflow.emplace_back();
+    ++m_size;
+    Entry& newEntry = at(m_size-1);
+    newEntry.key = key;
+    return newEntry;
+}
+
+void FrameData::set(FrameDataKey key, const std::string& value) {
+    Entry& entry = findOrAdd(key);
+    entry.type = Type::STRING;
+    entry.string = value;
+}
+
+void FrameData::set(FrameDataKey key, const char* value) {
+    Entry& entry = findOrAdd(key);
+    entry.type = Type::STRING;
+    entry.string = value;
+}
+
+void FrameData::set(FrameDataKey key, double value) {
+    Entry& entry = findOrAdd(key);
+    entry.type = Type::FLOAT;
+    entry.floatingPoint = value;
+    entry.string.clear();
+}
+
+void FrameData::set(FrameDataKey key, int64_t value) {
+    Entry& entry = findOrAdd(key);
+    entry.type = Type::INTEGER;
+    entry.integer = value;
+    entry.string.clear();
+}
+
+bool FrameData::has(FrameDataKey key) const {
+    return find(key) != nullptr;
+}
+
+void FrameData::remove(FrameDataKey key) {
+    for(int i = 0; i < m_size; ++i) {
+        if(at(i).key == key) {
+            // Move last entry into this position
+            if(i != m_size-1)
+                at(i) = std::move(at(m_size-1));
+            if(m_size > m_inlineSize)
+                m_overflow.pop_back();
+            --m_size;
+            return;
+        }
+    }
+}
+
+void FrameData::clear() {
+    m_overflow.clear();
+    m_size = 0;
+}
+
+void FrameData::merge(const FrameData& other) {
+    for(int i = 0; i < other.m_size; ++i) {
+        const Entry& otherEntry = other.at(i);
+        Entry& entry = findOrAdd(otherEntry.key);
+        entry = otherEntry;
+    }
+}
+
+int FrameData::size() const {
+    return m_size;
+}
+
+std::map<std::string, std::string> FrameData::toStringMap() const {
+    std::map<std::string, std::string> result;
+    for(int i = 0; i < m_size; ++i)
+        result[getKeyName(at(i).key)] = getString(at(i));
+    return result;
+}
+
+std::string FrameData::getString(const Entry& entry) const {
+    switch(entry.type) {
+        case Type::INTEGER:
+            return std::to_string(entry.integer);
+        case Type::FLOAT: {
+            // Spacing of WSI patches can be very small, thus use enough digits to represent the double exactly
+            std::ostringstream stream;
+            stream.precision(std::numeric_limits<double>::max_digits10);
+            stream << entry.floatingPoint;
+            return stream.str();
+        }
+        default:
+            return entry.string;
+    }
+}
+
+double FrameData::getDouble(const Entry& entry) const {
+    switch(entry.type) {
+        case Type::INTEGER:
+            return (double)entry.integer;
+        case Type::FLOAT:
+            return entry.floatingPoint;
+        default:
+            return std::stod(entry.string);
+    }
+}
+
+int64_t FrameData::getInteger(const Entry& entry) const {
+    switch(entry.type) {
+        case Type::INTEGER:
+            return entry.integer;
+        case Type::FLOAT:
+            return (int64_t)entry.floatingPoint;
+        default:
+            // Old frame data could have integers stored as "10.000000", thus parse as double
+            return (int64_t)std::stod(entry.string);
+    }
+}
+
+template <>
+std::string FrameData::get(FrameDataKey key) const {
+    const Entry* entry = find(key);
+    if(entry == nullptr)
+        throw Exception("Frame data " + getKeyName(key) + " does not exist.");
+    return getString(*entry);
+}
+
+}
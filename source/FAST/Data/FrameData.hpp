@@ -0,0 +1,121 @@
+#pragma once
+
+#include <FAST/Exception.hpp>
+#include <array>
+#include <vector>
+#include <map>
+#include <type_traits>
+#include <cstdint>
+
+namespace fast {
+
+/**
+ * @brief Interned frame data key, see FrameData::getKey
+ */
+typedef uint32_t FrameDataKey;
+
+/**
+ * @brief Typed storage of frame data
+ *
+ * Frame data is small key-value data which follows a data object through a pipeline, such as patch IDs and
+ * offsets set by the PatchGenerator. Keys are interned strings, and values are stored as int64, double or string.
+ * The first entries are stored inline, thus setting, getting and copying frame data normally doesn't allocate memory.
+ *
+ * Values can be read as any type: numbers are converted to string and strings are parsed to numbers when needed.
+ *
+ * @sa DataObject
+ */
+class FAST_EXPORT FrameData {
+    public:
+        /**
+         * @brief Get interned key for a frame data name.
+         * For best performance, store the key instead of calling this for every frame.
+         * @param name
+         * @return key
+         */
+        static FrameDataKey getKey(const std::string& name);
+        /**
+         * @brief Get name of an interned key
+         * @param key
+         * @return name
+         */
+        static std::string getKeyName(FrameDataKey key);
+
+        FrameData() = default;
+        FrameData(const FrameData& other);
+        FrameData& operator=(const FrameData& other);
+
+        void set(FrameDataKey key, const std::string& value);
+        void set(FrameDataKey key, const char* value);
+        void set(FrameDataKey key, double value);
+        void set(FrameDataKey key, int64_t value);
+        template <class T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+        void set(FrameDataKey key, T value) { set(key, (int64_t)value); }
+        template <class T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+        void set(FrameDataKey key, T value) { set(key, (double)value); }
+        /**
+         * @brief Get value as a given type. Supported types are arithmetic types and std::string.
+         * Throws an exception if key doesn't exist.
+         */
+        template <class T>
+        T get(FrameDataKey key) const;
+        bool has(FrameDataKey key) const;
+        void remove(FrameDataKey key);
+        void clear();
+        /**
+         * @brief Set all values of other in this object. Existing values with other keys are kept.
+         * @param other
+         */
+        void merge(const FrameData& other);
+        int size() const;
+        /**
+         * @brief Convert all values to strings
+         * @return map of names and string values
+         */
+        std::map<std::string, std::string> toStringMap() const;
+    private:
+        enum class Type : uint8_t {
+            INTEGER,
+            FLOAT,
+            STRING
+        };
+        struct Entry {
+            FrameDataKey key;
+            Type type;
+            union {
+                int64_t integer;
+                double floatingPoint;
+            };
+            std::string string; // Short strings are stored inline by std::string
+        };
+        static constexpr int m_inlineSize = 16;
+        Entry* find(FrameDataKey key);
+        const Entry* find(FrameDataKey key) const;
+        Entry& findOrAdd(FrameDataKey key);
+        Entry& at(int index);
+        const Entry& at(int index) const;
+        std::string getString(const Entry& entry) const;
+        double getDouble(const Entry& entry) const;
+        int64_t getInteger(const Entry& entry) const;
+
+        std::array<Entry, m_inlineSize> m_inline;
+        std::vector<Entry> m_overflow; // Only used if there are more than m_inlineSize entries
+        int m_size = 0;
+};
+
+template <class T>
+T FrameData::get(FrameDataKey key) const {
+    const Entry* entry = find(key);
+    if(entry == nullptr)
+        throw Exception("Frame data " + getKeyName(key) + " does not exist.");
+    if(std::is_floating_point<T>::value) {
+        return (T)getDouble(*entry);
+    } else {
+        return (T)getInteger(*entry);
+    }
+}
+
+template <>
+FAST_EXPORT std::string FrameData::get(FrameDataKey key) const;
+
+}
@@ -5,6 +5,7 @@
 #include "FAST/Utility.hpp"
 #include "FAST/SceneGraph.hpp"
 #include "FAST/Config.hpp"
+#include "FAST/Data/ImageBufferPool.hpp"
 #include <eigen3/unsupported/Eigen/CXX11/Tensor>
 #ifdef FAST_MODULE_VISUALIZATION
 #include <FAST/Visualization/Window.hpp>
@@ -23,15 +24,6 @@
 
 namespace fast {
 
-unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type) {
-    unique_pixel_ptr ptr;
-    switch(type) {
-        fastSwitchTypeMacro(ptr = make_unique_pixel<FAST_TYPE>(new FAST_TYPE[size]))
-    }
-
-    return ptr;
-}
-
 // Pad data with 1, 2 or 3 channels to 4 channels with 0
 template <class T>
 void * padData(T * data, unsigned int size, unsigned int nrOfChannels) {
@@ -130,7 +122,7 @@ void Image::transferCLImageToHost(OpenCLDevice::pointer device) {
     } else {
         if(!mHostHasData) {
             // Must allocate memory for host data
-            mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels,mType);
+            mHostData = allocateHostData();
 			mHostHasData = true;
         }
         device->getCommandQueue().enqueueReadImage(*(cl::Image*)mCLImages[device],
@@ -153,8 +145,12 @@ void Image::updateOpenCLImageData(OpenCLDevice::pointer device) {
     bool updated = false;
     if (mCLImagesIsUpToDate.count(device) == 0) {
         // Data is not on device, create it
-        cl::Image * newImage;
-        if(mDimensions == 2) {
+        cl::Image * newImage = nullptr;
+        if(m_useBufferPool)
+            newImage = ImageBufferPool::getInstance()->acquireOpenCLImage(device, mWidth, mHeight, mDepth, mType, mChannels);
+        if(newImage != nullptr) {
+            // Reused from pool
+        } else if(mDimensions == 2) {
             newImage = new cl::Image2D(device->getContext(),
             CL_MEM_READ_WRITE, getOpenCLImageFormat(device, CL_MEM_OBJECT_IMAGE2D, mType,mChannels), mWidth, mHeight);
         } else {
@@ -262,8 +258,11 @@ void Image::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     if (mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
         unsigned int bufferSize = getBufferSize();
-        cl::Buffer * newBuffer = new cl::Buffer(device->getContext(),
-        CL_MEM_READ_WRITE, bufferSize);
+        cl::Buffer * newBuffer = nullptr;
+        if(m_useBufferPool)
+            newBuffer = ImageBufferPool::getInstance()->acquireOpenCLBuffer(device, bufferSize);
+        if(newBuffer == nullptr)
+            newBuffer = new cl::Buffer(device->getContext(), CL_MEM_READ_WRITE, bufferSize);
 
         if(hasAnyData()) {
             mCLBuffersIsUpToDate[device] = false;
@@ -324,7 +323,7 @@ void Image::transferCLBufferFromHost(OpenCLDevice::pointer device) {
 void Image::transferCLBufferToHost(OpenCLDevice::pointer device) {
 	if (!mHostHasData) {
 		// Must allocate memory for host data
-		mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
+		mHostData = allocateHostData();
 		mHostHasData = true;
 	}
     unsigned int bufferSize = getBufferSize();
@@ -343,7 +342,7 @@ void Image::updateHostData() {
         unsigned int size = mWidth*mHeight*mChannels;
         if(mDimensions == 3)
             size *= mDepth;
-        mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels,mType);
+        mHostData = allocateHostData();
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
         } else {
@@ -435,6 +434,17 @@ Image::Image() {
     mMaxMinInitialized = false;
     mSumInitialized = false;
     mIsInitialized = false;
+    m_useBufferPool = ImageBufferPool::isEnabledForCurrentThread();
+}
+
+unique_pixel_ptr Image::allocateHostData() {
+    const std::size_t size = (std::size_t)mWidth*mHeight*mDepth*mChannels;
+    if(m_useBufferPool) {
+        auto data = ImageBufferPool::getInstance()->acquireHostData(mType, size);
+        if(data)
+            return data;
+    }
+    return allocatePixelArray(size, mType);
 }
 
 ImageAccess::pointer Image::getImageAccess(accessType type) {
@@ -633,7 +643,7 @@ void Image::copyData(ExecutionDevice::pointer device, const void* const data) {
         throw Exception("Image must be initialized");
     // We do not own this pointer, have to copy it
     if(device->isHost()) {
-        mHostData = allocatePixelArray(mWidth*mHeight*mDepth*mChannels, mType);
+        mHostData = allocateHostData();
         std::memcpy(mHostData.get(), data, getSizeOfDataType(mType, mChannels) * mWidth * mHeight * mDepth);
         mHostHasData = true;
         mHostDataIsUpToDate = true;
@@ -701,26 +711,47 @@ bool Image::isInitialized() const {
 void Image::free(ExecutionDevice::pointer device) {
     // Delete data on a specific device
     if(device->isHost()) {
+        if(m_useBufferPool) {
+            ImageBufferPool::getInstance()->releaseHostData(std::move(mHostData), mType, (std::size_t)mWidth*mHeight*mDepth*mChannels);
+        }
         mHostData.reset();
         mHostHasData = false;
     } else {
         OpenCLDevice::pointer clDevice = std::static_pointer_cast<OpenCLDevice>(device);
         // Delete any OpenCL images
-        delete mCLImages[clDevice];
+        if(mCLImages.count(clDevice) > 0)
+            freeOpenCLImage(clDevice, mCLImages[clDevice]);
         mCLImages.erase(clDevice);
         mCLImagesIsUpToDate.erase(clDevice);
         // Delete any OpenCL buffers
-        delete mCLBuffers[clDevice];
+        if(mCLBuffers.count(clDevice) > 0)
+            freeOpenCLBuffer(clDevice, mCLBuffers[clDevice]);
         mCLBuffers.erase(clDevice);
         mCLBuffersIsUpToDate.erase(clDevice);
     }
 }
 
+void Image::freeOpenCLImage(OpenCLDevice::pointer device, cl::Image* image) {
+    if(m_useBufferPool) {
+        ImageBufferPool::getInstance()->releaseOpenCLImage(image, device, mWidth, mHeight, mDepth, mType, mChannels);
+    } else {
+        delete image;
+    }
+}
+
+void Image::freeOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer* buffer) {
+    if(m_useBufferPool) {
+        ImageBufferPool::getInstance()->releaseOpenCLBuffer(buffer, device, getBufferSize());
+    } else {
+        delete buffer;
+    }
+}
+
 void Image::freeAll() {
     // Delete OpenCL Images
     std::unordered_map<OpenCLDevice::pointer, cl::Image*>::iterator it;
     for (it = mCLImages.begin(); it != mCLImages.end(); it++) {
-        delete it->second;
+        freeOpenCLImage(it->first, it->second);
     }
     mCLImages.clear();
     mCLImagesIsUpToDate.clear();
@@ -728,7 +759,7 @@ void Image::freeAll() {
     // Delete OpenCL buffers
     std::unordered_map<OpenCLDevice::pointer, cl::Buffer*>::iterator it2;
     for (it2 = mCLBuffers.begin(); it2 != mCLBuffers.end(); it2++) {
-        delete it2->second;
+        freeOpenCLBuffer(it2->first, it2->second);
     }
     mCLBuffers.clear();
     mCLBuffersIsUpToDate.clear();
@@ -1092,6 +1123,21 @@ Image::Image(Image::pointer image) : Image() {
     updateModifiedTimestamp();
 }
 
+Image::pointer Image::create(VectorXui size, DataType type, uint nrOfChannels, unique_pixel_ptr ptr) {
+    if(!ptr)
+        throw Exception("Data pointer was null in Image::create");
+    auto image = std::shared_ptr<Image>(new Image());
+    image->setPtr(image);
+    image->init(size, type, nrOfChannels);
+    // Data is owned by someone else, thus it must never be handed to the buffer pool
+    image->m_useBufferPool = false;
+    image->mHostData = std::move(ptr);
+    image->mHostHasData = true;
+    image->mHostDataIsUpToDate = true;
+    image->updateModifiedTimestamp();
+    return image;
+}
+
 
 Image::pointer Image::copy(ExecutionDevice::pointer device) {
     Image::pointer clone = Image::createFromImage(std::static_pointer_cast<Image>(mPtr.lock()));
@@ -1180,26 +1226,9 @@ void Image::fill(float value) {
     } catch(...) {
     	// Has no data
     	// Create an OpenCL image
-    	cl::Image* clImage;
         OpenCLDevice::pointer clDevice = std::dynamic_pointer_cast<OpenCLDevice>(
                 DeviceManager::getInstance()->getDefaultDevice());
-    	if(getDimensions() == 2) {
-			clImage = new cl::Image2D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE2D, mType, mChannels),
-				mWidth, mHeight
-			);
-    	} else {
-			clImage = new cl::Image3D(
-				clDevice->getContext(),
-				CL_MEM_READ_WRITE,
-				getOpenCLImageFormat(clDevice, CL_MEM_OBJECT_IMAGE3D, mType, mChannels),
-				mWidth, mHeight, mDepth
-			);
-    	}
-		mCLImages[clDevice] = clImage;
-		mCLImagesIsUpToDate[clDevice] = true;
+        updateOpenCLImageData(clDevice);
 		device = clDevice;
 		isOpenCLImage = true;
     }
@@ -1590,6 +1619,10 @@ bool Image::isSegmentationType() const {
     return mType == TYPE_UINT8 && mChannels == 1;
 }
 
+bool Image::isHostDataUpToDate() const {
+    return mHostHasData && mHostDataIsUpToDate;
+}
+
 } // end namespace fast;
 
 
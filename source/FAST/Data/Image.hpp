@@ -12,24 +12,6 @@
 
 namespace fast {
 
-#ifndef SWIG
-using pixel_deleter_t = std::function<void(void *)>;
-using unique_pixel_ptr = std::unique_ptr<void, pixel_deleter_t>;
-template<typename T>
-auto pixel_deleter(void const * data) -> void
-{
-    T const * p = static_cast<T const*>(data);
-    //std::cout << "[" << (uint64_t)p <<  "] is being deleted." << std::endl;
-    delete[] p;
-}
-
-template<typename T>
-auto make_unique_pixel(T * ptr) -> unique_pixel_ptr {
-    return unique_pixel_ptr(ptr, &pixel_deleter<T>);
-}
-unique_pixel_ptr allocatePixelArray(std::size_t size, DataType type);
-#endif
-
 /**
  * @brief Image data
  *
@@ -232,6 +214,20 @@ class FAST_EXPORT Image : public SpatialDataObject {
          */
         template <class T>
         static Image::pointer create(VectorXui, DataType type, uint nrOfChannels, std::unique_ptr<T> ptr);
+#ifndef SWIG
+        /**
+         * Wraps existing 2D/3D host data without copying it.
+         * The deleter of the pointer is called when the image no longer needs the data. This can be used to
+         * give out views of memory owned by someone else, e.g. a memory mapped file, by letting the deleter
+         * hold a reference to the owner. The data must be writable if the image is accessed with ACCESS_READ_WRITE.
+         *
+         * @param size
+         * @param type
+         * @param nrOfChannels
+         * @param ptr
+         */
+        static Image::pointer create(VectorXui size, DataType type, uint nrOfChannels, unique_pixel_ptr ptr);
+#endif
 
         OpenCLImageAccess::pointer getOpenCLImageAccess(accessType type, OpenCLDevice::pointer);
         OpenCLBufferAccess::pointer getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
@@ -283,6 +279,13 @@ class FAST_EXPORT Image : public SpatialDataObject {
          */
         bool isSegmentationType() const;
 
+        /**
+         * Checks whether the image data is up to date on the host (CPU) memory.
+         * This can be used to choose between a CPU and GPU implementation to avoid unnecessary data transfers.
+         * @return true if host data is up to date
+         */
+        bool isHostDataUpToDate() const;
+
         // Override
         DataBoundingBox getTransformedBoundingBox() const override;
         DataBoundingBox getBoundingBox() const override;
@@ -328,6 +331,12 @@ class FAST_EXPORT Image : public SpatialDataObject {
         bool mHostHasData;
         bool mHostDataIsUpToDate;
 
+        // Whether backing stores are taken from and returned to the ImageBufferPool
+        bool m_useBufferPool = false;
+        unique_pixel_ptr allocateHostData();
+        void freeOpenCLImage(OpenCLDevice::pointer device, cl::Image* image);
+        void freeOpenCLBuffer(OpenCLDevice::pointer device, cl::Buffer* buffer);
+
         // OpenGL data
         uint m_GLtextureID = 0;
         bool m_GLtextureUpToDate = false;
@@ -0,0 +1,163 @@
+#include "ImageBufferPool.hpp"
+
+namespace fast {
+
+static thread_local bool poolingEnabled = false;
+
+ImageBufferPool::Scope::Scope(bool enabled) {
+    m_previous = poolingEnabled;
+    poolingEnabled = enabled;
+}
+
+ImageBufferPool::Scope::~Scope() {
+    poolingEnabled = m_previous;
+}
+
+bool ImageBufferPool::isEnabledForCurrentThread() {
+    return poolingEnabled;
+}
+
+std::shared_ptr<ImageBufferPool> ImageBufferPool::getInstance() {
+    static std::shared_ptr<ImageBufferPool> instance(new ImageBufferPool());
+    return instance;
+}
+
+ImageBufferPool::ImageBufferPool() {
+    m_maximumSize = 256ull*1024ull*1024ull;
+    m_hits = mRuntimeManager->getCounter("image pool hits");
+    m_allocations = mRuntimeManager->getCounter("image pool allocations");
+    m_allocatedBytes = mRuntimeManager->getCounter("image pool allocated bytes");
+    m_bytes = mRuntimeManager->getCounter("image pool bytes");
+}
+
+bool ImageBufferPool::acquire(const Key& key, std::size_t bytes, Entry& result) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if(it->key == key) {
+                result = std::move(*it);
+                m_size -= it->bytes;
+                *m_bytes -= it->bytes;
+                m_entries.erase(it);
+                ++(*m_hits);
+                return true;
+            }
+        }
+    }
+    // Caller has to allocate
+    ++(*m_allocations);
+    *m_allocatedBytes += bytes;
+    return false;
+}
+
+void ImageBufferPool::release(Entry entry) {
+    if(entry.bytes > m_maximumSize) {
+        destroy(entry);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_size += entry.bytes;
+    *m_bytes += entry.bytes;
+    m_entries.push_front(std::move(entry));
+    evict(m_maximumSize);
+}
+
+void ImageBufferPool::evict(uint64_t maxBytes) {
+    // Mutex must be locked by caller
+    while(m_size > maxBytes && !m_entries.empty()) {
+        Entry& entry = m_entries.back();
+        m_size -= entry.bytes;
+        *m_bytes -= entry.bytes;
+        destroy(entry);
+        m_entries.pop_back();
+    }
+}
+
+void ImageBufferPool::destroy(Entry& entry) {
+    entry.hostData.reset();
+    delete entry.image;
+    entry.image = nullptr;
+    delete entry.buffer;
+    entry.buffer = nullptr;
+}
+
+unique_pixel_ptr ImageBufferPool::acquireHostData(DataType type, std::size_t size) {
+    Entry entry;
+    if(!acquire({Kind::Host, nullptr, (uint)size, 1, 1, type, 1}, size*getSizeOfDataType(type, 1), entry))
+        return nullptr;
+    return std::move(entry.hostData);
+}
+
+void ImageBufferPool::releaseHostData(unique_pixel_ptr data, DataType type, std::size_t size) {
+    if(!data)
+        return;
+    Entry entry;
+    entry.key = {Kind::Host, nullptr, (uint)size, 1, 1, type, 1};
+    entry.bytes = size*getSizeOfDataType(type, 1);
+    entry.hostData = std::move(data);
+    release(std::move(entry));
+}
+
+// OpenCL images with 3 channels are stored with 4 channels
+static std::size_t getOpenCLImageSize(uint width, uint height, uint depth, DataType type, uint nrOfChannels) {
+    return (std::size_t)width*height*depth*getSizeOfDataType(type, nrOfChannels == 3 ? 4 : nrOfChannels);
+}
+
+cl::Image* ImageBufferPool::acquireOpenCLImage(OpenCLDevice::pointer device, uint width, uint height, uint depth, DataType type, uint nrOfChannels) {
+    Entry entry;
+    if(!acquire({Kind::OpenCLImage, device, width, height, depth, type, nrOfChannels}, getOpenCLImageSize(width, height, depth, type, nrOfChannels), entry))
+        return nullptr;
+    return entry.image;
+}
+
+void ImageBufferPool::releaseOpenCLImage(cl::Image* image, OpenCLDevice::pointer device, uint width, uint height, uint depth, DataType type, uint nrOfChannels) {
+    if(image == nullptr)
+        return;
+    Entry entry;
+    entry.key = {Kind::OpenCLImage, device, width, height, depth, type, nrOfChannels};
+    entry.bytes = getOpenCLImageSize(width, height, depth, type, nrOfChannels);
+    entry.image = image;
+    release(std::move(entry));
+}
+
+cl::Buffer* ImageBufferPool::acquireOpenCLBuffer(OpenCLDevice::pointer device, std::size_t bytes) {
+    Entry entry;
+    if(!acquire({Kind::OpenCLBuffer, device, (uint)bytes, 1, 1, TYPE_UINT8, 1}, bytes, entry))
+        return nullptr;
+    return entry.buffer;
+}
+
+void ImageBufferPool::releaseOpenCLBuffer(cl::Buffer* buffer, OpenCLDevice::pointer device, std::size_t bytes) {
+    if(buffer == nullptr)
+        return;
+    Entry entry;
+    entry.key = {Kind::OpenCLBuffer, device, (uint)bytes, 1, 1, TYPE_UINT8, 1};
+    entry.bytes = bytes;
+    entry.buffer = buffer;
+    release(std::move(entry));
+}
+
+void ImageBufferPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict(0);
+}
+
+void ImageBufferPool::setMaximumSize(uint64_t bytes) {
+    m_maximumSize = bytes;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict(bytes);
+}
+
+uint64_t ImageBufferPool::getMaximumSize() const {
+    return m_maximumSize;
+}
+
+uint64_t ImageBufferPool::getSize() const {
+    return (uint64_t)m_bytes->load();
+}
+
+ImageBufferPool::~ImageBufferPool() {
+    clear();
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/DataTypes.hpp>
+#include <FAST/ExecutionDevice.hpp>
+#include <mutex>
+#include <list>
+#include <atomic>
+
+namespace fast {
+
+/**
+ * @brief Process-wide pool of image backing stores
+ *
+ * Streaming process objects usually create a new output image for every frame, which means that host memory
+ * and OpenCL images/buffers are allocated and freed at frame rate. When pooling is enabled for a process object,
+ * see ProcessObject::setImageBufferPooling, images created while it executes don't free their host data,
+ * OpenCL images and OpenCL buffers when they are destroyed. Instead these are put in this pool, and reused by the next
+ * image with the same size, data type, nr of channels and device.
+ * Reused memory is not cleared, just as newly allocated memory.
+ *
+ * Idle memory in the pool is limited by a byte budget, and the least recently released memory is freed first.
+ *
+ * Counters are available through getRuntimeManager()->getCounterValue() with the names
+ * "image pool hits", "image pool allocations", "image pool allocated bytes" (total bytes allocated by images using the pool)
+ * and "image pool bytes" (idle bytes currently in the pool).
+ *
+ * @sa Image ProcessObject::setImageBufferPooling
+ */
+class FAST_EXPORT ImageBufferPool : public Object {
+    public:
+        typedef std::shared_ptr<ImageBufferPool> pointer;
+        static std::shared_ptr<ImageBufferPool> getInstance();
+        /**
+         * @brief Enables pooling for images created by the current thread while this object exists
+         */
+        class FAST_EXPORT Scope {
+            public:
+                explicit Scope(bool enabled);
+                ~Scope();
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+            private:
+                bool m_previous;
+        };
+        /**
+         * @brief Whether images created by the current thread should use the pool
+         * @return
+         */
+        static bool isEnabledForCurrentThread();
+#ifndef SWIG
+        /**
+         * @brief Get host data from the pool
+         * @param type
+         * @param size Nr of elements
+         * @return data, or nullptr if no data of this size and type is available. Allocation should then be done by caller.
+         */
+        unique_pixel_ptr acquireHostData(DataType type, std::size_t size);
+        void releaseHostData(unique_pixel_ptr data, DataType type, std::size_t size);
+        /**
+         * @brief Get an OpenCL image from the pool
+         * @param device
+         * @param width
+         * @param height
+         * @param depth 1 for 2D images
+         * @param type
+         * @param nrOfChannels
+         * @return image, or nullptr if no image is available. Allocation should then be done by caller.
+         */
+        cl::Image* acquireOpenCLImage(OpenCLDevice::pointer device, uint width, uint height, uint depth, DataType type, uint nrOfChannels);
+        void releaseOpenCLImage(cl::Image* image, OpenCLDevice::pointer device, uint width, uint height, uint depth, DataType type, uint nrOfChannels);
+        /**
+         * @brief Get an OpenCL buffer from the pool
+         * @param device
+         * @param bytes
+         * @return buffer, or nullptr if no buffer of this size is available. Allocation should then be done by caller.
+         */
+        cl::Buffer* acquireOpenCLBuffer(OpenCLDevice::pointer device, std::size_t bytes);
+        void releaseOpenCLBuffer(cl::Buffer* buffer, OpenCLDevice::pointer device, std::size_t bytes);
+#endif
+        /**
+         * @brief Free all memory in the pool
+         */
+        void clear();
+        /**
+         * @brief Set maximum size of idle memory in the pool in bytes. Default is 256 MB.
+         * @param bytes
+         */
+        void setMaximumSize(uint64_t bytes);
+        uint64_t getMaximumSize() const;
+        /**
+         * @brief Get current size of idle memory in the pool in bytes
+         * @return bytes
+         */
+        uint64_t getSize() const;
+        ~ImageBufferPool() override;
+    private:
+        ImageBufferPool();
+        enum class Kind {
+            Host,
+            OpenCLImage,
+            OpenCLBuffer
+        };
+        struct Key {
+            Kind kind;
+            OpenCLDevice::pointer device; // nullptr for host data
+            uint width;
+            uint height;
+            uint depth;
+            DataType type;
+            uint nrOfChannels;
+            bool operator==(const Key& other) const {
+                return kind == other.kind && device == other.device && width == other.width && height == other.height &&
+                    depth == other.depth && type == other.type && nrOfChannels == other.nrOfChannels;
+            }
+        };
+        struct Entry {
+            Key key;
+            std::size_t bytes;
+            unique_pixel_ptr hostData;
+            cl::Image* image = nullptr;
+            cl::Buffer* buffer = nullptr;
+        };
+        bool acquire(const Key& key, std::size_t bytes, Entry& entry);
+        void release(Entry entry);
+        void evict(uint64_t maxBytes);
+        static void destroy(Entry& entry);
+
+        std::mutex m_mutex;
+        // Most recently released entries are in the front
+        std::list<Entry> m_entries;
+        uint64_t m_size = 0;
+        std::atomic<uint64_t> m_maximumSize;
+        std::shared_ptr<std::atomic<int64_t>> m_hits;
+        std::shared_ptr<std::atomic<int64_t>> m_allocations;
+        std::shared_ptr<std::atomic<int64_t>> m_allocatedBytes;
+        std::shared_ptr<std::atomic<int64_t>> m_bytes;
+};
+
+}
@@ -8,6 +8,8 @@
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Image.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
+#include <FAST/Data/Access/TIFFTileWriter.hpp>
+#include <FAST/Data/Access/TIFFHandlePool.hpp>
 #include <utility>
 #ifdef WIN32
 #include <winbase.h>
@@ -38,6 +40,7 @@ ImagePyramid::ImagePyramid(int width, int height, int channels, int patchWidth,
     int currentWidth = width;
     int currentHeight = height;
     m_channels = channels;
+    m_downsampling = channels >= 3 ? PyramidDownsampling::AVERAGE : PyramidDownsampling::MAJORITY;
     m_tempFile = true;
 
     do {
@@ -267,6 +270,11 @@ void ImagePyramid::free(ExecutionDevice::pointer device) {
 }
 
 void ImagePyramid::freeAll() {
+    // Write all pending tiles before closing the TIFF
+    flushTileWriter();
+    m_tileWriter.reset();
+    m_tiffHandlePool.reset();
+    TileCache::getInstance()->remove(m_tileCacheID);
     m_levels.clear();
     if(m_fileHandle != nullptr) {
         openslide_close(m_fileHandle);
@@ -311,7 +319,23 @@ ImagePyramidAccess::pointer ImagePyramid::getAccess(accessType type, bool useTil
         std::unique_lock<std::mutex> lock(mDataIsBeingAccessedMutex);
         mDataIsBeingAccessed = true;
     }
-    auto access =  std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat, useTileCache, tileCacheSize);
+    if(type == ACCESS_READ_WRITE && !m_tileWriter && m_tempFile && m_tileCompressionThreads != 0 &&
+        (m_compressionFormat == ImageCompression::JPEG || m_compressionFormat == ImageCompression::JPEGXL)) {
+        m_tileWriter = std::make_shared<TIFFTileWriter>(m_tiffHandle, m_readMutex, m_compressionFormat, m_compressionQuality, m_tileCompressionThreads);
+    }
+    if(m_tiffHandle != nullptr && !m_tempFile) {
+        if(type == ACCESS_READ_WRITE) {
+            // The pool is only used for TIFFs which are not written to.
+            // No other accesses exist at this point, so it is safe to close the pool
+            m_tiffHandlePool.reset();
+            m_tiffWrittenTo = true;
+        } else if(!m_tiffWrittenTo && m_tiffReadHandles != 0) {
+            std::lock_guard<std::mutex> lock(m_readMutex);
+            if(!m_tiffHandlePool)
+                m_tiffHandlePool = std::make_shared<TIFFHandlePool>(m_tiffPath, m_tiffReadHandles);
+        }
+    }
+    auto access =  std::make_unique<ImagePyramidAccess>(m_levels, m_fileHandle, m_tiffHandle, std::static_pointer_cast<ImagePyramid>(mPtr.lock()), type == ACCESS_READ_WRITE, m_initializedPatchList, m_readMutex, m_compressionFormat, useTileCache, m_tileCacheID, m_tileWriter, m_tiffHandlePool);
     if(m_JPEGTablesCount > 0)
         access->setJPEGTables(m_JPEGTablesCount, m_JPEGTablesData);
     return access;
@@ -340,12 +364,41 @@ void ImagePyramid::clearDirtyPatches(std::set<std::string> patches) {
 		m_dirtyPatches.erase(patch);
 }
 
+void ImagePyramid::setOutdatedTile(int level, int tileX, int tileY) {
+    if(level <= 0 || level >= getNrOfLevels())
+        throw Exception("Invalid level " + std::to_string(level) + " given to ImagePyramid::setOutdatedTile");
+    std::lock_guard<std::mutex> lock(m_outdatedTilesMutex);
+    if(m_outdatedTiles.size() != m_levels.size())
+        m_outdatedTiles.resize(m_levels.size());
+    m_outdatedTiles[level].insert({tileX, tileY});
+}
+
+std::vector<std::pair<int, int>> ImagePyramid::takeOutdatedTiles(int level) {
+    std::lock_guard<std::mutex> lock(m_outdatedTilesMutex);
+    if(level >= m_outdatedTiles.size())
+        return {};
+    std::vector<std::pair<int, int>> tiles(m_outdatedTiles[level].begin(), m_outdatedTiles[level].end());
+    m_outdatedTiles[level].clear();
+    return tiles;
+}
+
+bool ImagePyramid::hasOutdatedTiles() {
+    std::lock_guard<std::mutex> lock(m_outdatedTilesMutex);
+    for(auto&& tiles : m_outdatedTiles) {
+        if(!tiles.empty())
+            return true;
+    }
+    return false;
+}
+
 void ImagePyramid::setSpacing(Vector3f spacing) {
 	m_spacing = spacing;
     if(m_tiffHandle != nullptr) {
         // Write spacing to TIFF file
 		if(spacing.x() != 1 && spacing.y() != 1) { // Spacing == 1 means not set.
             auto access = getAccess(ACCESS_READ_WRITE); // Ensure we have exclusive access to TIFF
+            flush();
+            std::lock_guard<std::mutex> lock(m_readMutex);
             for(int level = 0; level < getNrOfLevels(); ++level) {
                 TIFFSetDirectory(m_tiffHandle, level);
                 TIFFSetField(m_tiffHandle, TIFFTAG_RESOLUTIONUNIT, RESUNIT_CENTIMETER);
@@ -370,8 +423,10 @@ ImagePyramid::ImagePyramid(TIFF *fileHandle, std::vector<ImagePyramidLevel> leve
     if(channels <= 0 || channels > 4)
         throw Exception("Nr of channels must be between 1 and 4 in ImagePyramid when importing from TIFF");
     m_tiffHandle = fileHandle;
+    m_tiffPath = TIFFFileName(fileHandle);
     m_levels = levels;
     m_channels = channels;
+    m_downsampling = channels >= 3 ? PyramidDownsampling::AVERAGE : PyramidDownsampling::MAJORITY;
     for(int i = 0; i < m_levels.size(); ++i) {
         m_levels[i].tilesX = std::ceil((float)m_levels[i].width / m_levels[i].tileWidth);
         m_levels[i].tilesY = std::ceil((float)m_levels[i].height / m_levels[i].tileHeight);
@@ -584,6 +639,14 @@ int ImagePyramid::getCompressionQuality() const {
     return m_compressionQuality;
 }
 
+void ImagePyramid::setDownsampling(PyramidDownsampling method) {
+    m_downsampling = method;
+}
+
+PyramidDownsampling ImagePyramid::getDownsampling() const {
+    return m_downsampling;
+}
+
 float ImagePyramid::getMagnification(bool estimateFromSpacingIfUnknown) const {
     if(m_magnification <= 0) {
         // Try to guess magnification from spacing if available
@@ -665,4 +728,45 @@ std::pair<int, float> ImagePyramid::getClosestLevelForMagnification(float magnif
     return {level, resampleFactor};
 }
 
+void ImagePyramid::setTileCompressionThreads(int threads) {
+    if(threads == m_tileCompressionThreads)
+        return;
+    // Finish current writes before changing the pool. Existing accesses keep using the old writer until they are destroyed
+    flushTileWriter();
+    m_tileWriter.reset();
+    m_tileCompressionThreads = threads;
+}
+
+int ImagePyramid::getTileCompressionThreads() const {
+    return m_tileCompressionThreads;
+}
+
+void ImagePyramid::setTIFFReadHandles(int handles) {
+    if(handles == m_tiffReadHandles)
+        return;
+    // Existing accesses keep using the old pool until they are destroyed
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    m_tiffHandlePool.reset();
+    m_tiffReadHandles = handles;
+}
+
+int ImagePyramid::getTIFFReadHandles() const {
+    return m_tiffReadHandles;
+}
+
+void ImagePyramid::flushTileWriter() {
+    if(!m_tileWriter)
+        return;
+    try {
+        m_tileWriter->flush();
+    } catch(std::exception &e) {
+        reportError() << "Tiles were lost when flushing TIFF tile writer: " << e.what() << reportEnd();
+    }
+}
+
+void ImagePyramid::flush() {
+    if(m_tileWriter)
+        m_tileWriter->flush();
+}
+
 }
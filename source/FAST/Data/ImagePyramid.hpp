@@ -3,6 +3,8 @@
 #include <FAST/Data/SpatialDataObject.hpp>
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/Access/ImagePyramidAccess.hpp>
+#include <FAST/Data/Access/TileCache.hpp>
+#include <FAST/Data/Access/ImagePyramidDownsampling.hpp>
 #include <set>
 
 
@@ -80,12 +82,47 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::string getTIFFPath() const;
         void setSpacing(Vector3f spacing);
         Vector3f getSpacing() const;
+        /**
+         * @brief Get access to the image pyramid
+         * @param type Access type
+         * @param useTileCache Whether to use the process-wide TileCache for decoded tiles. Only used for the TIFF backend.
+         * @param tileCacheSize Deprecated and ignored. The tile cache size is set using TileCache::setMaximumSize
+         * @return access object
+         */
         ImagePyramidAccess::pointer getAccess(accessType type, bool useTileCache = false, int tileCacheSize = -1);
         std::unordered_set<std::string> getDirtyPatches();
         bool isDirtyPatch(const std::string& tileID);
         bool isOMETIFF() const;
         void setDirtyPatch(int level, int patchIdX, int patchIdY);
         void clearDirtyPatches(std::set<std::string> patches);
+        /**
+         * @brief Mark a tile as outdated, meaning it has to be regenerated from the level below.
+         * Outdated tiles are regenerated by ImagePyramidAccess::updatePyramidLevels.
+         * @param level Level of tile, must be > 0
+         * @param tileX Tile x index
+         * @param tileY Tile y index
+         */
+        void setOutdatedTile(int level, int tileX, int tileY);
+        /**
+         * @brief Get and clear the list of outdated tiles of a level
+         * @param level
+         * @return tile x and y indices
+         */
+        std::vector<std::pair<int, int>> takeOutdatedTiles(int level);
+        /**
+         * @brief Whether any levels have outdated tiles
+         */
+        bool hasOutdatedTiles();
+        /**
+         * @brief Set how 2x2 pixels are reduced when generating the lower resolution levels of the pyramid
+         *
+         * Default is PyramidDownsampling::AVERAGE for color images and PyramidDownsampling::MAJORITY for
+         * single channel images, such as segmentations.
+         *
+         * @param method
+         */
+        void setDownsampling(PyramidDownsampling method);
+        PyramidDownsampling getDownsampling() const;
         void free(ExecutionDevice::pointer device) override;
         void freeAll() override;
         ~ImagePyramid();
@@ -103,10 +140,39 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         DataType getDataType() const;
         float getMagnification(bool estimateFromSpacingIfUnknown = false) const;
         void setMagnification(float magnification);
+        /**
+         * @brief Set nr of threads to use for compressing tiles written to this pyramid
+         *
+         * When writing to a JPEG or JPEG XL compressed image pyramid created by FAST, tiles are compressed
+         * on a pool of worker threads, and only the actual TIFF write is serialized.
+         * Disabled by default, since each pyramid written to gets its own pool of threads.
+         *
+         * @param threads Nr of threads. 0 disables asynchronous compression, -1 uses the nr of cores available.
+         */
+        void setTileCompressionThreads(int threads);
+        int getTileCompressionThreads() const;
+        /**
+         * @brief Set max nr of TIFF handles to use for reading tiles in parallel
+         *
+         * When reading from a TIFF image pyramid which is not written to, each thread reading tiles gets its own TIFF handle
+         * from a pool, and tiles are decoded without holding any lock.
+         * Should be set before getAccess is called.
+         *
+         * @param handles Max nr of handles. 0 disables parallel reading, -1 uses the nr of cores available.
+         */
+        void setTIFFReadHandles(int handles);
+        int getTIFFReadHandles() const;
+        /**
+         * @brief Block until all asynchronously compressed tiles have been written to the TIFF file.
+         * Throws an exception if a tile could not be compressed, as the tile was then not written.
+         */
+        void flush();
     private:
         ImagePyramid();
         std::vector<ImagePyramidLevel> m_levels;
         ImagePyramidLevel getLevelInfo(int level);
+        // Write pending tiles, and report any tiles which failed instead of throwing
+        void flushTileWriter();
 
         openslide_t* m_fileHandle = nullptr;
         TIFF* m_tiffHandle = nullptr;
@@ -115,6 +181,7 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::string m_tiffPath;
 
         int m_channels;
+        PyramidDownsampling m_downsampling = PyramidDownsampling::AVERAGE;
         DataType m_dataType = TYPE_UINT8;
         bool m_initialized;
         /**
@@ -125,6 +192,8 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
         std::unordered_set<std::string> m_dirtyPatches;
         static int m_counter;
         std::mutex m_dirtyPatchMutex;
+        std::vector<std::set<std::pair<int, int>>> m_outdatedTiles; // Per level
+        std::mutex m_outdatedTilesMutex;
         Vector3f m_spacing = Vector3f::Ones();
         std::unordered_set<std::string> m_initializedPatchList; // Keep a list of initialized patches, for tiff backend
 
@@ -142,6 +211,16 @@ class FAST_EXPORT ImagePyramid : public SpatialDataObject {
 
         uint32_t m_JPEGTablesCount = 0;
         void* m_JPEGTablesData = nullptr;
+
+        int m_tileCompressionThreads = 0;
+        // Shared with accesses, so that the writer outlives accesses created before it is replaced
+        std::shared_ptr<TIFFTileWriter> m_tileWriter;
+        int m_tiffReadHandles = -1;
+        bool m_tiffWrittenTo = false;
+        // Shared with accesses, so that the pool outlives accesses created before it is replaced
+        std::shared_ptr<TIFFHandlePool> m_tiffHandlePool;
+        // Identifies tiles of this pyramid in the process-wide TileCache
+        const uint64_t m_tileCacheID = TileCache::createCacheID();
 };
 
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace fast {
+
+/**
+ * @brief On-disk layout of FAST sequence files (.fastseq)
+ *
+ * A sequence file stores a stream of images in a single file:
+ * - FileHeader at offset 0
+ * - One FrameHeader per frame, directly followed by the pixel data of the frame.
+ *   Each FrameHeader starts at a multiple of alignment, and the size of FrameHeader is a multiple of alignment,
+ *   thus uncompressed pixel data can be used directly from a memory mapped file.
+ * - An index with one IndexEntry per frame, at FileHeader::indexOffset.
+ *
+ * The index and frame count are written when the file is closed. If indexOffset is 0, the file was not closed
+ * properly, and readers can find the frames by following FrameHeader::storedSize from the first frame.
+ *
+ * All values are stored little endian.
+ *
+ * @sa SequenceFileWriter
+ */
+namespace SequenceFile {
+
+constexpr char magic[8] = {'F', 'A', 'S', 'T', 'S', 'E', 'Q', '1'};
+constexpr uint32_t version = 1;
+constexpr uint32_t frameMagic = 0x454D5246; // FRME
+constexpr uint64_t alignment = 64;
+
+enum class Compression : uint32_t {
+    None = 0,
+    Zlib = 1,
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t frameCount;
+    uint64_t indexOffset;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(FileHeader) == alignment, "Sequence file header must be 64 bytes");
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t compression; // Compression
+    uint32_t dataType; // DataType
+    uint32_t nrOfChannels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t dimensions;
+    float spacing[3];
+    float transform[16]; // Column major 4x4 matrix
+    uint32_t reserved0;
+    uint64_t timestamp; // Creation timestamp of the data object
+    uint64_t rawSize; // Size of pixel data in bytes, when uncompressed
+    uint64_t storedSize; // Size of pixel data in bytes in the file, including padding to alignment
+    uint64_t dataSize; // Size of stored pixel data in bytes, excluding padding
+    uint8_t reserved[48];
+};
+static_assert(sizeof(FrameHeader) == 3*alignment, "Sequence frame header size must be a multiple of alignment");
+
+struct IndexEntry {
+    uint64_t offset; // Offset of FrameHeader
+    uint64_t timestamp;
+};
+
+/**
+ * Round size up to a multiple of alignment
+ */
+inline uint64_t align(uint64_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline bool hasValidMagic(const FileHeader& header) {
+    return std::memcmp(header.magic, magic, sizeof(magic)) == 0;
+}
+
+}
+
+}
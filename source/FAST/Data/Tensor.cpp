@@ -1,16 +1,22 @@
 #include "Tensor.hpp"
 #include <FAST/Utility.hpp>
 #include <FAST/Data/Access/OpenCLBufferAccess.hpp>
+#include <limits>
+#include <cmath>
+#include <cstring>
 
 namespace fast {
 
-void Tensor::init(std::unique_ptr<float[]> data, TensorShape shape) {
+void Tensor::init(unique_pixel_ptr data, TensorShape shape, DataType type) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("Shape can't have unknown dimensions");
+    if(type != TYPE_FLOAT && type != TYPE_FLOAT16 && type != TYPE_UINT8 && type != TYPE_INT8 && type != TYPE_INT32)
+        throw Exception("Unsupported tensor data type " + getCTypeAsString(type));
     m_data = std::move(data);
     m_shape = shape;
+    m_dataType = type;
     m_spacing = VectorXf::Ones(shape.getDimensions());
     mHostDataIsUpToDate = true;
     if(m_shape.getDimensions() >= 3) {
@@ -21,27 +27,32 @@ void Tensor::init(std::unique_ptr<float[]> data, TensorShape shape) {
 }
 
 Tensor::Tensor(std::unique_ptr<float[]> data, TensorShape shape) {
-    init(std::move(data), shape);
+    init(make_unique_pixel<float>(data.release()), shape);
 }
 
-Tensor::Tensor(const float* const data, TensorShape shape) {
+Tensor::Tensor(unique_pixel_ptr data, TensorShape shape, DataType type) {
+    init(std::move(data), shape, type);
+}
+
+Tensor::Tensor(const float* const data, TensorShape shape) : Tensor((const void*)data, shape, TYPE_FLOAT) {
+}
+
+Tensor::Tensor(const void* const data, TensorShape shape, DataType type) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    auto newData = make_uninitialized_unique<float[]>(shape.getTotalSize());
-    std::memcpy(newData.get(), data, shape.getTotalSize()*sizeof(float));
-    init(std::move(newData), shape);
+    auto newData = allocatePixelArray(shape.getTotalSize(), type);
+    std::memcpy(newData.get(), data, getSizeOfDataType(type, shape.getTotalSize()));
+    init(std::move(newData), shape, type);
 }
 
-
-Tensor::Tensor(TensorShape shape) {
+Tensor::Tensor(TensorShape shape, DataType type) {
     if(shape.empty())
         throw Exception("Shape can't be empty");
     if(shape.getUnknownDimensions() > 0)
         throw Exception("When creating a tensor, shape must be fully defined");
-    auto newData = make_uninitialized_unique<float[]>(shape.getTotalSize());
-    init(std::move(newData), shape);
+    init(allocatePixelArray(shape.getTotalSize(), type), shape, type);
 }
 
 Tensor::Tensor(std::initializer_list<float> data) {
@@ -55,7 +66,7 @@ Tensor::Tensor(std::initializer_list<float> data) {
 		++i;
 	}
     auto shape = TensorShape({(int)data.size()});
-    init(std::move(newData), shape);
+    init(make_unique_pixel<float>(newData.release()), shape);
 }
 
 void Tensor::expandDims(int position) {
@@ -71,6 +82,97 @@ TensorShape Tensor::getShape() const {
     return m_shape;
 }
 
+DataType Tensor::getDataType() const {
+    return m_dataType;
+}
+
+std::size_t Tensor::getBufferSize() const {
+    return getSizeOfDataType(m_dataType, m_shape.getTotalSize());
+}
+
+template <class T>
+static T clampAndRound(float value) {
+    // Clamp in double, as float can't represent the max value of 32 bit integers
+    return (T)std::round(std::min(std::max((double)value, (double)std::numeric_limits<T>::min()), (double)std::numeric_limits<T>::max()));
+}
+
+template <class T>
+static void convertFromFloat(const float* input, T* output, std::size_t size) {
+    for(std::size_t i = 0; i < size; ++i)
+        output[i] = clampAndRound<T>(input[i]);
+}
+
+template <>
+void convertFromFloat(const float* input, float* output, std::size_t size) {
+    std::memcpy(output, input, size*sizeof(float));
+}
+
+template <class T>
+static void convertToFloat(const T* input, float* output, std::size_t size) {
+    for(std::size_t i = 0; i < size; ++i)
+        output[i] = (float)input[i];
+}
+
+std::shared_ptr<Tensor> Tensor::convertToType(DataType type) {
+    if(type == m_dataType)
+        return std::static_pointer_cast<Tensor>(mPtr.lock());
+    const std::size_t size = m_shape.getTotalSize();
+    auto access = getAccess(ACCESS_READ);
+    const void* input = access->get();
+
+    // Convert via float
+    std::unique_ptr<float[]> floatData;
+    const float* floatInput;
+    if(m_dataType == TYPE_FLOAT) {
+        floatInput = (const float*)input;
+    } else {
+        floatData = make_uninitialized_unique<float[]>(size);
+        switch(m_dataType) {
+            case TYPE_FLOAT16:
+                for(std::size_t i = 0; i < size; ++i)
+                    floatData[i] = float16ToFloat(((const uint16_t*)input)[i]);
+                break;
+            case TYPE_UINT8:
+                convertToFloat((const uchar*)input, floatData.get(), size);
+                break;
+            case TYPE_INT8:
+                convertToFloat((const char*)input, floatData.get(), size);
+                break;
+            case TYPE_INT32:
+                convertToFloat((const int*)input, floatData.get(), size);
+                break;
+            default:
+                throw NotImplementedException();
+        }
+        floatInput = floatData.get();
+    }
+
+    auto newData = allocatePixelArray(size, type);
+    switch(type) {
+        case TYPE_FLOAT:
+            convertFromFloat(floatInput, (float*)newData.get(), size);
+            break;
+        case TYPE_FLOAT16:
+            for(std::size_t i = 0; i < size; ++i)
+                ((uint16_t*)newData.get())[i] = floatToFloat16(floatInput[i]);
+            break;
+        case TYPE_UINT8:
+            convertFromFloat(floatInput, (uchar*)newData.get(), size);
+            break;
+        case TYPE_INT8:
+            convertFromFloat(floatInput, (char*)newData.get(), size);
+            break;
+        case TYPE_INT32:
+            convertFromFloat(floatInput, (int*)newData.get(), size);
+            break;
+        default:
+            throw Exception("Unsupported tensor data type " + getCTypeAsString(type));
+    }
+    auto tensor = Tensor::create(std::move(newData), m_shape, type);
+    tensor->setSpacing(m_spacing);
+    return tensor;
+}
+
 TensorAccess::pointer Tensor::getAccess(accessType type) {
     if(!isInitialized())
         throw Exception("Tensor has not been initialized.");
@@ -92,7 +194,7 @@ TensorAccess::pointer Tensor::getAccess(accessType type) {
         std::unique_lock<std::mutex> lock(mDataIsBeingAccessedMutex);
         mDataIsBeingAccessed = true;
     }
-    return std::make_unique<TensorAccess>(getHostDataPointer(), m_shape, std::static_pointer_cast<Tensor>(mPtr.lock()));
+    return std::make_unique<TensorAccess>(getHostDataPointer(), m_shape, m_dataType, std::static_pointer_cast<Tensor>(mPtr.lock()));
 }
 
 void Tensor::free(ExecutionDevice::pointer device) {
@@ -159,7 +261,7 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
     bool updated = false;
     if(mCLBuffers.count(device) == 0) {
         // Data is not on device, create it
-        unsigned int bufferSize = getShape().getTotalSize()*4;
+        const std::size_t bufferSize = getBufferSize();
         cl::Buffer * newBuffer = new cl::Buffer(
                 device->getContext(),
                 CL_MEM_READ_WRITE,
@@ -189,7 +291,7 @@ void Tensor::updateOpenCLBufferData(OpenCLDevice::pointer device) {
 }
 
 void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
-    std::size_t bufferSize = m_shape.getTotalSize()*4;
+    const std::size_t bufferSize = getBufferSize();
     device->getCommandQueue().enqueueWriteBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, getHostDataPointer());
 }
@@ -197,9 +299,9 @@ void Tensor::transferCLBufferFromHost(OpenCLDevice::pointer device) {
 void Tensor::transferCLBufferToHost(OpenCLDevice::pointer device) {
 	if(!m_data) {
 		// Must allocate memory for host data
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocatePixelArray(m_shape.getTotalSize(), m_dataType);
 	}
-    std::size_t bufferSize = m_shape.getTotalSize()*4;
+    const std::size_t bufferSize = getBufferSize();
     device->getCommandQueue().enqueueReadBuffer(*mCLBuffers[device],
         CL_TRUE, 0, bufferSize, getHostDataPointer());
 }
@@ -221,7 +323,7 @@ void Tensor::updateHostData() {
     bool updated = false;
     if(!m_data) {
         // Data is not initialized, do that first
-        m_data = make_uninitialized_unique<float[]>(m_shape.getTotalSize());
+        m_data = allocatePixelArray(m_shape.getTotalSize(), m_dataType);
 
         if(hasAnyData()) {
             mHostDataIsUpToDate = false;
@@ -282,7 +384,7 @@ DataBoundingBox Tensor::getBoundingBox() const {
     return SpatialDataObject::getBoundingBox().getTransformedBoundingBox(T);
 }
 
-float* Tensor::getHostDataPointer() {
+void* Tensor::getHostDataPointer() {
     return m_data.get();
 }
 
@@ -4,6 +4,7 @@
 #include <FAST/Data/Access/TensorAccess.hpp>
 #include <FAST/Data/Access/Access.hpp>
 #include <FAST/Data/TensorShape.hpp>
+#include <FAST/Data/DataTypes.hpp>
 #include <unordered_map>
 
 namespace fast {
@@ -15,7 +16,8 @@ class OpenCLBufferAccess;
  *
  * This object represents an N-dimensional tensor.
  * The data can be stored as a C++ pointer, and as an OpenCL buffer.
- * The tensor data is stored as 32-bit floats.
+ * The tensor data is stored as 32-bit floats by default, but can also be stored as TYPE_FLOAT16, TYPE_UINT8 and TYPE_INT8
+ * to reduce memory usage, or as TYPE_INT32 for networks with integer tensors. Use getDataType to check the type, and convertToType to get a float copy if needed.
  *
  * @ingroup data neural-network
  */
@@ -34,6 +36,22 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
          * @param data
          */
         FAST_CONSTRUCTOR(Tensor, std::initializer_list<float>, data,)
+        /**
+         * Create a tensor of a given data type using the provided data and shape. The tensor takes ownership of the
+         * data, and the deleter of the pointer is called when the tensor data is freed. This can be used
+         * to wrap memory owned by other libraries, such as inference engine output, without copying it.
+         * @param data
+         * @param shape
+         * @param type
+         */
+        FAST_CONSTRUCTOR(Tensor, unique_pixel_ptr, data,, TensorShape, shape,, DataType, type,)
+        /**
+         * Create a tensor of a given data type using the provided data and shape. This method will COPY the data.
+         * @param data
+         * @param shape
+         * @param type
+         */
+        FAST_CONSTRUCTOR(Tensor, const void* const, data,, TensorShape, shape,, DataType, type,)
 #endif
         /**
          * Create a tensor using the provided data and shape. This method will COPY the data.
@@ -44,14 +62,31 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         /**
          * Create an unitialized tensor with the provided shape
          * @param shape
+         * @param type Data type of tensor. Supported types are TYPE_FLOAT, TYPE_FLOAT16, TYPE_UINT8, TYPE_INT8 and TYPE_INT32
          */
-        FAST_CONSTRUCTOR(Tensor, TensorShape, shape,)
+        FAST_CONSTRUCTOR(Tensor, TensorShape, shape,, DataType, type, = TYPE_FLOAT)
 		/**
 		 * Add a dimension of size 1 at provided position. -1 is last position.
 		 * @param position
 		 */
 		virtual void expandDims(int position = 0);
         virtual TensorShape getShape() const;
+        /**
+         * @return data type of this tensor
+         */
+        virtual DataType getDataType() const;
+        /**
+         * @return size of tensor data in bytes
+         */
+        std::size_t getBufferSize() const;
+        /**
+         * Create a copy of this tensor with another data type.
+         * If the type is the same as this tensor, this tensor is returned.
+         * Float values are not scaled when converting to integer types, but are rounded and clamped.
+         * @param type
+         * @return tensor of the given type
+         */
+        std::shared_ptr<Tensor> convertToType(DataType type);
         virtual TensorAccess::pointer getAccess(accessType type);
         virtual std::unique_ptr<OpenCLBufferAccess> getOpenCLBufferAccess(accessType type, OpenCLDevice::pointer);
         virtual void freeAll() override;
@@ -65,7 +100,7 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
 		virtual ~Tensor();
 
     protected:
-        void init(std::unique_ptr<float[]> data, TensorShape shape);
+        void init(unique_pixel_ptr data, TensorShape shape, DataType type = TYPE_FLOAT);
         Tensor() = default;
         virtual bool isInitialized();
         virtual void transferCLBufferFromHost(OpenCLDevice::pointer device);
@@ -74,9 +109,10 @@ class FAST_EXPORT Tensor : public SpatialDataObject {
         void setAllDataToOutOfDate();
         virtual bool hasAnyData();
         void updateHostData();
-        virtual float* getHostDataPointer();
+        virtual void* getHostDataPointer();
 
-        std::unique_ptr<float[]> m_data;
+        unique_pixel_ptr m_data;
+        DataType m_dataType = TYPE_FLOAT;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, cl::Buffer*> mCLBuffers;
         std::unordered_map<std::shared_ptr<OpenCLDevice>, bool> mCLBuffersIsUpToDate;
         TensorShape m_shape;
@@ -12,6 +12,41 @@ TEST_CASE("Update timestamp on DataObject", "[fast][DataObject]") {
     CHECK(timestamp != data->getTimestamp());
 }
 
+TEST_CASE("Typed frame data on DataObject", "[fast][DataObject][FrameData]") {
+    DummyDataObject::pointer data = DummyDataObject::New();
+    data->setFrameData("patchid-x", 10);
+    data->setFrameData("patch-spacing-x", 0.00025);
+    data->setFrameData("streaming", "yes");
+    data->setFrameData("original-width", std::string("1024.000000")); // Old string style
+
+    CHECK(data->hasFrameData("patchid-x"));
+    CHECK(!data->hasFrameData("patchid-y"));
+    CHECK(data->getFrameData<int>("patchid-x") == 10);
+    CHECK(data->getFrameData("patchid-x") == "10");
+    CHECK(data->getFrameData<double>("patch-spacing-x") == 0.00025);
+    CHECK(std::stod(data->getFrameData("patch-spacing-x")) == 0.00025);
+    CHECK(data->getFrameData("streaming") == "yes");
+    CHECK(data->getFrameData<int>("original-width") == 1024);
+    CHECK_THROWS(data->getFrameData<int>("patchid-y"));
+    CHECK(data->getFrameData().size() == 4);
+
+    // Propagation keeps types and overwrites existing values
+    DummyDataObject::pointer data2 = DummyDataObject::New();
+    data2->setFrameData("patchid-x", 5);
+    data2->setFrameData("patchid-y", 6);
+    data2->mergeFrameData(data->getTypedFrameData());
+    CHECK(data2->getFrameData<int>("patchid-x") == 10);
+    CHECK(data2->getFrameData<int>("patchid-y") == 6);
+    CHECK(data2->getTypedFrameData().size() == 5);
+
+    // More entries than stored inline
+    for(int i = 0; i < 40; ++i)
+        data2->setFrameData("key-" + std::to_string(i), i);
+    for(int i = 0; i < 40; ++i)
+        CHECK(data2->getFrameData<int>("key-" + std::to_string(i)) == i);
+    CHECK(data2->getFrameData<int>("patchid-y") == 6);
+}
+
 
 
 };
@@ -7,6 +7,9 @@
 #include <FAST/Visualization/ImagePyramidRenderer/ImagePyramidRenderer.hpp>
 #include <FAST/Exporters/TIFFImagePyramidExporter.hpp>
 #include <FAST/Importers/TIFFImagePyramidImporter.hpp>
+#include <thread>
+#include <random>
+#include <chrono>
 
 using namespace fast;
 
@@ -108,3 +111,288 @@ TEST_CASE("getClosestLevelForMagnification()", "[fast][ImagePyramid]") {
     }
      */
 }
+
+TEST_CASE("Write JPEG image pyramid with parallel tile compression", "[fast][ImagePyramid][JPEG]") {
+    const int tileSize = 256;
+    auto imagePyramid = ImagePyramid::create(tileSize*16, tileSize*16, 3, tileSize, tileSize, ImageCompression::JPEG);
+    imagePyramid->setTileCompressionThreads(4);
+    CHECK(imagePyramid->getTileCompressionThreads() == 4);
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        for(int y = 0; y < 16; ++y) {
+            for(int x = 0; x < 16; ++x) {
+                auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 3);
+                patch->fill(x*16);
+                access->setPatch(0, x*tileSize, y*tileSize, patch);
+            }
+        }
+        // Tiles should be readable while they are still being compressed
+        auto patch = access->getPatchAsImage(0, 3, 2);
+        auto patchAccess = patch->getImageAccess(ACCESS_READ);
+        CHECK(patchAccess->getScalar(Vector2i(10, 10)) == Approx(3*16).margin(2));
+    }
+    imagePyramid->flush();
+    auto access = imagePyramid->getAccess(ACCESS_READ);
+    auto patch = access->getPatchAsImage(0, 5, 7);
+    auto patchAccess = patch->getImageAccess(ACCESS_READ);
+    // JPEG is lossy
+    CHECK(patchAccess->getScalar(Vector2i(10, 10)) == Approx(5*16).margin(2));
+}
+
+TEST_CASE("Access keeps tile writer alive when tile compression threads are changed", "[fast][ImagePyramid][JPEG]") {
+    const int tileSize = 256;
+    auto imagePyramid = ImagePyramid::create(tileSize*4, tileSize*4, 3, tileSize, tileSize, ImageCompression::JPEG);
+    CHECK(imagePyramid->getTileCompressionThreads() == 0); // Disabled by default
+    imagePyramid->setTileCompressionThreads(2);
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 3);
+        patch->fill(100);
+        access->setPatch(0, 0, 0, patch);
+        imagePyramid->setTileCompressionThreads(0);
+        // The access still uses the old writer
+        access->setPatch(0, tileSize, 0, patch);
+        auto result = access->getPatchAsImage(0, 1, 0);
+        CHECK(result->getImageAccess(ACCESS_READ)->getScalar(Vector2i(10, 10)) == Approx(100).margin(2));
+    }
+    imagePyramid->flush();
+}
+
+TEST_CASE("Update image pyramid levels after writing patches", "[fast][ImagePyramid]") {
+    const int tileSize = 512;
+    auto imagePyramid = ImagePyramid::create(tileSize*32, tileSize*32, 1, tileSize, tileSize);
+    REQUIRE(imagePyramid->getNrOfLevels() == 3);
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        for(int y = 0; y < 4; ++y) {
+            for(int x = 0; x < 4; ++x) {
+                auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 1);
+                patch->fill(1 + x + y*4);
+                access->setPatch(0, x*tileSize, y*tileSize, patch, false);
+            }
+        }
+        CHECK(imagePyramid->hasOutdatedTiles());
+        access->updatePyramidLevels();
+        CHECK(!imagePyramid->hasOutdatedTiles());
+    }
+    auto access = imagePyramid->getAccess(ACCESS_READ);
+    // Single channel pyramids are downsampled using majority vote
+    auto level1 = access->getPatchAsImage(1, 0, 0);
+    auto level1Access = level1->getImageAccess(ACCESS_READ);
+    CHECK(level1Access->getScalar(Vector2i(10, 10)) == 1);
+    CHECK(level1Access->getScalar(Vector2i(tileSize/2 + 10, 10)) == 2);
+    CHECK(level1Access->getScalar(Vector2i(10, tileSize/2 + 10)) == 5);
+    auto level2 = access->getPatchAsImage(2, 0, 0);
+    auto level2Access = level2->getImageAccess(ACCESS_READ);
+    // Each level 2 pixel covers 4x4 level 0 pixels, thus a level 0 tile is a quarter tile at level 2
+    CHECK(level2Access->getScalar(Vector2i(10, 10)) == 1);
+    CHECK(level2Access->getScalar(Vector2i(tileSize/4 + 10, 10)) == 2);
+    CHECK(level2Access->getScalar(Vector2i(tileSize/2 + 10, tileSize/2 + 10)) == 11);
+}
+
+TEST_CASE("Image pyramid tile cache", "[fast][ImagePyramid][TileCache]") {
+    const int tileSize = 256;
+    auto imagePyramid = ImagePyramid::create(tileSize*4, tileSize*4, 1, tileSize, tileSize);
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 1);
+        patch->fill(10);
+        access->setPatch(0, tileSize, tileSize, patch, false);
+    }
+    auto cache = TileCache::getInstance();
+    auto manager = cache->getRuntimeManager();
+    const auto hits = manager->getCounterValue("tile cache hits");
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ, true);
+        auto patch = access->getPatchAsImage(0, 1, 1);
+        CHECK(patch->getImageAccess(ACCESS_READ)->getScalar(Vector2i(10, 10)) == 10);
+        patch = access->getPatchAsImage(0, 1, 1);
+        CHECK(patch->getImageAccess(ACCESS_READ)->getScalar(Vector2i(10, 10)) == 10);
+    }
+    CHECK(manager->getCounterValue("tile cache hits") > hits);
+    CHECK(cache->getSize() > 0);
+    {
+        // Overwriting a tile should invalidate it in the cache
+        auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+        auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 1);
+        patch->fill(20);
+        access->setPatch(0, tileSize, tileSize, patch, false);
+    }
+    {
+        auto access = imagePyramid->getAccess(ACCESS_READ, true);
+        auto patch = access->getPatchAsImage(0, 1, 1);
+        CHECK(patch->getImageAccess(ACCESS_READ)->getScalar(Vector2i(10, 10)) == 20);
+    }
+    const auto size = cache->getSize();
+    imagePyramid->freeAll();
+    CHECK(cache->getSize() < size);
+}
+
+TEST_CASE("Read TIFF image pyramid tiles in parallel", "[fast][ImagePyramid][JPEG]") {
+    const int tileSize = 256;
+    const int tiles = 8;
+    {
+        auto imagePyramid = ImagePyramid::create(tileSize*tiles, tileSize*tiles, 3, tileSize, tileSize, ImageCompression::JPEG);
+        {
+            auto access = imagePyramid->getAccess(ACCESS_READ_WRITE);
+            for(int y = 0; y < tiles; ++y) {
+                for(int x = 0; x < tiles; ++x) {
+                    auto patch = Image::create(tileSize, tileSize, TYPE_UINT8, 3);
+                    patch->fill((x + y*tiles)*3);
+                    access->setPatch(0, x*tileSize, y*tileSize, patch, false);
+                }
+            }
+        }
+        TIFFImagePyramidExporter::create("parallel_read_test.tiff")->connect(imagePyramid)->run();
+    }
+
+    auto imagePyramid = TIFFImagePyramidImporter::create("parallel_read_test.tiff")->runAndGetOutputData<ImagePyramid>();
+    imagePyramid->setTIFFReadHandles(4);
+    std::vector<std::thread> threads;
+    std::atomic<int> errors(0);
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([&, i]() {
+            auto access = imagePyramid->getAccess(ACCESS_READ);
+            for(int tile = i; tile < tiles*tiles; tile += 4) {
+                auto patch = access->getPatchAsImage(0, tile % tiles, tile / tiles);
+                auto patchAccess = patch->getImageAccess(ACCESS_READ);
+                if(std::abs(patchAccess->getScalar(Vector2i(10, 10)) - tile*3) > 2)
+                    ++errors;
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    CHECK(errors == 0);
+
+    // Replacing the pool while an access exists keeps the old pool alive for that access
+    auto access = imagePyramid->getAccess(ACCESS_READ);
+    imagePyramid->setTIFFReadHandles(2);
+    auto patch = access->getPatchAsImage(0, 1, 0);
+    CHECK(patch->getImageAccess(ACCESS_READ)->getScalar(Vector2i(10, 10)) == Approx(3).margin(2));
+}
+
+TEST_CASE("Downsample 2x2 gives same result with all instruction sets", "[fast][ImagePyramid][downsampling]") {
+    std::mt19937 generator(1);
+    const int width = 83; // Not a multiple of the vector sizes
+    const int height = 5;
+    std::vector<DownsamplingInstructionSet> instructionSets = {DownsamplingInstructionSet::SCALAR};
+    if(getDownsamplingInstructionSet() >= DownsamplingInstructionSet::SSE2)
+        instructionSets.push_back(DownsamplingInstructionSet::SSE2);
+    if(getDownsamplingInstructionSet() >= DownsamplingInstructionSet::AVX2)
+        instructionSets.push_back(DownsamplingInstructionSet::AVX2);
+    for(int channels = 1; channels <= 4; ++channels) {
+        for(auto method : {PyramidDownsampling::AVERAGE, PyramidDownsampling::MAX, PyramidDownsampling::MAJORITY}) {
+            std::vector<uint8_t> input(4*width*height*channels);
+            // Few labels, so that the majority vote has both ties and majorities
+            for(auto& value : input)
+                value = method == PyramidDownsampling::MAJORITY ? generator() % 3 : generator() % 256;
+            std::vector<uint8_t> expected(width*height*channels);
+            for(int y = 0; y < height; ++y) {
+                for(int x = 0; x < width; ++x) {
+                    for(int c = 0; c < channels; ++c) {
+                        std::vector<uint8_t> values = {
+                                input[c + channels*(x*2 + y*2*width*2)],
+                                input[c + channels*(x*2 + 1 + y*2*width*2)],
+                                input[c + channels*(x*2 + (y*2 + 1)*width*2)],
+                                input[c + channels*(x*2 + 1 + (y*2 + 1)*width*2)],
+                        };
+                        uint8_t result = 0;
+                        if(method == PyramidDownsampling::AVERAGE) {
+                            result = (uint8_t)round((float)(values[0] + values[1] + values[2] + values[3]) / 4);
+                        } else if(method == PyramidDownsampling::MAX) {
+                            result = *std::max_element(values.begin(), values.end());
+                        } else {
+                            // Most frequent, lowest on ties
+                            int bestCount = 0;
+                            for(auto value : values) {
+                                const int count = std::count(values.begin(), values.end(), value);
+                                if(count > bestCount || (count == bestCount && value < result)) {
+                                    result = value;
+                                    bestCount = count;
+                                }
+                            }
+                        }
+                        expected[c + channels*(x + y*width)] = result;
+                    }
+                }
+            }
+            for(auto instructionSet : instructionSets) {
+                std::vector<uint8_t> output(width*height*channels);
+                downsample2x2(input.data(), width*2, output.data(), width, width, height, channels, method, instructionSet);
+                CHECK(output == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("Downsample 2x2 benchmark", "[fast][ImagePyramid][downsampling][benchmark]") {
+    // Compare against the scalar loops previously used to create pyramid levels
+    const int tileSize = 512;
+    const int iterations = 20;
+    std::mt19937 generator(1);
+    for(int channels : {1, 3}) {
+        std::vector<uint8_t> input(tileSize*tileSize*channels);
+        for(auto& value : input)
+            value = channels == 1 ? generator() % 4 : generator() % 256;
+        std::vector<uint8_t> output(tileSize*tileSize*channels/4);
+        auto benchmark = [&](const std::string& name, std::function<void()> function) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for(int i = 0; i < iterations; ++i)
+                function();
+            std::chrono::duration<float, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+            std::cout << channels << " channel(s) " << name << ": " << duration.count()/iterations << " ms per tile" << std::endl;
+        };
+        const int half = tileSize/2;
+        if(channels == 1) {
+            benchmark("old max loop", [&]() {
+                for(int dy = 0; dy < half; ++dy) {
+                    for(int dx = 0; dx < half; ++dx) {
+                        output[dx + dy*half] = std::max(std::max(std::max(
+                                input[dx*2 + dy*2*tileSize], input[dx*2 + 1 + dy*2*tileSize]),
+                                input[dx*2 + 1 + (dy*2+1)*tileSize]), input[dx*2 + (dy*2+1)*tileSize]);
+                    }
+                }
+            });
+            benchmark("old sort based majority loop", [&]() {
+                for(int dy = 0; dy < half; ++dy) {
+                    for(int dx = 0; dx < half; ++dx) {
+                        uint8_t list[4] = {
+                                input[dx*2 + dy*2*tileSize], input[dx*2 + 1 + dy*2*tileSize],
+                                input[dx*2 + 1 + (dy*2+1)*tileSize], input[dx*2 + (dy*2+1)*tileSize]
+                        };
+                        std::sort(list, list + 4);
+                        output[dx + dy*half] = list[0] == list[1] ? list[0] : list[2];
+                    }
+                }
+            });
+        } else {
+            benchmark("old average loop", [&]() {
+                for(int dy = 0; dy < half; ++dy) {
+                    for(int dx = 0; dx < half; ++dx) {
+                        for(int c = 0; c < channels; ++c) {
+                            output[c + channels*(dx + dy*half)] = (uint8_t)round((float)(
+                                    input[c + channels*(dx*2 + dy*2*tileSize)] +
+                                    input[c + channels*(dx*2 + 1 + dy*2*tileSize)] +
+                                    input[c + channels*(dx*2 + 1 + (dy*2 + 1)*tileSize)] +
+                                    input[c + channels*(dx*2 + (dy*2 + 1)*tileSize)]
+                            ) / 4);
+                        }
+                    }
+                }
+            });
+        }
+        std::vector<std::pair<std::string, DownsamplingInstructionSet>> instructionSets = {{"scalar", DownsamplingInstructionSet::SCALAR}};
+        if(getDownsamplingInstructionSet() >= DownsamplingInstructionSet::SSE2)
+            instructionSets.push_back({"SSE2", DownsamplingInstructionSet::SSE2});
+        if(getDownsamplingInstructionSet() >= DownsamplingInstructionSet::AVX2)
+            instructionSets.push_back({"AVX2", DownsamplingInstructionSet::AVX2});
+        for(auto method : channels == 1 ? std::vector<PyramidDownsampling>{PyramidDownsampling::MAX, PyramidDownsampling::MAJORITY} : std::vector<PyramidDownsampling>{PyramidDownsampling::AVERAGE}) {
+            for(auto instructionSet : instructionSets) {
+                benchmark(std::string(method == PyramidDownsampling::MAX ? "max" : (method == PyramidDownsampling::MAJORITY ? "majority" : "average")) + " " + instructionSet.first, [&]() {
+                    downsample2x2(input.data(), tileSize, output.data(), half, half, half, channels, method, instructionSet.second);
+                });
+            }
+        }
+    }
+}
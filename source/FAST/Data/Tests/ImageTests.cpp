@@ -1,5 +1,6 @@
 #include "FAST/Testing.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/Data/ImageBufferPool.hpp"
 #include "FAST/DeviceManager.hpp"
 #include "FAST/Tests/DataComparison.hpp"
 #include "FAST/Utility.hpp"
@@ -1520,3 +1521,35 @@ TEST_CASE("createFromImage on 3D image", "[fast][image]") {
 }
 
 
+
+TEST_CASE("Image buffer pool reuses memory of destroyed images", "[fast][image][ImageBufferPool]") {
+    auto pool = ImageBufferPool::getInstance();
+    auto manager = pool->getRuntimeManager();
+    pool->clear();
+    const auto hits = manager->getCounterValue("image pool hits");
+    const auto allocations = manager->getCounterValue("image pool allocations");
+    {
+        ImageBufferPool::Scope scope(true);
+        for(int i = 0; i < 5; ++i) {
+            auto image = Image::create(128, 64, TYPE_UINT8, 1);
+            image->fill(i); // Creates OpenCL image
+            auto access = image->getImageAccess(ACCESS_READ);
+            CHECK(access->getScalar(Vector2i(10, 10)) == i);
+        }
+    }
+    // Only the first image should allocate memory, both an OpenCL image and host data
+    CHECK(manager->getCounterValue("image pool hits") > hits);
+    CHECK(manager->getCounterValue("image pool allocations") - allocations <= 2);
+    CHECK(pool->getSize() > 0);
+    pool->clear();
+    CHECK(pool->getSize() == 0);
+
+    // Images created without the scope should not use the pool
+    const auto hits2 = manager->getCounterValue("image pool hits");
+    {
+        auto image = Image::create(128, 64, TYPE_UINT8, 1);
+        image->fill(1);
+    }
+    CHECK(pool->getSize() == 0);
+    CHECK(manager->getCounterValue("image pool hits") == hits2);
+}
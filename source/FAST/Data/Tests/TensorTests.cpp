@@ -0,0 +1,92 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Data/Tensor.hpp"
+#include "FAST/Data/Access/OpenCLBufferAccess.hpp"
+#include "FAST/DeviceManager.hpp"
+#include <cmath>
+
+namespace fast {
+
+TEST_CASE("Create float tensor", "[fast][Tensor]") {
+    auto tensor = Tensor::create({1.0f, 2.0f, 3.0f});
+    CHECK(tensor->getDataType() == TYPE_FLOAT);
+    CHECK(tensor->getBufferSize() == 3*sizeof(float));
+    auto access = tensor->getAccess(ACCESS_READ);
+    CHECK(access->getRawData()[2] == 3.0f);
+}
+
+TEST_CASE("Half precision conversion", "[fast][Tensor]") {
+    for(float value : {0.0f, 1.0f, -2.5f, 0.1f, 65504.0f, 1e-7f}) {
+        CHECK(float16ToFloat(floatToFloat16(value)) == Approx(value).epsilon(1e-3).margin(1e-7));
+    }
+    CHECK(std::isinf(float16ToFloat(floatToFloat16(1e6f))));
+}
+
+TEST_CASE("Create half precision and int8 tensors", "[fast][Tensor]") {
+    const float values[] = {0.0f, 1.5f, -3.25f, 100.0f};
+    auto floatTensor = Tensor::create(values, TensorShape({2, 2}));
+
+    auto halfTensor = floatTensor->convertToType(TYPE_FLOAT16);
+    CHECK(halfTensor->getDataType() == TYPE_FLOAT16);
+    CHECK(halfTensor->getBufferSize() == 4*2);
+    CHECK(halfTensor->getShape() == floatTensor->getShape());
+    {
+        auto access = halfTensor->getAccess(ACCESS_READ);
+        CHECK_THROWS(access->getRawData());
+        CHECK(float16ToFloat(((uint16_t*)access->get())[1]) == 1.5f);
+    }
+
+    auto int8Tensor = floatTensor->convertToType(TYPE_INT8);
+    CHECK(int8Tensor->getBufferSize() == 4);
+    {
+        auto access = int8Tensor->getAccess(ACCESS_READ);
+        auto data = (const char*)access->get();
+        CHECK(data[1] == 2); // Rounded
+        CHECK(data[2] == -3);
+        CHECK(data[3] == 100);
+    }
+    auto uint8Tensor = floatTensor->convertToType(TYPE_UINT8);
+    CHECK(((const uchar*)uint8Tensor->getAccess(ACCESS_READ)->get())[2] == 0); // Clamped
+
+    // Round trip back to float
+    auto result = halfTensor->convertToType(TYPE_FLOAT);
+    auto access = result->getAccess(ACCESS_READ);
+    for(int i = 0; i < 4; ++i)
+        CHECK(access->getRawData()[i] == values[i]);
+    CHECK(floatTensor->convertToType(TYPE_FLOAT) == floatTensor);
+}
+
+TEST_CASE("Create int32 tensor", "[fast][Tensor]") {
+    const float values[] = {0.0f, 1.5f, -3.25f, 3e9f};
+    auto intTensor = Tensor::create(values, TensorShape({2, 2}))->convertToType(TYPE_INT32);
+    CHECK(intTensor->getDataType() == TYPE_INT32);
+    CHECK(intTensor->getBufferSize() == 4*4);
+    {
+        auto access = intTensor->getAccess(ACCESS_READ);
+        auto data = (const int*)access->get();
+        CHECK(data[1] == 2); // Rounded
+        CHECK(data[2] == -3);
+        CHECK(data[3] == std::numeric_limits<int>::max()); // Clamped
+    }
+    auto result = intTensor->convertToType(TYPE_FLOAT);
+    CHECK(result->getAccess(ACCESS_READ)->getRawData()[2] == -3.0f);
+}
+
+TEST_CASE("Create tensor of unsupported type throws", "[fast][Tensor]") {
+    CHECK_THROWS(Tensor::create(TensorShape({2, 2}), TYPE_UINT16));
+}
+
+TEST_CASE("Half precision tensor on OpenCL device", "[fast][Tensor]") {
+    const float values[] = {0.5f, 1.5f, -3.25f, 8.0f};
+    auto tensor = Tensor::create(values, TensorShape({4}))->convertToType(TYPE_FLOAT16);
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+    {
+        auto access = tensor->getOpenCLBufferAccess(ACCESS_READ_WRITE, device);
+        CHECK(access->get()->getInfo<CL_MEM_SIZE>() == 4*2);
+    }
+    auto result = tensor->convertToType(TYPE_FLOAT);
+    auto access = result->getAccess(ACCESS_READ);
+    for(int i = 0; i < 4; ++i)
+        CHECK(access->getRawData()[i] == values[i]);
+}
+
+}
@@ -1,4 +1,6 @@
 #include "DataChannel.hpp"
+#include <FAST/ProcessObject.hpp>
+#include <FAST/Tracer.hpp>
 
 namespace fast {
 void DataChannel::stop(std::string errorMessage) {
@@ -11,6 +13,90 @@ void DataChannel::stop(std::string errorMessage) {
 
 DataChannel::DataChannel() {
     m_stop = false;
+    m_addFrameWaitTime = std::make_shared<RuntimeMeasurement>("addFrame wait");
+    m_nextFrameWaitTime = std::make_shared<RuntimeMeasurement>("getNextFrame wait");
+    m_peakSize = 0;
+    m_framesAdded = 0;
+    m_framesDropped = 0;
+}
+
+RuntimeMeasurement::pointer DataChannel::getAddFrameWaitTime() const {
+    return m_addFrameWaitTime;
+}
+
+RuntimeMeasurement::pointer DataChannel::getNextFrameWaitTime() const {
+    return m_nextFrameWaitTime;
+}
+
+int DataChannel::getPeakSize() const {
+    return m_peakSize;
+}
+
+int64_t DataChannel::getFramesAdded() const {
+    return m_framesAdded;
+}
+
+int64_t DataChannel::getFramesDropped() const {
+    return m_framesDropped;
+}
+
+void DataChannel::recordFrameAdded(int size, bool dropped) {
+    ++m_framesAdded;
+    if(dropped)
+        ++m_framesDropped;
+    int peak = m_peakSize;
+    while(size > peak && !m_peakSize.compare_exchange_weak(peak, size)) {
+    }
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    for(auto it = m_listeners.begin(); it != m_listeners.end();) {
+        auto listener = it->lock();
+        if(listener) {
+            listener->notify();
+            ++it;
+        } else {
+            it = m_listeners.erase(it);
+        }
+    }
+}
+
+void DataChannel::addListener(std::shared_ptr<DataChannelListener> listener) {
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    for(const auto& existing : m_listeners) {
+        if(existing.lock() == listener)
+            return;
+    }
+    m_listeners.push_back(listener);
+}
+
+void DataChannelListener::notify() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_notifications;
+    }
+    m_condition.notify_all();
+}
+
+uint64_t DataChannelListener::getNotifications() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_notifications;
+}
+
+void DataChannelListener::waitForNotification(uint64_t notifications, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait_for(lock, timeout, [this, notifications] { return m_notifications != notifications; });
+}
+
+void DataChannel::recordWaitTime(RuntimeMeasurement::pointer measurement, std::chrono::steady_clock::time_point start) {
+    const auto end = std::chrono::steady_clock::now();
+    const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    measurement->addSample(milliseconds);
+    // Only trace waits which actually blocked, to not flood the trace
+    if(Tracer::isEnabled() && milliseconds >= 0.01) {
+        Tracer::Arguments arguments;
+        if(m_processObject)
+            arguments["producer"] = m_processObject->getNameOfClass();
+        Tracer::getInstance()->addEvent(measurement->getName(), "DataChannel", start, end, arguments);
+    }
 }
 
 std::shared_ptr<ProcessObject> DataChannel::getProcessObject() const {
@@ -21,6 +107,10 @@ void DataChannel::setProcessObject(std::shared_ptr<ProcessObject> po) {
     m_processObject = po;
 }
 
+DataObject::pointer DataChannel::tryGetNextFrame(std::chrono::microseconds timeout) {
+    return nullptr;
+}
+
 template <>
 std::shared_ptr<DataObject> DataChannel::getNextFrame<DataObject>() {
     return getNextDataFrame();
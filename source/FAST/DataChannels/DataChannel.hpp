@@ -2,11 +2,38 @@
 
 #include <FAST/Data/DataObject.hpp>
 #include <FAST/Data/DataTypes.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 namespace fast {
 
 class ProcessObject;
 
+/**
+ * @brief Used to wait for frames to be added to one or more data channels
+ *
+ * Counts the nr of notifications, which are sent by the data channels it is added to every time a frame is added.
+ */
+class FAST_EXPORT DataChannelListener {
+    public:
+        /**
+         * @brief Increment the nr of notifications and wake any waiting threads
+         */
+        void notify();
+        uint64_t getNotifications();
+        /**
+         * @brief Block until the nr of notifications differs from the given nr, or the time is up
+         * @param notifications Nr of notifications from getNotifications
+         * @param timeout Max time to wait
+         */
+        void waitForNotification(uint64_t notifications, std::chrono::milliseconds timeout);
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        uint64_t m_notifications = 0;
+};
+
 class FAST_EXPORT DataChannel : public Object {
     public:
         typedef std::shared_ptr<DataChannel> pointer;
@@ -24,6 +51,14 @@ class FAST_EXPORT DataChannel : public Object {
         template <class T = DataObject>
         std::shared_ptr<T> getNextFrame();
 
+        /**
+         * Get next frame in the data channel if it is available within the given time.
+         * Data channels which don't remove frames when read, such as the StaticDataChannel, always return nullptr.
+         * @param timeout Max time to wait for a frame. If 0, this doesn't block.
+         * @return next frame, or nullptr if no frame became available
+         */
+        virtual DataObject::pointer tryGetNextFrame(std::chrono::microseconds timeout = std::chrono::microseconds(0));
+
         /**
          * @return the number of frames stored in this DataChannel
          */
@@ -50,14 +85,62 @@ class FAST_EXPORT DataChannel : public Object {
          */
         virtual DataObject::pointer getFrame() = 0;
 
+        /**
+         * @brief Add a listener which is notified every time a frame is added to this data channel
+         * @param listener
+         */
+        void addListener(std::shared_ptr<DataChannelListener> listener);
         std::shared_ptr<ProcessObject> getProcessObject() const;
         void setProcessObject(std::shared_ptr<ProcessObject> po);
+        virtual std::string getNameOfClass() const = 0;
+
+        /**
+         * @brief Time the producer has been blocked in addFrame because this data channel was full
+         */
+        RuntimeMeasurement::pointer getAddFrameWaitTime() const;
+        /**
+         * @brief Time consumers have been blocked in getNextFrame waiting for a frame
+         */
+        RuntimeMeasurement::pointer getNextFrameWaitTime() const;
+        /**
+         * @brief Largest nr of frames stored in this data channel at the same time
+         */
+        int getPeakSize() const;
+        /**
+         * @brief Nr of frames added to this data channel
+         */
+        int64_t getFramesAdded() const;
+        /**
+         * @brief Nr of frames replaced by a newer frame before they were read
+         */
+        int64_t getFramesDropped() const;
     protected:
         bool m_stop;
         std::string m_errorMessage = "";
         std::mutex m_mutex;
         std::shared_ptr<ProcessObject> m_processObject;
 
+        // Statistics, always collected
+        RuntimeMeasurement::pointer m_addFrameWaitTime;
+        RuntimeMeasurement::pointer m_nextFrameWaitTime;
+        std::atomic<int> m_peakSize;
+        std::atomic<int64_t> m_framesAdded;
+        std::atomic<int64_t> m_framesDropped;
+        std::vector<std::weak_ptr<DataChannelListener>> m_listeners;
+        std::mutex m_listenerMutex;
+        /**
+         * Update statistics and notify listeners after a frame was added
+         * @param size Nr of frames in data channel after adding frame
+         * @param dropped Whether a frame which wasn't read was replaced
+         */
+        void recordFrameAdded(int size, bool dropped = false);
+        /**
+         * Add time spent waiting since start to a wait time measurement, and to the Tracer if enabled
+         * @param measurement
+         * @param start
+         */
+        void recordWaitTime(RuntimeMeasurement::pointer measurement, std::chrono::steady_clock::time_point start);
+
         virtual DataObject::pointer getNextDataFrame() = 0;
         DataChannel();
 };
@@ -7,6 +7,8 @@ void NewestFrameDataChannel::addFrame(DataObject::pointer data) {
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_frame = data;
+        recordFrameAdded(1, m_frameUnread);
+        m_frameUnread = true;
     }
     m_frameConditionVariable.notify_one();
 }
@@ -15,15 +17,18 @@ DataObject::pointer NewestFrameDataChannel::getNextDataFrame() {
     std::unique_lock<std::mutex> lock(m_mutex);
 
     // Block until we get any data or a stop signal
+    const auto start = std::chrono::steady_clock::now();
     while(getSize() == 0 && !m_stop) {
         m_frameConditionVariable.wait(lock);
     }
+    recordWaitTime(m_nextFrameWaitTime, start);
 
     // If stop is signaled, throw an exception to stop the entire computation thread
     if(m_stop)
         throw ThreadStopped(m_errorMessage);
 
     DataObject::pointer data = m_frame;
+    m_frameUnread = false;
 
     // Remove frame as we don't want to process the same frame again
     m_frame.reset();
@@ -31,6 +36,18 @@ DataObject::pointer NewestFrameDataChannel::getNextDataFrame() {
     return data;
 }
 
+DataObject::pointer NewestFrameDataChannel::tryGetNextFrame(std::chrono::microseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_frameConditionVariable.wait_for(lock, timeout, [this] { return getSize() > 0 || m_stop; });
+    if(m_stop)
+        throw ThreadStopped(m_errorMessage);
+
+    DataObject::pointer data = m_frame;
+    m_frame.reset();
+    m_frameUnread = false;
+    return data;
+}
+
 int NewestFrameDataChannel::getSize() {
     return m_frame ? 1 : 0;
 }
@@ -43,9 +43,12 @@ class FAST_EXPORT NewestFrameDataChannel : public DataChannel {
          * Get current frame, throws if current frame is not available.
          */
         DataObject::pointer getFrame() override;
+
+        DataObject::pointer tryGetNextFrame(std::chrono::microseconds timeout) override;
     protected:
         std::condition_variable m_frameConditionVariable;
         std::shared_ptr<DataObject> m_frame;
+        bool m_frameUnread = false; // Whether m_frame has been added, but not read yet
 
         DataObject::pointer getNextDataFrame() override;
 
@@ -8,7 +8,9 @@ void QueuedDataChannel::addFrame(DataObject::pointer data) {
     //    Reporter::error() << "EXECUTION BLOCKED by DataChannel from " << mProcessObject->getNameOfClass() << ". Do you have a DataChannel object that is not used?" << Reporter::end();
 
     // Decrement semaphore by one, wait if queue is full
+    const auto start = std::chrono::steady_clock::now();
     m_emptyCount->wait();
+    recordWaitTime(m_addFrameWaitTime, start);
 
     {
         std::unique_lock<std::mutex> lock(m_mutex);
@@ -18,15 +20,19 @@ void QueuedDataChannel::addFrame(DataObject::pointer data) {
             throw ThreadStopped(m_errorMessage);
 
         m_queue.push(data);
+        recordFrameAdded(m_queue.size());
     }
 
     // Increment semaphore by one, signal any waiting due to empty queue
     m_fillCount->signal();
+    m_frameAdded.notify_all();
 }
 
 DataObject::pointer QueuedDataChannel::getNextDataFrame() {
     // Decrement semaphore by one, and wait if queue is empty
+    const auto start = std::chrono::steady_clock::now();
     m_fillCount->wait();
+    recordWaitTime(m_nextFrameWaitTime, start);
 
     DataObject::pointer data;
     {
@@ -47,6 +53,33 @@ DataObject::pointer QueuedDataChannel::getNextDataFrame() {
     return data;
 }
 
+DataObject::pointer QueuedDataChannel::tryGetNextFrame(std::chrono::microseconds timeout) {
+    // Decrement semaphore by one if queue is not empty, otherwise wait until a frame is added or the time is up
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while(!m_fillCount->tryWait()) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(!m_frameAdded.wait_until(lock, deadline, [this] { return !m_queue.empty() || m_stop; }))
+            return nullptr;
+        // The semaphore is signaled right after the frame is added, so try again
+    }
+
+    DataObject::pointer data;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // If stop is signaled, throw an exception to stop the entire computation thread
+        if(m_stop)
+            throw ThreadStopped(m_errorMessage);
+
+        data = m_queue.front();
+        m_queue.pop();
+    }
+
+    m_emptyCount->signal();
+
+    return data;
+}
+
 int QueuedDataChannel::getSize() {
     return m_queue.size();
 }
@@ -70,6 +103,7 @@ void QueuedDataChannel::stop(std::string errorMessage) {
     // Since getNextFrame or addFrame might be waiting for data, we need to signal the semaphore to stop them blocking
     m_fillCount->signal();
     m_emptyCount->signal();
+    m_frameAdded.notify_all();
 }
 
 bool QueuedDataChannel::hasCurrentData() {
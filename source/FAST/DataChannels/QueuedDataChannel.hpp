@@ -2,6 +2,7 @@
 
 #include <FAST/DataChannels/DataChannel.hpp>
 #include <queue>
+#include <condition_variable>
 #include <FAST/Semaphore.hpp>
 
 namespace fast {
@@ -45,11 +46,15 @@ class FAST_EXPORT QueuedDataChannel : public DataChannel {
          * Get current frame, throws if current frame is not available.
          */
         DataObject::pointer getFrame() override;
+
+        DataObject::pointer tryGetNextFrame(std::chrono::microseconds timeout) override;
     protected:
         std::queue<std::shared_ptr<DataObject>> m_queue;
         uint mMaximumNumberOfFrames;
         std::unique_ptr<LightweightSemaphore> m_fillCount;
         std::unique_ptr<LightweightSemaphore> m_emptyCount;
+        // Notified when a frame is added or the channel is stopped, used by tryGetNextFrame with a timeout
+        std::condition_variable m_frameAdded;
 
         DataObject::pointer getNextDataFrame() override;
         QueuedDataChannel();
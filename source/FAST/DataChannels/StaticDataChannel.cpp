@@ -6,15 +6,18 @@ DataObject::pointer StaticDataChannel::getNextDataFrame() {
     std::unique_lock<std::mutex> lock(m_mutex);
 
     // Block until we get any data or a stop signal
+    const auto start = std::chrono::steady_clock::now();
     while(getSize() == 0 && !m_stop) {
         m_frameConditionVariable.wait(lock);
     }
+    recordWaitTime(m_nextFrameWaitTime, start);
 
     // If stop is signaled, throw an exception to stop the entire computation thread
     if(m_stop)
         throw ThreadStopped();
 
     DataObject::pointer data = m_frame;
+    m_frameUnread = false;
 
     // For static channels the data is not removed
 
@@ -1,8 +1,12 @@
 #include "FAST/ExecutionDevice.hpp"
 #include "FAST/RuntimeMeasurementManager.hpp"
+#include "FAST/Tracer.hpp"
 #include "FAST/Utility.hpp"
 #include <mutex>
 #include <fstream>
+#include <random>
+#include <cstdio>
+#include <set>
 #include "FAST/Config.hpp"
 
 #if defined(__APPLE__) || defined(__MACOSX)
@@ -122,8 +126,6 @@ OpenCLDevice::OpenCLDevice() {
 }
 
 
-std::mutex buildBinaryMutex; // a global mutex
-
 bool OpenCLDevice::isImageFormatSupported(cl_channel_order order, cl_channel_type type, cl_mem_object_type imageType) {
     std::vector<cl::ImageFormat> formats;
     context.getSupportedImageFormats(CL_MEM_READ_WRITE, imageType, &formats);
@@ -214,8 +216,9 @@ OpenCLDevice::OpenCLDevice(std::vector<cl::Device> devices, unsigned long* OpenG
     delete[] cps;
 
     // Create a command queue for each device
+    // The tracer needs profiling info to place OpenCL commands on its timeline
     for(int i = 0; i < devices.size(); i++) {
-        if(profilingEnabled) {
+        if(profilingEnabled || Tracer::isEnabled()) {
             this->queues.push_back(cl::CommandQueue(context, devices[i], CL_QUEUE_PROFILING_ENABLE));
         } else {
             this->queues.push_back(cl::CommandQueue(context, devices[i]));
@@ -223,57 +226,45 @@ OpenCLDevice::OpenCLDevice(std::vector<cl::Device> devices, unsigned long* OpenG
     }
 }
 
-int OpenCLDevice::createProgramFromSource(std::string filename, std::string buildOptions, bool useCaching) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
-    cl::Program program;
-    if(useCaching) {
-        program = buildProgramFromBinary(filename, buildOptions);
-    } else {
-        std::string sourceCode = readFile(filename);
-        // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
-        if(isWritingTo3DTexturesSupported())
-            sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
-        cl::Program::Sources source(1, std::make_pair(sourceCode.c_str(), sourceCode.length()));
-        program = buildSources(source, buildOptions);
-    }
+static std::string add3DImageWritesPragma(std::string sourceCode) {
+    return "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
+}
+
+int OpenCLDevice::addProgram(cl::Program program) {
+    std::lock_guard<std::mutex> lock(m_programMutex);
     programs.push_back(program);
     return programs.size()-1;
 }
 
+int OpenCLDevice::createProgramFromSource(std::string filename, std::string buildOptions, bool useCaching) {
+    std::string sourceCode = readFile(filename);
+    // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
+    if(isWritingTo3DTexturesSupported())
+        sourceCode = add3DImageWritesPragma(sourceCode);
+    return addProgram(buildProgram({sourceCode}, buildOptions, useCaching, {filename}));
+}
+
 /**
  * Compile several source files together
  */
 int OpenCLDevice::createProgramFromSource(std::vector<std::string> filenames, std::string buildOptions) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
-    // Do this in a weird way, because the the logical way does not work.
-    std::string sourceCode = readFile(filenames[0]);
-    if(isWritingTo3DTexturesSupported())
-        sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
-    cl::Program::Sources sources(filenames.size(), std::make_pair(sourceCode.c_str(), sourceCode.length()));
-    for(int i = 1; i < filenames.size(); i++) {
-        std::string sourceCode2 = readFile(filenames[i]);
+    std::vector<std::string> sourceCodes;
+    for(const auto& filename : filenames) {
+        std::string sourceCode = readFile(filename);
         // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
         if(isWritingTo3DTexturesSupported())
-            sourceCode2 = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode2;
-        sources[i] = std::make_pair(sourceCode2.c_str(), sourceCode2.length());
+            sourceCode = add3DImageWritesPragma(sourceCode);
+        sourceCodes.push_back(sourceCode);
     }
-
-    cl::Program program = buildSources(sources, buildOptions);
-    programs.push_back(program);
-    return programs.size()-1;
+    return addProgram(buildProgram(sourceCodes, buildOptions, true, filenames));
 }
 
 int OpenCLDevice::createProgramFromString(std::string code, std::string buildOptions) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
-    cl::Program::Sources source(1, std::make_pair(code.c_str(), code.length()));
-
-    cl::Program program = buildSources(source, buildOptions);
-    programs.push_back(program);
-    return programs.size()-1;
+    return addProgram(buildProgram({code}, buildOptions, true));
 }
 
 cl::Program OpenCLDevice::getProgram(unsigned int i) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    std::lock_guard<std::mutex> lock(m_programMutex);
     return programs.at(i);
 }
 
@@ -324,155 +315,207 @@ RuntimeMeasurementsManager::pointer OpenCLDevice::getRunTimeMeasurementManager()
 }
 
 
-cl::Program OpenCLDevice::writeBinary(std::string filename, std::string buildOptions) {
-    // Build program from source file and store the binary file
-    std::string sourceCode = readFile(filename);
-    // If 3d image writes is supported, append the enable line to all source files (fix error on Intel devices)
-    if(isWritingTo3DTexturesSupported())
-        sourceCode = "#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n\n" + sourceCode;
-
-    cl::Program::Sources source(1, std::make_pair(sourceCode.c_str(), sourceCode.length()));
-    cl::Program program = buildSources(source, buildOptions);
-
-    std::vector<std::size_t> binarySizes;
-    binarySizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
-
-    std::vector<std::vector<uchar>> binaries;
-    binaries = program.getInfo<CL_PROGRAM_BINARIES>();
-
-    std::string deviceName = getDevice(0).getInfo<CL_DEVICE_NAME>();
-    std::size_t hash = std::hash<std::string>{}(buildOptions + deviceName);
-    std::string binaryPath = Config::getKernelBinaryPath();
-    // TODO fix this for both install and build
-    std::string kernelSourcePath = Config::getKernelSourcePath();
-    std::string binaryFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".bin";
-    std::string cacheFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".cache";
-
-    // Create directories if they don't exist
-    if(binaryFilename.rfind("/") != std::string::npos) {
-        std::string directoryPath = binaryFilename.substr(0, binaryFilename.rfind("/"));
-//        QDir dir(directoryPath.c_str());
-//        if (!dir.exists()) {
-//            dir.mkpath(".");
-//        }
-        createDirectories(directoryPath);
+// 64 bit FNV-1a hash. std::hash is not used since the cache key must be equal for all processes and builds.
+static uint64_t hashFNV1a(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+    for(unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
     }
-    FILE * file = fopen(binaryFilename.c_str(), "wb");
-    if(!file)
-        throw Exception("Could not write kernel binary to file: " + binaryFilename);
-    fwrite(binaries[0].data(), sizeof(char), (int)binarySizes[0], file);
-    fclose(file);
-
-    // Write cache file
-    FILE * cacheFile = fopen(cacheFilename.c_str(), "w");
-    auto modifiedDate = getModifiedDate(filename);
-    std::string timeStr = modifiedDate + "\n";
-    std::vector<cl::Device> devices = context.getInfo<CL_CONTEXT_DEVICES>();
-    timeStr += devices[0].getInfo<CL_DEVICE_NAME>() + "\n";
-    timeStr += buildOptions;
-    fwrite(timeStr.c_str(), sizeof(char), timeStr.size(), cacheFile);
-    fclose(cacheFile);
+    return hash;
+}
 
-    return program;
+std::string OpenCLDevice::getProgramCacheKey(const std::vector<std::string>& sourceCodes, const std::string& buildOptions) {
+    // Program binaries are only valid for the same device and driver
+    cl::Device device = getDevice(0);
+    std::string key = device.getInfo<CL_DEVICE_NAME>() + "\n" +
+            device.getInfo<CL_DEVICE_VERSION>() + "\n" +
+            device.getInfo<CL_DRIVER_VERSION>() + "\n" +
+            platform.getInfo<CL_PLATFORM_VERSION>() + "\n" +
+            buildOptions + "\n";
+    for(const auto& sourceCode : sourceCodes)
+        key += std::to_string(sourceCode.size()) + "\n" + sourceCode;
+
+    // Combine two hashes with different seeds to make collisions very unlikely
+    std::stringstream stream;
+    stream << std::hex << hashFNV1a(key) << "_" << hashFNV1a(key, 1469598103934665603ull);
+    return stream.str();
 }
 
-cl::Program OpenCLDevice::readBinary(std::string filename) {
-    std::ifstream sourceFile(filename.c_str(), std::ios_base::binary | std::ios_base::in);
-    std::string sourceCode(
-        std::istreambuf_iterator<char>(sourceFile),
-        (std::istreambuf_iterator<char>()));
-    cl::Program::Binaries binary(1, std::make_pair(sourceCode.c_str(), sourceCode.length()));
-
-    std::vector<cl::Device> devices = context.getInfo<CL_CONTEXT_DEVICES>();
-    if(devices.size() > 1) {
-        // Currently only support compiling for one device
-        cl::Device device = devices[0];
-        devices.clear();
-        devices.push_back(device);
+cl::Program OpenCLDevice::buildProgram(const std::vector<std::string>& sourceCodes, const std::string& buildOptions, bool useCaching, const std::vector<std::string>& filenames) {
+    cl::Program::Sources sources;
+    for(const auto& sourceCode : sourceCodes)
+        sources.push_back(std::make_pair(sourceCode.c_str(), sourceCode.length()));
+    if(!useCaching)
+        return buildSources(sources, buildOptions);
+
+    const std::string key = getProgramCacheKey(sourceCodes, buildOptions);
+
+    // If another thread is already building the same program, wait for it instead of building it again.
+    // Different programs are built in parallel.
+    std::promise<cl::Program> promise;
+    {
+        std::unique_lock<std::mutex> lock(m_programCacheMutex);
+        auto it = m_programCache.find(key);
+        if(it != m_programCache.end()) {
+            auto future = it->second;
+            lock.unlock();
+            return future.get();
+        }
+        m_programCache[key] = promise.get_future().share();
     }
 
-    cl::Program program = cl::Program(context, devices, binary);
-
-    // Build program for these specific devices
-    program.build(devices);
-    return program;
+    try {
+        const std::string binaryFilename = join(Config::getKernelBinaryPath(), "programs", key + ".bin");
+        cl::Program program;
+        if(fileExists(binaryFilename))
+            program = readBinary(binaryFilename);
+        if(!program()) {
+            reportInfo() << "Kernel binary " << key << " not found in cache. Compiling..." << reportEnd();
+            program = buildSources(sources, buildOptions);
+            writeBinary(program, binaryFilename);
+            if(!filenames.empty())
+                recordProgramBuild(filenames, buildOptions);
+        }
+        promise.set_value(program);
+        return program;
+    } catch(...) {
+        // Remove failed build from cache, so that it is possible to try again
+        {
+            std::lock_guard<std::mutex> lock(m_programCacheMutex);
+            m_programCache.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
 }
 
-cl::Program OpenCLDevice::buildProgramFromBinary(std::string filename, std::string buildOptions) {
-    cl::Program program;
+// Each line is the build options followed by the source filenames, separated by tabs
+static std::string getProgramBuildsFilename() {
+    return join(Config::getKernelBinaryPath(), "programs", "builds.txt");
+}
 
-    std::string deviceName = getDevice(0).getInfo<CL_DEVICE_NAME>();
-    std::size_t hash = std::hash<std::string>{}(buildOptions + deviceName);
-    std::string binaryPath = Config::getKernelBinaryPath();
-    std::string kernelSourcePath = Config::getKernelSourcePath();
-    std::string binaryFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".bin";
-    std::string cacheFilename = binaryPath + filename.substr(kernelSourcePath.size()) + "_" + std::to_string(hash) + ".cache";
+void OpenCLDevice::recordProgramBuild(const std::vector<std::string>& filenames, const std::string& buildOptions) {
+    std::string line = buildOptions;
+    for(const auto& filename : filenames)
+        line += "\t" + filename;
+    line += "\n";
+    // Append the entire line with one write, so that lines from several threads and processes are not mixed
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    FILE * file = fopen(getProgramBuildsFilename().c_str(), "ab");
+    if(!file) {
+        reportWarning() << "Could not record kernel build in " << getProgramBuildsFilename() << reportEnd();
+        return;
+    }
+    fwrite(line.c_str(), sizeof(char), line.size(), file);
+    fclose(file);
+}
 
-    // Check if a binary file exists
-    std::ifstream binaryFile(binaryFilename.c_str(), std::ios_base::binary | std::ios_base::in);
-    if(binaryFile.fail()) {
-        program = writeBinary(filename, buildOptions);
-    } else {
-        // Compare modified dates of binary file and source file
-
-        // Read cache file
-        std::ifstream cacheFile(cacheFilename.c_str());
-        std::string cache(
-            std::istreambuf_iterator<char>(cacheFile),
-            (std::istreambuf_iterator<char>()));
-        auto lines = split(cache, "\n");
-
-        bool outOfDate = true;
-        bool wrongDeviceID = true;
-        bool buildOptionsChanged = true;
-        if(lines.size() >= 2) {
-            // Get modification date of file
-            auto modifiedDate = getModifiedDate(filename);
-            outOfDate = modifiedDate != lines[0];
-            std::vector<cl::Device> devices = context.getInfo<CL_CONTEXT_DEVICES>();
-            wrongDeviceID = lines[1] != devices[0].getInfo<CL_DEVICE_NAME>();
-            if(lines.size() == 3)
-                buildOptionsChanged = lines[2] != buildOptions;
+std::vector<std::pair<std::vector<std::string>, std::string>> OpenCLDevice::getCachedProgramBuilds() {
+    std::vector<std::pair<std::vector<std::string>, std::string>> builds;
+    std::set<std::string> lines; // The same build is recorded again if the cache is invalidated
+    std::ifstream file(getProgramBuildsFilename());
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.empty() || !lines.insert(line).second)
+            continue;
+        std::vector<std::string> parts;
+        std::size_t start = 0;
+        while(true) {
+            const std::size_t end = line.find('\t', start);
+            parts.push_back(line.substr(start, end - start));
+            if(end == std::string::npos)
+                break;
+            start = end + 1;
         }
+        if(parts.size() < 2)
+            continue;
+        builds.push_back({std::vector<std::string>(parts.begin() + 1, parts.end()), parts[0]});
+    }
+    return builds;
+}
 
-        if(outOfDate || wrongDeviceID || buildOptionsChanged) {
-            Reporter::warning() << "Kernel binary " << filename.substr(kernelSourcePath.size()) << " is out of date. Compiling..." << Reporter::end();
-            program = writeBinary(filename, buildOptions);
-        } else {
-            //std::cout << "Binary is not out of date." << std::endl;
-            program = readBinary(binaryFilename);
-        }
+void OpenCLDevice::writeBinary(cl::Program program, std::string filename) {
+    std::vector<std::vector<uchar>> binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+    if(binaries.empty() || binaries[0].empty()) {
+        reportWarning() << "OpenCL platform did not provide a program binary, unable to cache kernel." << reportEnd();
+        return;
     }
 
-    return program;
+    createDirectories(filename.substr(0, filename.rfind("/")));
+    // Write to a temporary file which is renamed when complete. Rename is atomic, thus other processes
+    // will never read a partially written binary.
+    std::stringstream tempFilename;
+    tempFilename << filename << "." << std::hex << std::random_device()() << std::random_device()() << ".tmp";
+    FILE * file = fopen(tempFilename.str().c_str(), "wb");
+    if(!file) {
+        reportWarning() << "Could not write kernel binary to file: " << tempFilename.str() << reportEnd();
+        return;
+    }
+    const bool success = fwrite(binaries[0].data(), sizeof(char), binaries[0].size(), file) == binaries[0].size();
+    fclose(file);
+    if(!success || std::rename(tempFilename.str().c_str(), filename.c_str()) != 0) {
+        // Rename will fail on windows if another process created the binary in the mean time, which is OK.
+        std::remove(tempFilename.str().c_str());
+    }
+}
+
+cl::Program OpenCLDevice::readBinary(std::string filename) {
+    std::ifstream binaryFile(filename.c_str(), std::ios_base::binary | std::ios_base::in);
+    std::string binaryData(
+        std::istreambuf_iterator<char>(binaryFile),
+        (std::istreambuf_iterator<char>()));
+    if(binaryData.empty())
+        return cl::Program();
+    cl::Program::Binaries binary(1, std::make_pair(binaryData.c_str(), binaryData.length()));
+
+    // Currently only support compiling for one device
+    std::vector<cl::Device> devices = {getDevice(0)};
+
+    try {
+        cl::Program program = cl::Program(context, devices, binary);
+        // Build program for these specific devices
+        program.build(devices);
+        return program;
+    } catch(cl::Error &error) {
+        // Binary may be invalid, e.g. if the driver was updated without changing the version string
+        reportWarning() << "Failed to load kernel binary " << filename << ", compiling from source instead." << reportEnd();
+        return cl::Program();
+    }
 }
 
 int OpenCLDevice::createProgramFromSourceWithName(
         std::string programName,
         std::string filename,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromSource(filename,buildOptions);
-    return programNames[programName];
+    const int index = createProgramFromSource(filename,buildOptions);
+    std::lock_guard<std::mutex> lock(m_programMutex);
+    programNames[programName] = index;
+    return index;
 }
 
 int OpenCLDevice::createProgramFromSourceWithName(
         std::string programName,
         std::vector<std::string> filenames,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromSource(filenames,buildOptions);
-    return programNames[programName];
+    const int index = createProgramFromSource(filenames,buildOptions);
+    std::lock_guard<std::mutex> lock(m_programMutex);
+    programNames[programName] = index;
+    return index;
 }
 
 int OpenCLDevice::createProgramFromStringWithName(
         std::string programName,
         std::string code,
         std::string buildOptions) {
-    programNames[programName] = createProgramFromString(code,buildOptions);
-    return programNames[programName];
+    const int index = createProgramFromString(code,buildOptions);
+    std::lock_guard<std::mutex> lock(m_programMutex);
+    programNames[programName] = index;
+    return index;
 }
 
 cl::Program OpenCLDevice::getProgram(std::string name) {
-    std::lock_guard<std::mutex> lock(buildBinaryMutex);
+    std::lock_guard<std::mutex> lock(m_programMutex);
     if(programNames.count(name) == 0) {
         std::string msg ="Could not find OpenCL program with the name" + name;
         throw Exception(msg.c_str(), __LINE__, __FILE__);
@@ -485,6 +528,7 @@ cl::Program OpenCLDevice::getProgram(std::string name) {
 }
 
 bool OpenCLDevice::hasProgram(std::string name) {
+    std::lock_guard<std::mutex> lock(m_programMutex);
     return programNames.count(name) > 0;
 }
 
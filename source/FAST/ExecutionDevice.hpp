@@ -2,6 +2,9 @@
 
 #include "FAST/Object.hpp"
 #include "RuntimeMeasurementManager.hpp"
+#include <future>
+#include <mutex>
+#include <unordered_map>
 
 namespace fast {
 
@@ -101,19 +104,37 @@ class FAST_EXPORT  OpenCLDevice : public ExecutionDevice {
         OpenCLPlatformVendor getPlatformVendor();
         bool isWritingTo3DTexturesSupported();
         RuntimeMeasurementsManager::pointer getRunTimeMeasurementManager();
+        /**
+         * Get the source files and build options of all programs which have been compiled from source files
+         * and stored in the kernel binary cache. Used to warm up the cache with the same build options as
+         * the process objects, for instance after a driver update.
+         * @return list of source filenames and build options
+         */
+        static std::vector<std::pair<std::vector<std::string>, std::string>> getCachedProgramBuilds();
         ~OpenCLDevice();
     private:
         OpenCLDevice();
         unsigned long * mGLContext;
-        cl::Program writeBinary(std::string filename, std::string buildOptions);
+        int addProgram(cl::Program program);
+        /**
+         * Build program from source code. If caching is enabled, the program binary is cached in memory and on disk
+         * in the kernel binary path. The cache key is a hash of the source code, build options and device/driver version.
+         * If filenames are given, they are recorded together with the build options when the program is compiled.
+         */
+        cl::Program buildProgram(const std::vector<std::string>& sourceCodes, const std::string& buildOptions, bool useCaching, const std::vector<std::string>& filenames = {});
+        void recordProgramBuild(const std::vector<std::string>& filenames, const std::string& buildOptions);
+        std::string getProgramCacheKey(const std::vector<std::string>& sourceCodes, const std::string& buildOptions);
+        void writeBinary(cl::Program program, std::string filename);
         cl::Program readBinary(std::string filename);
-        cl::Program buildProgramFromBinary(std::string filename, std::string buildOptions);
         cl::Program buildSources(cl::Program::Sources source, std::string buildOptions);
 
         cl::Context context;
         std::vector<cl::CommandQueue> queues;
         std::map<std::string, int> programNames;
         std::vector<cl::Program> programs;
+        std::mutex m_programMutex; // Protects programs and programNames
+        std::unordered_map<std::string, std::shared_future<cl::Program>> m_programCache;
+        std::mutex m_programCacheMutex;
         std::vector<cl::Device> devices;
         cl::Platform platform;
 
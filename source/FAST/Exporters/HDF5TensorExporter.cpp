@@ -42,7 +42,7 @@ void HDF5TensorExporter::execute() {
 	for(int i = 0; i < shape.getDimensions(); ++i)
 		h5shape.push_back(shape[i]);
 	H5::DataSpace memspace(shape.getDimensions(), h5shape.data());
-	auto tensorAccess = tensor->getAccess(ACCESS_READ);
+	auto tensorAccess = tensor->convertToType(TYPE_FLOAT)->getAccess(ACCESS_READ);
 	auto dataset = file.createDataSet(m_datasetName.c_str(), H5::PredType::NATIVE_FLOAT, memspace);
 	dataset.write(tensorAccess->getRawData(), H5::PredType::NATIVE_FLOAT, memspace, memspace);
 	{
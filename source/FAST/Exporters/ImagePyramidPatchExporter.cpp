@@ -47,12 +47,12 @@ void ImagePyramidPatchExporter::execute() {
 
 void ImagePyramidPatchExporter::exportPatch(std::shared_ptr<Image> patch) {
     auto level = patch->getFrameData("patch-level");
-    auto patchX = std::stoi(patch->getFrameData("patchid-x"));
-    auto patchY = std::stoi(patch->getFrameData("patchid-y"));
-    auto patchWidth = std::stoi(patch->getFrameData("patch-width"));
-    auto patchHeight = std::stoi(patch->getFrameData("patch-height"));
-    auto patchOverlapX = std::stoi(patch->getFrameData("patch-overlap-x"));
-    auto patchOverlapY = std::stoi(patch->getFrameData("patch-overlap-y"));
+    auto patchX = patch->getFrameData<int>("patchid-x");
+    auto patchY = patch->getFrameData<int>("patchid-y");
+    auto patchWidth = patch->getFrameData<int>("patch-width");
+    auto patchHeight = patch->getFrameData<int>("patch-height");
+    auto patchOverlapX = patch->getFrameData<int>("patch-overlap-x");
+    auto patchOverlapY = patch->getFrameData<int>("patch-overlap-y");
     auto spacingX = patch->getFrameData("patch-spacing-x");
     auto spacingY = patch->getFrameData("patch-spacing-y");
     auto totalWidth = patch->getFrameData("original-width");
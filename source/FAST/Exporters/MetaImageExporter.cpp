@@ -1,5 +1,6 @@
 #include "MetaImageExporter.hpp"
 #include "FAST/Data/Image.hpp"
+#include "FAST/ThreadPool.hpp"
 #include <fstream>
 #include <zlib/zlib.h>
 
@@ -9,15 +10,17 @@ MetaImageExporter::MetaImageExporter() : FileExporter() {
     createInputPort<Image>(0);
     mIsModified = true;
     mUseCompression = false;
+    mCompressionBlockSize = 0;
 }
 
 MetaImageExporter::MetaImageExporter(std::string filename, bool compress) : FileExporter(filename) {
     createInputPort<Image>(0);
+    mCompressionBlockSize = 0;
     setCompression(compress);
 }
 
 template <class T>
-inline std::size_t writeToRawFile(std::string filename, T * data, unsigned int numberOfElements, bool useCompression) {
+inline std::size_t writeToRawFile(std::string filename, T * data, std::size_t numberOfElements, bool useCompression) {
     // TODO use mapped_file_sink form boost instead
     FILE* file = fopen(filename.c_str(), "wb");
     if(file == NULL) {
@@ -60,6 +63,66 @@ inline std::size_t writeToRawFile(std::string filename, T * data, unsigned int n
     return returnSize;
 }
 
+/**
+ * Compress blocks of data independently and in parallel, and write them as a single zlib stream.
+ * Each block is a raw deflate block which ends on a byte boundary, thus readers can inflate the blocks independently
+ * given the offset of each block, while other readers can read the file as a normal zlib stream.
+ */
+static std::size_t writeBlockCompressedRawFile(std::string filename, const Bytef* data, std::size_t size, std::size_t blockSize, std::vector<std::size_t>& blockOffsets) {
+    const int blocks = std::max<std::size_t>(1, (size + blockSize - 1) / blockSize);
+    std::vector<std::vector<Bytef>> compressedBlocks(blocks);
+    std::vector<uLong> checksums(blocks);
+    ThreadPool::getInstance()->parallelFor(0, blocks, [&](int begin, int end) {
+        for(int i = begin; i < end; ++i) {
+            const std::size_t offset = i*blockSize;
+            const std::size_t length = std::min(blockSize, size - offset);
+            const bool last = i == blocks-1;
+            z_stream stream = {};
+            if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw Exception("Failed to initialize zlib while compressing raw file");
+            auto& block = compressedBlocks[i];
+            block.resize(deflateBound(&stream, length) + 16); // Extra space for full flush marker
+            stream.next_in = (Bytef*)data + offset;
+            stream.avail_in = (uInt)length;
+            stream.next_out = block.data();
+            stream.avail_out = (uInt)block.size();
+            // Full flush ends the block on a byte boundary, and removes any references to previous data
+            const int result = deflate(&stream, last ? Z_FINISH : Z_FULL_FLUSH);
+            const bool success = (last ? result == Z_STREAM_END : result == Z_OK) && stream.avail_in == 0 && stream.avail_out > 0;
+            block.resize(stream.total_out);
+            deflateEnd(&stream);
+            if(!success)
+                throw Exception("Error while compressing raw file");
+            checksums[i] = adler32(adler32(0, Z_NULL, 0), data + offset, (uInt)length);
+        }
+    }, 1);
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if(file == NULL) {
+        throw Exception("Could not open file " + filename + " for writing");
+    }
+    const Bytef header[2] = {0x78, 0x9C}; // zlib header, deflate with 32K window and default compression
+    fwrite(header, 1, 2, file);
+    std::size_t offset = 2;
+    uLong checksum = checksums[0];
+    blockOffsets.clear();
+    for(int i = 0; i < blocks; ++i) {
+        blockOffsets.push_back(offset);
+        fwrite(compressedBlocks[i].data(), 1, compressedBlocks[i].size(), file);
+        offset += compressedBlocks[i].size();
+        if(i > 0)
+            checksum = adler32_combine(checksum, checksums[i], std::min(blockSize, size - i*blockSize));
+    }
+    const Bytef trailer[4] = {(Bytef)(checksum >> 24), (Bytef)(checksum >> 16), (Bytef)(checksum >> 8), (Bytef)checksum};
+    fwrite(trailer, 1, 4, file);
+    const bool error = ferror(file) != 0;
+    fclose(file);
+    if(error)
+        throw Exception("Error while writing to " + filename);
+
+    return offset + 4;
+}
+
 void MetaImageExporter::execute() {
     if(m_filename == "")
         throw Exception("No filename was given to the MetaImageExporter");
@@ -112,38 +175,53 @@ void MetaImageExporter::execute() {
         extension = ".zraw";
     }
     std::string rawFilename = m_filename.substr(0,m_filename.length()-4) + extension;
-    const unsigned int numberOfElements = input->getWidth()*input->getHeight()*
+    const std::size_t numberOfElements = (std::size_t)input->getWidth()*input->getHeight()*
             input->getDepth()*input->getNrOfChannels();
 
     ImageAccess::pointer access = input->getImageAccess(ACCESS_READ);
     void* data = access->get();
-    std::size_t compressedSize;
     switch(input->getDataType()) {
     case TYPE_FLOAT:
         mhdFile << "ElementType = MET_FLOAT\n";
-        compressedSize = writeToRawFile<float>(rawFilename,(float*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_UINT8:
         mhdFile << "ElementType = MET_UCHAR\n";
-        compressedSize = writeToRawFile<uchar>(rawFilename,(uchar*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_INT8:
         mhdFile << "ElementType = MET_CHAR\n";
-        compressedSize = writeToRawFile<char>(rawFilename,(char*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_UINT16:
         mhdFile << "ElementType = MET_USHORT\n";
-        compressedSize = writeToRawFile<ushort>(rawFilename,(ushort*)data,numberOfElements,mUseCompression);
         break;
     case TYPE_INT16:
         mhdFile << "ElementType = MET_SHORT\n";
-        compressedSize = writeToRawFile<short>(rawFilename,(short*)data,numberOfElements,mUseCompression);
         break;
+    case TYPE_UINT32:
+        mhdFile << "ElementType = MET_UINT\n";
+        break;
+    case TYPE_INT32:
+        mhdFile << "ElementType = MET_INT\n";
+        break;
+    }
+    const std::size_t bytes = numberOfElements*getSizeOfDataType(input->getDataType(), 1);
+    std::size_t compressedSize;
+    std::vector<std::size_t> blockOffsets;
+    if(mUseCompression && mCompressionBlockSize > 0) {
+        compressedSize = writeBlockCompressedRawFile(rawFilename, (const Bytef*)data, bytes, mCompressionBlockSize, blockOffsets);
+    } else {
+        compressedSize = writeToRawFile<uchar>(rawFilename, (uchar*)data, bytes, mUseCompression);
     }
 
     if(mUseCompression) {
         mhdFile << "CompressedData = True" << "\n";
         mhdFile << "CompressedDataSize = " << compressedSize << "\n";
+        if(!blockOffsets.empty()) {
+            mhdFile << "CompressedDataBlockSize = " << mCompressionBlockSize << "\n";
+            mhdFile << "CompressedDataBlockOffsets =";
+            for(auto blockOffset : blockOffsets)
+                mhdFile << " " << blockOffset;
+            mhdFile << "\n";
+        }
     }
 
     // Add metadata
@@ -181,6 +259,13 @@ void MetaImageExporter::setCompression(bool compress) {
     mIsModified = true;
 }
 
+void MetaImageExporter::setCompressionBlockSize(uint64_t blockSize) {
+    if(blockSize > 1024*1024*1024)
+        throw Exception("Compression block size in MetaImageExporter must be less than 1 GB");
+    mCompressionBlockSize = blockSize;
+    mIsModified = true;
+}
+
 void MetaImageExporter::setMetadata(std::string key, std::string value) {
     mMetadata[key] = value;
 }
@@ -10,7 +10,7 @@ namespace fast {
  *
  * This exporter writes 2D and 3D images using the MetaImage format which are pairs of .mhd text files and .raw files
  * containing raw pixel data.
- * Supports compression (.zraw) using the zlib library.
+ * Supports compression (.zraw) using the zlib library, optionally in blocks which are compressed in parallel.
  * All meta data in the Image is stored in the .mhd text file.
  *
  * <h3>Input ports</h3>
@@ -30,6 +30,14 @@ class FAST_EXPORT MetaImageExporter : public FileExporter {
          * @param compress
          */
         void setCompression(bool compress);
+        /**
+         * Compress data in independent blocks of the given size. The blocks are compressed in parallel, and
+         * the MetaImageImporter will also decompress them in parallel. The file is still a normal zlib stream,
+         * thus other MetaImage readers can read it as well. Only used if compression is enabled.
+         *
+         * @param blockSize Uncompressed size of each block in bytes. 0 compresses everything as one block, which is the default.
+         */
+        void setCompressionBlockSize(uint64_t blockSize);
         /**
          * Deprecated
          */
@@ -52,6 +60,7 @@ class FAST_EXPORT MetaImageExporter : public FileExporter {
 
         std::map<std::string, std::string> mMetadata;
         bool mUseCompression;
+        uint64_t mCompressionBlockSize;
 };
 
 } // end namespace fast
\ No newline at end of file
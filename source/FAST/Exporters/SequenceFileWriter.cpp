@@ -0,0 +1,191 @@
+#include "SequenceFileWriter.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/SceneGraph.hpp>
+#include <zlib/zlib.h>
+#include <limits>
+
+namespace fast {
+
+SequenceFileWriter::SequenceFileWriter(std::string filename, bool compress, int maximumQueueSize, bool dropFramesWhenFull) {
+    if(maximumQueueSize <= 0)
+        throw Exception("Maximum queue size must be > 0 in SequenceFileWriter");
+    m_filename = filename;
+    m_compress = compress;
+    m_maximumQueueSize = maximumQueueSize;
+    m_dropFramesWhenFull = dropFramesWhenFull;
+    m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!m_file.is_open())
+        throw Exception("Could not open file " + filename + " for writing");
+
+    // Header is rewritten with frame count and index offset when closing
+    SequenceFile::FileHeader header = {};
+    std::memcpy(header.magic, SequenceFile::magic, sizeof(SequenceFile::magic));
+    header.version = SequenceFile::version;
+    m_file.write((const char*)&header, sizeof(header));
+    m_offset = sizeof(header);
+
+    m_thread = std::thread(&SequenceFileWriter::writerLoop, this);
+}
+
+bool SequenceFileWriter::write(std::shared_ptr<Image> image) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(m_closed)
+        throw Exception("SequenceFileWriter for " + m_filename + " is closed");
+    if(m_error)
+        std::rethrow_exception(m_error);
+    if((int)m_queue.size() >= m_maximumQueueSize) {
+        if(m_dropFramesWhenFull) {
+            ++m_droppedFrames;
+            return false;
+        }
+        m_frameWritten.wait(lock, [this] { return (int)m_queue.size() < m_maximumQueueSize || m_error; });
+        if(m_error)
+            std::rethrow_exception(m_error);
+    }
+    m_queue.push_back(image);
+    lock.unlock();
+    m_frameQueued.notify_one();
+    return true;
+}
+
+void SequenceFileWriter::writerLoop() {
+    while(true) {
+        std::shared_ptr<Image> image;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameQueued.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+            if(m_queue.empty()) // Stopped and all frames written
+                return;
+            image = m_queue.front();
+        }
+        try {
+            writeFrame(image);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::current_exception();
+            m_queue.clear();
+        }
+        {
+            // Frame is removed from queue after it has been written, so that queue size includes frame being written
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!m_queue.empty())
+                m_queue.pop_front();
+        }
+        m_frameWritten.notify_all();
+    }
+}
+
+void SequenceFileWriter::writeFrame(std::shared_ptr<Image> image) {
+    SequenceFile::FrameHeader header = {};
+    header.magic = SequenceFile::frameMagic;
+    header.dataType = image->getDataType();
+    header.nrOfChannels = image->getNrOfChannels();
+    header.width = image->getWidth();
+    header.height = image->getHeight();
+    header.depth = image->getDepth();
+    header.dimensions = image->getDimensions();
+    const Vector3f spacing = image->getSpacing();
+    for(int i = 0; i < 3; ++i)
+        header.spacing[i] = spacing[i];
+    const Matrix4f transform = SceneGraph::getEigenTransformFromData(image).matrix();
+    std::memcpy(header.transform, transform.data(), sizeof(header.transform));
+    header.timestamp = image->getCreationTimestamp();
+    header.rawSize = (uint64_t)image->getNrOfVoxels()*getSizeOfDataType(image->getDataType(), image->getNrOfChannels());
+
+    auto access = image->getImageAccess(ACCESS_READ);
+    const char* data = (const char*)access->get();
+    std::unique_ptr<Bytef[]> compressed;
+    if(m_compress) {
+        // uLong is only 32 bit on Windows, thus zlib can't compress frames which are larger than ~4 GB in one call
+        if(header.rawSize > std::numeric_limits<uLong>::max() || header.rawSize + (header.rawSize >> 11) + 13 > std::numeric_limits<uLong>::max())
+            throw Exception("Frame of " + std::to_string(header.rawSize) + " bytes is too large to be compressed in SequenceFileWriter");
+        uLongf compressedSize = compressBound((uLong)header.rawSize);
+        compressed = std::make_unique<Bytef[]>(compressedSize);
+        // Use fastest compression level, as this runs while recording
+        if(compress2(compressed.get(), &compressedSize, (const Bytef*)data, (uLong)header.rawSize, Z_BEST_SPEED) != Z_OK)
+            throw Exception("Failed to compress frame in SequenceFileWriter");
+        header.compression = (uint32_t)SequenceFile::Compression::Zlib;
+        header.dataSize = compressedSize;
+        data = (const char*)compressed.get();
+    } else {
+        header.compression = (uint32_t)SequenceFile::Compression::None;
+        header.dataSize = header.rawSize;
+    }
+    header.storedSize = SequenceFile::align(header.dataSize);
+
+    m_file.write((const char*)&header, sizeof(header));
+    m_file.write(data, header.dataSize);
+    static const char padding[SequenceFile::alignment] = {};
+    m_file.write(padding, header.storedSize - header.dataSize);
+    if(!m_file.good())
+        throw Exception("Failed to write frame to " + m_filename);
+    m_index.push_back({m_offset, header.timestamp});
+    m_offset += sizeof(header) + header.storedSize;
+    ++m_writtenFrames;
+    m_writtenBytes += sizeof(header) + header.storedSize;
+}
+
+void SequenceFileWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_closed)
+            return;
+        m_closed = true;
+        m_stop = true;
+    }
+    m_frameQueued.notify_one();
+    m_thread.join();
+
+    // Write index and update header
+    SequenceFile::FileHeader header = {};
+    std::memcpy(header.magic, SequenceFile::magic, sizeof(SequenceFile::magic));
+    header.version = SequenceFile::version;
+    header.frameCount = m_index.size();
+    header.indexOffset = m_offset;
+    m_file.write((const char*)m_index.data(), m_index.size()*sizeof(SequenceFile::IndexEntry));
+    m_file.seekp(0);
+    m_file.write((const char*)&header, sizeof(header));
+    m_file.close();
+    reportInfo() << "Closed sequence file " << m_filename << " with " << m_index.size() << " frames" << reportEnd();
+    throwIfError();
+}
+
+void SequenceFileWriter::throwIfError() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_error) {
+        auto error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+std::string SequenceFileWriter::getFilename() const {
+    return m_filename;
+}
+
+uint64_t SequenceFileWriter::getNrOfWrittenFrames() const {
+    return m_writtenFrames;
+}
+
+uint64_t SequenceFileWriter::getNrOfDroppedFrames() const {
+    return m_droppedFrames;
+}
+
+uint64_t SequenceFileWriter::getNrOfWrittenBytes() const {
+    return m_writtenBytes;
+}
+
+int SequenceFileWriter::getQueueSize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size();
+}
+
+SequenceFileWriter::~SequenceFileWriter() {
+    try {
+        close();
+    } catch(std::exception& e) {
+        reportError() << "Error while closing sequence file: " << e.what() << reportEnd();
+    }
+}
+
+}
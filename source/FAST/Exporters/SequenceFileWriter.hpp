@@ -0,0 +1,78 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <FAST/Data/SequenceFile.hpp>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <condition_variable>
+
+namespace fast {
+
+class Image;
+
+/**
+ * @brief Writes images to a sequence file in a background thread
+ *
+ * Images given to write() are put in a bounded queue, and a background thread appends them to a
+ * single sequence file, optionally compressed with zlib. See SequenceFile for the file layout.
+ * When the queue is full, write() either blocks until there is room (backpressure), or drops the frame.
+ *
+ * Images are kept in the queue until they are written, thus they should not be modified after being given to write().
+ *
+ * @sa StreamToFileExporter SequenceFile
+ */
+class FAST_EXPORT SequenceFileWriter : public Object {
+    public:
+        typedef std::shared_ptr<SequenceFileWriter> pointer;
+        /**
+         * @brief Create writer and open file
+         * @param filename
+         * @param compress Compress frames with zlib
+         * @param maximumQueueSize Max nr of frames waiting to be written
+         * @param dropFramesWhenFull If true, frames are dropped when the queue is full. If false, write() blocks.
+         */
+        SequenceFileWriter(std::string filename, bool compress = false, int maximumQueueSize = 16, bool dropFramesWhenFull = false);
+        /**
+         * @brief Queue image for writing
+         * @param image
+         * @return false if the frame was dropped because the queue was full
+         */
+        bool write(std::shared_ptr<Image> image);
+        /**
+         * @brief Write all queued frames and the index, and close the file.
+         * Errors which happened in the background thread are rethrown here, or in the next call to write().
+         */
+        void close();
+        std::string getFilename() const;
+        uint64_t getNrOfWrittenFrames() const;
+        uint64_t getNrOfDroppedFrames() const;
+        uint64_t getNrOfWrittenBytes() const;
+        int getQueueSize();
+        ~SequenceFileWriter() override;
+    private:
+        void writerLoop();
+        void writeFrame(std::shared_ptr<Image> image);
+        void throwIfError();
+
+        std::string m_filename;
+        bool m_compress;
+        int m_maximumQueueSize;
+        bool m_dropFramesWhenFull;
+        std::ofstream m_file;
+        uint64_t m_offset = 0;
+        std::vector<SequenceFile::IndexEntry> m_index;
+        std::deque<std::shared_ptr<Image>> m_queue;
+        std::mutex m_mutex;
+        std::condition_variable m_frameQueued;
+        std::condition_variable m_frameWritten;
+        std::thread m_thread;
+        bool m_stop = false;
+        bool m_closed = false;
+        std::exception_ptr m_error;
+        std::atomic<uint64_t> m_writtenFrames{0};
+        std::atomic<uint64_t> m_droppedFrames{0};
+        std::atomic<uint64_t> m_writtenBytes{0};
+};
+
+}
@@ -4,6 +4,7 @@
 #include "ImageFileExporter.hpp"
 #include "VTKMeshFileExporter.hpp"
 #include "MetaImageExporter.hpp"
+#include "SequenceFileWriter.hpp"
 #include <FAST/Utility.hpp>
 
 namespace fast {
@@ -58,10 +59,28 @@ void StreamToFileExporter::execute() {
     if(m_frameCounter >= m_frameLimit)
         throw Exception("Maximum nr of frames (" + std::to_string(m_frameLimit) + ") reached in StreamToFileExporter");
 
+    if(m_sequenceFileMode) {
+        auto imageInput = std::dynamic_pointer_cast<Image>(input);
+        if(!imageInput)
+            throw Exception("StreamToFileExporter can only handle Image data objects in sequence file mode");
+        if(!m_writer)
+            m_writer = std::make_shared<SequenceFileWriter>(join(m_path, m_currentFolder, m_filename + ".fastseq"), m_compress, m_maximumQueueSize, m_dropFramesWhenFull);
+        if(m_writer->write(imageInput))
+            m_frameCounter += 1;
+        *m_queueSizeCounter = m_writer->getQueueSize();
+        *m_droppedFramesCounter = m_writer->getNrOfDroppedFrames();
+        if(input->isLastFrame()) {
+            // Write index so that the file is complete
+            m_writer->close();
+        }
+        addOutputData(0, input);
+        return;
+    }
+
     std::string currentFileName = join(m_path, m_currentFolder, m_filename + "_" + std::to_string(m_frameCounter));
     if(auto imageInput = std::dynamic_pointer_cast<Image>(input)) {
         auto exporter = MetaImageExporter::New();
-        exporter->enableCompression();
+        exporter->setCompression(m_compress);
         exporter->setFilename(currentFileName + ".mhd");
         exporter->setInputData(input);
         exporter->update();
@@ -78,6 +97,10 @@ void StreamToFileExporter::execute() {
 }
 
 void StreamToFileExporter::reset() {
+    if(m_writer) {
+        m_writer->close();
+        m_writer.reset();
+    }
     m_frameCounter = 0;
     m_currentFolder = "";
     m_hasStarted = false;
@@ -86,6 +109,46 @@ void StreamToFileExporter::reset() {
 StreamToFileExporter::StreamToFileExporter() {
     createInputPort<DataObject>(0);
     createOutputPort<DataObject>(0);
+    m_queueSizeCounter = mRuntimeManager->getCounter("recording queue size");
+    m_droppedFramesCounter = mRuntimeManager->getCounter("recording dropped frames");
+}
+
+void StreamToFileExporter::setSequenceFileMode(bool sequenceFile) {
+    if(m_writer)
+        throw Exception("Can't change sequence file mode while recording in StreamToFileExporter");
+    m_sequenceFileMode = sequenceFile;
+}
+
+void StreamToFileExporter::setCompression(bool compress) {
+    m_compress = compress;
+}
+
+void StreamToFileExporter::setMaximumQueueSize(int size) {
+    if(size <= 0)
+        throw Exception("Maximum queue size must be > 0 in StreamToFileExporter");
+    m_maximumQueueSize = size;
+}
+
+void StreamToFileExporter::setDropFramesWhenFull(bool drop) {
+    m_dropFramesWhenFull = drop;
+}
+
+uint64_t StreamToFileExporter::getNrOfDroppedFrames() const {
+    if(!m_writer)
+        return (uint64_t)m_droppedFramesCounter->load();
+    return m_writer->getNrOfDroppedFrames();
+}
+
+int StreamToFileExporter::getQueueSize() const {
+    if(!m_writer)
+        return 0;
+    return m_writer->getQueueSize();
+}
+
+std::string StreamToFileExporter::getSequenceFilename() const {
+    if(!m_writer)
+        throw Exception("No sequence file has been created in StreamToFileExporter");
+    return m_writer->getFilename();
 }
 
 StreamToFileExporter::StreamToFileExporter(std::string path, std::string recordingFolderName) : StreamToFileExporter() {
@@ -5,9 +5,17 @@
 
 namespace fast {
 
+class SequenceFileWriter;
+
 /**
  * @brief Write a stream of Mesh or Image data as a sequence of files.
  *
+ * By default each frame is written to a separate file on the pipeline thread.
+ * With setSequenceFileMode, images are instead appended to a single sequence file (.fastseq) by a background thread,
+ * see SequenceFileWriter. Frames wait in a bounded queue; when it is full this process object either blocks or drops
+ * frames, see setDropFramesWhenFull. The runtime manager counters "recording queue size" and
+ * "recording dropped frames" show the state of the queue.
+ *
  * <h3>Input ports</h3>
  * - 0: Image or Mesh
  *
@@ -38,6 +46,35 @@ class FAST_EXPORT StreamToFileExporter : public ProcessObject {
         float getRecordingDuration() const;
         void reset();
         bool isEnabled();
+        /**
+         * @brief Write all images to a single sequence file in a background thread, instead of one file per frame.
+         * Only images are supported in this mode.
+         * @param sequenceFile
+         */
+        void setSequenceFileMode(bool sequenceFile);
+        /**
+         * @brief Compress frames with zlib. Default is true.
+         * @param compress
+         */
+        void setCompression(bool compress);
+        /**
+         * @brief Max nr of frames waiting to be written in sequence file mode. Default is 32.
+         * @param size
+         */
+        void setMaximumQueueSize(int size);
+        /**
+         * @brief If true, frames are dropped when the queue is full in sequence file mode.
+         * If false (default), this process object blocks until there is room in the queue.
+         * @param drop
+         */
+        void setDropFramesWhenFull(bool drop);
+        uint64_t getNrOfDroppedFrames() const;
+        int getQueueSize() const;
+        /**
+         * @brief Get filename of the current sequence file
+         * @return filename
+         */
+        std::string getSequenceFilename() const;
     private:
         StreamToFileExporter();
         void execute() override;
@@ -51,6 +88,13 @@ class FAST_EXPORT StreamToFileExporter : public ProcessObject {
         std::chrono::high_resolution_clock::time_point m_recordingStartTime;
         bool m_enabled = true;
         bool m_hasStarted = false;
+        bool m_sequenceFileMode = false;
+        bool m_compress = true;
+        int m_maximumQueueSize = 32;
+        bool m_dropFramesWhenFull = false;
+        std::shared_ptr<SequenceFileWriter> m_writer;
+        std::shared_ptr<std::atomic<int64_t>> m_queueSizeCounter;
+        std::shared_ptr<std::atomic<int64_t>> m_droppedFramesCounter;
 };
 
 }
\ No newline at end of file
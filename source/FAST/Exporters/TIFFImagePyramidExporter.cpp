@@ -29,13 +29,15 @@ void TIFFImagePyramidExporter::execute() {
             for(int x = 0; x < image->getWidth(); x += 256) {
                 auto width = std::min(image->getWidth() - x - 1, 256);
                 auto height = std::min(image->getHeight() - y - 1, 256);
-                access->setPatch(0, x, y, image->crop(Vector2i(x, y), Vector2i(width, height)));
+                access->setPatch(0, x, y, image->crop(Vector2i(x, y), Vector2i(width, height)), false);
             }
         }
+        access->updatePyramidLevels();
     }
 
     if(imagePyramid->usesTIFF()) {
         // If image pyramid is using TIFF backend. It is already stored on disk, we just need to copy it..
+        imagePyramid->flush(); // Make sure all asynchronously compressed tiles have been written
         if(fileExists(m_filename)) {
             // If destination file already exists, we have to remove the existing file, or copy will not run.
             QFile::remove(m_filename.c_str());
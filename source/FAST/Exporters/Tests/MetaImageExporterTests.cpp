@@ -3,6 +3,8 @@
 #include "FAST/Importers/MetaImageImporter.hpp"
 #include "FAST/Data/Image.hpp"
 #include "FAST/Tests/DataComparison.hpp"
+#include <zlib/zlib.h>
+#include <fstream>
 
 using namespace fast;
 
@@ -349,3 +351,45 @@ TEST_CASE("Write a compressed 3D image with the MetaImageExporter", "[fast][Meta
         }
     }
 }
+
+TEST_CASE("Write a block compressed 3D image with the MetaImageExporter", "[fast][MetaImageExporter]") {
+    unsigned int width = 64;
+    unsigned int height = 52;
+    unsigned int depth = 40;
+    for(unsigned int typeNr = 0; typeNr < 5; typeNr++) { // for all types
+        DataType type = (DataType)typeNr;
+
+        void* data = allocateRandomData(width*height*depth, type);
+        Image::pointer image = Image::create(width, height, depth, type, 1, Host::getInstance(), data);
+
+        // Export image with blocks which doesn't divide the image size
+        auto exporter = MetaImageExporter::create("MetaImageExporterTestBlocks.mhd", true);
+        exporter->setCompressionBlockSize(10000);
+        exporter->connect(image);
+        exporter->run();
+
+        // Import image back again, blocks are decompressed in parallel
+        auto importer = MetaImageImporter::create("MetaImageExporterTestBlocks.mhd");
+        auto image2 = importer->runAndGetOutputData<Image>();
+        CHECK(image2->getWidth() == width);
+        CHECK(image2->getHeight() == height);
+        CHECK(image2->getDepth() == depth);
+        CHECK(image2->getDataType() == type);
+        CHECK(image2->getMetadata().count("CompressedDataBlockOffsets") == 0);
+
+        ImageAccess::pointer access = image2->getImageAccess(ACCESS_READ);
+        void* data2 = access->get();
+        CHECK(compareDataArrays(data, data2, width*height*depth, type) == true);
+
+        // File must also be readable as a single zlib stream by other readers
+        std::ifstream file("MetaImageExporterTestBlocks.zraw", std::ios::binary);
+        std::vector<Bytef> compressed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const std::size_t bytes = width*height*depth*getSizeOfDataType(type, 1);
+        std::vector<Bytef> uncompressed(bytes);
+        uLongf size = bytes;
+        REQUIRE(uncompress(uncompressed.data(), &size, compressed.data(), compressed.size()) == Z_OK);
+        CHECK(size == bytes);
+        CHECK(compareDataArrays(data, uncompressed.data(), width*height*depth, type) == true);
+        deleteArray(data, type);
+    }
+}
@@ -0,0 +1,80 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Exporters/StreamToFileExporter.hpp"
+#include "FAST/Exporters/SequenceFileWriter.hpp"
+#include "FAST/Data/Image.hpp"
+#include <zlib/zlib.h>
+#include <fstream>
+
+using namespace fast;
+
+static std::vector<char> readFile(std::string filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("StreamToFileExporter writes images to a single sequence file", "[fast][StreamToFileExporter][SequenceFile]") {
+    const int frames = 10;
+    for(bool compress : {false, true}) {
+        auto exporter = StreamToFileExporter::create("sequence_test", compress ? "compressed" : "uncompressed");
+        exporter->setSequenceFileMode(true);
+        exporter->setCompression(compress);
+        exporter->setMaximumQueueSize(2);
+        for(int i = 0; i < frames; ++i) {
+            auto image = Image::create(64, 32, TYPE_UINT8, 1);
+            image->fill(i);
+            if(i == frames-1)
+                image->setLastFrame("test");
+            exporter->connect(image);
+            exporter->run();
+        }
+        CHECK(exporter->getFrameCounter() == frames);
+        CHECK(exporter->getNrOfDroppedFrames() == 0);
+
+        auto file = readFile(exporter->getSequenceFilename());
+        REQUIRE(file.size() > sizeof(SequenceFile::FileHeader));
+        auto header = (const SequenceFile::FileHeader*)file.data();
+        CHECK(SequenceFile::hasValidMagic(*header));
+        REQUIRE(header->frameCount == frames);
+        auto index = (const SequenceFile::IndexEntry*)(file.data() + header->indexOffset);
+        for(int i = 0; i < frames; ++i) {
+            CHECK(index[i].offset % SequenceFile::alignment == 0);
+            auto frame = (const SequenceFile::FrameHeader*)(file.data() + index[i].offset);
+            CHECK(frame->magic == SequenceFile::frameMagic);
+            CHECK(frame->width == 64);
+            CHECK(frame->height == 32);
+            CHECK(frame->dataType == TYPE_UINT8);
+            CHECK(frame->rawSize == 64*32);
+            std::vector<uchar> pixels(frame->rawSize);
+            const char* data = (const char*)frame + sizeof(SequenceFile::FrameHeader);
+            if(compress) {
+                CHECK(frame->compression == (uint32_t)SequenceFile::Compression::Zlib);
+                uLongf size = pixels.size();
+                CHECK(uncompress(pixels.data(), &size, (const Bytef*)data, frame->dataSize) == Z_OK);
+            } else {
+                CHECK(frame->compression == (uint32_t)SequenceFile::Compression::None);
+                std::memcpy(pixels.data(), data, pixels.size());
+            }
+            CHECK(pixels[0] == i);
+            CHECK(pixels[pixels.size()-1] == i);
+        }
+    }
+    removeDirectory("sequence_test");
+}
+
+TEST_CASE("SequenceFileWriter drops frames when queue is full", "[fast][StreamToFileExporter][SequenceFile]") {
+    createDirectories("sequence_test");
+    auto writer = std::make_shared<SequenceFileWriter>("sequence_test/drop.fastseq", true, 1, true);
+    int written = 0;
+    for(int i = 0; i < 50; ++i) {
+        auto image = Image::create(512, 512, TYPE_FLOAT, 1);
+        image->fill(i);
+        if(writer->write(image))
+            ++written;
+    }
+    writer->close();
+    CHECK(writer->getNrOfWrittenFrames() == written);
+    CHECK(writer->getNrOfWrittenFrames() + writer->getNrOfDroppedFrames() == 50);
+    CHECK_THROWS(writer->write(Image::create(16, 16, TYPE_UINT8, 1)));
+    writer.reset();
+    removeDirectory("sequence_test");
+}
@@ -2,7 +2,9 @@
 #include "FAST/Exception.hpp"
 #include "FAST/Data/Image.hpp"
 #include "FAST/Utility.hpp"
+#include "FAST/ThreadPool.hpp"
 #include <fstream>
+#include <limits>
 #include <set>
 #include <zlib/zlib.h>
 using namespace fast;
@@ -37,11 +39,62 @@ std::vector<std::string> stringSplit(std::string str, std::string delimiter) {
     return values;
 }
 
+/**
+ * Inflate the compressed bytes [begin, end) of file directly into output, reading the file in small chunks.
+ * @param windowBits 15 for a zlib stream, -15 for a raw deflate block
+ */
+static void inflateRange(std::ifstream& file, std::size_t begin, std::size_t end, char* output, std::size_t outputSize, int windowBits, const std::string& filename) {
+    constexpr std::size_t chunkSize = 256*1024;
+    auto chunk = make_uninitialized_unique<Bytef[]>(chunkSize);
+    z_stream stream = {};
+    if(inflateInit2(&stream, windowBits) != Z_OK)
+        throw Exception("Failed to initialize zlib while decompressing raw file");
+    file.seekg(begin);
+    std::size_t compressedLeft = end - begin;
+    std::size_t outputLeft = outputSize;
+    int result = Z_OK;
+    while(outputLeft > 0) {
+        if(stream.avail_in == 0) {
+            if(compressedLeft == 0)
+                break;
+            const std::size_t readSize = std::min(chunkSize, compressedLeft);
+            file.read((char*)chunk.get(), readSize);
+            if(!file.good()) {
+                inflateEnd(&stream);
+                throw Exception("Failed to read compressed raw file " + filename);
+            }
+            compressedLeft -= readSize;
+            stream.next_in = chunk.get();
+            stream.avail_in = (uInt)readSize;
+        }
+        // avail_out is 32 bit, thus large images has to be inflated in several parts
+        const uInt outputPart = (uInt)std::min<std::size_t>(outputLeft, std::numeric_limits<uInt>::max());
+        stream.next_out = (Bytef*)output + (outputSize - outputLeft);
+        stream.avail_out = outputPart;
+        result = inflate(&stream, Z_NO_FLUSH);
+        outputLeft -= outputPart - stream.avail_out;
+        if(result == Z_STREAM_END)
+            break;
+        if(result != Z_OK && result != Z_BUF_ERROR) {
+            inflateEnd(&stream);
+            if(result == Z_MEM_ERROR)
+                throw Exception("Out of memory while decompressing raw file");
+            throw Exception("Corrupt compressed data in raw file " + filename);
+        }
+    }
+    inflateEnd(&stream);
+    if(outputLeft > 0)
+        throw Exception("Compressed raw file " + filename + " contained less data than expected");
+}
+
+/**
+ * Read raw file. Compressed files are inflated directly into the image buffer while reading the file,
+ * and block compressed files (see MetaImageExporter::setCompressionBlockSize) are inflated in parallel.
+ */
 template <class T>
-static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize) {
+static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t voxels, unsigned int nrOfComponents, bool compressed, std::size_t compressedFileSize, std::size_t blockSize, const std::vector<std::size_t>& blockOffsets) {
     auto data = make_uninitialized_unique<T[]>(voxels*nrOfComponents);
     if(compressed) {
-        // Read compressed data
         std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
         if(!file.is_open())
             throw FileNotFoundException(rawFilename);
@@ -49,39 +102,32 @@ static std::unique_ptr<T[]> readRawData(std::string rawFilename, std::size_t vox
         // Determine the file length
         file.seekg(0, std::ios_base::end);
         std::size_t size = file.tellg();
-        file.seekg(0, std::ios_base::beg);
-
-        auto fileData = make_uninitialized_unique<Bytef[]>(size);
-        file.read((char*)&fileData[0], size);
-        file.close();
-
-        unsigned long uncompressedSize = sizeof(T)*voxels*nrOfComponents;
-		int z_result = uncompress(
-            (Bytef*)data.get(),       // destination for the uncompressed
-                                    // data.  This should be the size of
-                                    // the original data, which you should
-                                    // already know.
-
-            (uLongf *)&uncompressedSize,  // length of destination (uncompressed)
-                                    // buffer
-
-            fileData.get(),   // source buffer - the compressed data
-
-            (uLong)compressedFileSize);   // length of compressed data in bytes
-        switch( z_result )
-        {
-        case Z_OK:
-            break;
-
-        case Z_MEM_ERROR:
-            throw Exception("Out of memory while decompressing raw file");
-            break;
-
-        case Z_BUF_ERROR:
-            throw Exception("Output buffer was not large enough while decompressing raw file");
-            break;
+        if(compressedFileSize > 0 && compressedFileSize < size)
+            size = compressedFileSize;
+
+        const std::size_t uncompressedSize = sizeof(T)*voxels*nrOfComponents;
+        if(blockSize > 0 && !blockOffsets.empty()) {
+            const std::size_t blocks = blockOffsets.size();
+            if((uncompressedSize + blockSize - 1) / blockSize != blocks)
+                throw Exception("Block offsets in mhd file does not match image size for " + rawFilename);
+            file.close();
+            // Each block is a raw deflate block, which can be inflated independently. The file ends with the 4 byte adler32 checksum.
+            ThreadPool::getInstance()->parallelFor(0, (int)blocks, [&](int begin, int end) {
+                std::ifstream blockFile(rawFilename, std::ifstream::binary | std::ifstream::in);
+                if(!blockFile.is_open())
+                    throw FileNotFoundException(rawFilename);
+                for(int i = begin; i < end; ++i) {
+                    const std::size_t compressedEnd = i+1 < (int)blocks ? blockOffsets[i+1] : size - 4;
+                    if(blockOffsets[i] >= compressedEnd || compressedEnd > size)
+                        throw Exception("Invalid block offsets in mhd file for " + rawFilename);
+                    const std::size_t outputBegin = i*blockSize;
+                    inflateRange(blockFile, blockOffsets[i], compressedEnd, (char*)data.get() + outputBegin,
+                                 std::min(blockSize, uncompressedSize - outputBegin), -15, rawFilename);
+                }
+            }, 1);
+        } else {
+            inflateRange(file, 0, size, (char*)data.get(), uncompressedSize, 15, rawFilename);
         }
-        file.close();
     } else {
         std::ifstream file(rawFilename, std::ifstream::binary | std::ifstream::in);
         if(!file.is_open())
@@ -146,13 +192,17 @@ void MetaImageImporter::execute() {
     Matrix3f transformMatrix = Matrix3f::Identity();
     bool isCompressed = false;
     std::size_t compressedDataSize = 0;
+    std::size_t compressedDataBlockSize = 0;
+    std::vector<std::size_t> compressedDataBlockOffsets;
     std::map<std::string, std::string> metadata;
 
     // Blacklist of keys to avoid importing as metadata
     std::set<std::string> blacklist = {
         "NDims",
         "ObjectType",
-        "BinaryData"
+        "BinaryData",
+        "CompressedDataBlockSize",
+        "CompressedDataBlockOffsets"
     };
 
     do{
@@ -190,7 +240,14 @@ void MetaImageImporter::execute() {
         } else if(key == "CompressedData" && value == "True") {
             isCompressed = true;
         } else if(key == "CompressedDataSize") {
-            compressedDataSize = std::stoi(value);
+            compressedDataSize = std::stoull(value);
+        } else if(key == "CompressedDataBlockSize") {
+            compressedDataBlockSize = std::stoull(value);
+        } else if(key == "CompressedDataBlockOffsets") {
+            std::vector<std::string> values = split(value);
+            values.erase(std::remove(values.begin(), values.end(), ""), values.end());
+            for(auto& item : values)
+                compressedDataBlockOffsets.push_back(std::stoull(item));
         } else if(key == "ElementDataFile") {
             rawFilename = value;
             rawFilenameFound = true;
@@ -359,25 +416,25 @@ void MetaImageImporter::execute() {
     if(size.size() == 3)
         voxels *= size.z();
     if(typeName == "MET_INT") {
-        auto data = readRawData<int32_t>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<int32_t>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_INT32,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_UINT") {
-        auto data = readRawData<uint32_t>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<uint32_t>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_UINT32,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_SHORT") {
-        auto data = readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<short>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_INT16,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_USHORT") {
-        auto data = readRawData<ushort>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<ushort>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_UINT16,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_CHAR") {
-        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_INT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_UCHAR") {
-        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<unsigned char>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_UINT8,nrOfComponents,getMainDevice(),std::move(data));
     } else if(typeName == "MET_FLOAT") {
-        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize);
+        auto data = readRawData<float>(rawFilename, voxels, nrOfComponents, isCompressed, compressedDataSize, compressedDataBlockSize, compressedDataBlockOffsets);
         output = Image::create(size,TYPE_FLOAT,nrOfComponents,getMainDevice(),std::move(data));
     }
 
@@ -0,0 +1,127 @@
+#include "PipelinedExecutor.hpp"
+#include "ProcessObject.hpp"
+#include <FAST/Streamers/ThreadedStage.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fast {
+
+PipelinedExecutor::PipelinedExecutor(std::shared_ptr<ProcessObject> sink, int queueSize) {
+    if(!sink)
+        throw Exception("Process object given to PipelinedExecutor was null");
+    if(queueSize <= 0)
+        throw Exception("Queue size given to PipelinedExecutor must be > 0");
+    m_sink = sink;
+    m_queueSize = queueSize;
+}
+
+void PipelinedExecutor::addStage(std::shared_ptr<ProcessObject> processObject, int queueSize) {
+    if(m_isBuilt)
+        throw Exception("Stages must be added to PipelinedExecutor before build()");
+    if(!processObject)
+        throw Exception("Process object given to PipelinedExecutor::addStage was null");
+    m_stageRequests.push_back({processObject, queueSize <= 0 ? m_queueSize : queueSize});
+}
+
+static bool isStreamer(ProcessObject* po) {
+    return dynamic_cast<Streamer*>(po) != nullptr;
+}
+
+std::vector<std::shared_ptr<ThreadedStage>> PipelinedExecutor::build() {
+    if(m_isBuilt)
+        return m_stages;
+
+    // Find all edges in the pipeline up to the sink
+    struct Edge {
+        std::shared_ptr<ProcessObject> consumer;
+        uint portID;
+        DataChannel::pointer channel;
+    };
+    std::unordered_map<ProcessObject*, std::vector<Edge>> edgesFrom; // Edges from a process object to its consumers
+    std::vector<std::shared_ptr<ProcessObject>> processObjects;
+    std::unordered_set<ProcessObject*> visited;
+    std::vector<std::shared_ptr<ProcessObject>> stack = {m_sink};
+    while(!stack.empty()) {
+        auto po = stack.back();
+        stack.pop_back();
+        if(visited.count(po.get()) > 0)
+            continue;
+        visited.insert(po.get());
+        processObjects.push_back(po);
+        for(auto&& connection : po->getInputConnections()) {
+            auto producer = connection.second->getProcessObject();
+            edgesFrom[producer.get()].push_back({po, connection.first, connection.second});
+            stack.push_back(producer);
+        }
+    }
+
+    // Select stages
+    std::vector<std::pair<std::shared_ptr<ProcessObject>, int>> stages = m_stageRequests;
+    if(stages.empty()) {
+        for(auto&& po : processObjects) {
+            if(po == m_sink || isStreamer(po.get()) || po->getNrOfInputConnections() == 0)
+                continue;
+            // Skip the pass-through process objects which streamers put on their output ports
+            auto inputs = po->getInputConnections();
+            if(po->getNameOfClass() == "RunLambda" && inputs.size() == 1 && isStreamer(inputs.begin()->second->getProcessObject().get()))
+                continue;
+            stages.push_back({po, m_queueSize});
+        }
+    }
+    std::unordered_set<ProcessObject*> isStage;
+    for(auto&& stage : stages) {
+        if(visited.count(stage.first.get()) == 0)
+            throw Exception("Process object " + stage.first->getNameOfClass() + " given to PipelinedExecutor is not part of the pipeline");
+        if(stage.first == m_sink)
+            throw Exception("The sink of the PipelinedExecutor can't be a stage");
+        if(edgesFrom[stage.first.get()].size() > 1)
+            throw Exception("Process object " + stage.first->getNameOfClass() + " has several consumers, which is not supported by PipelinedExecutor");
+        isStage.insert(stage.first.get());
+    }
+
+    // Check that every process object is only updated by one thread.
+    // The sink and each stage updates itself and its upstream process objects up to the next stage or streamer.
+    std::unordered_map<ProcessObject*, ProcessObject*> updatedBy;
+    std::vector<ProcessObject*> roots = {m_sink.get()};
+    for(auto&& stage : stages)
+        roots.push_back(stage.first.get());
+    for(auto root : roots) {
+        std::vector<ProcessObject*> segment = {root};
+        while(!segment.empty()) {
+            auto po = segment.back();
+            segment.pop_back();
+            if(updatedBy.count(po) > 0) {
+                if(updatedBy[po] == root)
+                    continue;
+                throw Exception("Process object " + po->getNameOfClass() + " would be updated by several threads in PipelinedExecutor. Add it as a stage.");
+            }
+            updatedBy[po] = root;
+            if(isStreamer(po))
+                continue;
+            for(auto&& connection : po->getInputConnections()) {
+                auto producer = connection.second->getProcessObject().get();
+                if(isStage.count(producer) == 0)
+                    segment.push_back(producer);
+            }
+        }
+    }
+
+    // Insert a ThreadedStage between each stage and its consumer
+    for(auto&& stage : stages) {
+        for(auto&& edge : edgesFrom[stage.first.get()]) {
+            auto threadedStage = ThreadedStage::create(edge.channel, stage.second);
+            edge.consumer->setInputConnection(edge.portID, threadedStage->getOutputPort());
+            m_stages.push_back(threadedStage);
+            reportInfo() << "PipelinedExecutor: Running " << stage.first->getNameOfClass() << " in separate thread with queue size " << stage.second << reportEnd();
+        }
+    }
+    m_isBuilt = true;
+    return m_stages;
+}
+
+void PipelinedExecutor::stop() {
+    for(auto&& stage : m_stages)
+        stage->stop();
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <map>
+#include <vector>
+
+namespace fast {
+
+class ProcessObject;
+class ThreadedStage;
+
+/**
+ * @brief Run process objects of a pipeline in parallel, each in its own thread
+ *
+ * A pipeline is normally executed by one thread which updates every process object one after another.
+ * The PipelinedExecutor inserts a ThreadedStage after each selected process object, so that each selected process
+ * object runs in its own thread, with a bounded queue between it and its consumer. The stages thus overlap, and the
+ * pipeline throughput approaches the throughput of the slowest stage instead of the sum of all stages.
+ * This is useful for streaming pipelines such as streamer -> filter -> neural network -> stitcher.
+ *
+ * Each process object must only be updated by one thread. Therefore, process objects which have several
+ * consumers in the pipeline are not supported.
+ *
+ * Example:
+ * @code
+ * auto executor = PipelinedExecutor(stitcher);
+ * executor.addStage(filter);
+ * executor.addStage(network, 8);
+ * executor.build();
+ * auto stream = DataStream(stitcher);
+ * @endcode
+ *
+ * @sa ThreadedStage
+ */
+class FAST_EXPORT PipelinedExecutor : public Object {
+    public:
+        /**
+         * @brief Create executor for the pipeline up to a given process object
+         * @param sink Last process object in the pipeline
+         * @param queueSize Default max nr of data objects in the queue after each stage
+         */
+        explicit PipelinedExecutor(std::shared_ptr<ProcessObject> sink, int queueSize = 4);
+        /**
+         * @brief Run a process object in its own thread.
+         * If no stages are added, all process objects up to the sink, except streamers, get their own thread.
+         * @param processObject Process object in the pipeline
+         * @param queueSize Max nr of data objects in the queue after this stage. If <= 0 the default queue size is used.
+         */
+        void addStage(std::shared_ptr<ProcessObject> processObject, int queueSize = -1);
+        /**
+         * @brief Insert the threaded stages into the pipeline.
+         * Must be called before the pipeline is run.
+         * @return created stages
+         */
+        std::vector<std::shared_ptr<ThreadedStage>> build();
+        /**
+         * @brief Stop all stages
+         */
+        void stop();
+    protected:
+        std::shared_ptr<ProcessObject> m_sink;
+        int m_queueSize;
+        std::vector<std::pair<std::shared_ptr<ProcessObject>, int>> m_stageRequests;
+        std::vector<std::shared_ptr<ThreadedStage>> m_stages;
+        bool m_isBuilt = false;
+};
+
+}
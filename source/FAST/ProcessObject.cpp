@@ -2,10 +2,12 @@
 #include "FAST/Exception.hpp"
 #include "FAST/OpenCLProgram.hpp"
 #include "FAST/Streamers/Streamer.hpp"
+#include "FAST/Data/ImageBufferPool.hpp"
 #include <unordered_set>
 #include <FAST/DataChannels/QueuedDataChannel.hpp>
 #include <FAST/DataChannels/NewestFrameDataChannel.hpp>
 #include <FAST/DataChannels/StaticDataChannel.hpp>
+#include <FAST/Tracer.hpp>
 
 
 namespace fast {
@@ -114,9 +116,16 @@ void ProcessObject::update(int executeToken) {
             reportInfo() << "EXECUTING " << getNameOfClass() << " because PO has new input data." << reportEnd();
         }
         mIsModified = false;
-        preExecute();
-        execute();
-        postExecute();
+        {
+            ImageBufferPool::Scope poolScope(m_imageBufferPooling);
+            if(Tracer::isEnabled()) {
+                executeTraced(executeToken);
+            } else {
+                preExecute();
+                execute();
+                postExecute();
+            }
+        }
         m_lastExecuteToken = executeToken;
         if(this->mRuntimeManager->isEnabled())
             this->waitToFinish();
@@ -127,6 +136,44 @@ void ProcessObject::update(int executeToken) {
     //m_lastFrame.clear();
 }
 
+void ProcessObject::executeTraced(int executeToken) {
+    Tracer::Arguments arguments = {{"executeToken", std::to_string(executeToken)}};
+    if(mInputConnections.count(0) > 0) {
+        try {
+            arguments["frameTimestamp"] = std::to_string(mInputConnections[0]->getFrame()->getCreationTimestamp());
+        } catch(Exception &e) {
+            // No input frame available
+        }
+    }
+    Tracer::Scope scope(getNameOfClass(), "execute", arguments);
+
+    // Place markers before and after execute in the command queue of the main device, so that all OpenCL commands
+    // enqueued by this process object can be shown on the OpenCL track
+    OpenCLDevice::pointer device;
+    cl::Event startEvent, endEvent;
+    if(mDevices.count(0) > 0)
+        device = std::dynamic_pointer_cast<OpenCLDevice>(mDevices.at(0));
+    if(device && !device->isHost()) {
+#if !defined(CL_VERSION_1_2) || defined(CL_USE_DEPRECATED_OPENCL_1_1_APIS)
+        device->getCommandQueue().enqueueMarker(&startEvent);
+#else
+        device->getCommandQueue().enqueueMarkerWithWaitList(NULL, &startEvent);
+#endif
+    }
+    preExecute();
+    execute();
+    postExecute();
+    if(device && !device->isHost()) {
+#if !defined(CL_VERSION_1_2) || defined(CL_USE_DEPRECATED_OPENCL_1_1_APIS)
+        device->getCommandQueue().enqueueMarker(&endEvent);
+#else
+        device->getCommandQueue().enqueueMarkerWithWaitList(NULL, &endEvent);
+#endif
+        Tracer::getInstance()->addOpenCLEvent(getNameOfClass(), startEvent, endEvent, arguments);
+        device->getCommandQueue().flush();
+    }
+}
+
 DataChannel::pointer ProcessObject::getOutputPort(uint portID) {
     validateOutputPortExists(portID);
     // Create DataChannel, and it to list and return it
@@ -164,6 +211,10 @@ DataChannel::pointer ProcessObject::getInputPort(uint portID) {
     return mInputConnections.at(portID);
 }
 
+std::map<uint, DataChannel::pointer> ProcessObject::getInputConnections() const {
+    return mInputConnections;
+}
+
 void ProcessObject::setInputConnection(uint portID, DataChannel::pointer port) {
     validateInputPortExists(portID);
     if(port->getProcessObject().get() == this)
@@ -186,8 +237,7 @@ void ProcessObject::addOutputData(uint portID, DataObject::pointer data, bool pr
         }
     }
     if(propagateFrameData)
-        for(auto&& frameData : m_frameData)
-            data->setFrameData(frameData.first, frameData.second);
+        data->mergeFrameData(m_frameData);
 
     // Add to current data for this port
     mOutputPorts[portID].currentData = data;
@@ -424,6 +474,14 @@ bool ProcessObject::getExecuteOnLastFrameOnly() const {
     return m_executeOnLastFrameOnly;
 }
 
+void ProcessObject::setImageBufferPooling(bool pooling) {
+    m_imageBufferPooling = pooling;
+}
+
+bool ProcessObject::getImageBufferPooling() const {
+    return m_imageBufferPooling;
+}
+
 DataObject::pointer ProcessObject::getOutputData(uint portID) {
     validateOutputPortExists(portID);
 
@@ -91,6 +91,11 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         virtual DataChannel::pointer getOutputPort(uint portID = 0);
         virtual DataChannel::pointer getInputPort(uint portID = 0);
+        /**
+         * @brief Get all input connections of this process object
+         * @return map of input port ID and data channel
+         */
+        std::map<uint, DataChannel::pointer> getInputConnections() const;
         virtual void setInputConnection(DataChannel::pointer port);
         virtual void setInputConnection(uint portID, DataChannel::pointer port);
         virtual void setInputData(DataObject::pointer data);
@@ -152,6 +157,18 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
          */
         void setExecuteOnLastFrameOnly(bool executeOnLastFrameOnly);
         bool getExecuteOnLastFrameOnly() const;
+        /**
+         * @brief Reuse memory of images created by this process object
+         *
+         * If enabled, images created while this process object executes take their host data, OpenCL images and
+         * OpenCL buffers from the ImageBufferPool, and return them to the pool when they are destroyed.
+         * This avoids allocating new memory for every frame in streaming pipelines.
+         * Default is disabled.
+         *
+         * @param pooling
+         */
+        void setImageBufferPooling(bool pooling);
+        bool getImageBufferPooling() const;
 
         /**
          * @brief Convert attributes to string
@@ -177,6 +194,10 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
         virtual void execute()=0;
         virtual void preExecute();
         virtual void postExecute();
+        /**
+         * Run preExecute, execute and postExecute while recording events with the Tracer
+         */
+        void executeTraced(int executeToken);
 
         void createInputPort(uint portID, std::string name = "", std::string description = "", bool required = true);
         void createOutputPort(uint portID, std::string name = "", std::string description = "");
@@ -233,12 +254,13 @@ class FAST_EXPORT  ProcessObject : public AttributeObject {
 
         // Frame data
         // Similar to metadata, only this is transferred from input to output
-        std::unordered_map<std::string, std::string> m_frameData;
+        FrameData m_frameData;
         // Indicates whether this data object is the last frame in a stream, and if so, the name of the stream
         std::unordered_set<std::string> m_lastFrame;
 
         int m_maximumNrOfFrames = -1;
         bool m_executeOnLastFrameOnly = false;
+        bool m_imageBufferPooling = false;
 
         std::mutex m_mutex;
 
@@ -272,8 +294,7 @@ std::shared_ptr<DataType> ProcessObject::getInputData(uint portID, bool readFram
     if(readFrameData) {
         for(auto&& lastFrame : data->getLastFrame())
             m_lastFrame.insert(lastFrame);
-        for(auto&& frameData : data->getFrameData())
-            m_frameData[frameData.first] = frameData.second;
+        m_frameData.merge(data->getTypedFrameData());
     }
 
     return convertedData;
@@ -0,0 +1,176 @@
+#include "ProfilerReport.hpp"
+#include <FAST/ProcessObject.hpp>
+#include <FAST/Exception.hpp>
+#include <FAST/Utility.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <functional>
+
+namespace fast {
+
+/**
+ * Visit all process objects upstream of the sinks, parents before children
+ */
+static void visitPipeline(std::vector<std::shared_ptr<ProcessObject>> sinks, std::function<void(std::shared_ptr<ProcessObject>)> visitor) {
+    std::map<ProcessObject*, bool> visited;
+    std::function<void(std::shared_ptr<ProcessObject>)> visit = [&](std::shared_ptr<ProcessObject> po) {
+        if(!po || visited.count(po.get()) > 0)
+            return;
+        visited[po.get()] = true;
+        for(auto&& input : po->getInputConnections())
+            visit(input.second->getProcessObject());
+        visitor(po);
+    };
+    for(auto&& sink : sinks)
+        visit(sink);
+}
+
+ProfilerReport::ProfilerReport(std::shared_ptr<ProcessObject> sink) : ProfilerReport(std::vector<std::shared_ptr<ProcessObject>>{sink}) {
+}
+
+ProfilerReport::ProfilerReport(std::vector<std::shared_ptr<ProcessObject>> sinks) {
+    auto getTiming = [](RuntimeMeasurement::pointer measurement) {
+        Timing timing;
+        timing.name = measurement->getName();
+        timing.samples = measurement->getSamples();
+        timing.average = measurement->getAverage();
+        timing.p50 = measurement->getPercentile(50);
+        timing.p95 = measurement->getPercentile(95);
+        timing.p99 = measurement->getPercentile(99);
+        timing.max = measurement->getMax();
+        return timing;
+    };
+
+    // Give each process object a unique id: Class name, with a number if there are several of the same class
+    std::map<ProcessObject*, std::string> ids;
+    std::map<std::string, int> classCount;
+    visitPipeline(sinks, [&](std::shared_ptr<ProcessObject> po) {
+        const std::string className = po->getNameOfClass();
+        const int count = ++classCount[className];
+        const std::string id = count == 1 ? className : className + " " + std::to_string(count);
+        ids[po.get()] = id;
+
+        Node node;
+        node.id = id;
+        node.className = className;
+        for(auto&& timing : po->getAllRuntimes()->getTimings()) {
+            if(timing.second->getSamples() > 0)
+                node.timings.push_back(getTiming(timing.second));
+        }
+        m_nodes.push_back(node);
+
+        for(auto&& input : po->getInputConnections()) {
+            auto channel = input.second;
+            Edge edge;
+            edge.from = ids[channel->getProcessObject().get()];
+            edge.to = id;
+            edge.port = input.first;
+            edge.type = channel->getNameOfClass();
+            edge.size = channel->getSize();
+            edge.capacity = channel->getMaximumNumberOfFrames();
+            edge.peakSize = channel->getPeakSize();
+            edge.framesAdded = channel->getFramesAdded();
+            edge.framesDropped = channel->getFramesDropped();
+            edge.addFrameWait = getTiming(channel->getAddFrameWaitTime());
+            edge.getNextFrameWait = getTiming(channel->getNextFrameWaitTime());
+            m_edges.push_back(edge);
+        }
+    });
+}
+
+void ProfilerReport::enableRuntimeMeasurements(std::shared_ptr<ProcessObject> sink) {
+    visitPipeline({sink}, [](std::shared_ptr<ProcessObject> po) {
+        po->enableRuntimeMeasurements();
+    });
+}
+
+std::string ProfilerReport::getTable() const {
+    std::stringstream buffer;
+    buffer << std::fixed << std::setprecision(3);
+    const std::string line(120, '-');
+    buffer << line << std::endl;
+    buffer << std::left << std::setw(40) << "Process object" << std::setw(24) << "Timing" << std::right << std::setw(8) << "Samples"
+           << std::setw(10) << "Average" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "Max" << " (ms)" << std::endl;
+    buffer << line << std::endl;
+    auto printTiming = [&buffer](const Timing& timing) {
+        buffer << std::right << std::setw(8) << timing.samples << std::setw(10) << timing.average << std::setw(10) << timing.p50
+               << std::setw(10) << timing.p95 << std::setw(10) << timing.p99 << std::setw(10) << timing.max << std::endl;
+    };
+    for(auto&& node : m_nodes) {
+        if(node.timings.empty()) {
+            buffer << std::left << std::setw(40) << node.id << "No runtimes recorded" << std::endl;
+            continue;
+        }
+        for(int i = 0; i < node.timings.size(); ++i) {
+            buffer << std::left << std::setw(40) << (i == 0 ? node.id : "") << std::setw(24) << node.timings[i].name;
+            printTiming(node.timings[i]);
+        }
+    }
+    buffer << line << std::endl;
+    buffer << std::left << std::setw(40) << "Data channel" << std::setw(24) << "Type" << std::right << std::setw(8) << "Size"
+           << std::setw(10) << "Capacity" << std::setw(10) << "Peak" << std::setw(10) << "Added" << std::setw(10) << "Dropped" << std::endl;
+    buffer << std::left << std::setw(40) << "" << std::setw(24) << "Wait" << std::right << std::setw(8) << "Samples"
+           << std::setw(10) << "Average" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "Max" << " (ms)" << std::endl;
+    buffer << line << std::endl;
+    for(auto&& edge : m_edges) {
+        buffer << std::left << std::setw(40) << (edge.from + " -> " + edge.to + ":" + std::to_string(edge.port)) << std::setw(24) << edge.type
+               << std::right << std::setw(8) << edge.size << std::setw(10) << edge.capacity << std::setw(10) << edge.peakSize
+               << std::setw(10) << edge.framesAdded << std::setw(10) << edge.framesDropped << std::endl;
+        buffer << std::left << std::setw(40) << "" << std::setw(24) << "addFrame (producer)";
+        printTiming(edge.addFrameWait);
+        buffer << std::left << std::setw(40) << "" << std::setw(24) << "getNextFrame (consumer)";
+        printTiming(edge.getNextFrameWait);
+    }
+    buffer << line << std::endl;
+    return buffer.str();
+}
+
+std::string ProfilerReport::getJSON() const {
+    std::stringstream buffer;
+    buffer << std::setprecision(6);
+    auto printTiming = [&buffer](const Timing& timing) {
+        buffer << "{\"name\": " << escapeJSON(timing.name) << ", \"samples\": " << timing.samples
+               << ", \"average\": " << timing.average << ", \"p50\": " << timing.p50 << ", \"p95\": " << timing.p95
+               << ", \"p99\": " << timing.p99 << ", \"max\": " << timing.max << "}";
+    };
+    buffer << "{\n  \"unit\": \"ms\",\n  \"processObjects\": [";
+    for(int i = 0; i < m_nodes.size(); ++i) {
+        const auto& node = m_nodes[i];
+        buffer << (i > 0 ? "," : "") << "\n    {\"id\": " << escapeJSON(node.id) << ", \"class\": " << escapeJSON(node.className) << ", \"timings\": [";
+        for(int j = 0; j < node.timings.size(); ++j) {
+            buffer << (j > 0 ? ", " : "");
+            printTiming(node.timings[j]);
+        }
+        buffer << "]}";
+    }
+    buffer << "\n  ],\n  \"dataChannels\": [";
+    for(int i = 0; i < m_edges.size(); ++i) {
+        const auto& edge = m_edges[i];
+        buffer << (i > 0 ? "," : "") << "\n    {\"from\": " << escapeJSON(edge.from) << ", \"to\": " << escapeJSON(edge.to)
+               << ", \"port\": " << edge.port << ", \"type\": " << escapeJSON(edge.type) << ", \"size\": " << edge.size
+               << ", \"capacity\": " << edge.capacity << ", \"peakSize\": " << edge.peakSize << ", \"framesAdded\": " << edge.framesAdded
+               << ", \"framesDropped\": " << edge.framesDropped << ", \"addFrameWait\": ";
+        printTiming(edge.addFrameWait);
+        buffer << ", \"getNextFrameWait\": ";
+        printTiming(edge.getNextFrameWait);
+        buffer << "}";
+    }
+    buffer << "\n  ]\n}\n";
+    return buffer.str();
+}
+
+void ProfilerReport::print() const {
+    std::cout << getTable();
+}
+
+void ProfilerReport::saveJSON(std::string filename) const {
+    std::ofstream file(filename);
+    if(!file.is_open())
+        throw Exception("Unable to open file " + filename + " for writing profiler report");
+    file << getJSON();
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <FASTExport.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace fast {
+
+class ProcessObject;
+
+/**
+ * @brief Runtime report of an entire pipeline
+ *
+ * Collects runtimes of all process objects upstream of one or more sink process objects,
+ * and queue statistics of the data channels connecting them:
+ * Nr of frames stored, capacity, peak nr of frames, frames added and dropped,
+ * and how long producers (addFrame) and consumers (getNextFrame) have been blocked.
+ * Runtimes are reported with average, p50, p95, p99 and max, see RuntimeMeasurement.
+ *
+ * The report is a snapshot made when the object is created, and can be given as a table or as JSON.
+ * Runtimes of process objects are only collected if runtime measurements are enabled, see enableRuntimeMeasurements.
+ * Data channel statistics are always collected.
+ *
+ * @code
+ * ProfilerReport::enableRuntimeMeasurements(renderer);
+ * window->run();
+ * ProfilerReport(renderer).print();
+ * @endcode
+ */
+class FAST_EXPORT ProfilerReport {
+    public:
+        /**
+         * @brief Create report of sink and all process objects upstream of it
+         * @param sink
+         */
+        explicit ProfilerReport(std::shared_ptr<ProcessObject> sink);
+        /**
+         * @brief Create report of multiple sinks and all process objects upstream of them
+         * @param sinks
+         */
+        explicit ProfilerReport(std::vector<std::shared_ptr<ProcessObject>> sinks);
+        /**
+         * @brief Enable runtime measurements of sink and all process objects upstream of it
+         * @param sink
+         */
+        static void enableRuntimeMeasurements(std::shared_ptr<ProcessObject> sink);
+        std::string getTable() const;
+        std::string getJSON() const;
+        /**
+         * @brief Print report as a table to stdout
+         */
+        void print() const;
+        void saveJSON(std::string filename) const;
+    private:
+        struct Timing {
+            std::string name;
+            uint64_t samples = 0;
+            double average = 0;
+            double p50 = 0;
+            double p95 = 0;
+            double p99 = 0;
+            double max = 0;
+        };
+        struct Node {
+            std::string id;
+            std::string className;
+            std::vector<Timing> timings;
+        };
+        struct Edge {
+            std::string from;
+            std::string to;
+            int port;
+            std::string type;
+            int size;
+            int capacity;
+            int peakSize;
+            int64_t framesAdded;
+            int64_t framesDropped;
+            Timing addFrameWait;
+            Timing getNextFrameWait;
+        };
+        std::vector<Node> m_nodes;
+        std::vector<Edge> m_edges;
+};
+
+}
@@ -9,6 +9,73 @@
 
 namespace fast {
 
+// Values below 64 microseconds are stored exactly, each larger power of two is split into 32 buckets
+static constexpr int linearBuckets = 64;
+static constexpr int subBuckets = 32;
+static constexpr int maxExponent = 40; // 2^40 microseconds, about 12 days
+static constexpr int totalBuckets = linearBuckets + (maxExponent - 6)*subBuckets;
+
+LatencyHistogram::LatencyHistogram() : m_counts(totalBuckets, 0) {
+}
+
+int LatencyHistogram::getBucket(uint64_t microseconds) {
+    microseconds = std::min(microseconds, ((uint64_t)1 << maxExponent) - 1);
+    if(microseconds < linearBuckets)
+        return (int)microseconds;
+    int exponent = 0;
+    while((microseconds >> (exponent + 1)) > 0)
+        ++exponent;
+    const int shift = exponent - 5;
+    const int subBucket = (int)(microseconds >> shift) - subBuckets;
+    return linearBuckets + (shift - 1)*subBuckets + subBucket;
+}
+
+double LatencyHistogram::getBucketValue(int bucket) {
+    if(bucket < linearBuckets)
+        return bucket / 1000.0;
+    const int shift = (bucket - linearBuckets) / subBuckets + 1;
+    const uint64_t lowest = (uint64_t)((bucket - linearBuckets) % subBuckets + subBuckets) << shift;
+    // Middle of bucket
+    return (lowest + (((uint64_t)1 << shift) - 1) / 2.0) / 1000.0;
+}
+
+void LatencyHistogram::addSample(double milliseconds) {
+    milliseconds = std::max(milliseconds, 0.0);
+    if(m_samples == 0) {
+        m_min = milliseconds;
+        m_max = milliseconds;
+    } else {
+        m_min = std::min(m_min, milliseconds);
+        m_max = std::max(m_max, milliseconds);
+    }
+    ++m_counts[getBucket((uint64_t)std::llround(milliseconds*1000.0))];
+    ++m_samples;
+}
+
+double LatencyHistogram::getPercentile(double percentile) const {
+    if(m_samples == 0)
+        return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * m_samples));
+    uint64_t count = 0;
+    for(int bucket = 0; bucket < totalBuckets; ++bucket) {
+        count += m_counts[bucket];
+        if(count >= rank)
+            return std::min(std::max(getBucketValue(bucket), m_min), m_max);
+    }
+    return m_max;
+}
+
+uint64_t LatencyHistogram::getSamples() const {
+    return m_samples;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_samples = 0;
+    m_min = 0.0;
+    m_max = 0.0;
+}
+
 RuntimeMeasurement::RuntimeMeasurement(){
     mSum = 0.0;
 	mSamples = 0;
@@ -21,46 +88,54 @@ RuntimeMeasurement::RuntimeMeasurement(std::string name, int warmupRounds, int m
 	mSamples = 0;
 	mRunningMean = 0.0;
     mRunningVariance = 0.0;
+	mMin = 0.0;
+	mMax = 0.0;
 	this->mName = name;
 	if(warmupRounds < 0)
 		throw Exception("Warmup rounds must be > 0");
 	m_warmupRounds = warmupRounds;
 	m_maximumSamples = maximumSamples;
+	if(m_maximumSamples > 0)
+		m_window.reserve(m_maximumSamples);
 }
 
 void RuntimeMeasurement::addSample(double runtime) {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	if(m_warmupRounds > 0) {
 		--m_warmupRounds;
 		return;
 	}
+	m_histogram.addSample(runtime);
+	if(m_maximumSamples > 0) {
+		// Fixed size window of the last samples
+		if((int)m_window.size() < m_maximumSamples) {
+			m_window.push_back(runtime);
+		} else {
+			m_window[m_windowNext] = runtime;
+		}
+		m_windowNext = (m_windowNext + 1) % m_maximumSamples;
+		mSamples = m_window.size();
+		mSum = std::accumulate(m_window.begin(), m_window.end(), 0.0);
+		mRunningMean = mSum / mSamples;
+		mRunningVariance = 0.0;
+		for(double sample : m_window)
+			mRunningVariance += (sample - mRunningMean)*(sample - mRunningMean);
+		const auto [min, max] = std::minmax_element(m_window.begin(), m_window.end());
+		mMin = *min;
+		mMax = *max;
+		return;
+	}
 	mSamples++;
 	mSum += runtime;
     if(mSamples > 1) {
-
-		if(m_maximumSamples > 0) {
-		    // TODO should probably mutex protect all of this
-            m_queueRuntime.push_back(runtime);
-            mSum = std::accumulate(m_queueRuntime.begin(), m_queueRuntime.end(), 0.0);
-            mRunningMean = mSum / m_queueRuntime.size();
-            mRunningVariance = 0.0; // TODO
-            const auto [min, max] = std::minmax_element(m_queueRuntime.begin(), m_queueRuntime.end());
-            mMin = *min;
-            mMax = *max;
-		} else {
-            const double delta = runtime - mRunningMean;
-            mRunningMean += delta / mSamples;
-            const double delta2 = runtime - mRunningMean;
-            mRunningVariance += delta * delta2;
-            if(runtime < mMin)
-                mMin = runtime;
-            if(runtime > mMax)
-                mMax = runtime;
-		}
-        if(m_maximumSamples == mSamples) {
-            m_queueRuntime.pop_front();
-            mSamples--;
-        }
-
+		const double delta = runtime - mRunningMean;
+		mRunningMean += delta / mSamples;
+		const double delta2 = runtime - mRunningMean;
+		mRunningVariance += delta * delta2;
+		if(runtime < mMin)
+			mMin = runtime;
+		if(runtime > mMax)
+			mMax = runtime;
 	} else {
 		mRunningMean = runtime;
         mMin = runtime;
@@ -69,7 +144,7 @@ void RuntimeMeasurement::addSample(double runtime) {
 }
 
 std::string RuntimeMeasurement::print() const {
-	
+	std::lock_guard<std::mutex> lock(m_mutex);
 	std::stringstream buffer;
 
     buffer << std::endl;
@@ -80,11 +155,14 @@ std::string RuntimeMeasurement::print() const {
 	} else if (mSamples == 1) {
 		buffer << mSum << " ms" << std::endl;
 	} else {
-		buffer << "Total: " << getSum() << " ms" << std::endl;
-		buffer << "Average: " << getAverage() << " ms" << std::endl;
-		buffer << "Standard deviation: " << getStdDeviation() << " ms" << std::endl;
+		buffer << "Total: " << mSum << " ms" << std::endl;
+		buffer << "Average: " << mRunningMean << " ms" << std::endl;
+		buffer << "Standard deviation: " << std::sqrt(mRunningVariance / mSamples) << " ms" << std::endl;
 		buffer << "Minimum: " << mMin << " ms" << std::endl;
 		buffer << "Maximum: " << mMax << " ms" << std::endl;
+		buffer << "Median (p50): " << m_histogram.getPercentile(50) << " ms" << std::endl;
+		buffer << "p95: " << m_histogram.getPercentile(95) << " ms" << std::endl;
+		buffer << "p99: " << m_histogram.getPercentile(99) << " ms" << std::endl;
 		buffer << "Number of samples: " << mSamples << std::endl;
 	}
 	buffer << "----------------------------------------------------" << std::endl;
@@ -95,34 +173,57 @@ std::string RuntimeMeasurement::print() const {
 }
 
 double RuntimeMeasurement::getSum() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	return mSum;
 }
 
 double RuntimeMeasurement::getAverage() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	return mRunningMean;
 }
 
 double RuntimeMeasurement::getStdDeviation() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if(mSamples == 0)
+		return 0.0;
     return std::sqrt(mRunningVariance / mSamples);
 }
 
 unsigned int RuntimeMeasurement::getSamples() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	return mSamples;
 }
 
 double RuntimeMeasurement::getMax() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	return mMax;
 }
 
 double RuntimeMeasurement::getMin() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	return mMin;
 }
 
+double RuntimeMeasurement::getPercentile(double percentile) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_histogram.getPercentile(percentile);
+}
+
+std::string RuntimeMeasurement::getName() const {
+	return mName;
+}
+
 void RuntimeMeasurement::reset() {
+	std::lock_guard<std::mutex> lock(m_mutex);
     mSum = 0.0;
     mSamples = 0;
     mRunningMean = 0.0;
     mRunningVariance = 0.0;
+	mMin = 0.0;
+	mMax = 0.0;
+	m_window.clear();
+	m_windowNext = 0;
+	m_histogram.reset();
 }
 
 } // end namespace fast
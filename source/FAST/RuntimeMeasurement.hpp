@@ -2,17 +2,55 @@
 
 #include <string>
 #include <memory>
-#include <deque>
+#include <vector>
+#include <mutex>
 #include <FASTExport.hpp>
 
 namespace fast {
+
+/**
+ * @brief Fixed memory histogram of latencies
+ *
+ * Log-linear buckets (similar to HDR histograms): Values below 64 microseconds are stored exactly,
+ * above that each power of two is split into 32 buckets, giving a relative error of at most 1.6 %.
+ * Values up to about 12 days are supported, larger values are clamped.
+ * Memory use is constant (~5 KB), no matter how many samples are added.
+ *
+ * All values are in milliseconds. Not thread safe, see RuntimeMeasurement.
+ */
+class FAST_EXPORT LatencyHistogram {
+public:
+	LatencyHistogram();
+	void addSample(double milliseconds);
+	/**
+	 * @brief Get value at a given percentile
+	 * @param percentile 0-100
+	 * @return value in milliseconds, 0 if no samples
+	 */
+	double getPercentile(double percentile) const;
+	uint64_t getSamples() const;
+	void reset();
+private:
+	static int getBucket(uint64_t microseconds);
+	static double getBucketValue(int bucket);
+
+	std::vector<uint32_t> m_counts;
+	uint64_t m_samples = 0;
+	double m_min = 0.0;
+	double m_max = 0.0;
+};
+
 /**
  * @brief A class for runtime measurement
  *
  * Collect multiple runtimes over time, and calculates running average, running standard deviation,
- * sum, max, min etc.
+ * sum, max, min, and percentiles (p50, p95, p99 etc.) using a LatencyHistogram.
+ * If maximumSamples > 0, average, standard deviation, sum, min and max are calculated over the last maximumSamples
+ * samples only, while percentiles are always calculated over all samples since last reset.
+ * Memory use is constant.
  *
- * All measurements are in milliseconds
+ * All measurements are in milliseconds.
+ * Samples may be added and read from different threads.
  *
  */
 class FAST_EXPORT RuntimeMeasurement {
@@ -26,6 +64,13 @@ public:
 	double getMax() const;
 	double getMin() const;
 	double getStdDeviation() const;
+	/**
+	 * @brief Get runtime at a given percentile, e.g. 99 for p99
+	 * @param percentile 0-100
+	 * @return runtime in milliseconds, with a relative error of at most 1.6 %
+	 */
+	double getPercentile(double percentile) const;
+	std::string getName() const;
 	std::string print() const;
 	void reset();
 	~RuntimeMeasurement() = default;
@@ -38,13 +83,14 @@ private:
 	double mRunningMean;
 	double mMin;
 	double mMax;
-	double mFirstSample;
 	std::string mName;
 	int m_warmupRounds;
 	int m_maximumSamples;
-    std::deque<double> m_queueRuntime;
-	std::deque<double> m_queueAvg;
-    std::deque<double> m_queueStd;
+	// Ring buffer of the last m_maximumSamples samples
+	std::vector<double> m_window;
+	int m_windowNext = 0;
+	LatencyHistogram m_histogram;
+	mutable std::mutex m_mutex;
 };
 
 }; // end namespace
@@ -1,5 +1,7 @@
 #include "RuntimeMeasurementManager.hpp"
 #include "Exception.hpp"
+#include "Tracer.hpp"
+#include <iostream>
 
 namespace fast {
 
@@ -57,13 +59,11 @@ void RuntimeMeasurementsManager::stopCLTimer(std::string name, cl::CommandQueue
 	cl::Event startEvent = startEvents[name];
 	startEvent.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &start);
 	endEvent.getProfilingInfo<cl_ulong>(CL_PROFILING_COMMAND_START, &end);
-	if (timings.count(name) == 0) {
-		// No timings with this name exists, create a new one
-		RuntimeMeasurement::pointer runtime(new RuntimeMeasurement(name, m_warmupRounds));
-		runtime->addSample((end - start) * 1.0e-6);
-		timings[name] =  runtime;
-	} else {
-		timings[name]->addSample((end - start) * 1.0e-6);
+	getTiming(name)->addSample((end - start) * 1.0e-6);
+	if(Tracer::isEnabled()) {
+		// Queue is finished, so use current host time as end of the timer
+		const auto hostEnd = std::chrono::steady_clock::now();
+		Tracer::getInstance()->addEvent(name, "OpenCL timer", hostEnd - std::chrono::nanoseconds(end - start), hostEnd);
 	}
 
 	// Remove the start event
@@ -85,15 +85,7 @@ void RuntimeMeasurementsManager::stopRegularTimer(std::string name) {
 	    return;
 
 	std::chrono::duration<double, std::milli> time = std::chrono::system_clock::now() - startTimes[name];
-    if (timings.count(name) == 0) {
-		// No timings with this name exists, create a new one
-		RuntimeMeasurement::pointer runtime(new RuntimeMeasurement(name, m_warmupRounds));
-
-		runtime->addSample(time.count());
-		timings[name] =  runtime;
-	} else {
-		timings[name]->addSample(time.count());
-	}
+	getTiming(name)->addSample(time.count());
 
     startTimes.erase(name);
 }
@@ -119,6 +111,7 @@ void RuntimeMeasurementsManager::stopNumberedRegularTimer(std::string name) {
 }
 
 RuntimeMeasurement::pointer RuntimeMeasurementsManager::getTiming(std::string name) {
+	std::lock_guard<std::mutex> lock(m_timingMutex);
     if(timings.count(name) == 0) {
         // Create a new empty timing
 		RuntimeMeasurement::pointer runtime(new RuntimeMeasurement(name, m_warmupRounds));
@@ -128,23 +121,52 @@ RuntimeMeasurement::pointer RuntimeMeasurementsManager::getTiming(std::string na
 	return timings[name];
 }
 
+std::map<std::string, RuntimeMeasurement::pointer> RuntimeMeasurementsManager::getTimings() {
+	std::lock_guard<std::mutex> lock(m_timingMutex);
+	return timings;
+}
+
 void RuntimeMeasurementsManager::print(std::string name) {
 	if (!enabled)
 		return;
 
-	timings[name]->print();
+	getTiming(name)->print();
 }
 
 void RuntimeMeasurementsManager::printAll() {
 	if (!enabled)
 		return;
 
-	std::map<std::string, RuntimeMeasurement::pointer>::iterator it;
-	for (it = timings.begin(); it != timings.end(); it++) {
-		it->second->print();
+	for(auto&& timing : getTimings()) {
+		timing.second->print();
+	}
+	for(auto&& counter : getCounters()) {
+		std::cout << counter.first << ": " << counter.second << std::endl;
 	}
 }
 
+std::shared_ptr<std::atomic<int64_t>> RuntimeMeasurementsManager::getCounter(std::string name) {
+	std::lock_guard<std::mutex> lock(m_counterMutex);
+	if(m_counters.count(name) == 0)
+		m_counters[name] = std::make_shared<std::atomic<int64_t>>(0);
+	return m_counters[name];
+}
+
+int64_t RuntimeMeasurementsManager::getCounterValue(std::string name) {
+	std::lock_guard<std::mutex> lock(m_counterMutex);
+	if(m_counters.count(name) == 0)
+		return 0;
+	return m_counters[name]->load();
+}
+
+std::map<std::string, int64_t> RuntimeMeasurementsManager::getCounters() {
+	std::lock_guard<std::mutex> lock(m_counterMutex);
+	std::map<std::string, int64_t> result;
+	for(auto&& counter : m_counters)
+		result[counter.first] = counter.second->load();
+	return result;
+}
+
 RuntimeMeasurementsManager::RuntimeMeasurementsManager() {
     enabled = false;
 }
@@ -6,6 +6,8 @@
 #include <FAST/RuntimeMeasurement.hpp>
 #include <chrono>
 #include <memory>
+#include <atomic>
+#include <mutex>
 
 
 namespace fast {
@@ -54,6 +56,33 @@ public:
 	void stopNumberedRegularTimer(std::string name);
 
 	RuntimeMeasurement::pointer getTiming(std::string name);
+	/**
+	 * @brief Get all timings
+	 * @return map of timing name and timing
+	 */
+	std::map<std::string, RuntimeMeasurement::pointer> getTimings();
+
+#ifndef SWIG
+	/**
+	 * @brief Get a counter with the given name, it is created if it doesn't exist.
+	 * The returned counter can be stored and incremented from any thread without locking.
+	 * Counters are updated even if the manager is disabled.
+	 * @param name
+	 * @return counter
+	 */
+	std::shared_ptr<std::atomic<int64_t>> getCounter(std::string name);
+#endif
+	/**
+	 * @brief Get current value of a counter
+	 * @param name
+	 * @return value, 0 if the counter doesn't exist
+	 */
+	int64_t getCounterValue(std::string name);
+	/**
+	 * @brief Get current value of all counters
+	 * @return map of counter name and value
+	 */
+	std::map<std::string, int64_t> getCounters();
 
 	void print(std::string name);
 	void printAll();
@@ -63,9 +92,12 @@ private:
 	bool enabled;
 	int m_warmupRounds = 0;
 	std::map<std::string, RuntimeMeasurement::pointer> timings;
+	std::mutex m_timingMutex; // Guards timings, which may be read by other threads
 	std::map<std::string, unsigned int> numberings;
 	std::map<std::string, cl::Event> startEvents;
 	std::map<std::string, std::chrono::system_clock::time_point> startTimes;
+	std::map<std::string, std::shared_ptr<std::atomic<int64_t>>> m_counters;
+	std::mutex m_counterMutex;
 	std::weak_ptr<RuntimeMeasurementsManager> mPtr;
 };
 
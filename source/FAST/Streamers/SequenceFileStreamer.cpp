@@ -0,0 +1,320 @@
+#include "SequenceFileStreamer.hpp"
+#include <FAST/Data/Image.hpp>
+#include <FAST/Data/SequenceFile.hpp>
+#include <FAST/SceneGraph.hpp>
+#include <zlib/zlib.h>
+#include <limits>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fast {
+
+/**
+ * Read-only memory mapping of an entire file, used to read headers and compressed frames.
+ * Uncompressed frames are given their own copy-on-write mapping, which lives until the image is deleted.
+ */
+class SequenceFileStreamer::MappedFile {
+    public:
+        explicit MappedFile(const std::string& filename);
+        ~MappedFile();
+        const char* getData() const { return m_data; }
+        uint64_t getSize() const { return m_size; }
+        /**
+         * Map a part of the file copy-on-write. Every call creates a new mapping, thus pages written to are copied
+         * and only seen through the returned memory, and never by other mappings or the file.
+         * The memory is unmapped when the returned pointer is deleted.
+         */
+        unique_pixel_ptr mapCopyOnWrite(uint64_t offset, uint64_t size) const;
+    private:
+        char* m_data = nullptr;
+        uint64_t m_size = 0;
+#ifdef _WIN32
+        HANDLE m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+};
+
+#ifdef _WIN32
+SequenceFileStreamer::MappedFile::MappedFile(const std::string& filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        throw FileNotFoundException(filename);
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(SequenceFile::FileHeader)) {
+        CloseHandle(file);
+        throw Exception("File " + filename + " is not a valid sequence file");
+    }
+    m_size = size.QuadPart;
+    // Write copy, so that views of frames can be mapped copy-on-write
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file); // The mapping keeps the file open
+    if(m_mapping == nullptr)
+        throw Exception("Failed to memory map " + filename);
+    m_data = (char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_data == nullptr) {
+        CloseHandle(m_mapping);
+        throw Exception("Failed to memory map " + filename);
+    }
+}
+
+unique_pixel_ptr SequenceFileStreamer::MappedFile::mapCopyOnWrite(uint64_t offset, uint64_t size) const {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    // View offset must be a multiple of the allocation granularity
+    const uint64_t start = offset / info.dwAllocationGranularity * info.dwAllocationGranularity;
+    void* view = MapViewOfFile(m_mapping, FILE_MAP_COPY, (DWORD)(start >> 32), (DWORD)start, offset - start + size);
+    if(view == nullptr)
+        throw Exception("Failed to memory map frame of sequence file");
+    return unique_pixel_ptr((char*)view + (offset - start), [view](void*) { UnmapViewOfFile(view); });
+}
+
+SequenceFileStreamer::MappedFile::~MappedFile() {
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+}
+#else
+SequenceFileStreamer::MappedFile::MappedFile(const std::string& filename) {
+    m_file = open(filename.c_str(), O_RDONLY);
+    if(m_file < 0)
+        throw FileNotFoundException(filename);
+    struct stat status;
+    if(fstat(m_file, &status) != 0 || status.st_size < (off_t)sizeof(SequenceFile::FileHeader)) {
+        close(m_file);
+        throw Exception("File " + filename + " is not a valid sequence file");
+    }
+    m_size = status.st_size;
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+    if(data == MAP_FAILED) {
+        close(m_file);
+        throw Exception("Failed to memory map " + filename);
+    }
+    m_data = (char*)data;
+}
+
+unique_pixel_ptr SequenceFileStreamer::MappedFile::mapCopyOnWrite(uint64_t offset, uint64_t size) const {
+    // Mapping offset must be a multiple of the page size
+    const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    const uint64_t start = offset / pageSize * pageSize;
+    const uint64_t length = offset - start + size;
+    void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_file, start);
+    if(data == MAP_FAILED)
+        throw Exception("Failed to memory map frame of sequence file");
+    return unique_pixel_ptr((char*)data + (offset - start), [data, length](void*) { munmap(data, length); });
+}
+
+SequenceFileStreamer::MappedFile::~MappedFile() {
+    munmap(m_data, m_size);
+    close(m_file);
+}
+#endif
+
+SequenceFileStreamer::SequenceFileStreamer() {
+    createOutputPort(0, "Image");
+    createStringAttribute("filename", "Filename", "Sequence file to stream", "");
+    createBooleanAttribute("loop", "Loop", "Loop streaming", false);
+    createBooleanAttribute("use-timestamps", "Use timestamps", "Use timestamps stored in file when streaming", true);
+    createIntegerAttribute("framerate", "Framerate", "Framerate", -1);
+}
+
+SequenceFileStreamer::SequenceFileStreamer(std::string filename, bool loop, bool useTimestamps, int framerate) : SequenceFileStreamer() {
+    setFilename(filename);
+    setLooping(loop);
+    setUseTimestamps(useTimestamps);
+    setFramerate(framerate);
+}
+
+void SequenceFileStreamer::loadAttributes() {
+    setFilename(getStringAttribute("filename"));
+    setLooping(getBooleanAttribute("loop"));
+    setUseTimestamps(getBooleanAttribute("use-timestamps"));
+    setFramerate(getIntegerAttribute("framerate"));
+}
+
+void SequenceFileStreamer::setFilename(std::string filename) {
+    // The stream thread uses the file
+    if(m_streamIsStarted)
+        throw Exception("The filename of SequenceFileStreamer can't be changed while streaming, call stop first");
+    m_filename = filename;
+    m_file.reset();
+    m_frameOffsets.clear();
+    setModified(true);
+}
+
+void SequenceFileStreamer::setUseTimestamps(bool use) {
+    m_useTimestamps = use;
+}
+
+void SequenceFileStreamer::load() {
+    if(m_filename.empty())
+        throw Exception("No filename was given to the SequenceFileStreamer");
+    auto file = std::make_shared<MappedFile>(m_filename);
+    const char* data = file->getData();
+    const uint64_t fileSize = file->getSize();
+    auto header = (const SequenceFile::FileHeader*)data;
+    if(!SequenceFile::hasValidMagic(*header))
+        throw Exception("File " + m_filename + " is not a valid sequence file");
+    if(header->version > SequenceFile::version)
+        throw Exception("Sequence file " + m_filename + " has unsupported version " + std::to_string(header->version));
+
+    auto isValidFrame = [data, fileSize](uint64_t offset) {
+        if(offset % SequenceFile::alignment != 0 || offset + sizeof(SequenceFile::FrameHeader) > fileSize)
+            return false;
+        auto frame = (const SequenceFile::FrameHeader*)(data + offset);
+        return frame->magic == SequenceFile::frameMagic &&
+            frame->dataSize <= frame->storedSize &&
+            frame->storedSize <= fileSize - offset - sizeof(SequenceFile::FrameHeader) &&
+            frame->rawSize == (uint64_t)frame->width*frame->height*frame->depth*getSizeOfDataType((DataType)frame->dataType, frame->nrOfChannels);
+    };
+
+    std::vector<uint64_t> offsets;
+    if(header->indexOffset != 0 && header->indexOffset <= fileSize &&
+        header->frameCount <= (fileSize - header->indexOffset) / sizeof(SequenceFile::IndexEntry)) {
+        auto index = (const SequenceFile::IndexEntry*)(data + header->indexOffset);
+        offsets.reserve(header->frameCount);
+        for(uint64_t i = 0; i < header->frameCount; ++i) {
+            if(!isValidFrame(index[i].offset))
+                throw Exception("Sequence file " + m_filename + " has an invalid index");
+            offsets.push_back(index[i].offset);
+        }
+    } else {
+        // File was not closed properly; find frames by following the frame headers
+        reportWarning() << "Sequence file " << m_filename << " has no index, scanning frames" << reportEnd();
+        uint64_t offset = sizeof(SequenceFile::FileHeader);
+        while(isValidFrame(offset)) {
+            offsets.push_back(offset);
+            offset += sizeof(SequenceFile::FrameHeader) + ((const SequenceFile::FrameHeader*)(data + offset))->storedSize;
+        }
+    }
+    reportInfo() << "Opened sequence file " << m_filename << " with " << offsets.size() << " frames" << reportEnd();
+    m_file = file;
+    m_frameOffsets = std::move(offsets);
+}
+
+int SequenceFileStreamer::getNrOfFrames() {
+    if(!m_file)
+        load();
+    return m_frameOffsets.size();
+}
+
+std::shared_ptr<Image> SequenceFileStreamer::getFrame(int index) {
+    auto file = m_file;
+    const uint64_t dataOffset = m_frameOffsets[index] + sizeof(SequenceFile::FrameHeader);
+    auto header = (const SequenceFile::FrameHeader*)(file->getData() + m_frameOffsets[index]);
+    const char* data = file->getData() + dataOffset;
+    const auto type = (DataType)header->dataType;
+
+    VectorXui size(header->dimensions == 3 ? 3 : 2);
+    size[0] = header->width;
+    size[1] = header->height;
+    if(header->dimensions == 3)
+        size[2] = header->depth;
+
+    unique_pixel_ptr pixels;
+    switch((SequenceFile::Compression)header->compression) {
+        case SequenceFile::Compression::None:
+            // Zero copy: The image uses a copy-on-write mapping of the frame, which is unmapped when the image is deleted.
+            // Since each image gets its own mapping, writing to it doesn't change this frame when looping or seeking.
+            pixels = file->mapCopyOnWrite(dataOffset, header->rawSize);
+            break;
+        case SequenceFile::Compression::Zlib: {
+            // uLong is only 32 bit on Windows
+            if(header->rawSize > std::numeric_limits<uLong>::max() || header->dataSize > std::numeric_limits<uLong>::max())
+                throw Exception("Frame " + std::to_string(index) + " in " + m_filename + " is too large to be decompressed");
+            pixels = allocatePixelArray((std::size_t)header->width*header->height*header->depth*header->nrOfChannels, type);
+            uLongf rawSize = (uLongf)header->rawSize;
+            if(uncompress((Bytef*)pixels.get(), &rawSize, (const Bytef*)data, (uLong)header->dataSize) != Z_OK || rawSize != header->rawSize)
+                throw Exception("Failed to decompress frame " + std::to_string(index) + " in " + m_filename);
+            break;
+        }
+        default:
+            throw Exception("Unknown compression in frame " + std::to_string(index) + " in " + m_filename);
+    }
+
+    auto image = Image::create(size, type, header->nrOfChannels, std::move(pixels));
+    image->setSpacing(Vector3f(header->spacing[0], header->spacing[1], header->spacing[2]));
+    Affine3f transform;
+    transform.matrix() = Eigen::Map<const Matrix4f>(header->transform);
+    if(!transform.matrix().isIdentity())
+        image->getSceneGraphNode()->setTransform(transform);
+    image->setCreationTimestamp(header->timestamp);
+    return image;
+}
+
+void SequenceFileStreamer::execute() {
+    if(!m_file)
+        load();
+    if(m_frameOffsets.empty())
+        throw Exception("Sequence file " + m_filename + " has no frames");
+    startStream();
+    waitForFirstFrame();
+}
+
+void SequenceFileStreamer::generateStream() {
+    uint64_t previousTimestamp = 0;
+    auto previousTimestampTime = std::chrono::high_resolution_clock::time_point::min();
+    auto previousTime = std::chrono::high_resolution_clock::now();
+    while(true) {
+        bool pause = getPause();
+        if(pause)
+            waitForUnpause();
+        pause = getPause();
+
+        if(m_stop) {
+            m_streamIsStarted = false;
+            m_firstFrameIsInserted = false;
+            break;
+        }
+        const int frameNr = getCurrentFrameIndex();
+        try {
+            auto image = getFrame(frameNr);
+            if(!pause) {
+                if(m_framerate > 0) {
+                    std::chrono::duration<float, std::milli> passedTime = std::chrono::high_resolution_clock::now() - previousTime;
+                    std::chrono::duration<int, std::milli> sleepFor(1000 / m_framerate - (int)passedTime.count());
+                    if(sleepFor.count() > 0)
+                        std::this_thread::sleep_for(sleepFor);
+                    previousTime = std::chrono::high_resolution_clock::now();
+                } else if(m_useTimestamps && image->getCreationTimestamp() != 0) {
+                    const uint64_t timestamp = image->getCreationTimestamp();
+                    // Restart timing when looping or seeking backwards
+                    if(timestamp < previousTimestamp)
+                        previousTimestampTime = std::chrono::high_resolution_clock::time_point::min();
+                    if(previousTimestampTime != std::chrono::high_resolution_clock::time_point::min()) {
+                        // Wait as long as necessary before adding image
+                        auto timePassed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::high_resolution_clock::now() - previousTimestampTime);
+                        const int64_t left = (int64_t)(timestamp - previousTimestamp) - timePassed.count();
+                        if(left > 0)
+                            std::this_thread::sleep_for(std::chrono::milliseconds(left));
+                    }
+                    previousTimestamp = timestamp;
+                    previousTimestampTime = std::chrono::high_resolution_clock::now();
+                }
+                getCurrentFrameIndexAndUpdate(); // Update index
+            }
+            if(!m_loop && frameNr == getNrOfFrames()-1)
+                image->setLastFrame(getNameOfClass());
+
+            addOutputData(0, image);
+            frameAdded();
+        } catch(ThreadStopped &e) {
+            break;
+        } catch(Exception &e) {
+            stopWithError(e.what());
+            break;
+        }
+    }
+}
+
+SequenceFileStreamer::~SequenceFileStreamer() {
+    stop();
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <FAST/Streamers/RandomAccessStreamer.hpp>
+
+namespace fast {
+
+class Image;
+
+/**
+ * @brief Stream images from a FAST sequence file (.fastseq)
+ *
+ * Sequence files are recorded with the StreamToFileExporter in sequence file mode.
+ * The file is memory mapped, and uncompressed frames are given out as images which use mapped memory
+ * directly, thus no pixel data is copied when streaming. Compressed frames are decompressed when streamed.
+ * Each image gets its own copy-on-write mapping of the pixel data, so writing to a streamed image never changes
+ * the file, or the same frame when it is streamed again by looping or seeking.
+ *
+ * Supports pause, looping, framerate and seeking to any frame, see RandomAccessStreamer.
+ *
+ * <h3>Output ports</h3>
+ * - 0: Image
+ *
+ * @ingroup streamers
+ * @sa StreamToFileExporter SequenceFileWriter
+ */
+class FAST_EXPORT SequenceFileStreamer : public RandomAccessStreamer {
+    FAST_PROCESS_OBJECT(SequenceFileStreamer)
+    public:
+        /**
+         * @brief Create instance
+         * @param filename Sequence file to open
+         * @param loop Whether to loop or not
+         * @param useTimestamps Whether to use the timestamps stored in the file when streaming, or just stream as fast as possible
+         * @param framerate If framerate is > 0, this framerate will be used for streaming the images
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(SequenceFileStreamer,
+                         std::string, filename,,
+                         bool, loop, = false,
+                         bool, useTimestamps, = true,
+                         int, framerate, = -1
+        );
+        /**
+         * @brief Set sequence file to stream. Throws if streaming has started.
+         * @param filename
+         */
+        void setFilename(std::string filename);
+        void setUseTimestamps(bool use);
+        int getNrOfFrames() override;
+        void loadAttributes() override;
+        ~SequenceFileStreamer();
+    private:
+        SequenceFileStreamer();
+        void execute() override;
+        void generateStream() override;
+        void load();
+        std::shared_ptr<Image> getFrame(int index);
+
+        class MappedFile;
+
+        std::string m_filename;
+        bool m_useTimestamps = true;
+        std::shared_ptr<MappedFile> m_file;
+        std::vector<uint64_t> m_frameOffsets;
+};
+
+}
@@ -1,5 +1,8 @@
 #include <FAST/Algorithms/Lambda/RunLambda.hpp>
 #include "Streamer.hpp"
+#include <FAST/Data/ImageBufferPool.hpp>
+#include <FAST/ThreadPool.hpp>
+#include <FAST/Config.hpp>
 
 namespace fast {
 
@@ -14,7 +17,15 @@ void Streamer::waitForFirstFrame() {
 void Streamer::startStream() {
     if(!m_streamIsStarted) {
         m_streamIsStarted = true;
-        m_thread = std::make_unique<std::thread>(std::bind(&Streamer::generateStream, this));
+        const bool pooling = getImageBufferPooling();
+        const auto affinity = Config::getThreadPoolAffinity("streamers");
+        m_thread = std::make_unique<std::thread>([this, pooling, affinity]() {
+            // Stream threads are long running, thus they have dedicated threads instead of using a ThreadPool.
+            // They can still be pinned to a set of cores with the affinity of the "streamers" pool.
+            ThreadPool::setCurrentThreadAffinity(affinity);
+            ImageBufferPool::Scope poolScope(pooling);
+            generateStream();
+        });
     }
 }
 
@@ -30,7 +41,7 @@ Streamer::Streamer() {
     m_firstFrameIsInserted = false;
     m_streamIsStarted = false;
     m_stop = false;
-    m_frameData["streaming"] = "yes";
+    m_frameData.set(FrameData::getKey("streaming"), "yes");
 }
 
 void Streamer::stop() {
@@ -0,0 +1,94 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Streamers/SequenceFileStreamer.hpp"
+#include "FAST/Exporters/SequenceFileWriter.hpp"
+#include "FAST/Data/Image.hpp"
+#include "FAST/DataStream.hpp"
+
+using namespace fast;
+
+static std::string writeSequence(std::string name, int frames, bool compress) {
+    const std::string filename = name + ".fastseq";
+    SequenceFileWriter writer(filename, compress);
+    for(int i = 0; i < frames; ++i) {
+        auto image = Image::create(64, 32, TYPE_UINT8, 1);
+        image->fill(i);
+        image->setSpacing(Vector3f(0.5f, 0.25f, 1.0f));
+        writer.write(image);
+    }
+    writer.close();
+    return filename;
+}
+
+TEST_CASE("SequenceFileStreamer streams all frames of a sequence file", "[fast][SequenceFileStreamer][SequenceFile]") {
+    const int frames = 10;
+    for(bool compress : {false, true}) {
+        auto filename = writeSequence(compress ? "sequence_streamer_compressed" : "sequence_streamer", frames, compress);
+        auto streamer = SequenceFileStreamer::create(filename, false, false);
+        CHECK(streamer->getNrOfFrames() == frames);
+
+        DataStream stream(streamer);
+        int counter = 0;
+        while(!stream.isDone()) {
+            auto image = stream.getNextFrame<Image>();
+            CHECK(image->getWidth() == 64);
+            CHECK(image->getHeight() == 32);
+            CHECK(image->getDataType() == TYPE_UINT8);
+            CHECK(image->getSpacing().x() == Approx(0.5f));
+            CHECK(image->getSpacing().y() == Approx(0.25f));
+            auto access = image->getImageAccess(ACCESS_READ);
+            auto data = (const uchar*)access->get();
+            CHECK(data[0] == counter);
+            CHECK(data[64*32-1] == counter);
+            ++counter;
+        }
+        CHECK(counter == frames);
+    }
+}
+
+TEST_CASE("SequenceFileStreamer can seek to a frame", "[fast][SequenceFileStreamer][SequenceFile]") {
+    auto filename = writeSequence("sequence_streamer_seek", 10, false);
+    auto streamer = SequenceFileStreamer::create(filename, false, false);
+    streamer->setCurrentFrameIndex(7);
+    DataStream stream(streamer);
+    auto image = stream.getNextFrame<Image>();
+    auto access = image->getImageAccess(ACCESS_READ);
+    CHECK(((const uchar*)access->get())[0] == 7);
+}
+
+TEST_CASE("Writing to an image from SequenceFileStreamer doesn't change the file", "[fast][SequenceFileStreamer][SequenceFile]") {
+    auto filename = writeSequence("sequence_streamer_write", 2, false);
+    {
+        auto streamer = SequenceFileStreamer::create(filename, false, false);
+        DataStream stream(streamer);
+        auto image = stream.getNextFrame<Image>();
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        ((uchar*)access->get())[0] = 100;
+    }
+    auto streamer = SequenceFileStreamer::create(filename, false, false);
+    DataStream stream(streamer);
+    auto image = stream.getNextFrame<Image>();
+    auto access = image->getImageAccess(ACCESS_READ);
+    CHECK(((const uchar*)access->get())[0] == 0);
+}
+
+TEST_CASE("Writing to an image from SequenceFileStreamer doesn't change the frame when looping", "[fast][SequenceFileStreamer][SequenceFile]") {
+    auto filename = writeSequence("sequence_streamer_write_loop", 2, false);
+    auto streamer = SequenceFileStreamer::create(filename, true, false);
+    DataStream stream(streamer);
+    for(int i = 0; i < 6; ++i) {
+        auto image = stream.getNextFrame<Image>();
+        auto access = image->getImageAccess(ACCESS_READ_WRITE);
+        auto data = (uchar*)access->get();
+        // Every frame is modified, thus the value is only correct if the frame is read from the file again
+        CHECK(data[0] == i % 2);
+        CHECK(data[64*32-1] == i % 2);
+        data[0] = 100;
+        data[64*32-1] = 100;
+    }
+    CHECK_THROWS(streamer->setFilename(filename));
+}
+
+TEST_CASE("SequenceFileStreamer throws on invalid file", "[fast][SequenceFileStreamer][SequenceFile]") {
+    CHECK_THROWS(SequenceFileStreamer::create("not_existing.fastseq")->getNrOfFrames());
+    CHECK_THROWS(SequenceFileStreamer::create(Config::getTestDataPath() + "US/Heart/ApicalFourChamber/US-2D_0.mhd")->getNrOfFrames());
+}
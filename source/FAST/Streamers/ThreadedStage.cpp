@@ -0,0 +1,102 @@
+#include "ThreadedStage.hpp"
+#include <set>
+
+namespace fast {
+
+ThreadedStage::ThreadedStage(DataChannel::pointer upstream, int queueSize) {
+    if(!upstream)
+        throw Exception("Upstream data channel given to ThreadedStage was null");
+    if(queueSize <= 0)
+        throw Exception("Queue size of ThreadedStage must be > 0");
+    createOutputPort<DataObject>(0);
+    m_upstream = upstream;
+    m_queueSize = queueSize;
+    setMaximumNrOfFrames(queueSize);
+    mIsModified = true;
+}
+
+DataChannel::pointer ThreadedStage::getUpstream() const {
+    return m_upstream;
+}
+
+int ThreadedStage::getQueueSize() const {
+    return m_queueSize;
+}
+
+void ThreadedStage::execute() {
+    startStream();
+    waitForFirstFrame();
+}
+
+/**
+ * Add listener to the input data channels of a process object and all process objects upstream of it
+ */
+static void addListenerUpstream(const std::shared_ptr<ProcessObject>& processObject, const std::shared_ptr<DataChannelListener>& listener, std::set<ProcessObject*>& visited) {
+    if(!processObject || !visited.insert(processObject.get()).second)
+        return;
+    for(const auto& input : processObject->getInputConnections()) {
+        input.second->addListener(listener);
+        addListenerUpstream(input.second->getProcessObject(), listener, visited);
+    }
+}
+
+void ThreadedStage::generateStream() {
+    auto upstreamPO = m_upstream->getProcessObject();
+    std::set<ProcessObject*> visited;
+    addListenerUpstream(upstreamPO, m_listener, visited);
+    DataObject::pointer previousData;
+    uint64_t previousTimestamp = 0;
+    try {
+        while(!m_stop) {
+            const uint64_t notifications = m_listener->getNotifications();
+            upstreamPO->update();
+            auto data = m_upstream->getNextFrame();
+            if(data == previousData && data->getTimestamp() <= previousTimestamp) {
+                // Upstream PO did not execute, because there is no new data.
+                // Wait until a frame is added upstream. The timeout is needed in case an upstream process object is
+                // modified by changing a parameter, which doesn't notify the listener.
+                if(data->isLastFrame())
+                    break;
+                m_listener->waitForNotification(notifications, std::chrono::milliseconds(100));
+                continue;
+            }
+            previousData = data;
+            previousTimestamp = data->getTimestamp();
+
+            const bool lastFrame = data->isLastFrame();
+            if(lastFrame) // Downstream POs check for last frame of its parent streamer
+                data->setLastFrame(getNameOfClass());
+            addOutputData(0, data, false, false);
+            frameAdded();
+            if(lastFrame)
+                break;
+        }
+    } catch(ThreadStopped &e) {
+        reportInfo() << "ThreadedStage stopped" << reportEnd();
+        frameAdded();
+    } catch(std::exception &e) {
+        // Pass error on to downstream POs
+        reportError() << "Error in ThreadedStage for " << upstreamPO->getNameOfClass() << ": " << e.what() << reportEnd();
+        stopWithError(e.what());
+    }
+}
+
+void ThreadedStage::stop() {
+    // Thread might be blocked upstream, stop upstream channels to unblock it
+    if(m_thread)
+        stopPipeline();
+    Streamer::stop();
+}
+
+void ThreadedStage::stopPipeline() {
+    m_upstream->stop();
+    m_upstream->getProcessObject()->stopPipeline();
+    // Wake the thread if it is waiting for new data
+    m_listener->notify();
+}
+
+ThreadedStage::~ThreadedStage() {
+    stop();
+}
+
+}
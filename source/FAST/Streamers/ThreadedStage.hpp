@@ -0,0 +1,53 @@
+#pragma once
+
+#include <FAST/Streamers/Streamer.hpp>
+
+namespace fast {
+
+/**
+ * @brief Runs the upstream part of a pipeline in a separate thread
+ *
+ * This streamer repeatedly updates the process object which produces the upstream data channel,
+ * and puts its output data in a bounded queue. Downstream process objects thus run in parallel with the upstream
+ * process objects, and only block when the queue is empty. The upstream process objects block when the queue is full.
+ *
+ * The order of the data is kept. When a data object marked as last frame arrives, it is also marked as last frame
+ * for this stage, and the thread stops.
+ *
+ * The upstream channel is not an input connection of this process object, thus updating this stage does not
+ * update the upstream process objects. Upstream process objects should therefore only be used by this stage.
+ * Usually this object is created by the PipelinedExecutor.
+ *
+ * <h3>Output ports</h3>
+ * - 0: DataObject
+ *
+ * @sa PipelinedExecutor
+ * @ingroup streamers
+ */
+class FAST_EXPORT ThreadedStage : public Streamer {
+    FAST_PROCESS_OBJECT(ThreadedStage)
+    public:
+        /**
+         * @brief Create instance
+         * @param upstream Output data channel of the process object to run in this stage
+         * @param queueSize Max nr of data objects in the output queue of this stage
+         * @return instance
+         */
+        FAST_CONSTRUCTOR(ThreadedStage, DataChannel::pointer, upstream,, int, queueSize, = 4)
+        DataChannel::pointer getUpstream() const;
+        int getQueueSize() const;
+        void stop() override;
+        void stopPipeline() override;
+        ~ThreadedStage() override;
+    protected:
+        void execute() override;
+        void generateStream() override;
+        ThreadedStage() = default;
+
+        DataChannel::pointer m_upstream;
+        int m_queueSize = 4;
+        // Notified when a frame is added to any data channel upstream, used to wait when there is no new data
+        std::shared_ptr<DataChannelListener> m_listener = std::make_shared<DataChannelListener>();
+};
+
+}
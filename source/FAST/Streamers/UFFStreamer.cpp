@@ -493,7 +493,7 @@ void UFFStreamer::generateStream() {
                 //resultImage = image;
                 // This is a hack to make UFFStreamer work with InterleavePlayback
                 resultImage = image->copy(getMainDevice());
-                resultImage->setFrameData(image->getFrameData());
+                resultImage->setFrameData(image->getTypedFrameData());
                 if(image->isLastFrame())
                     resultImage->setLastFrame("UFFStreamer");
             } else {
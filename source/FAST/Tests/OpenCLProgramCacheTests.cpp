@@ -0,0 +1,103 @@
+#include "FAST/Testing.hpp"
+#include "FAST/DeviceManager.hpp"
+#include "FAST/Config.hpp"
+#include "FAST/Utility.hpp"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+using namespace fast;
+
+/**
+ * Use a new empty kernel binary cache in the temp directory while in scope, to not fill up the user's cache
+ */
+class TemporaryKernelBinaryPath {
+    public:
+        TemporaryKernelBinaryPath() : m_originalPath(Config::getKernelBinaryPath()) {
+#ifdef WIN32
+            m_path = "C:/windows/temp/fast_kernel_binaries_" + generateRandomString(16) + "/";
+#else
+            m_path = "/tmp/fast_kernel_binaries_" + generateRandomString(16) + "/";
+#endif
+            createDirectories(join(m_path, "programs"));
+            Config::setKernelBinaryPath(m_path);
+        }
+        std::string getPath() const {
+            return m_path;
+        }
+        ~TemporaryKernelBinaryPath() {
+            Config::setKernelBinaryPath(m_originalPath);
+            try {
+                removeDirectory(m_path);
+            } catch(Exception& e) {
+                Reporter::warning() << "Unable to remove temporary kernel binary path: " << e.what() << Reporter::end();
+            }
+        }
+    private:
+        std::string m_originalPath;
+        std::string m_path;
+};
+
+TEST_CASE("OpenCL program from string is stored in kernel binary cache", "[fast][OpenCLDevice][OpenCLProgramCache]") {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+    TemporaryKernelBinaryPath cache;
+    const std::string name = "cacheTest";
+    const std::string code = "__kernel void " + name + "(__global float* buffer) { buffer[get_global_id(0)] = 1.0f; }";
+    const std::string programsPath = join(cache.getPath(), "programs");
+
+    int index = device->createProgramFromString(code, "-DTEST");
+    CHECK_NOTHROW(cl::Kernel(device->getProgram(index), name.c_str()));
+    CHECK(getDirectoryList(programsPath).size() == 1);
+
+    // Same code and build options should give the same cache entry
+    int index2 = device->createProgramFromString(code, "-DTEST");
+    CHECK(index2 != index);
+    CHECK(getDirectoryList(programsPath).size() == 1);
+    CHECK_NOTHROW(cl::Kernel(device->getProgram(index2), name.c_str()));
+
+    // Different build options should give a new cache entry
+    device->createProgramFromString(code, "-DTEST2");
+    CHECK(getDirectoryList(programsPath).size() == 2);
+}
+
+TEST_CASE("OpenCL programs built from source files are recorded with their build options", "[fast][OpenCLDevice][OpenCLProgramCache]") {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+    TemporaryKernelBinaryPath cache;
+    const std::string filename = join(cache.getPath(), "recordTest.cl");
+    {
+        std::ofstream file(filename);
+        file << "__kernel void recordTest(__global float* buffer) { buffer[get_global_id(0)] = VALUE; }";
+    }
+
+    device->createProgramFromSource(filename, "-DVALUE=1.0f");
+    device->createProgramFromSource(filename, "-DVALUE=1.0f"); // Cached, not recorded again
+    device->createProgramFromSource(filename, "-DVALUE=2.0f");
+
+    auto builds = OpenCLDevice::getCachedProgramBuilds();
+    REQUIRE(builds.size() == 2);
+    CHECK(builds[0].first == std::vector<std::string>{filename});
+    CHECK(builds[0].second == "-DVALUE=1.0f");
+    CHECK(builds[1].second == "-DVALUE=2.0f");
+}
+
+TEST_CASE("Build OpenCL programs from several threads", "[fast][OpenCLDevice][OpenCLProgramCache]") {
+    auto device = std::dynamic_pointer_cast<OpenCLDevice>(DeviceManager::getInstance()->getDefaultDevice());
+    std::vector<std::thread> threads;
+    std::atomic_int failed(0);
+    for(int i = 0; i < 8; ++i) {
+        threads.emplace_back([&device, &failed, i]() {
+            try {
+                // Half of the threads build the same program
+                const std::string name = "threadTest" + std::to_string(i % 4);
+                int index = device->createProgramFromString("__kernel void " + name + "(__global float* buffer) { buffer[0] = 1.0f; }");
+                cl::Kernel(device->getProgram(index), name.c_str());
+            } catch(std::exception &e) {
+                ++failed;
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    CHECK(failed == 0);
+}
@@ -1,5 +1,8 @@
 #include <FAST/Testing.hpp>
 #include "DummyObjects.hpp"
+#include <FAST/PipelinedExecutor.hpp>
+#include <FAST/Algorithms/Lambda/RunLambda.hpp>
+#include <atomic>
 
 using namespace fast;
 
@@ -631,3 +634,57 @@ TEST_CASE("DataStream multi output", "[ProecssObject][DataStream][Streamer][fast
     }
     CHECK(timestep == totalFrames);
 }
+
+TEST_CASE("PipelinedExecutor keeps order of frames", "[ProcessObject][PipelinedExecutor][Streamer][fast]") {
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(1);
+    const int totalFrames = 20;
+    streamer->setTotalFrames(totalFrames);
+
+    // Count how many stages are running at the same time to verify that the stages overlap
+    std::atomic_int running(0);
+    std::atomic_int maxRunning(0);
+    auto slowPassThrough = [&running, &maxRunning](DataObject::pointer data) -> DataList {
+        int current = ++running;
+        int previousMax = maxRunning;
+        while(current > previousMax && !maxRunning.compare_exchange_weak(previousMax, current));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        --running;
+        return DataList(data);
+    };
+    auto stage1 = RunLambda::create(slowPassThrough)->connect(streamer);
+    auto stage2 = RunLambda::create(slowPassThrough)->connect(stage1);
+    auto sink = RunLambda::create(slowPassThrough)->connect(stage2);
+
+    auto executor = PipelinedExecutor(sink, 2);
+    auto stages = executor.build();
+    CHECK(stages.size() == 2);
+
+    auto stream = DataStream(sink);
+    int timestep = 0;
+    while(!stream.isDone()) {
+        auto data = stream.getNextFrame<DummyDataObject>();
+        CHECK(timestep == data->getID());
+        ++timestep;
+    }
+    CHECK(timestep == totalFrames);
+    CHECK(maxRunning >= 2);
+}
+
+TEST_CASE("PipelinedExecutor throws if staged process object has several consumers", "[ProcessObject][PipelinedExecutor][fast]") {
+    auto streamer = DummyStreamer::New();
+    auto passThrough = [](DataObject::pointer data) -> DataList {
+        return DataList(data);
+    };
+    auto stage = RunLambda::create(passThrough)->connect(streamer);
+    auto consumer1 = RunLambda::create(passThrough)->connect(stage);
+    auto sink = RunLambda::create([](DataList list) -> DataList {
+        return DataList(list.getInputData<DataObject>(0));
+    });
+    sink->connect(0, consumer1);
+    sink->connect(1, stage);
+
+    auto executor = PipelinedExecutor(sink);
+    executor.addStage(stage);
+    CHECK_THROWS(executor.build());
+}
@@ -0,0 +1,75 @@
+#include "FAST/Testing.hpp"
+#include "FAST/ProfilerReport.hpp"
+#include "DummyObjects.hpp"
+
+using namespace fast;
+
+TEST_CASE("Latency histogram percentiles", "[fast][RuntimeMeasurement]") {
+    LatencyHistogram histogram;
+    CHECK(histogram.getPercentile(50) == 0);
+    for(int i = 1; i <= 1000; ++i)
+        histogram.addSample(i);
+    CHECK(histogram.getSamples() == 1000);
+    CHECK(histogram.getPercentile(0) == Approx(1).epsilon(0.016));
+    CHECK(histogram.getPercentile(50) == Approx(500).epsilon(0.016));
+    CHECK(histogram.getPercentile(95) == Approx(950).epsilon(0.016));
+    CHECK(histogram.getPercentile(99) == Approx(990).epsilon(0.016));
+    CHECK(histogram.getPercentile(100) == Approx(1000).epsilon(0.016));
+
+    // Small values are exact at microsecond resolution
+    histogram.reset();
+    for(int i = 0; i < 99; ++i)
+        histogram.addSample(0.010);
+    histogram.addSample(5000);
+    CHECK(histogram.getPercentile(50) == Approx(0.010));
+    CHECK(histogram.getPercentile(99) == Approx(0.010));
+    CHECK(histogram.getPercentile(100) == Approx(5000));
+}
+
+TEST_CASE("Runtime measurement with maximum samples only uses last samples", "[fast][RuntimeMeasurement]") {
+    RuntimeMeasurement measurement("test", 0, 4);
+    for(int i = 1; i <= 10; ++i)
+        measurement.addSample(i);
+    CHECK(measurement.getSamples() == 4);
+    CHECK(measurement.getSum() == Approx(7 + 8 + 9 + 10));
+    CHECK(measurement.getAverage() == Approx(8.5));
+    CHECK(measurement.getMin() == Approx(7));
+    CHECK(measurement.getMax() == Approx(10));
+    CHECK(measurement.getStdDeviation() == Approx(std::sqrt(1.25)));
+    // Percentiles are calculated from all samples
+    CHECK(measurement.getPercentile(10) == Approx(1));
+}
+
+TEST_CASE("Profiler report of streaming pipeline", "[fast][ProfilerReport]") {
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(10);
+    streamer->setTotalFrames(20);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamer->getOutputPort());
+    ProfilerReport::enableRuntimeMeasurements(po);
+    CHECK(streamer->getRuntimeManager()->isEnabled());
+
+    auto port = po->getOutputPort();
+    bool lastFrame = false;
+    while(!lastFrame) {
+        po->update();
+        lastFrame = port->getNextFrame<DummyDataObject>()->isLastFrame();
+    }
+
+    auto input = po->getInputPort(0);
+    CHECK(input->getFramesAdded() == 20);
+    CHECK(input->getFramesDropped() == 0);
+    CHECK(input->getPeakSize() >= 1);
+    CHECK(input->getNextFrameWaitTime()->getSamples() == 20);
+    CHECK(po->getRuntime()->getSamples() == 20);
+
+    ProfilerReport report(po);
+    auto table = report.getTable();
+    CHECK(table.find("DummyStreamer -> DummyProcessObject:0") != std::string::npos);
+    auto json = report.getJSON();
+    CHECK(json.find("\"id\": \"DummyProcessObject\"") != std::string::npos);
+    CHECK(json.find("\"name\": \"execute\", \"samples\": 20") != std::string::npos);
+    CHECK(json.find("\"from\": \"DummyStreamer\", \"to\": \"DummyProcessObject\"") != std::string::npos);
+    CHECK(json.find("\"framesAdded\": 20") != std::string::npos);
+}
@@ -0,0 +1,69 @@
+#include "FAST/Testing.hpp"
+#include "FAST/ThreadPool.hpp"
+#include "FAST/Config.hpp"
+#include <atomic>
+#include <numeric>
+
+using namespace fast;
+
+TEST_CASE("Thread pool runs submitted tasks", "[fast][ThreadPool]") {
+    ThreadPool pool(4);
+    CHECK(pool.getNrOfThreads() == 4);
+    std::vector<std::future<int>> futures;
+    for(int i = 0; i < 100; ++i)
+        futures.push_back(pool.submit([i]() { return i*2; }));
+    for(int i = 0; i < 100; ++i)
+        CHECK(futures[i].get() == i*2);
+
+    auto future = pool.submit([]() -> int { throw Exception("Error in task"); });
+    CHECK_THROWS(future.get());
+}
+
+TEST_CASE("Thread pool parallelFor visits each index once", "[fast][ThreadPool]") {
+    ThreadPool pool(4);
+    std::vector<int> visits(10000, 0);
+    pool.parallelFor(0, visits.size(), [&](int begin, int end) {
+        for(int i = begin; i < end; ++i)
+            visits[i]++;
+    });
+    CHECK(std::accumulate(visits.begin(), visits.end(), 0) == 10000);
+    CHECK(*std::min_element(visits.begin(), visits.end()) == 1);
+
+    // Empty range should not call the function
+    bool called = false;
+    pool.parallelFor(5, 5, [&](int, int) { called = true; });
+    CHECK_FALSE(called);
+}
+
+TEST_CASE("Thread pool parallelFor can be nested in tasks", "[fast][ThreadPool]") {
+    ThreadPool pool(2);
+    std::atomic<int> sum(0);
+    std::vector<std::future<void>> futures;
+    // More tasks than threads, all waiting for nested loops
+    for(int task = 0; task < 8; ++task) {
+        futures.push_back(pool.submit([&pool, &sum]() {
+            pool.parallelFor(0, 1000, [&sum](int begin, int end) {
+                sum += end - begin;
+            }, 10);
+        }));
+    }
+    for(auto& future : futures)
+        future.get();
+    CHECK(sum == 8000);
+}
+
+TEST_CASE("Thread pool parallelFor rethrows exceptions", "[fast][ThreadPool]") {
+    ThreadPool pool(4);
+    CHECK_THROWS(pool.parallelFor(0, 100, [](int begin, int end) {
+        if(begin <= 50 && 50 < end)
+            throw Exception("Error in chunk");
+    }, 1));
+}
+
+TEST_CASE("Shared thread pool uses size from Config", "[fast][ThreadPool]") {
+    Config::setThreadPoolSize(3, "thread-pool-test");
+    CHECK(Config::getThreadPoolSize("thread-pool-test") == 3);
+    auto pool = ThreadPool::getInstance("thread-pool-test");
+    CHECK(pool->getNrOfThreads() == 3);
+    CHECK(ThreadPool::getInstance("thread-pool-test") == pool);
+}
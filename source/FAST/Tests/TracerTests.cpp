@@ -0,0 +1,60 @@
+#include "FAST/Testing.hpp"
+#include "FAST/Tracer.hpp"
+#include "DummyObjects.hpp"
+
+using namespace fast;
+
+TEST_CASE("Tracer records execute events of streaming pipeline", "[fast][Tracer]") {
+    auto tracer = Tracer::getInstance();
+    tracer->start();
+    CHECK(Tracer::isEnabled());
+
+    auto streamer = DummyStreamer::New();
+    streamer->setSleepTime(10);
+    streamer->setTotalFrames(5);
+
+    auto po = DummyProcessObject::New();
+    po->setInputConnection(streamer->getOutputPort());
+
+    auto port = po->getOutputPort();
+    bool lastFrame = false;
+    int executeToken = 0;
+    while(!lastFrame) {
+        po->update(executeToken);
+        lastFrame = port->getNextFrame<DummyDataObject>()->isLastFrame();
+        ++executeToken;
+    }
+    tracer->stop();
+    CHECK_FALSE(Tracer::isEnabled());
+
+    // Process object executes once per frame
+    CHECK(tracer->getNrOfEvents() >= 5);
+    CHECK(tracer->getNrOfDroppedEvents() == 0);
+    auto json = tracer->getJSON();
+    CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.find("\"name\": \"DummyProcessObject\", \"cat\": \"execute\"") != std::string::npos);
+    CHECK(json.find("\"executeToken\": \"4\"") != std::string::npos);
+    CHECK(json.find("\"frameTimestamp\"") != std::string::npos);
+
+    // Nothing is recorded after stop
+    const uint64_t events = tracer->getNrOfEvents();
+    {
+        Tracer::Scope scope("test", "test");
+    }
+    CHECK(tracer->getNrOfEvents() == events);
+}
+
+TEST_CASE("Tracer drops events above maximum", "[fast][Tracer]") {
+    auto tracer = Tracer::getInstance();
+    tracer->start();
+    tracer->setMaximumNrOfEvents(2);
+    for(int i = 0; i < 5; ++i) {
+        Tracer::Scope scope("event \"" + std::to_string(i) + "\"", "test", {{"index", std::to_string(i)}});
+    }
+    tracer->stop();
+    tracer->setMaximumNrOfEvents(1000000);
+    CHECK(tracer->getNrOfEvents() == 2);
+    CHECK(tracer->getNrOfDroppedEvents() == 3);
+    // Names are escaped
+    CHECK(tracer->getJSON().find("\"event \\\"1\\\"\"") != std::string::npos);
+}
@@ -0,0 +1,198 @@
+#include "ThreadPool.hpp"
+#include <FAST/Config.hpp>
+#include <map>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fast {
+
+// Pool and worker index of the current thread, used to put tasks submitted by a worker in its own queue
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+std::shared_ptr<ThreadPool> ThreadPool::getInstance(const std::string& name) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<ThreadPool>> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    if(pools.count(name) == 0)
+        pools[name] = std::make_shared<ThreadPool>(Config::getThreadPoolSize(name), Config::getThreadPoolAffinity(name));
+    return pools[name];
+}
+
+ThreadPool::ThreadPool(int threads, std::vector<int> affinity) {
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    for(int i = 0; i < threads; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+    for(int i = 0; i < threads; ++i)
+        m_workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i, affinity);
+    reportInfo() << "Created thread pool with " << threads << " threads" << reportEnd();
+}
+
+int ThreadPool::getNrOfThreads() const {
+    return m_workers.size();
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    int index;
+    if(currentPool == this) {
+        index = currentWorker;
+    } else {
+        index = m_nextWorker++ % m_workers.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        ++m_pendingTasks;
+    }
+    m_taskAvailable.notify_one();
+}
+
+bool ThreadPool::tryRunTask() {
+    std::function<void()> task;
+    const int self = currentPool == this ? currentWorker : -1;
+    // Newest task in own queue first, for cache locality
+    if(self >= 0) {
+        std::lock_guard<std::mutex> lock(m_workers[self]->mutex);
+        if(!m_workers[self]->tasks.empty()) {
+            task = std::move(m_workers[self]->tasks.back());
+            m_workers[self]->tasks.pop_back();
+        }
+    }
+    // Then steal oldest task from other queues
+    if(!task) {
+        const int size = m_workers.size();
+        const int start = self >= 0 ? self + 1 : m_nextWorker % size;
+        for(int i = 0; i < size && !task; ++i) {
+            auto& worker = m_workers[(start + i) % size];
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            if(!worker->tasks.empty()) {
+                task = std::move(worker->tasks.front());
+                worker->tasks.pop_front();
+            }
+        }
+    }
+    if(!task)
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        --m_pendingTasks;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(int index, std::vector<int> affinity) {
+    currentPool = this;
+    currentWorker = index;
+    if(!affinity.empty())
+        setCurrentThreadAffinity({affinity[index % affinity.size()]});
+    while(true) {
+        if(tryRunTask())
+            continue;
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_taskAvailable.wait(lock, [this] { return m_pendingTasks > 0 || m_stop; });
+        if(m_stop && m_pendingTasks <= 0)
+            break;
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& function, int grainSize) {
+    if(end <= begin)
+        return;
+    const int size = end - begin;
+    if(grainSize <= 0)
+        grainSize = std::max(1, size / (getNrOfThreads()*4));
+    const int chunks = (size + grainSize - 1) / grainSize;
+    if(chunks == 1) {
+        function(begin, end);
+        return;
+    }
+
+    // Shared with the helper tasks, which may start after this function has returned
+    struct State {
+        std::function<void(int, int)> function;
+        std::atomic<int> nextChunk{0};
+        int chunksDone = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+    state->function = function;
+    auto runChunks = [state, begin, end, grainSize, chunks]() {
+        int chunk;
+        while((chunk = state->nextChunk++) < chunks) {
+            const int chunkBegin = begin + chunk*grainSize;
+            try {
+                state->function(chunkBegin, std::min(end, chunkBegin + grainSize));
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if(!state->error)
+                    state->error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(++state->chunksDone == chunks)
+                state->finished.notify_all();
+        }
+    };
+    const int helpers = std::min(chunks - 1, getNrOfThreads());
+    for(int i = 0; i < helpers; ++i)
+        push(runChunks);
+    runChunks();
+
+    // Wait for chunks processed by other threads. Run other tasks meanwhile to avoid deadlock if all workers are waiting.
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if(state->chunksDone == chunks)
+                break;
+        }
+        if(!tryRunTask()) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->finished.wait_for(lock, std::chrono::milliseconds(1), [&state, chunks] { return state->chunksDone == chunks; });
+        }
+    }
+    if(state->error)
+        std::rethrow_exception(state->error);
+}
+
+void ThreadPool::setCurrentThreadAffinity(const std::vector<int>& cores) {
+    if(cores.empty())
+        return;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for(int core : cores)
+        mask |= (DWORD_PTR)1 << core;
+    if(SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+        Reporter::warning() << "Unable to set thread affinity" << Reporter::end();
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int core : cores)
+        CPU_SET(core, &set);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0)
+        Reporter::warning() << "Unable to set thread affinity" << Reporter::end();
+#else
+    Reporter::warning() << "Thread affinity is not supported on this platform" << Reporter::end();
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_taskAvailable.notify_all();
+    for(auto& worker : m_workers)
+        worker->thread.join();
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <FAST/Object.hpp>
+#include <functional>
+#include <future>
+#include <thread>
+#include <deque>
+#include <condition_variable>
+#include <type_traits>
+
+namespace fast {
+
+/**
+ * @brief Work-stealing thread pool
+ *
+ * Each worker thread has its own task queue. Tasks submitted from a worker thread are put in the queue of that worker,
+ * while tasks submitted from other threads are distributed among the workers. Idle workers steal tasks from the
+ * queues of other workers.
+ *
+ * Pools are shared through getInstance with a name, e.g. "default". The nr of threads and CPU affinity of each
+ * pool can be set with Config::setThreadPoolSize and Config::setThreadPoolAffinity before the pool is first used, or
+ * in the configuration file with the keys ThreadPoolSize.<name> and ThreadPoolAffinity.<name>.
+ * Sharing pools avoids oversubscribing the CPU when several pipelines run in the same process.
+ *
+ * Tasks should not block for a long time waiting for other threads, as this occupies a worker.
+ * Long running loops, such as the stream thread of a Streamer, should therefore use a dedicated thread instead.
+ *
+ * Example:
+ * @code
+ * auto pool = ThreadPool::getInstance();
+ * auto future = pool->submit([]() { return 42; });
+ * pool->parallelFor(0, size, [&](int begin, int end) {
+ *     for(int i = begin; i < end; ++i)
+ *         data[i] *= 2;
+ * });
+ * @endcode
+ */
+class FAST_EXPORT ThreadPool : public Object {
+    public:
+        typedef std::shared_ptr<ThreadPool> pointer;
+        /**
+         * @brief Get a shared thread pool. The pool is created the first time it is requested.
+         * @param name Name of pool
+         * @return pool
+         */
+        static std::shared_ptr<ThreadPool> getInstance(const std::string& name = "default");
+        /**
+         * @brief Create a thread pool
+         * @param threads Nr of worker threads. If <= 0, it will use the nr of cores available.
+         * @param affinity CPU cores to pin the workers to. Worker i is pinned to core affinity[i % affinity.size()].
+         *      If empty, workers are not pinned.
+         */
+        explicit ThreadPool(int threads = -1, std::vector<int> affinity = {});
+#ifndef SWIG
+        /**
+         * @brief Run a task in the pool
+         * @param task
+         * @return future with the result of the task. Exceptions thrown by the task are rethrown by future.get().
+         */
+        template <class Function>
+        std::future<std::invoke_result_t<Function>> submit(Function&& task);
+        /**
+         * @brief Run a loop in parallel, and wait for it to finish.
+         * The range is split into chunks of indices. The calling thread also processes chunks, and
+         * runs other tasks in the pool while waiting. Thus parallelFor can be used from within a task without deadlocking.
+         * If any chunk throws an exception, the first exception is rethrown after all chunks have finished.
+         * @param begin First index
+         * @param end One past the last index
+         * @param function Function called with the first and one past the last index of each chunk
+         * @param grainSize Minimum nr of indices per chunk. If <= 0, the range is split in 4 chunks per thread.
+         */
+        void parallelFor(int begin, int end, const std::function<void(int begin, int end)>& function, int grainSize = 0);
+#endif
+        int getNrOfThreads() const;
+        /**
+         * @brief Pin the calling thread to a set of CPU cores. Does nothing if cores is empty.
+         * Only supported on Linux and Windows.
+         * @param cores
+         */
+        static void setCurrentThreadAffinity(const std::vector<int>& cores);
+        ~ThreadPool() override;
+    private:
+        struct Worker {
+            std::deque<std::function<void()>> tasks;
+            std::mutex mutex;
+            std::thread thread;
+        };
+        void push(std::function<void()> task);
+        bool tryRunTask();
+        void workerLoop(int index, std::vector<int> affinity);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::mutex m_sleepMutex;
+        std::condition_variable m_taskAvailable;
+        int m_pendingTasks = 0; // Protected by m_sleepMutex
+        bool m_stop = false; // Protected by m_sleepMutex
+        std::atomic<uint> m_nextWorker{0};
+};
+
+template <class Function>
+std::future<std::invoke_result_t<Function>> ThreadPool::submit(Function&& task) {
+    typedef std::invoke_result_t<Function> ReturnType;
+    auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Function>(task));
+    auto future = packagedTask->get_future();
+    push([packagedTask]() { (*packagedTask)(); });
+    return future;
+}
+
+}
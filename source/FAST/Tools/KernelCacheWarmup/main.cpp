@@ -0,0 +1,95 @@
+#include <FAST/DeviceManager.hpp>
+#include <FAST/Config.hpp>
+#include <FAST/Utility.hpp>
+#include <FAST/Tools/CommandLineParser.hpp>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <set>
+
+using namespace fast;
+
+/**
+ * Find all OpenCL source files in a directory recursively
+ */
+static void findKernels(const std::string& path, std::vector<std::string>& kernels) {
+    for(const auto& filename : getDirectoryList(path, true, false)) {
+        if(filename.size() > 3 && filename.substr(filename.size() - 3) == ".cl")
+            kernels.push_back(join(path, filename));
+    }
+    for(const auto& directory : getDirectoryList(path, false, true))
+        findKernels(join(path, directory), kernels);
+}
+
+int main(int argc, char** argv) {
+    CommandLineParser parser("FAST Kernel Cache Warmup",
+                             "Precompile OpenCL kernels and store the binaries in the kernel binary cache. "
+                             "Every program which has previously been compiled from a source file and stored in the cache is compiled again "
+                             "with the same build options, which makes it possible to warm up the cache after a driver update. "
+                             "In addition, all OpenCL kernels (.cl files) in the kernel source path are compiled without build options, "
+                             "or with the given build options. Kernels which need build options to compile will fail unless the build options are given.");
+    parser.addVariable("path", Config::getKernelSourcePath(), "Path to search for OpenCL kernels");
+    parser.addVariable("build-options", "", "Build options to compile each kernel with. Several sets of build options can be separated by ;");
+    parser.addVariable("threads", "-1", "Number of kernels to compile in parallel. Default is number of cores.");
+    parser.parse(argc, argv);
+
+    auto device = DeviceManager::getInstance()->getOneOpenCLDevice();
+    Reporter::info() << "Compiling kernels for device " << device->getName() << Reporter::end();
+
+    // Builds recorded in the cache already have the final build options
+    std::vector<std::pair<std::vector<std::string>, std::string>> builds = OpenCLDevice::getCachedProgramBuilds();
+    std::set<std::pair<std::vector<std::string>, std::string>> existingBuilds(builds.begin(), builds.end());
+
+    std::vector<std::string> kernels;
+    findKernels(parser.get("path"), kernels);
+    std::vector<std::string> buildOptionsList = split(parser.get("build-options"), ";");
+    if(buildOptionsList.empty())
+        buildOptionsList.push_back("");
+    for(auto& buildOptions : buildOptionsList) {
+        trim(buildOptions);
+        // Same as OpenCLProgram::build, to get the same cache entry
+        if(device->isWritingTo3DTexturesSupported()) {
+            if(buildOptions.size() > 0)
+                buildOptions += " ";
+            buildOptions += "-Dfast_3d_image_writes";
+        }
+        for(const auto& kernel : kernels) {
+            std::pair<std::vector<std::string>, std::string> build = {{kernel}, buildOptions};
+            if(existingBuilds.insert(build).second)
+                builds.push_back(build);
+        }
+    }
+
+    int threads = parser.get<int>("threads");
+    if(threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    // Compile in parallel
+    const int total = builds.size();
+    std::atomic_int next(0);
+    std::atomic_int failed(0);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for(int i = 0; i < std::min(threads, total); ++i) {
+        workers.emplace_back([&]() {
+            for(int job = next++; job < total; job = next++) {
+                const auto& filenames = builds[job].first;
+                const auto& buildOptions = builds[job].second;
+                try {
+                    device->createProgramFromSource(filenames, buildOptions);
+                    Reporter::info() << "Compiled " << filenames[0] << " " << buildOptions << Reporter::end();
+                } catch(std::exception& e) {
+                    Reporter::warning() << "Failed to compile " << filenames[0] << " " << buildOptions << Reporter::end();
+                    ++failed;
+                }
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+    std::chrono::duration<float> duration = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << "Compiled " << (total - failed) << " of " << total << " kernels in " << duration.count() << " seconds." << std::endl;
+    std::cout << "Kernel binaries stored in " << Config::getKernelBinaryPath() << std::endl;
+    return 0;
+}
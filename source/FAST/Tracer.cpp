@@ -0,0 +1,179 @@
+#include "Tracer.hpp"
+#include <FAST/Exception.hpp>
+#include <FAST/Utility.hpp>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fast {
+
+std::atomic<bool> Tracer::m_enabled(false);
+
+std::shared_ptr<Tracer> Tracer::getInstance() {
+    static std::shared_ptr<Tracer> instance(new Tracer());
+    return instance;
+}
+
+bool Tracer::isEnabled() {
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.clear();
+    m_threadNumbers.clear();
+    m_droppedEvents = 0;
+    m_startTime = std::chrono::steady_clock::now();
+    m_enabled = true;
+}
+
+void Tracer::stop() {
+    m_enabled = false;
+}
+
+void Tracer::setMaximumNrOfEvents(uint64_t events) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumEvents = events;
+}
+
+uint64_t Tracer::getNrOfEvents() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events.size();
+}
+
+uint64_t Tracer::getNrOfDroppedEvents() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_droppedEvents;
+}
+
+int Tracer::getThreadNumber(std::thread::id id) {
+    auto it = m_threadNumbers.find(id);
+    if(it != m_threadNumbers.end())
+        return it->second;
+    const int number = m_threadNumbers.size() + 1;
+    m_threadNumbers[id] = number;
+    return number;
+}
+
+void Tracer::addEvent(const std::string& name, const std::string& category, std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end, Arguments arguments) {
+    if(!isEnabled())
+        return;
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    event.openCL = false;
+    event.arguments = std::move(arguments);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_startTime).count();
+    event.thread = getThreadNumber(std::this_thread::get_id());
+    if(m_events.size() >= m_maximumEvents) {
+        ++m_droppedEvents;
+        return;
+    }
+    m_events.push_back(std::move(event));
+}
+
+void Tracer::addEvent(Event event) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_events.size() >= m_maximumEvents) {
+        ++m_droppedEvents;
+        return;
+    }
+    m_events.push_back(std::move(event));
+}
+
+namespace {
+struct OpenCLTraceData {
+    std::string name;
+    Tracer::Arguments arguments;
+    cl::Event startEvent;
+    cl::Event endEvent;
+    std::chrono::steady_clock::time_point endQueued;
+};
+}
+
+void CL_CALLBACK Tracer::openCLEventCompleted(cl_event, cl_int status, void* userData) {
+    std::unique_ptr<OpenCLTraceData> data((OpenCLTraceData*)userData);
+    if(status != CL_COMPLETE || !isEnabled())
+        return;
+    cl_ulong queued, start, end;
+    // Fails if the command queue doesn't have profiling enabled
+    if(clGetEventProfilingInfo(data->endEvent(), CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &queued, nullptr) != CL_SUCCESS ||
+        clGetEventProfilingInfo(data->startEvent(), CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, nullptr) != CL_SUCCESS ||
+        clGetEventProfilingInfo(data->endEvent(), CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, nullptr) != CL_SUCCESS)
+        return;
+    // The device has its own clock. The end event was queued right before addOpenCLEvent was called,
+    // so use that to convert device time to host time.
+    auto tracer = getInstance();
+    Event event;
+    event.name = data->name;
+    event.category = "OpenCL";
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(data->endQueued - tracer->m_startTime).count() -
+            ((int64_t)queued - (int64_t)start);
+    event.duration = (int64_t)end - (int64_t)start;
+    event.thread = 1;
+    event.openCL = true;
+    event.arguments = std::move(data->arguments);
+    tracer->addEvent(std::move(event));
+}
+
+void Tracer::addOpenCLEvent(const std::string& name, cl::Event startEvent, cl::Event endEvent, Arguments arguments) {
+    if(!isEnabled())
+        return;
+    auto data = new OpenCLTraceData{name, std::move(arguments), startEvent, endEvent, std::chrono::steady_clock::now()};
+    if(endEvent.setCallback(CL_COMPLETE, &Tracer::openCLEventCompleted, data) != CL_SUCCESS)
+        delete data;
+}
+
+std::string Tracer::getJSON() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::stringstream buffer;
+    buffer << std::fixed << std::setprecision(3);
+    buffer << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    // Names of processes and threads
+    buffer << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"FAST\"}},\n";
+    buffer << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"OpenCL\"}},\n";
+    buffer << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 2, \"tid\": 1, \"args\": {\"name\": \"OpenCL device\"}}";
+    for(auto&& thread : m_threadNumbers)
+        buffer << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread.second << ", \"args\": {\"name\": \"Thread " << thread.second << "\"}}";
+    for(auto&& event : m_events) {
+        // Complete events (X) with timestamp and duration in microseconds
+        buffer << ",\n{\"name\": " << escapeJSON(event.name) << ", \"cat\": " << escapeJSON(event.category)
+               << ", \"ph\": \"X\", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0
+               << ", \"pid\": " << (event.openCL ? 2 : 1) << ", \"tid\": " << event.thread << ", \"args\": {";
+        bool first = true;
+        for(auto&& argument : event.arguments) {
+            buffer << (first ? "" : ", ") << escapeJSON(argument.first) << ": " << escapeJSON(argument.second);
+            first = false;
+        }
+        buffer << "}}";
+    }
+    buffer << "\n]}\n";
+    return buffer.str();
+}
+
+void Tracer::saveJSON(std::string filename) {
+    std::ofstream file(filename);
+    if(!file.is_open())
+        throw Exception("Unable to open file " + filename + " for writing trace");
+    file << getJSON();
+}
+
+Tracer::Scope::Scope(std::string name, std::string category, Arguments arguments) {
+    m_enabled = Tracer::isEnabled();
+    if(!m_enabled)
+        return;
+    m_name = std::move(name);
+    m_category = std::move(category);
+    m_arguments = std::move(arguments);
+    m_start = std::chrono::steady_clock::now();
+}
+
+Tracer::Scope::~Scope() {
+    if(m_enabled)
+        Tracer::getInstance()->addEvent(m_name, m_category, m_start, std::chrono::steady_clock::now(), std::move(m_arguments));
+}
+
+}
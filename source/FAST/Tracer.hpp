@@ -0,0 +1,132 @@
+#pragma once
+
+#include <FASTExport.hpp>
+#include <FAST/OpenCL.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fast {
+
+/**
+ * @brief Records a timeline of pipeline execution, which can be saved as Chrome trace events
+ *
+ * When started, the following is recorded with start time, duration and thread:
+ * - ProcessObject execute, with name of process object, execute token and timestamp of input frame
+ * - OpenCL commands enqueued by a process object during execute, on a separate OpenCL track, using device timestamps
+ * - DataChannel addFrame and getNextFrame calls which block
+ * - ImagePyramidAccess tile reads
+ * - RuntimeMeasurementsManager OpenCL timers
+ *
+ * The saved JSON file can be opened in chrome://tracing or https://ui.perfetto.dev to see where stages of a pipeline stall and overlap.
+ * Tracing is off by default, and has negligible overhead when off.
+ * To record OpenCL events, the tracer must be started before the OpenCL device is created, i.e. before
+ * any process objects are created, as this requires a command queue with profiling enabled.
+ *
+ * @code
+ * Tracer::getInstance()->start();
+ * // Create and run pipeline
+ * Tracer::getInstance()->stop();
+ * Tracer::getInstance()->saveJSON("trace.json");
+ * @endcode
+ */
+class FAST_EXPORT Tracer {
+    public:
+        typedef std::map<std::string, std::string> Arguments;
+        static std::shared_ptr<Tracer> getInstance();
+        /**
+         * @brief Whether the tracer is started. Cheap, thus can be used to avoid building event arguments when off.
+         */
+        static bool isEnabled();
+        /**
+         * @brief Remove all previous events and start recording
+         */
+        void start();
+        /**
+         * @brief Stop recording. Recorded events are kept until start is called again.
+         */
+        void stop();
+        /**
+         * @brief Set max nr of events to keep. Events recorded after this are dropped. Default is 1 million.
+         * @param events
+         */
+        void setMaximumNrOfEvents(uint64_t events);
+        uint64_t getNrOfEvents();
+        uint64_t getNrOfDroppedEvents();
+        /**
+         * @brief Record an event on the current thread
+         * @param name Name of event
+         * @param category Category, e.g. execute
+         * @param start
+         * @param end
+         * @param arguments Extra information shown for the event
+         */
+        void addEvent(const std::string& name, const std::string& category, std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end, Arguments arguments = Arguments());
+#ifndef SWIG
+        /**
+         * @brief Record the OpenCL commands between two markers as an event on the OpenCL track
+         *
+         * The event is added when endEvent completes, using profiling info of the events.
+         * Thus the command queue must have profiling enabled, if not the event is ignored.
+         * Should be called right after endEvent is enqueued.
+         *
+         * @param name
+         * @param startEvent Event of first command
+         * @param endEvent Event of last command
+         * @param arguments
+         */
+        void addOpenCLEvent(const std::string& name, cl::Event startEvent, cl::Event endEvent, Arguments arguments = Arguments());
+#endif
+        /**
+         * @brief Get all recorded events in the Chrome trace event JSON format
+         */
+        std::string getJSON();
+        void saveJSON(std::string filename);
+
+        /**
+         * @brief Records an event from creation to destruction of this object, if the tracer is enabled.
+         */
+        class FAST_EXPORT Scope {
+            public:
+                Scope(std::string name, std::string category, Arguments arguments = Arguments());
+                ~Scope();
+            private:
+                bool m_enabled;
+                std::string m_name;
+                std::string m_category;
+                Arguments m_arguments;
+                std::chrono::steady_clock::time_point m_start;
+        };
+    private:
+        Tracer() = default;
+        struct Event {
+            std::string name;
+            std::string category;
+            int64_t start; // Nanoseconds since tracer was started
+            int64_t duration; // Nanoseconds
+            int thread;
+            bool openCL;
+            Arguments arguments;
+        };
+        void addEvent(Event event);
+        int getThreadNumber(std::thread::id id);
+#ifndef SWIG
+        static void CL_CALLBACK openCLEventCompleted(cl_event event, cl_int status, void* userData);
+#endif
+
+        static std::atomic<bool> m_enabled;
+        std::mutex m_mutex;
+        std::vector<Event> m_events;
+        std::map<std::thread::id, int> m_threadNumbers;
+        uint64_t m_maximumEvents = 1000000;
+        uint64_t m_droppedEvents = 0;
+        std::chrono::steady_clock::time_point m_startTime;
+};
+
+}
@@ -13,6 +13,7 @@
 #endif
 
 #include "FAST/Config.hpp"
+#include <cstdio>
 #define _USE_MATH_DEFINES
 #include <cmath>
 #ifdef _WIN32
@@ -886,6 +887,27 @@ std::string replace(std::string str, std::string find, std::string replacement)
     return str;
 }
 
+std::string escapeJSON(const std::string& str) {
+    std::string result = "\"";
+    for(char c : str) {
+        switch(c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if((unsigned char)c < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    result += code;
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
 std::vector<std::string> split(const std::string input, const std::string& delimiter, float removeEmpty) {
     std::vector<std::string> parts;
     int startPos = 0;
@@ -1000,6 +1022,25 @@ void createDirectories(std::string path) {
     }
 }
 
+void removeDirectory(std::string path) {
+    if(!fileExists(path))
+        return;
+    for(const auto& file : getDirectoryList(path, true, false)) {
+        const std::string filePath = join(path, file);
+        if(std::remove(filePath.c_str()) != 0)
+            throw Exception("Unable to remove file " + filePath);
+    }
+    for(const auto& directory : getDirectoryList(path, false, true))
+        removeDirectory(join(path, directory));
+#if defined(_WIN32)
+    int error = _rmdir(path.c_str());
+#else
+    int error = rmdir(path.c_str());
+#endif
+    if(error != 0)
+        throw Exception("Unable to remove directory " + path);
+}
+
 bool fileExists(std::string filename) {
 #ifdef _WIN32
     //return _access_s(filename.c_str(), 0) == 0;
@@ -161,6 +161,11 @@ static inline void trim(std::string &s) {
  */
 FAST_EXPORT std::string replace(std::string str, std::string find, std::string replacement);
 
+/*
+ * Quote and escape a string so that it can be used as a JSON string
+ */
+FAST_EXPORT std::string escapeJSON(const std::string& str);
+
 template <class T>
 static inline void hash_combine(std::size_t& seed, const T& v)
 {
@@ -184,6 +189,13 @@ FAST_EXPORT void createDirectory(std::string path);
  */
 FAST_EXPORT void createDirectories(std::string path);
 
+/**
+ * Removes a directory and all its content.
+ * Does nothing if the directory does not exist.
+ * Throws exception if it fails
+ */
+FAST_EXPORT void removeDirectory(std::string path);
+
 /**
  * Check if file exists
  * @param filename
@@ -94,7 +94,7 @@ int ImagePyramidRenderer::loadTileTexture(std::string tileID) {
     //std::cout << "Creating texture for tile " << tile_x << " " << tile_y << " at level " << level << std::endl;
     Image::pointer tile;
     {
-        auto access = m_input->getAccess(ACCESS_READ);
+        auto access = m_input->getAccess(ACCESS_READ, true);
         try {
             tile = access->getPatchAsImage(level, tile_x, tile_y, false);
         } catch(Exception &e) {